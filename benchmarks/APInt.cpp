@@ -0,0 +1,98 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+// Widths of 64 bits and below use the single word representation, wider ones
+// the heap allocated multi-word one.
+static std::vector<APInt> getValues(unsigned BitWidth, unsigned N) {
+  std::vector<APInt> Values;
+  std::mt19937_64 Rng(0);
+  unsigned NumWords = APInt::getNumWords(BitWidth);
+  std::vector<uint64_t> Words(NumWords);
+  for (unsigned I = 0; I < N; ++I) {
+    for (uint64_t &W : Words)
+      W = Rng();
+    // Keep the values non-zero so they can be used as divisors.
+    Words[0] |= 1;
+    Values.push_back(APInt(BitWidth, makeArrayRef(Words)));
+  }
+  return Values;
+}
+
+static const unsigned NumValues = 256;
+
+static void BM_APIntAdd(benchmark::State &State) {
+  std::vector<APInt> Values = getValues(State.range(0), NumValues);
+  for (auto _ : State)
+    for (unsigned I = 1; I < NumValues; ++I)
+      benchmark::DoNotOptimize(Values[I - 1] + Values[I]);
+  State.SetItemsProcessed(State.iterations() * (NumValues - 1));
+}
+BENCHMARK(BM_APIntAdd)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+
+static void BM_APIntAddInPlace(benchmark::State &State) {
+  std::vector<APInt> Values = getValues(State.range(0), NumValues);
+  APInt Acc = Values[0];
+  for (auto _ : State)
+    for (unsigned I = 1; I < NumValues; ++I)
+      benchmark::DoNotOptimize(Acc += Values[I]);
+  State.SetItemsProcessed(State.iterations() * (NumValues - 1));
+}
+BENCHMARK(BM_APIntAddInPlace)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+
+static void BM_APIntMul(benchmark::State &State) {
+  std::vector<APInt> Values = getValues(State.range(0), NumValues);
+  for (auto _ : State)
+    for (unsigned I = 1; I < NumValues; ++I)
+      benchmark::DoNotOptimize(Values[I - 1] * Values[I]);
+  State.SetItemsProcessed(State.iterations() * (NumValues - 1));
+}
+BENCHMARK(BM_APIntMul)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+
+static void BM_APIntUDiv(benchmark::State &State) {
+  std::vector<APInt> Values = getValues(State.range(0), NumValues);
+  for (auto _ : State)
+    for (unsigned I = 1; I < NumValues; ++I)
+      benchmark::DoNotOptimize(Values[I - 1].udiv(Values[I].lshr(3) | 1));
+  State.SetItemsProcessed(State.iterations() * (NumValues - 1));
+}
+BENCHMARK(BM_APIntUDiv)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+
+static void BM_APIntShift(benchmark::State &State) {
+  unsigned BitWidth = State.range(0);
+  std::vector<APInt> Values = getValues(BitWidth, NumValues);
+  for (auto _ : State)
+    for (unsigned I = 0; I < NumValues; ++I)
+      benchmark::DoNotOptimize(Values[I].shl(I % BitWidth).lshr(I % 7));
+  State.SetItemsProcessed(State.iterations() * NumValues);
+}
+BENCHMARK(BM_APIntShift)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+
+static void BM_APIntCompare(benchmark::State &State) {
+  std::vector<APInt> Values = getValues(State.range(0), NumValues);
+  for (auto _ : State)
+    for (unsigned I = 1; I < NumValues; ++I)
+      benchmark::DoNotOptimize(Values[I - 1].slt(Values[I]));
+  State.SetItemsProcessed(State.iterations() * (NumValues - 1));
+}
+BENCHMARK(BM_APIntCompare)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+
+static void BM_APIntToString(benchmark::State &State) {
+  std::vector<APInt> Values = getValues(State.range(0), NumValues);
+  SmallString<128> Str;
+  for (auto _ : State)
+    for (const APInt &V : Values) {
+      Str.clear();
+      V.toString(Str, 10, /*Signed=*/true);
+      benchmark::DoNotOptimize(Str.data());
+    }
+  State.SetItemsProcessed(State.iterations() * NumValues);
+}
+BENCHMARK(BM_APIntToString)->Arg(32)->Arg(64)->Arg(128)->Arg(256);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,96 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ConcurrentAllocator.h"
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+using namespace llvm;
+
+static void BM_BumpPtrAllocate(benchmark::State &State) {
+  size_t Size = State.range(0);
+  BumpPtrAllocator Alloc;
+  for (auto _ : State) {
+    for (unsigned I = 0; I < 1024; ++I)
+      benchmark::DoNotOptimize(Alloc.Allocate(Size, 8));
+    Alloc.Reset();
+  }
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_BumpPtrAllocate)->Arg(8)->Arg(24)->Arg(64)->Arg(256)->Arg(8192);
+
+// A fresh allocator per iteration includes the cost of getting slabs from
+// malloc and releasing them.
+static void BM_BumpPtrAllocateFresh(benchmark::State &State) {
+  size_t Size = State.range(0);
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    for (unsigned I = 0; I < 1024; ++I)
+      benchmark::DoNotOptimize(Alloc.Allocate(Size, 8));
+  }
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_BumpPtrAllocateFresh)->Arg(8)->Arg(24)->Arg(64)->Arg(256)->Arg(8192);
+
+static void BM_MallocFree(benchmark::State &State) {
+  size_t Size = State.range(0);
+  std::vector<void *> Ptrs(1024);
+  for (auto _ : State) {
+    for (void *&P : Ptrs)
+      benchmark::DoNotOptimize(P = std::malloc(Size));
+    for (void *P : Ptrs)
+      std::free(P);
+  }
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_MallocFree)->Arg(8)->Arg(24)->Arg(64)->Arg(256)->Arg(8192);
+
+namespace {
+struct Node {
+  Node *Next = nullptr;
+  unsigned Value[6];
+  ~Node() { benchmark::DoNotOptimize(Next); }
+};
+} // namespace
+
+static void BM_SpecificBumpPtrAllocator(benchmark::State &State) {
+  for (auto _ : State) {
+    SpecificBumpPtrAllocator<Node> Alloc;
+    Node *Prev = nullptr;
+    for (unsigned I = 0; I < 1024; ++I) {
+      Node *N = new (Alloc.Allocate()) Node();
+      N->Next = Prev;
+      Prev = N;
+    }
+    // Destruction runs ~Node on every allocated object.
+  }
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_SpecificBumpPtrAllocator);
+
+// A shared BumpPtrAllocator behind a mutex, which is what multithreaded users
+// had to do before ConcurrentBumpPtrAllocator.
+static BumpPtrAllocator SharedAlloc;
+static std::mutex SharedAllocMutex;
+
+static void BM_LockedBumpPtrAllocate(benchmark::State &State) {
+  for (auto _ : State)
+    for (unsigned I = 0; I < 1024; ++I) {
+      std::lock_guard<std::mutex> Lock(SharedAllocMutex);
+      benchmark::DoNotOptimize(SharedAlloc.Allocate(24, 8));
+    }
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_LockedBumpPtrAllocate)->ThreadRange(1, 8)->UseRealTime();
+
+static ConcurrentBumpPtrAllocator ConcurrentAlloc;
+
+static void BM_ConcurrentBumpPtrAllocate(benchmark::State &State) {
+  for (auto _ : State)
+    for (unsigned I = 0; I < 1024; ++I)
+      benchmark::DoNotOptimize(ConcurrentAlloc.Allocate(24, 8));
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_ConcurrentBumpPtrAllocate)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
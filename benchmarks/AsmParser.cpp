@@ -0,0 +1,105 @@
+#include "benchmark/benchmark.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using namespace llvm;
+
+// A large module in the shape of optimized C++: long mangled names, inlined
+// value names, comments, string constants and debug-style metadata.
+static const std::string &getAssembly() {
+  static std::string IR = [] {
+    std::string IR;
+    raw_string_ostream OS(IR);
+    OS << "declare i32 @_ZN4llvm6detail14ExternalHelperEPKcj(i8*, i32)\n";
+    for (unsigned F = 0; F != 2000; ++F) {
+      OS << "@.str." << F << " = private unnamed_addr constant [26 x i8] "
+         << "c\"function number \\22" << F % 10 << "\\22 \\0Ahere\\00\", "
+         << "align 1\n\n"
+         << "; Function Attrs: nounwind uwtable\n"
+         << "define i32 @_ZN4llvm9benchmark15GeneratedModule8functionILj" << F
+         << "EEEiPij(i32* %array.base.pointer, i32 %element.count) {\n"
+         << "entry.block:\n"
+         << "  br label %for.body.i.i.preheader\n"
+         << "for.body.i.i.preheader:\n"
+         << "  %induction.var.i.i = phi i32 [ 0, %entry.block ], "
+         << "[ %induction.var.next.i.i, %for.body.i.i.preheader ]\n"
+         << "  %accumulated.sum.i.i = phi i32 [ " << F << ", %entry.block ], "
+         << "[ %accumulated.sum.next.i.i, %for.body.i.i.preheader ]\n";
+      for (unsigned I = 0; I != 20; ++I)
+        OS << "  ; Load, scale and pass on element " << I << ".\n"
+           << "  %arrayidx" << I << ".i.i = getelementptr inbounds i32, "
+           << "i32* %array.base.pointer, i32 %induction.var.i.i\n"
+           << "  %loaded.value" << I << ".i.i = load i32, i32* %arrayidx" << I
+           << ".i.i, align 4, !tbaa !0\n"
+           << "  %scaled.value" << I << ".i.i = mul nsw i32 %loaded.value" << I
+           << ".i.i, " << I * 7 + F << "\n"
+           << "  %helper.result" << I << ".i.i = call i32 "
+           << "@_ZN4llvm6detail14ExternalHelperEPKcj(i8* getelementptr "
+           << "inbounds ([26 x i8], [26 x i8]* @.str." << F
+           << ", i64 0, i64 0), i32 %scaled.value" << I << ".i.i)\n"
+           << "  store i32 %helper.result" << I << ".i.i, i32* %arrayidx" << I
+           << ".i.i, align 4, !tbaa !0\n";
+      OS << "  %accumulated.sum.next.i.i = add nsw i32 %accumulated.sum.i.i, "
+         << "%helper.result19.i.i\n"
+         << "  %induction.var.next.i.i = add nuw nsw i32 %induction.var.i.i, "
+         << "1\n"
+         << "  %exit.condition.i.i = icmp eq i32 %induction.var.next.i.i, "
+         << "%element.count\n"
+         << "  br i1 %exit.condition.i.i, label %function.exit, "
+         << "label %for.body.i.i.preheader\n"
+         << "function.exit:\n"
+         << "  ret i32 %accumulated.sum.next.i.i\n"
+         << "}\n\n";
+    }
+    OS << "!0 = !{!1, !1, i64 0}\n"
+       << "!1 = !{!\"int\", !2, i64 0}\n"
+       << "!2 = !{!\"omnipotent char\", !3, i64 0}\n"
+       << "!3 = !{!\"Simple C++ TBAA\"}\n";
+    return OS.str();
+  }();
+  return IR;
+}
+
+static void BM_ParseAssemblyString(benchmark::State &State) {
+  const std::string &IR = getAssembly();
+  for (auto _ : State) {
+    LLVMContext Context;
+    SMDiagnostic Err;
+    std::unique_ptr<Module> M = parseAssemblyString(IR, Err, Context);
+    if (!M)
+      report_fatal_error("Invalid benchmark module: " + Err.getMessage());
+    benchmark::DoNotOptimize(M.get());
+  }
+  State.SetBytesProcessed(State.iterations() * IR.size());
+}
+BENCHMARK(BM_ParseAssemblyString);
+
+static void BM_PrintModule(benchmark::State &State) {
+  LLVMContext Context;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(getAssembly(), Err, Context);
+  if (!M)
+    report_fatal_error("Invalid benchmark module: " + Err.getMessage());
+  auto *Threads = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions()["asm-print-threads"]);
+  Threads->setValue(State.range(0));
+  std::string Text;
+  for (auto _ : State) {
+    Text.clear();
+    raw_string_ostream OS(Text);
+    M->print(OS, nullptr);
+    OS.flush();
+  }
+  Threads->setValue(0);
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_PrintModule)
+    ->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,228 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using namespace llvm;
+
+// A module of many functions with a loop each, as bitcode.
+static const SmallVector<char, 0> &getBitcode() {
+  static SmallVector<char, 0> Bitcode = [] {
+    std::string IR;
+    raw_string_ostream OS(IR);
+    OS << "declare i32 @ext(i32)\n";
+    for (unsigned F = 0; F != 2000; ++F) {
+      OS << "define i32 @f" << F << "(i32* %p, i32 %n) {\n"
+         << "entry:\n"
+         << "  br label %loop\n"
+         << "loop:\n"
+         << "  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]\n"
+         << "  %s = phi i32 [ " << F << ", %entry ], [ %s.next, %loop ]\n";
+      for (unsigned I = 0; I != 20; ++I)
+        OS << "  %a" << I << " = getelementptr i32, i32* %p, i32 %i\n"
+           << "  %v" << I << " = load i32, i32* %a" << I << "\n"
+           << "  %m" << I << " = mul i32 %v" << I << ", " << I * 7 + F << "\n"
+           << "  %c" << I << " = call i32 @ext(i32 %m" << I << ")\n"
+           << "  store i32 %c" << I << ", i32* %a" << I << "\n";
+      OS << "  %s.next = add i32 %s, %c19\n"
+         << "  %i.next = add i32 %i, 1\n"
+         << "  %done = icmp eq i32 %i.next, %n\n"
+         << "  br i1 %done, label %exit, label %loop\n"
+         << "exit:\n"
+         << "  ret i32 %s.next\n"
+         << "}\n";
+    }
+
+    LLVMContext Context;
+    SMDiagnostic Err;
+    std::unique_ptr<Module> M = parseAssemblyString(OS.str(), Err, Context);
+    if (!M)
+      report_fatal_error("Invalid benchmark module");
+    SmallVector<char, 0> Buffer;
+    raw_svector_ostream BOS(Buffer);
+    WriteBitcodeToFile(*M, BOS);
+    return Buffer;
+  }();
+  return Bitcode;
+}
+
+static void BM_ParseBitcodeFile(benchmark::State &State) {
+  const SmallVector<char, 0> &Bitcode = getBitcode();
+  auto *Threads = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions()["bitcode-materialize-threads"]);
+  Threads->setValue(State.range(0));
+  for (auto _ : State) {
+    LLVMContext Context;
+    Expected<std::unique_ptr<Module>> M = parseBitcodeFile(
+        MemoryBufferRef(StringRef(Bitcode.data(), Bitcode.size()), "bench"),
+        Context);
+    if (!M)
+      report_fatal_error(M.takeError());
+    benchmark::DoNotOptimize(M->get());
+  }
+  Threads->setValue(0);
+  State.SetBytesProcessed(State.iterations() * Bitcode.size());
+}
+BENCHMARK(BM_ParseBitcodeFile)
+    ->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+static void BM_WriteBitcodeToFile(benchmark::State &State) {
+  const SmallVector<char, 0> &Bitcode = getBitcode();
+  LLVMContext Context;
+  Expected<std::unique_ptr<Module>> M = parseBitcodeFile(
+      MemoryBufferRef(StringRef(Bitcode.data(), Bitcode.size()), "bench"),
+      Context);
+  if (!M)
+    report_fatal_error(M.takeError());
+  auto *Threads = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions()["bitcode-write-threads"]);
+  Threads->setValue(State.range(0));
+  SmallVector<char, 0> Buffer;
+  for (auto _ : State) {
+    Buffer.clear();
+    raw_svector_ostream OS(Buffer);
+    WriteBitcodeToFile(**M, OS);
+  }
+  Threads->setValue(0);
+  State.SetBytesProcessed(State.iterations() * Buffer.size());
+}
+BENCHMARK(BM_WriteBitcodeToFile)
+    ->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// A module in the shape of C++ built with -g: every class has a composite type
+// with members and method declarations, shared by the definitions of its
+// methods.
+static const SmallVector<char, 0> &getDebugInfoBitcode() {
+  static SmallVector<char, 0> Bitcode = [] {
+    std::string IR;
+    raw_string_ostream OS(IR);
+    OS << "declare void @llvm.dbg.value(metadata, metadata, metadata)\n\n";
+    unsigned NextMD = 4;
+    std::string MDs;
+    raw_string_ostream MOS(MDs);
+    for (unsigned C = 0; C != 2000; ++C) {
+      unsigned Type = NextMD++, Elements = NextMD++, Ptr = NextMD++,
+               SubroutineType = NextMD++, Types = NextMD++;
+      std::string Name = "Class" + std::to_string(C);
+      MOS << "!" << Type << " = distinct !DICompositeType(tag: DW_TAG_class_"
+          << "type, name: \"" << Name << "\", file: !2, line: " << C
+          << ", size: 256, elements: !" << Elements << ", identifier: \"_ZTS"
+          << Name.size() << Name << "\")\n"
+          << "!" << Ptr << " = !DIDerivedType(tag: DW_TAG_pointer_type, "
+          << "baseType: !" << Type << ", size: 64, flags: DIFlagArtificial | "
+          << "DIFlagObjectPointer)\n"
+          << "!" << SubroutineType << " = !DISubroutineType(types: !" << Types
+          << ")\n"
+          << "!" << Types << " = !{!3, !" << Ptr << "}\n";
+      std::string ElementList;
+      for (unsigned I = 0; I != 8; ++I) {
+        unsigned Member = NextMD++;
+        MOS << "!" << Member << " = !DIDerivedType(tag: DW_TAG_member, name: "
+            << "\"field" << I << "\", scope: !" << Type << ", file: !2, line: "
+            << C << ", baseType: !3, size: 32, offset: " << I * 32 << ")\n";
+        ElementList += "!" + std::to_string(Member) + ", ";
+      }
+      for (unsigned I = 0; I != 2; ++I) {
+        unsigned Decl = NextMD++, SP = NextMD++, Nodes = NextMD++,
+                 Var = NextMD++, Loc = NextMD++;
+        std::string LinkageName = "_ZN" + std::to_string(Name.size()) + Name +
+                                  "7method" + std::to_string(I) + "Ev";
+        MOS << "!" << Decl << " = !DISubprogram(name: \"method" << I
+            << "\", scope: !" << Type << ", file: !2, line: " << C
+            << ", type: !" << SubroutineType << ", scopeLine: " << C
+            << ", flags: DIFlagPrototyped, spFlags: DISPFlagOptimized)\n"
+            << "!" << SP << " = distinct !DISubprogram(name: \"method" << I
+            << "\", linkageName: \"" << LinkageName << "\", scope: !" << Type
+            << ", file: !2, line: " << C << ", type: !" << SubroutineType
+            << ", scopeLine: " << C << ", flags: DIFlagPrototyped, spFlags: "
+            << "DISPFlagDefinition | DISPFlagOptimized, unit: !0, declaration: !"
+            << Decl << ", retainedNodes: !" << Nodes << ")\n"
+            << "!" << Nodes << " = !{!" << Var << "}\n"
+            << "!" << Var << " = !DILocalVariable(name: \"this\", arg: 1, "
+            << "scope: !" << SP << ", type: !" << Ptr << ", flags: "
+            << "DIFlagArtificial | DIFlagObjectPointer)\n"
+            << "!" << Loc << " = !DILocation(line: " << C << ", column: 3, "
+            << "scope: !" << SP << ")\n";
+        ElementList += "!" + std::to_string(Decl) + (I ? "" : ", ");
+        OS << "define i32 @" << LinkageName << "(i32* %this) !dbg !" << SP
+           << " {\n"
+           << "  call void @llvm.dbg.value(metadata i32* %this, metadata !" << Var
+           << ", metadata !DIExpression()), !dbg !" << Loc << "\n"
+           << "  %v = load i32, i32* %this, !dbg !" << Loc << "\n"
+           << "  ret i32 %v, !dbg !" << Loc << "\n"
+           << "}\n\n";
+      }
+      MOS << "!" << Elements << " = !{" << ElementList << "}\n";
+    }
+    OS << "!llvm.dbg.cu = !{!0}\n"
+       << "!llvm.module.flags = !{!1}\n"
+       << "!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: "
+       << "!2, producer: \"bench\", isOptimized: true, runtimeVersion: 0, "
+       << "emissionKind: FullDebug)\n"
+       << "!1 = !{i32 2, !\"Debug Info Version\", i32 3}\n"
+       << "!2 = !DIFile(filename: \"bench.cpp\", directory: \"/\")\n"
+       << "!3 = !DIBasicType(name: \"int\", size: 32, encoding: DW_ATE_signed)\n"
+       << MOS.str();
+
+    LLVMContext Context;
+    SMDiagnostic Err;
+    std::unique_ptr<Module> M = parseAssemblyString(OS.str(), Err, Context);
+    if (!M)
+      report_fatal_error("Invalid benchmark module: " + Err.getMessage());
+    SmallVector<char, 0> Buffer;
+    raw_svector_ostream BOS(Buffer);
+    WriteBitcodeToFile(*M, BOS);
+    return Buffer;
+  }();
+  return Bitcode;
+}
+
+// Loads the -g module lazily and materializes one function in every
+// State.range(1), as a regular LTO link keeping few of the functions of an
+// input does, or all of them at once if that is 1. State.range(0) enables
+// on-demand metadata loading, and the MallocBytes counter is the memory held
+// by the module.
+static void BM_LazyLoadDebugInfo(benchmark::State &State) {
+  const SmallVector<char, 0> &Bitcode = getDebugInfoBitcode();
+  auto *Disable = static_cast<cl::opt<bool> *>(
+      cl::getRegisteredOptions()["disable-ondemand-mds-loading"]);
+  Disable->setValue(!State.range(0));
+  size_t MallocBytes = 0;
+  for (auto _ : State) {
+    size_t Before = sys::Process::GetMallocUsage();
+    LLVMContext Context;
+    Expected<std::unique_ptr<Module>> M = getLazyBitcodeModule(
+        MemoryBufferRef(StringRef(Bitcode.data(), Bitcode.size()), "bench"),
+        Context);
+    if (!M)
+      report_fatal_error(M.takeError());
+    if (State.range(1) == 1) {
+      if (Error Err = (*M)->materializeAll())
+        report_fatal_error(std::move(Err));
+    } else {
+      unsigned I = 0;
+      for (Function &F : **M)
+        if (I++ % State.range(1) == 0)
+          if (Error Err = F.materialize())
+            report_fatal_error(std::move(Err));
+    }
+    MallocBytes = sys::Process::GetMallocUsage() - Before;
+  }
+  Disable->setValue(false);
+  State.counters["MallocBytes"] = MallocBytes;
+}
+BENCHMARK(BM_LazyLoadDebugInfo)
+    ->Args({0, 100})->Args({1, 100})->Args({0, 1})->Args({1, 1});
+
+BENCHMARK_MAIN();
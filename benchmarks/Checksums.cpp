@@ -0,0 +1,56 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CRC.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/SHA1.h"
+#include <vector>
+
+using namespace llvm;
+
+static std::vector<uint8_t> getData(size_t Size) {
+  std::vector<uint8_t> Data(Size);
+  for (size_t I = 0; I != Size; ++I)
+    Data[I] = I * 31 + (I >> 7);
+  return Data;
+}
+
+static void BM_SHA1(benchmark::State &State) {
+  std::vector<uint8_t> Data = getData(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(SHA1::hash(Data));
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+BENCHMARK(BM_SHA1)->Range(64, 1 << 24);
+
+static void BM_SHA1Tree(benchmark::State &State) {
+  std::vector<uint8_t> Data = getData(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(SHA1::hashTree(Data));
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+BENCHMARK(BM_SHA1Tree)->Range(1 << 20, 1 << 24);
+
+static void BM_MD5(benchmark::State &State) {
+  std::vector<uint8_t> Data = getData(State.range(0));
+  for (auto _ : State) {
+    MD5 Hash;
+    MD5::MD5Result Result;
+    Hash.update(Data);
+    Hash.final(Result);
+    benchmark::DoNotOptimize(Result);
+  }
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+BENCHMARK(BM_MD5)->Range(64, 1 << 24);
+
+static void BM_CRC32(benchmark::State &State) {
+  std::vector<uint8_t> Data = getData(State.range(0));
+  StringRef S(reinterpret_cast<const char *>(Data.data()), Data.size());
+  for (auto _ : State)
+    benchmark::DoNotOptimize(crc32(0, S));
+  State.SetBytesProcessed(State.iterations() * Data.size());
+}
+BENCHMARK(BM_CRC32)->Range(64, 1 << 24);
+
+BENCHMARK_MAIN();
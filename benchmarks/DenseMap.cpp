@@ -0,0 +1,117 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+// Pointer keys spread over the address space the way Value* and Type* keys
+// are in practice. The second half is never inserted and is used for misses.
+static std::vector<void *> getPointerKeys(unsigned N) {
+  std::vector<void *> Keys;
+  std::mt19937_64 Rng(0);
+  for (unsigned I = 0; I < 2 * N; ++I)
+    Keys.push_back(reinterpret_cast<void *>((Rng() & 0xFFFFFFFFFFF0ULL) | 16));
+  return Keys;
+}
+
+static void BM_DenseMapInsert(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::vector<void *> Keys = getPointerKeys(N);
+  for (auto _ : State) {
+    DenseMap<void *, unsigned> Map;
+    for (unsigned I = 0; I < N; ++I)
+      Map[Keys[I]] = I;
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_DenseMapInsert)->Range(1 << 6, 1 << 17);
+
+static void BM_DenseMapInsertReserved(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::vector<void *> Keys = getPointerKeys(N);
+  for (auto _ : State) {
+    DenseMap<void *, unsigned> Map(N);
+    for (unsigned I = 0; I < N; ++I)
+      Map[Keys[I]] = I;
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_DenseMapInsertReserved)->Range(1 << 6, 1 << 17);
+
+static void lookup(benchmark::State &State, bool Hit) {
+  unsigned N = State.range(0);
+  std::vector<void *> Names = getPointerKeys(N);
+  DenseMap<void *, unsigned> Map;
+  for (unsigned I = 0; I < N; ++I)
+    Map[Names[I]] = I;
+
+  std::vector<void *> Keys(Names.begin() + (Hit ? 0 : N),
+                           Names.begin() + (Hit ? N : 2 * N));
+  std::shuffle(Keys.begin(), Keys.end(), std::mt19937(0));
+  for (auto _ : State)
+    for (void *Key : Keys)
+      benchmark::DoNotOptimize(Map.find(Key));
+  State.SetItemsProcessed(State.iterations() * N);
+}
+
+static void BM_DenseMapLookupHit(benchmark::State &State) {
+  lookup(State, true);
+}
+BENCHMARK(BM_DenseMapLookupHit)->Range(1 << 6, 1 << 17);
+
+static void BM_DenseMapLookupMiss(benchmark::State &State) {
+  lookup(State, false);
+}
+BENCHMARK(BM_DenseMapLookupMiss)->Range(1 << 6, 1 << 17);
+
+// Insert and erase in a sliding window, which leaves tombstones behind.
+static void BM_DenseMapEraseChurn(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::vector<void *> Keys = getPointerKeys(N);
+  for (auto _ : State) {
+    DenseMap<void *, unsigned> Map;
+    for (unsigned I = 0; I < 2 * N; ++I) {
+      Map[Keys[I]] = I;
+      if (I >= N / 2)
+        Map.erase(Keys[I - N / 2]);
+    }
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * 2 * N);
+}
+BENCHMARK(BM_DenseMapEraseChurn)->Range(1 << 6, 1 << 17);
+
+static void BM_DenseMapIterate(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::vector<void *> Keys = getPointerKeys(N);
+  DenseMap<void *, unsigned> Map;
+  for (unsigned I = 0; I < N; ++I)
+    Map[Keys[I]] = I;
+  for (auto _ : State) {
+    unsigned Sum = 0;
+    for (const auto &KV : Map)
+      Sum += KV.second;
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_DenseMapIterate)->Range(1 << 6, 1 << 17);
+
+static void BM_DenseSetInsertUnsigned(benchmark::State &State) {
+  unsigned N = State.range(0);
+  for (auto _ : State) {
+    DenseSet<unsigned> Set;
+    for (unsigned I = 0; I < N; ++I)
+      Set.insert(I * 7);
+    benchmark::DoNotOptimize(Set.size());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_DenseSetInsertUnsigned)->Range(1 << 6, 1 << 17);
+
+BENCHMARK_MAIN();
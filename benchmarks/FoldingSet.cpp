@@ -0,0 +1,87 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/Allocator.h"
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+// A uniqued node keyed on an opcode and a few operands, in the style of
+// SDNode and SCEV uniquing.
+struct Node : FoldingSetNode {
+  unsigned Opcode;
+  const void *Ops[3];
+
+  Node(unsigned Opcode, const void *A, const void *B, const void *C)
+      : Opcode(Opcode), Ops{A, B, C} {}
+
+  void Profile(FoldingSetNodeID &ID) const {
+    Profile(ID, Opcode, Ops[0], Ops[1], Ops[2]);
+  }
+
+  static void Profile(FoldingSetNodeID &ID, unsigned Opcode, const void *A,
+                      const void *B, const void *C) {
+    ID.AddInteger(Opcode);
+    ID.AddPointer(A);
+    ID.AddPointer(B);
+    ID.AddPointer(C);
+  }
+};
+} // namespace
+
+static const void *getOperand(unsigned I) {
+  return reinterpret_cast<const void *>(uintptr_t(I + 1) * 64);
+}
+
+static Node *getOrCreate(FoldingSet<Node> &Set, BumpPtrAllocator &Alloc,
+                         unsigned I) {
+  FoldingSetNodeID ID;
+  Node::Profile(ID, I % 13, getOperand(I), getOperand(I + 1),
+                getOperand(I / 2));
+  void *InsertPos;
+  if (Node *N = Set.FindNodeOrInsertPos(ID, InsertPos))
+    return N;
+  Node *N = new (Alloc.Allocate<Node>())
+      Node(I % 13, getOperand(I), getOperand(I + 1), getOperand(I / 2));
+  Set.InsertNode(N, InsertPos);
+  return N;
+}
+
+static void BM_FoldingSetNodeIDProfile(benchmark::State &State) {
+  for (auto _ : State)
+    for (unsigned I = 0; I < 1024; ++I) {
+      FoldingSetNodeID ID;
+      Node::Profile(ID, I % 13, getOperand(I), getOperand(I + 1),
+                    getOperand(I / 2));
+      benchmark::DoNotOptimize(ID.ComputeHash());
+    }
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_FoldingSetNodeIDProfile);
+
+static void BM_FoldingSetInsert(benchmark::State &State) {
+  unsigned N = State.range(0);
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    FoldingSet<Node> Set;
+    for (unsigned I = 0; I < N; ++I)
+      benchmark::DoNotOptimize(getOrCreate(Set, Alloc, I));
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_FoldingSetInsert)->Range(1 << 6, 1 << 16);
+
+static void BM_FoldingSetLookupHit(benchmark::State &State) {
+  unsigned N = State.range(0);
+  BumpPtrAllocator Alloc;
+  FoldingSet<Node> Set;
+  for (unsigned I = 0; I < N; ++I)
+    getOrCreate(Set, Alloc, I);
+  for (auto _ : State)
+    for (unsigned I = 0; I < N; ++I)
+      benchmark::DoNotOptimize(getOrCreate(Set, Alloc, I));
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_FoldingSetLookupHit)->Range(1 << 6, 1 << 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,96 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using namespace llvm;
+
+// A -ftime-trace style document: an array of small objects.
+static std::string getDocument(unsigned NumEvents) {
+  std::string S;
+  raw_string_ostream OS(S);
+  json::OStream J(OS);
+  J.object([&] {
+    J.attributeArray("traceEvents", [&] {
+      for (unsigned I = 0; I != NumEvents; ++I)
+        J.object([&] {
+          J.attribute("pid", 1);
+          J.attribute("tid", int64_t(I % 8));
+          J.attribute("ph", "X");
+          J.attribute("ts", int64_t(I) * 1000);
+          J.attribute("dur", 12.5 + I);
+          J.attribute("name", "ParseClass");
+          J.attributeObject("args", [&] {
+            J.attribute("detail", "llvm::json::\"Value\"");
+          });
+        });
+    });
+  });
+  return OS.str();
+}
+
+static void BM_JSONParseValue(benchmark::State &State) {
+  std::string Doc = getDocument(State.range(0));
+  for (auto _ : State) {
+    Expected<json::Value> V = json::parse(Doc);
+    benchmark::DoNotOptimize(V);
+    consumeError(V.takeError());
+  }
+  State.SetBytesProcessed(State.iterations() * Doc.size());
+}
+BENCHMARK(BM_JSONParseValue)->Range(1 << 6, 1 << 16);
+
+namespace {
+// Sums the durations, as a trace analysis would.
+class DurationHandler : public json::Handler {
+public:
+  double Total = 0;
+
+  bool objectKey(StringRef Key) override {
+    IsDuration = Key == "dur";
+    return true;
+  }
+  bool number(double D) override {
+    if (IsDuration)
+      Total += D;
+    return true;
+  }
+
+private:
+  bool IsDuration = false;
+};
+} // namespace
+
+static void BM_JSONParseEvents(benchmark::State &State) {
+  std::string Doc = getDocument(State.range(0));
+  for (auto _ : State) {
+    DurationHandler H;
+    consumeError(json::parse(Doc, H));
+    benchmark::DoNotOptimize(H.Total);
+  }
+  State.SetBytesProcessed(State.iterations() * Doc.size());
+}
+BENCHMARK(BM_JSONParseEvents)->Range(1 << 6, 1 << 16);
+
+static void BM_JSONWriteValue(benchmark::State &State) {
+  std::string Doc = getDocument(State.range(0));
+  Expected<json::Value> V = json::parse(Doc);
+  for (auto _ : State) {
+    std::string S;
+    raw_string_ostream OS(S);
+    OS << *V;
+    benchmark::DoNotOptimize(OS.str());
+  }
+  State.SetBytesProcessed(State.iterations() * Doc.size());
+}
+BENCHMARK(BM_JSONWriteValue)->Range(1 << 6, 1 << 16);
+
+static void BM_JSONWriteStream(benchmark::State &State) {
+  std::string Doc = getDocument(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(getDocument(State.range(0)));
+  State.SetBytesProcessed(State.iterations() * Doc.size());
+}
+BENCHMARK(BM_JSONWriteStream)->Range(1 << 6, 1 << 16);
+
+BENCHMARK_MAIN();
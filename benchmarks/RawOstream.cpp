@@ -0,0 +1,133 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using namespace llvm;
+
+static void BM_RawStringOstreamStrings(benchmark::State &State) {
+  std::string Buffer;
+  for (auto _ : State) {
+    Buffer.clear();
+    raw_string_ostream OS(Buffer);
+    for (unsigned I = 0; I < 1024; ++I)
+      OS << "  %" << "tmp" << " = add i32 %a, %b\n";
+    OS.flush();
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetBytesProcessed(State.iterations() * Buffer.size());
+}
+BENCHMARK(BM_RawStringOstreamStrings);
+
+static void BM_RawSvectorOstreamIntegers(benchmark::State &State) {
+  SmallString<8192> Buffer;
+  for (auto _ : State) {
+    Buffer.clear();
+    raw_svector_ostream OS(Buffer);
+    for (unsigned I = 0; I < 1024; ++I)
+      OS << I << ' ' << -static_cast<int64_t>(I) * 1000003 << '\n';
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetItemsProcessed(State.iterations() * 2048);
+}
+BENCHMARK(BM_RawSvectorOstreamIntegers);
+
+static void BM_RawSvectorOstreamHex(benchmark::State &State) {
+  SmallString<8192> Buffer;
+  for (auto _ : State) {
+    Buffer.clear();
+    raw_svector_ostream OS(Buffer);
+    for (uint64_t I = 0; I < 1024; ++I)
+      OS.write_hex(I * 0x9E3779B97F4A7C15ULL) << '\n';
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_RawSvectorOstreamHex);
+
+static void BM_Format(benchmark::State &State) {
+  SmallString<8192> Buffer;
+  for (auto _ : State) {
+    Buffer.clear();
+    raw_svector_ostream OS(Buffer);
+    for (unsigned I = 0; I < 256; ++I)
+      OS << format("%08x %5d %.3f\n", I, I, I / 3.0);
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetItemsProcessed(State.iterations() * 256);
+}
+BENCHMARK(BM_Format);
+
+static void BM_FormatHex(benchmark::State &State) {
+  SmallString<8192> Buffer;
+  for (auto _ : State) {
+    Buffer.clear();
+    raw_svector_ostream OS(Buffer);
+    for (uint64_t I = 0; I < 1024; ++I)
+      OS << format_hex(I * 0x9E3779B97F4A7C15ULL, 18) << '\n';
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_FormatHex);
+
+static void BM_Indent(benchmark::State &State) {
+  SmallString<8192> Buffer;
+  for (auto _ : State) {
+    Buffer.clear();
+    raw_svector_ostream OS(Buffer);
+    for (unsigned I = 0; I < 256; ++I)
+      OS.indent(I % 32) << "x\n";
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetItemsProcessed(State.iterations() * 256);
+}
+BENCHMARK(BM_Indent);
+
+// Writes through raw_null_ostream measure the buffering overhead alone.
+static void BM_RawNullOstream(benchmark::State &State) {
+  raw_null_ostream OS;
+  for (auto _ : State)
+    for (unsigned I = 0; I < 1024; ++I)
+      OS << "define void @f" << I << "() {\n";
+  State.SetItemsProcessed(State.iterations() * 1024);
+}
+BENCHMARK(BM_RawNullOstream);
+
+// Write State.range(0) MB of assembly-like text to a file, through write(2)
+// or through a memory mapping of the file.
+static void writeFile(benchmark::State &State, bool Mapped) {
+  SmallString<64> Path;
+  if (sys::fs::createTemporaryFile("bench", "s", Path)) {
+    State.SkipWithError("cannot create temporary file");
+    return;
+  }
+  size_t Size = State.range(0) << 20;
+  for (auto _ : State) {
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC, sys::fs::CD_CreateAlways,
+                      sys::fs::FA_Read | sys::fs::FA_Write, sys::fs::F_None);
+    if (Mapped && OS.enableMappedOutput()) {
+      State.SkipWithError("cannot map output file");
+      break;
+    }
+    for (unsigned I = 0; OS.tell() < Size; ++I)
+      OS << "\tmovq\t%rax, " << (I % 512) << "(%rsp)\n";
+  }
+  sys::fs::remove(Path);
+  State.SetBytesProcessed(State.iterations() * Size);
+}
+
+static void BM_RawFdOstreamWrite(benchmark::State &State) {
+  writeFile(State, false);
+}
+BENCHMARK(BM_RawFdOstreamWrite)->Arg(1)->Arg(16)->Arg(256);
+
+static void BM_RawFdOstreamMapped(benchmark::State &State) {
+  writeFile(State, true);
+}
+BENCHMARK(BM_RawFdOstreamMapped)->Arg(1)->Arg(16)->Arg(256);
+
+BENCHMARK_MAIN();
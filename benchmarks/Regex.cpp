@@ -0,0 +1,52 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Regex.h"
+#include <string>
+
+using namespace llvm;
+
+// IR-like text that the regexes below only match at the very end.
+static std::string getIRText(size_t Size) {
+  std::string Text;
+  for (unsigned I = 0; Text.size() < Size; ++I)
+    Text += "  %" + std::to_string(I) + " = add i32 %x, " +
+            std::to_string(I * 7) + "\n";
+  return Text + "  call void @foo(i32 12)\n";
+}
+
+// A typical FileCheck pattern, scanning the whole input.
+static void BM_RegexSearch(benchmark::State &State) {
+  std::string Text = getIRText(State.range(0));
+  Regex R("call void @[a-z]+\\(i32 [0-9]+\\)");
+  for (auto _ : State)
+    benchmark::DoNotOptimize(R.match(Text));
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_RegexSearch)->Range(1 << 10, 1 << 20);
+
+// The same search, also asking for the parenthesized matches.
+static void BM_RegexSearchWithGroups(benchmark::State &State) {
+  std::string Text = getIRText(State.range(0));
+  Regex R("call void @([a-z]+)\\(i32 ([0-9]+)\\)");
+  SmallVector<StringRef, 3> Matches;
+  for (auto _ : State)
+    benchmark::DoNotOptimize(R.match(Text, &Matches));
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_RegexSearchWithGroups)->Range(1 << 10, 1 << 20);
+
+// Many alternatives, as in sanitizer special case lists.
+static void BM_RegexAlternation(benchmark::State &State) {
+  std::string Text = getIRText(State.range(0));
+  std::string Pattern;
+  for (unsigned I = 0; I != 64; ++I)
+    Pattern += (I ? "|fun" : "fun") + std::to_string(I) + "_[a-z]*";
+  Regex R(Pattern);
+  for (auto _ : State)
+    benchmark::DoNotOptimize(R.match(Text));
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_RegexAlternation)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,73 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include <vector>
+
+using namespace llvm;
+
+static std::vector<int *> getPointers(std::vector<int> &Storage) {
+  std::vector<int *> Ptrs;
+  for (int &I : Storage)
+    Ptrs.push_back(&I);
+  return Ptrs;
+}
+
+// With 8 inline elements, N <= 8 exercises the linear small mode and larger N
+// the hashed big mode.
+static void BM_SmallPtrSetInsert(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::vector<int> Storage(N);
+  std::vector<int *> Ptrs = getPointers(Storage);
+  for (auto _ : State) {
+    SmallPtrSet<int *, 8> Set;
+    for (int *P : Ptrs)
+      Set.insert(P);
+    benchmark::DoNotOptimize(Set.size());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallPtrSetInsert)->Range(4, 1 << 14);
+
+// The visited-set pattern: most inserts are of pointers already in the set.
+static void BM_SmallPtrSetInsertDuplicates(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::vector<int> Storage(N);
+  std::vector<int *> Ptrs = getPointers(Storage);
+  for (auto _ : State) {
+    SmallPtrSet<int *, 8> Set;
+    for (unsigned Round = 0; Round < 4; ++Round)
+      for (int *P : Ptrs)
+        benchmark::DoNotOptimize(Set.insert(P).second);
+  }
+  State.SetItemsProcessed(State.iterations() * 4 * N);
+}
+BENCHMARK(BM_SmallPtrSetInsertDuplicates)->Range(4, 1 << 14);
+
+static void BM_SmallPtrSetCount(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::vector<int> Storage(2 * N);
+  std::vector<int *> Ptrs = getPointers(Storage);
+  SmallPtrSet<int *, 8> Set;
+  for (unsigned I = 0; I < N; ++I)
+    Set.insert(Ptrs[2 * I]);
+  for (auto _ : State)
+    for (int *P : Ptrs)
+      benchmark::DoNotOptimize(Set.count(P));
+  State.SetItemsProcessed(State.iterations() * 2 * N);
+}
+BENCHMARK(BM_SmallPtrSetCount)->Range(4, 1 << 14);
+
+static void BM_SmallPtrSetErase(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::vector<int> Storage(N);
+  std::vector<int *> Ptrs = getPointers(Storage);
+  for (auto _ : State) {
+    SmallPtrSet<int *, 8> Set(Ptrs.begin(), Ptrs.end());
+    for (int *P : Ptrs)
+      Set.erase(P);
+    benchmark::DoNotOptimize(Set.size());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallPtrSetErase)->Range(4, 1 << 14);
+
+BENCHMARK_MAIN();
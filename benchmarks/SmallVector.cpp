@@ -0,0 +1,91 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallVector.h"
+#include <string>
+
+using namespace llvm;
+
+// Push N elements into a vector with 8 inline elements, so that small N stays
+// inline and large N exercises grow().
+static void BM_SmallVectorPushBackPOD(benchmark::State &State) {
+  unsigned N = State.range(0);
+  for (auto _ : State) {
+    SmallVector<unsigned, 8> V;
+    for (unsigned I = 0; I < N; ++I)
+      V.push_back(I);
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallVectorPushBackPOD)->Range(4, 1 << 14);
+
+static void BM_SmallVectorPushBackString(benchmark::State &State) {
+  unsigned N = State.range(0);
+  std::string S = "a string long enough to need the heap";
+  for (auto _ : State) {
+    SmallVector<std::string, 8> V;
+    for (unsigned I = 0; I < N; ++I)
+      V.push_back(S);
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallVectorPushBackString)->Range(4, 1 << 12);
+
+static void BM_SmallVectorAppendRange(benchmark::State &State) {
+  unsigned N = State.range(0);
+  SmallVector<unsigned, 0> Src(N, 42);
+  for (auto _ : State) {
+    SmallVector<unsigned, 8> V;
+    V.append(Src.begin(), Src.end());
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetBytesProcessed(State.iterations() * N * sizeof(unsigned));
+}
+BENCHMARK(BM_SmallVectorAppendRange)->Range(4, 1 << 14);
+
+static void BM_SmallVectorInsertFront(benchmark::State &State) {
+  unsigned N = State.range(0);
+  for (auto _ : State) {
+    SmallVector<unsigned, 8> V;
+    for (unsigned I = 0; I < N; ++I)
+      V.insert(V.begin(), I);
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallVectorInsertFront)->Range(4, 1 << 10);
+
+static void BM_SmallVectorCopy(benchmark::State &State) {
+  unsigned N = State.range(0);
+  SmallVector<unsigned, 8> Src(N, 42);
+  for (auto _ : State) {
+    SmallVector<unsigned, 8> V(Src);
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetBytesProcessed(State.iterations() * N * sizeof(unsigned));
+}
+BENCHMARK(BM_SmallVectorCopy)->Range(4, 1 << 14);
+
+// The worklist pattern: a vector reused across iterations after clear().
+static void BM_SmallVectorWorklist(benchmark::State &State) {
+  unsigned N = State.range(0);
+  SmallVector<unsigned, 16> Worklist;
+  for (auto _ : State) {
+    Worklist.clear();
+    Worklist.push_back(0);
+    unsigned Visited = 0;
+    while (!Worklist.empty()) {
+      unsigned I = Worklist.pop_back_val();
+      ++Visited;
+      if (2 * I + 1 < N)
+        Worklist.push_back(2 * I + 1);
+      if (2 * I + 2 < N)
+        Worklist.push_back(2 * I + 2);
+    }
+    benchmark::DoNotOptimize(Visited);
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallVectorWorklist)->Range(16, 1 << 14);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,63 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include <string>
+
+using namespace llvm;
+
+// An assembly-like buffer with short lines.
+static std::string getAsmText(size_t Size) {
+  std::string Text;
+  for (unsigned I = 0; Text.size() < Size; ++I)
+    Text += "\tmovq\t%rax, " + std::to_string(I % 512) + "(%rsp)\n";
+  return Text;
+}
+
+// The first lookup at the end of a buffer indexes all of it.
+static void BM_SourceMgrFirstLookupAtEnd(benchmark::State &State) {
+  std::string Text = getAsmText(State.range(0));
+  for (auto _ : State) {
+    SourceMgr SM;
+    unsigned ID = SM.AddNewSourceBuffer(
+        MemoryBuffer::getMemBuffer(Text, "", false), SMLoc());
+    const MemoryBuffer *Buf = SM.getMemoryBuffer(ID);
+    SMLoc Loc = SMLoc::getFromPointer(Buf->getBufferEnd() - 1);
+    benchmark::DoNotOptimize(SM.getLineAndColumn(Loc, ID));
+  }
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_SourceMgrFirstLookupAtEnd)->Range(1 << 12, 1 << 26);
+
+// A diagnostic near the start of a large buffer only indexes that far.
+static void BM_SourceMgrFirstLookupAtStart(benchmark::State &State) {
+  std::string Text = getAsmText(State.range(0));
+  for (auto _ : State) {
+    SourceMgr SM;
+    unsigned ID = SM.AddNewSourceBuffer(
+        MemoryBuffer::getMemBuffer(Text, "", false), SMLoc());
+    const MemoryBuffer *Buf = SM.getMemoryBuffer(ID);
+    SMLoc Loc = SMLoc::getFromPointer(Buf->getBufferStart() + 100);
+    benchmark::DoNotOptimize(SM.getLineAndColumn(Loc, ID));
+  }
+  State.SetItemsProcessed(State.iterations());
+}
+BENCHMARK(BM_SourceMgrFirstLookupAtStart)->Range(1 << 12, 1 << 26);
+
+// Lookups that move forward through the buffer, as when a parser reports
+// many diagnostics.
+static void BM_SourceMgrForwardLookups(benchmark::State &State) {
+  std::string Text = getAsmText(State.range(0));
+  for (auto _ : State) {
+    SourceMgr SM;
+    unsigned ID = SM.AddNewSourceBuffer(
+        MemoryBuffer::getMemBuffer(Text, "", false), SMLoc());
+    const char *Start = SM.getMemoryBuffer(ID)->getBufferStart();
+    for (size_t Off = 0; Off < Text.size(); Off += 997)
+      benchmark::DoNotOptimize(
+          SM.getLineAndColumn(SMLoc::getFromPointer(Start + Off), ID));
+  }
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_SourceMgrForwardLookups)->Range(1 << 12, 1 << 22);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SpecialCaseList.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// A sanitizer blacklist in the style of large projects: mostly wildcards over
+// mangled names and source paths, a few literals and a few regexes.
+static std::string getList(unsigned NumEntries) {
+  std::string List = "[address]\n";
+  for (unsigned I = 0; I != NumEntries; ++I) {
+    std::string N = std::to_string(I);
+    switch (I % 8) {
+    case 0:
+    case 1:
+      List += "fun:_ZN5chrome" + N + "*\n";
+      break;
+    case 2:
+      List += "fun:*Widget" + N + "*Paint*\n";
+      break;
+    case 3:
+      List += "src:*/third_party/lib" + N + "/*\n";
+      break;
+    case 4:
+      List += "src:*/gen/[a-z]*" + N + ".cc\n";
+      break;
+    case 5:
+      List += "fun:_ZN2v88internal" + N + "Heap\n";
+      break;
+    case 6:
+      List += "global:*kTable" + N + "\n";
+      break;
+    case 7:
+      if (I % 64 == 7)
+        List += "fun:_ZN(base|net)" + N + "Lock*\n";
+      else
+        List += "type:*Observer" + N + "*\n";
+      break;
+    }
+  }
+  return List;
+}
+
+static std::vector<std::string> getQueries() {
+  std::vector<std::string> Queries;
+  for (unsigned I = 0; I != 1000; ++I) {
+    std::string N = std::to_string(I * 7919 % 100000);
+    Queries.push_back("_ZN5blink" + N + "LayoutObject5PaintEv");
+    Queries.push_back("_ZN4base" + N + "internal8BindStateEv");
+  }
+  return Queries;
+}
+
+static void BM_SpecialCaseListNoMatch(benchmark::State &State) {
+  std::string List = getList(State.range(0));
+  std::string Error;
+  std::unique_ptr<SpecialCaseList> SCL = SpecialCaseList::create(
+      MemoryBuffer::getMemBuffer(List).get(), Error);
+  std::vector<std::string> Queries = getQueries();
+  for (auto _ : State)
+    for (const std::string &Query : Queries)
+      benchmark::DoNotOptimize(SCL->inSection("address", "fun", Query));
+  State.SetItemsProcessed(State.iterations() * Queries.size());
+}
+BENCHMARK(BM_SpecialCaseListNoMatch)->Range(1 << 6, 1 << 15);
+
+static void BM_SpecialCaseListMatch(benchmark::State &State) {
+  std::string List = getList(State.range(0));
+  std::string Error;
+  std::unique_ptr<SpecialCaseList> SCL = SpecialCaseList::create(
+      MemoryBuffer::getMemBuffer(List).get(), Error);
+  std::vector<std::string> Queries;
+  for (unsigned I = 0; I < State.range(0); I += 8)
+    Queries.push_back("_ZN5chrome" + std::to_string(I) + "Browser4InitEv");
+  for (auto _ : State)
+    for (const std::string &Query : Queries)
+      benchmark::DoNotOptimize(SCL->inSection("address", "fun", Query));
+  State.SetItemsProcessed(State.iterations() * Queries.size());
+}
+BENCHMARK(BM_SpecialCaseListMatch)->Range(1 << 6, 1 << 15);
+
+static void BM_SpecialCaseListCreate(benchmark::State &State) {
+  std::string List = getList(State.range(0));
+  for (auto _ : State) {
+    std::string Error;
+    benchmark::DoNotOptimize(SpecialCaseList::create(
+        MemoryBuffer::getMemBuffer(List).get(), Error));
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_SpecialCaseListCreate)->Range(1 << 6, 1 << 15);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,105 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/StringSaver.h"
+#include "llvm/Support/xxhash.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Mangled names in the style of a large C++ symbol table. The second half is
+// never inserted and is used for misses.
+static std::vector<StringRef> getSymbolNames(unsigned N, StringSaver &Saver) {
+  std::vector<StringRef> Names;
+  for (unsigned I = 0; I < 2 * N; ++I)
+    Names.push_back(Saver.save("_ZN4llvm" + std::to_string(I % 97) +
+                               "DetailEN" + std::to_string(I) +
+                               "12_GLOBAL__N_18getValueEv"));
+  return Names;
+}
+
+static void BM_HashDJB(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  StringSaver Saver(Alloc);
+  std::vector<StringRef> Names = getSymbolNames(1024, Saver);
+  for (auto _ : State)
+    for (StringRef Name : Names)
+      benchmark::DoNotOptimize(djbHash(Name, 0));
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_HashDJB);
+
+static void BM_HashXX64(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  StringSaver Saver(Alloc);
+  std::vector<StringRef> Names = getSymbolNames(1024, Saver);
+  for (auto _ : State)
+    for (StringRef Name : Names)
+      benchmark::DoNotOptimize(xxHash64(Name));
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_HashXX64);
+
+static void BM_StringMapInsert(benchmark::State &State) {
+  unsigned N = State.range(0);
+  BumpPtrAllocator Alloc;
+  StringSaver Saver(Alloc);
+  std::vector<StringRef> Names = getSymbolNames(N, Saver);
+  for (auto _ : State) {
+    StringMap<unsigned> Map;
+    for (unsigned I = 0; I < N; ++I)
+      Map[Names[I]] = I;
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_StringMapInsert)->Range(1 << 10, 1 << 17);
+
+static void lookup(benchmark::State &State, bool Hit, bool Precomputed) {
+  unsigned N = State.range(0);
+  BumpPtrAllocator Alloc;
+  StringSaver Saver(Alloc);
+  std::vector<StringRef> Names = getSymbolNames(N, Saver);
+  StringMap<unsigned> Map;
+  for (unsigned I = 0; I < N; ++I)
+    Map[Names[I]] = I;
+
+  std::vector<StringRef> Keys(Names.begin() + (Hit ? 0 : N),
+                              Names.begin() + (Hit ? N : 2 * N));
+  std::shuffle(Keys.begin(), Keys.end(), std::mt19937(0));
+  std::vector<uint32_t> Hashes;
+  for (StringRef Key : Keys)
+    Hashes.push_back(StringMapImpl::hash(Key));
+
+  for (auto _ : State) {
+    if (Precomputed) {
+      for (unsigned I = 0; I < N; ++I)
+        benchmark::DoNotOptimize(Map.find(Keys[I], Hashes[I]));
+    } else {
+      for (StringRef Key : Keys)
+        benchmark::DoNotOptimize(Map.find(Key));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+
+static void BM_StringMapLookupHit(benchmark::State &State) {
+  lookup(State, true, false);
+}
+BENCHMARK(BM_StringMapLookupHit)->Range(1 << 10, 1 << 17);
+
+static void BM_StringMapLookupMiss(benchmark::State &State) {
+  lookup(State, false, false);
+}
+BENCHMARK(BM_StringMapLookupMiss)->Range(1 << 10, 1 << 17);
+
+static void BM_StringMapLookupPrecomputedHash(benchmark::State &State) {
+  lookup(State, true, true);
+}
+BENCHMARK(BM_StringMapLookupPrecomputedHash)->Range(1 << 10, 1 << 17);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,129 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/SwissTableMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/StringSaver.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Key distributions seen in LLVM's hot maps.
+
+// Value numbers and other dense IDs.
+struct DenseIDKeys {
+  std::vector<unsigned> Keys;
+  explicit DenseIDKeys(unsigned N) {
+    for (unsigned I = 0; I < 2 * N; ++I)
+      Keys.push_back(I);
+  }
+};
+
+// Pointers to IR objects, which are allocated one after the other and
+// therefore share their high bits and low alignment bits.
+struct PointerKeys {
+  BumpPtrAllocator Alloc;
+  std::vector<void *> Keys;
+  explicit PointerKeys(unsigned N) {
+    for (unsigned I = 0; I < 2 * N; ++I)
+      Keys.push_back(Alloc.Allocate(72, 8));
+  }
+};
+
+// Symbol names.
+struct StringKeys {
+  BumpPtrAllocator Alloc;
+  StringSaver Saver{Alloc};
+  std::vector<StringRef> Keys;
+  explicit StringKeys(unsigned N) {
+    for (unsigned I = 0; I < 2 * N; ++I)
+      Keys.push_back(Saver.save("_ZN4llvm12_GLOBAL__N_1" + std::to_string(I) +
+                                "EPNS_5ValueE"));
+  }
+};
+
+// The first half of the keys is inserted, the second half is used for misses.
+// Lookups are shuffled so that they do not follow the insertion order.
+template <typename MapT, typename KeysT>
+static void BM_Lookup(benchmark::State &State, bool Hit) {
+  unsigned N = State.range(0);
+  KeysT K(N);
+  MapT M;
+  for (unsigned I = 0; I < N; ++I)
+    M[K.Keys[I]] = I;
+  std::vector<unsigned> Order(N);
+  for (unsigned I = 0; I < N; ++I)
+    Order[I] = Hit ? I : N + I;
+  std::shuffle(Order.begin(), Order.end(), std::mt19937(0));
+
+  for (auto _ : State)
+    for (unsigned I : Order)
+      benchmark::DoNotOptimize(M.find(K.Keys[I]));
+  State.SetItemsProcessed(State.iterations() * N);
+}
+
+template <typename MapT, typename KeysT>
+static void BM_LookupHit(benchmark::State &State) {
+  BM_Lookup<MapT, KeysT>(State, true);
+}
+
+template <typename MapT, typename KeysT>
+static void BM_LookupMiss(benchmark::State &State) {
+  BM_Lookup<MapT, KeysT>(State, false);
+}
+
+template <typename MapT, typename KeysT>
+static void BM_Insert(benchmark::State &State) {
+  unsigned N = State.range(0);
+  KeysT K(N);
+  for (auto _ : State) {
+    MapT M;
+    for (unsigned I = 0; I < N; ++I)
+      M[K.Keys[I]] = I;
+    benchmark::DoNotOptimize(M.size());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+
+template <typename MapT, typename KeysT>
+static void BM_InsertErase(benchmark::State &State) {
+  unsigned N = State.range(0);
+  KeysT K(N);
+  MapT M;
+  for (unsigned I = 0; I < N; ++I)
+    M[K.Keys[I]] = I;
+  for (auto _ : State) {
+    for (unsigned I = 0; I < N; ++I)
+      M.erase(K.Keys[I]);
+    for (unsigned I = 0; I < N; ++I)
+      M[K.Keys[I]] = I;
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+
+#define MAP_BENCHMARKS(KEYS, KEYT)                                             \
+  BENCHMARK_TEMPLATE(BM_LookupHit, DenseMap<KEYT, unsigned>, KEYS)             \
+      ->Range(1 << 10, 1 << 20);                                               \
+  BENCHMARK_TEMPLATE(BM_LookupHit, SwissTableMap<KEYT, unsigned>, KEYS)        \
+      ->Range(1 << 10, 1 << 20);                                               \
+  BENCHMARK_TEMPLATE(BM_LookupMiss, DenseMap<KEYT, unsigned>, KEYS)            \
+      ->Range(1 << 10, 1 << 20);                                               \
+  BENCHMARK_TEMPLATE(BM_LookupMiss, SwissTableMap<KEYT, unsigned>, KEYS)       \
+      ->Range(1 << 10, 1 << 20);                                               \
+  BENCHMARK_TEMPLATE(BM_Insert, DenseMap<KEYT, unsigned>, KEYS)                \
+      ->Range(1 << 10, 1 << 20);                                               \
+  BENCHMARK_TEMPLATE(BM_Insert, SwissTableMap<KEYT, unsigned>, KEYS)           \
+      ->Range(1 << 10, 1 << 20);                                               \
+  BENCHMARK_TEMPLATE(BM_InsertErase, DenseMap<KEYT, unsigned>, KEYS)           \
+      ->Range(1 << 10, 1 << 16);                                               \
+  BENCHMARK_TEMPLATE(BM_InsertErase, SwissTableMap<KEYT, unsigned>, KEYS)      \
+      ->Range(1 << 10, 1 << 16);
+
+MAP_BENCHMARKS(DenseIDKeys, unsigned)
+MAP_BENCHMARKS(PointerKeys, void *)
+MAP_BENCHMARKS(StringKeys, StringRef)
+
+BENCHMARK_MAIN();
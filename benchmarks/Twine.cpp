@@ -0,0 +1,66 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Twine.h"
+#include <string>
+
+using namespace llvm;
+
+static void BM_TwineStr(benchmark::State &State) {
+  std::string Prefix = "llvm.";
+  StringRef Name = "memcpy";
+  for (auto _ : State)
+    for (unsigned I = 0; I < 256; ++I)
+      benchmark::DoNotOptimize((Prefix + Name + ".p0i8.i" + Twine(I)).str());
+  State.SetItemsProcessed(State.iterations() * 256);
+}
+BENCHMARK(BM_TwineStr);
+
+static void BM_TwineToVector(benchmark::State &State) {
+  std::string Prefix = "llvm.";
+  StringRef Name = "memcpy";
+  SmallString<64> Buffer;
+  for (auto _ : State)
+    for (unsigned I = 0; I < 256; ++I) {
+      Buffer.clear();
+      (Prefix + Name + ".p0i8.i" + Twine(I)).toVector(Buffer);
+      benchmark::DoNotOptimize(Buffer.data());
+    }
+  State.SetItemsProcessed(State.iterations() * 256);
+}
+BENCHMARK(BM_TwineToVector);
+
+// A single StringRef leaf is returned without copying.
+static void BM_TwineToStringRefSingle(benchmark::State &State) {
+  StringRef Name = "a.value.name";
+  SmallString<64> Buffer;
+  for (auto _ : State)
+    for (unsigned I = 0; I < 256; ++I)
+      benchmark::DoNotOptimize(Twine(Name).toStringRef(Buffer));
+  State.SetItemsProcessed(State.iterations() * 256);
+}
+BENCHMARK(BM_TwineToStringRefSingle);
+
+static void BM_TwineToStringRefConcat(benchmark::State &State) {
+  StringRef Name = "a.value.name";
+  SmallString<64> Buffer;
+  for (auto _ : State)
+    for (unsigned I = 0; I < 256; ++I) {
+      Buffer.clear();
+      benchmark::DoNotOptimize((Name + "." + Twine(I)).toStringRef(Buffer));
+    }
+  State.SetItemsProcessed(State.iterations() * 256);
+}
+BENCHMARK(BM_TwineToStringRefConcat);
+
+// The same concatenation with std::string, for comparison.
+static void BM_StdStringConcat(benchmark::State &State) {
+  std::string Prefix = "llvm.";
+  std::string Name = "memcpy";
+  for (auto _ : State)
+    for (unsigned I = 0; I < 256; ++I)
+      benchmark::DoNotOptimize(Prefix + Name + ".p0i8.i" + std::to_string(I));
+  State.SetItemsProcessed(State.iterations() * 256);
+}
+BENCHMARK(BM_StdStringConcat);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,232 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Mirrors of the optimization remark and ELF YAML formats, which can't be
+// used directly here as they live outside of Support.
+namespace {
+struct DebugLoc {
+  StringRef File;
+  unsigned Line, Column;
+};
+
+struct RemarkArg {
+  StringRef Key, Value;
+  Optional<DebugLoc> Loc;
+};
+
+struct Remark {
+  std::string Kind;
+  StringRef Pass, Name, Function;
+  Optional<DebugLoc> Loc;
+  Optional<unsigned> Hotness;
+  std::vector<RemarkArg> Args;
+};
+
+enum SectionType { SHT_NULL, SHT_PROGBITS, SHT_SYMTAB, SHT_NOBITS };
+enum SectionFlags { SHF_WRITE = 1, SHF_ALLOC = 2, SHF_EXECINSTR = 4 };
+
+struct Section {
+  StringRef Name;
+  SectionType Type = SHT_NULL;
+  SectionFlags Flags = SectionFlags(0);
+  yaml::Hex64 Address, AddressAlign;
+  StringRef Content;
+};
+
+struct Symbol {
+  StringRef Name, Section;
+  yaml::Hex64 Value, Size;
+  bool Global = false;
+};
+
+struct Object {
+  StringRef Class, Data, Type, Machine;
+  std::vector<Section> Sections;
+  std::vector<Symbol> Symbols;
+};
+} // namespace
+
+LLVM_YAML_IS_DOCUMENT_LIST_VECTOR(Remark)
+LLVM_YAML_IS_SEQUENCE_VECTOR(RemarkArg)
+LLVM_YAML_IS_SEQUENCE_VECTOR(Section)
+LLVM_YAML_IS_SEQUENCE_VECTOR(Symbol)
+
+namespace llvm {
+namespace yaml {
+template <> struct MappingTraits<DebugLoc> {
+  static void mapping(IO &IO, DebugLoc &L) {
+    IO.mapRequired("File", L.File);
+    IO.mapRequired("Line", L.Line);
+    IO.mapRequired("Column", L.Column);
+  }
+  static const bool flow = true;
+};
+
+template <> struct MappingTraits<RemarkArg> {
+  static void mapping(IO &IO, RemarkArg &A) {
+    if (IO.outputting()) {
+      IO.mapRequired(A.Key.str().c_str(), A.Value);
+    } else {
+      for (StringRef Key : IO.keys())
+        if (Key != "DebugLoc") {
+          A.Key = Key;
+          IO.mapRequired(Key.str().c_str(), A.Value);
+        }
+    }
+    IO.mapOptional("DebugLoc", A.Loc);
+  }
+};
+
+template <> struct MappingTraits<Remark> {
+  static void mapping(IO &IO, Remark &R) {
+    for (const char *Kind : {"!Passed", "!Missed", "!Analysis"})
+      if (IO.mapTag(Kind, R.Kind == Kind))
+        R.Kind = Kind;
+    IO.mapRequired("Pass", R.Pass);
+    IO.mapRequired("Name", R.Name);
+    IO.mapOptional("DebugLoc", R.Loc);
+    IO.mapRequired("Function", R.Function);
+    IO.mapOptional("Hotness", R.Hotness);
+    IO.mapOptional("Args", R.Args);
+  }
+};
+
+template <> struct ScalarEnumerationTraits<SectionType> {
+  static void enumeration(IO &IO, SectionType &T) {
+    IO.enumCase(T, "SHT_NULL", SHT_NULL);
+    IO.enumCase(T, "SHT_PROGBITS", SHT_PROGBITS);
+    IO.enumCase(T, "SHT_SYMTAB", SHT_SYMTAB);
+    IO.enumCase(T, "SHT_NOBITS", SHT_NOBITS);
+  }
+};
+
+template <> struct ScalarBitSetTraits<SectionFlags> {
+  static void bitset(IO &IO, SectionFlags &F) {
+    IO.bitSetCase(F, "SHF_WRITE", SHF_WRITE);
+    IO.bitSetCase(F, "SHF_ALLOC", SHF_ALLOC);
+    IO.bitSetCase(F, "SHF_EXECINSTR", SHF_EXECINSTR);
+  }
+};
+
+template <> struct MappingTraits<Section> {
+  static void mapping(IO &IO, Section &S) {
+    IO.mapRequired("Name", S.Name);
+    IO.mapRequired("Type", S.Type);
+    IO.mapOptional("Flags", S.Flags, SectionFlags(0));
+    IO.mapOptional("Address", S.Address, Hex64(0));
+    IO.mapOptional("AddressAlign", S.AddressAlign, Hex64(0));
+    IO.mapOptional("Content", S.Content);
+  }
+};
+
+template <> struct MappingTraits<Symbol> {
+  static void mapping(IO &IO, Symbol &S) {
+    IO.mapRequired("Name", S.Name);
+    IO.mapOptional("Section", S.Section);
+    IO.mapOptional("Value", S.Value, Hex64(0));
+    IO.mapOptional("Size", S.Size, Hex64(0));
+    IO.mapOptional("Global", S.Global, false);
+  }
+};
+
+template <> struct MappingTraits<Object> {
+  static void mapping(IO &IO, Object &O) {
+    IO.mapRequired("Class", O.Class);
+    IO.mapRequired("Data", O.Data);
+    IO.mapRequired("Type", O.Type);
+    IO.mapRequired("Machine", O.Machine);
+    IO.mapOptional("Sections", O.Sections);
+    IO.mapOptional("Symbols", O.Symbols);
+  }
+};
+} // namespace yaml
+} // namespace llvm
+
+static std::string getRemarks(unsigned NumRemarks) {
+  std::vector<std::string> Names;
+  for (unsigned I = 0; I != NumRemarks; ++I)
+    Names.push_back("_Z8functionILi" + std::to_string(I) + "EEvv");
+  std::vector<Remark> Remarks(NumRemarks);
+  for (unsigned I = 0; I != NumRemarks; ++I) {
+    Remark &R = Remarks[I];
+    R.Kind = I % 3 ? "!Missed" : "!Passed";
+    R.Pass = "inline";
+    R.Name = I % 3 ? "NoDefinition" : "Inlined";
+    R.Loc = DebugLoc{"lib/Support/YAMLTraits.cpp", I, 12};
+    R.Function = Names[I];
+    R.Hotness = I;
+    R.Args.push_back({"Callee", Names[(I * 7) % NumRemarks], None});
+    R.Args.back().Loc = DebugLoc{"include/llvm/Support/YAMLTraits.h", I, 3};
+    R.Args.push_back({"String", " will not be inlined into ", None});
+    R.Args.push_back({"Caller", Names[I], None});
+  }
+  std::string S;
+  raw_string_ostream OS(S);
+  yaml::Output YOut(OS);
+  YOut << Remarks;
+  return OS.str();
+}
+
+static std::string getObject(unsigned NumSymbols) {
+  Object O;
+  O.Class = "ELFCLASS64";
+  O.Data = "ELFDATA2LSB";
+  O.Type = "ET_REL";
+  O.Machine = "EM_X86_64";
+  std::vector<std::string> Names;
+  for (unsigned I = 0; I != NumSymbols; ++I)
+    Names.push_back(".text._Z8functionILi" + std::to_string(I) + "EEvv");
+  for (unsigned I = 0; I != NumSymbols; ++I) {
+    Section S;
+    S.Name = Names[I];
+    S.Type = SHT_PROGBITS;
+    S.Flags = SectionFlags(SHF_ALLOC | SHF_EXECINSTR);
+    S.AddressAlign = 16;
+    S.Content = "554889E5C745FC000000005DC3";
+    O.Sections.push_back(S);
+    Symbol Sym;
+    Sym.Name = StringRef(Names[I]).drop_front(6);
+    Sym.Section = Names[I];
+    Sym.Size = 13;
+    Sym.Global = true;
+    O.Symbols.push_back(Sym);
+  }
+  std::string S;
+  raw_string_ostream OS(S);
+  yaml::Output YOut(OS);
+  YOut << O;
+  return OS.str();
+}
+
+static void BM_YAMLReadRemarks(benchmark::State &State) {
+  std::string Text = getRemarks(State.range(0));
+  for (auto _ : State) {
+    std::vector<Remark> Remarks;
+    yaml::Input YIn(Text);
+    YIn >> Remarks;
+    if (YIn.error() || Remarks.size() != size_t(State.range(0)))
+      State.SkipWithError("failed to read remarks");
+  }
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_YAMLReadRemarks)->Range(1 << 6, 1 << 14);
+
+static void BM_YAMLReadObject(benchmark::State &State) {
+  std::string Text = getObject(State.range(0));
+  for (auto _ : State) {
+    Object O;
+    yaml::Input YIn(Text);
+    YIn >> O;
+    if (YIn.error() || O.Symbols.size() != size_t(State.range(0)))
+      State.SkipWithError("failed to read object");
+  }
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_YAMLReadObject)->Range(1 << 6, 1 << 14);
+
+BENCHMARK_MAIN();
@@ -27,8 +27,12 @@
 
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 // Determine whether statistics should be enabled. We must do it here rather
@@ -40,19 +44,46 @@
 
 namespace llvm {
 
+class Error;
 class raw_ostream;
 class raw_fd_ostream;
 class StringRef;
+template <typename T> class ArrayRef;
+
+namespace detail {
+
+/// Returns the slot \p Index of the calling thread. Each thread has slots of
+/// its own for every statistic, which only it writes to, so that counting
+/// does not bounce cache lines between threads.
+std::atomic<uint64_t> &getStatisticSlot(unsigned Index);
+
+/// Adds \p Delta to the slot \p Index of the calling thread.
+inline void addToStatisticSlot(unsigned Index, uint64_t Delta) {
+  std::atomic<uint64_t> &Slot = getStatisticSlot(Index);
+  // Only the calling thread writes to its slots, so there is no need for an
+  // atomic read-modify-write.
+  Slot.store(Slot.load(std::memory_order_relaxed) + Delta,
+             std::memory_order_relaxed);
+}
+
+} // end namespace detail
 
 class Statistic {
 public:
   const char *DebugType;
   const char *Name;
   const char *Desc;
-  std::atomic<unsigned> Value;
+  /// The part of the value that is not in the per-thread slots, which is
+  /// where assignments and updateMax() put their results.
+  std::atomic<uint64_t> Value;
   std::atomic<bool> Initialized;
+  /// Whether the statistic tracks a maximum, which is merged across stats
+  /// files by taking the largest value rather than the sum.
+  std::atomic<bool> IsMaximum;
+  /// The per-thread slots of the statistic, assigned when it is registered.
+  unsigned SlotIndex;
 
-  unsigned getValue() const { return Value.load(std::memory_order_relaxed); }
+  uint64_t getValue() const;
   const char *getDebugType() const { return DebugType; }
   const char *getName() const { return Name; }
   const char *getDesc() const { return Desc; }
@@ -64,64 +95,51 @@ public:
     Desc = desc;
     Value = 0;
     Initialized = false;
+    IsMaximum = false;
+    SlotIndex = 0;
   }
 
   // Allow use of this class as the value itself.
-  operator unsigned() const { return getValue(); }
+  operator uint64_t() const { return getValue(); }
 
 #if LLVM_ENABLE_STATS
-   const Statistic &operator=(unsigned Val) {
-    Value.store(Val, std::memory_order_relaxed);
-    return init();
-  }
+  const Statistic &operator=(uint64_t Val);
 
   const Statistic &operator++() {
-    Value.fetch_add(1, std::memory_order_relaxed);
-    return init();
+    detail::addToStatisticSlot(init().SlotIndex, 1);
+    return *this;
   }
 
-  unsigned operator++(int) {
-    init();
-    return Value.fetch_add(1, std::memory_order_relaxed);
-  }
+  // The previous value is not returned, as it is the sum of the slots of all
+  // threads.
+  void operator++(int) { ++*this; }
 
   const Statistic &operator--() {
-    Value.fetch_sub(1, std::memory_order_relaxed);
-    return init();
+    detail::addToStatisticSlot(init().SlotIndex, uint64_t(-1));
+    return *this;
   }
 
-  unsigned operator--(int) {
-    init();
-    return Value.fetch_sub(1, std::memory_order_relaxed);
-  }
+  void operator--(int) { --*this; }
 
-  const Statistic &operator+=(unsigned V) {
+  const Statistic &operator+=(uint64_t V) {
     if (V == 0)
       return *this;
-    Value.fetch_add(V, std::memory_order_relaxed);
-    return init();
+    detail::addToStatisticSlot(init().SlotIndex, V);
+    return *this;
   }
 
-  const Statistic &operator-=(unsigned V) {
+  const Statistic &operator-=(uint64_t V) {
     if (V == 0)
       return *this;
-    Value.fetch_sub(V, std::memory_order_relaxed);
-    return init();
+    detail::addToStatisticSlot(init().SlotIndex, -V);
+    return *this;
   }
 
-  void updateMax(unsigned V) {
-    unsigned PrevMax = Value.load(std::memory_order_relaxed);
-    // Keep trying to update max until we succeed or another thread produces
-    // a bigger max than us.
-    while (V > PrevMax && !Value.compare_exchange_weak(
-                              PrevMax, V, std::memory_order_relaxed)) {
-    }
-    init();
-  }
+  void updateMax(uint64_t V);
 
 #else  // Statistics are disabled in release builds.
 
-  const Statistic &operator=(unsigned Val) {
+  const Statistic &operator=(uint64_t Val) {
     return *this;
   }
 
@@ -129,27 +147,23 @@ public:
     return *this;
   }
 
-  unsigned operator++(int) {
-    return 0;
-  }
+  void operator++(int) {}
 
   const Statistic &operator--() {
     return *this;
   }
 
-  unsigned operator--(int) {
-    return 0;
-  }
+  void operator--(int) {}
 
-  const Statistic &operator+=(const unsigned &V) {
+  const Statistic &operator+=(const uint64_t &V) {
     return *this;
   }
 
-  const Statistic &operator-=(const unsigned &V) {
+  const Statistic &operator-=(const uint64_t &V) {
     return *this;
   }
 
-  void updateMax(unsigned V) {}
+  void updateMax(uint64_t V) {}
 
 #endif  // LLVM_ENABLE_STATS
 
@@ -166,7 +180,81 @@ protected:
 // STATISTIC - A macro to make definition of statistics really simple.  This
 // automatically passes the DEBUG_TYPE of the file into the statistic.
 #define STATISTIC(VARNAME, DESC)                                               \
-  static llvm::Statistic VARNAME = {DEBUG_TYPE, #VARNAME, DESC, {0}, {false}}
+  static llvm::Statistic VARNAME = {DEBUG_TYPE, #VARNAME, DESC, {0},           \
+                                    {false},    {false},  0}
+
+/// A statistic that records the distribution of values, such as sizes or
+/// times, rather than counting. Values are counted in buckets of powers of
+/// two: bucket 0 counts zeros and bucket I the values in [2^(I-1), 2^I).
+class HistogramStatistic {
+public:
+  static const unsigned NumBuckets = 65;
+
+  const char *DebugType;
+  const char *Name;
+  const char *Desc;
+  std::atomic<bool> Initialized;
+  /// The per-thread slots of the buckets, followed by the slot of the sum.
+  unsigned SlotIndex;
+
+  const char *getDebugType() const { return DebugType; }
+  const char *getName() const { return Name; }
+  const char *getDesc() const { return Desc; }
+
+  static unsigned getBucket(uint64_t V) {
+    return V ? 64 - countLeadingZeros(V) : 0;
+  }
+
+  uint64_t getBucketCount(unsigned Bucket) const;
+  uint64_t getCount() const;
+  uint64_t getSum() const;
+
+#if LLVM_ENABLE_STATS
+  void record(uint64_t V) {
+    unsigned Index = init().SlotIndex;
+    detail::addToStatisticSlot(Index + getBucket(V), 1);
+    detail::addToStatisticSlot(Index + NumBuckets, V);
+  }
+#else
+  void record(uint64_t V) {}
+#endif
+
+protected:
+  HistogramStatistic &init() {
+    if (!Initialized.load(std::memory_order_acquire))
+      RegisterStatistic();
+    return *this;
+  }
+
+  void RegisterStatistic();
+};
+
+#define STATISTIC_HISTOGRAM(VARNAME, DESC)                                     \
+  static llvm::HistogramStatistic VARNAME = {DEBUG_TYPE, #VARNAME, DESC,       \
+                                             {false}, 0}
+
+/// Records the time spent in its scope, in nanoseconds, into a histogram.
+class StatisticTimerScope {
+#if LLVM_ENABLE_STATS
+  HistogramStatistic &Histogram;
+  std::chrono::steady_clock::time_point Start;
+
+public:
+  explicit StatisticTimerScope(HistogramStatistic &Histogram)
+      : Histogram(Histogram), Start(std::chrono::steady_clock::now()) {}
+  ~StatisticTimerScope() {
+    Histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - Start)
+                         .count());
+  }
+#else
+public:
+  explicit StatisticTimerScope(HistogramStatistic &) {}
+#endif
+
+  StatisticTimerScope(const StatisticTimerScope &) = delete;
+  StatisticTimerScope &operator=(const StatisticTimerScope &) = delete;
+};
 
 /// Enable the collection and printing of statistics.
 void EnableStatistics(bool PrintOnExit = true);
@@ -196,7 +284,7 @@ void PrintStatisticsJSON(raw_ostream &OS);
 /// during it's execution. It will return the value at the point that it is
 /// read. However, it will prevent new statistics from registering until it
 /// completes.
-const std::vector<std::pair<StringRef, unsigned>> GetStatistics();
+const std::vector<std::pair<StringRef, uint64_t>> GetStatistics();
 
 /// Reset the statistics. This can be used to zero and de-register the
 /// statistics in order to measure a compilation.
@@ -213,6 +301,30 @@ const std::vector<std::pair<StringRef, unsigned>> GetStatistics();
 /// GetStatistics().
 void ResetStatistics();
 
+/// Add the statistics of this process to the stats file \p Path, creating it
+/// if needed. Many processes may merge into the same file at once.
+///
+/// A stats file is a JSON object meant to be read by tools, which stays valid
+/// as statistics come and go:
+/// \code
+///   {
+///     "version": 1,
+///     "invocations": 2,
+///     "counters": { "debugtype.name": 12, ... },
+///     "maxima": { "debugtype.name": 3, ... },
+///     "histograms": {
+///       "debugtype.name": { "count": 5, "sum": 80, "buckets": [0, 1, ...] },
+///       ...
+///     }
+///   }
+/// \endcode
+/// Merging adds up the counters, histograms and invocations, and takes the
+/// largest of the maxima.
+Error MergeStatisticsIntoFile(StringRef Path);
+
+/// Merge the stats files \p Inputs and write the result to \p OS.
+Error MergeStatisticsFiles(ArrayRef<std::string> Inputs, raw_ostream &OS);
+
 } // end namespace llvm
 
 #endif // LLVM_ADT_STATISTIC_H
@@ -0,0 +1,695 @@
+//===- llvm/ADT/SwissTableMap.h - Group probed hash table -------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the SwissTableMap class, an open addressing hash table
+// that keeps one control byte per bucket and probes groups of control bytes
+// at a time.
+//
+// The interface mirrors DenseMap and uses the same DenseMapInfo traits, so
+// hot code paths that do many lookups in large maps can switch to it by
+// changing the type. Only getHashValue() and isEqual() are used: the empty and
+// tombstone keys are not needed, since bucket state lives in the control
+// bytes.
+//
+// Every control byte is either empty, deleted, or holds 7 bits of the hash of
+// the key in its bucket. A lookup loads a group of 16 control bytes and
+// compares them all against the key's hash bits at once (with SSE2 or NEON
+// when available), and only touches the buckets that match. Most lookups
+// therefore read a single cache line of control bytes plus the bucket that
+// holds the key, whereas DenseMap compares full keys on every probe.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_SWISSTABLEMAP_H
+#define LLVM_ADT_SWISSTABLEMAP_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/EpochTracker.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/type_traits.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LLVM_SWISSTABLE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define LLVM_SWISSTABLE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace llvm {
+
+namespace detail {
+
+/// Control byte values. Full buckets hold a value in [0, 127].
+enum : int8_t { SwissEmpty = -128, SwissDeleted = -2 };
+
+/// A group of control bytes that is matched as a unit. Match results are bit
+/// masks with bit I set if the I-th control byte of the group matched.
+class SwissGroup {
+public:
+  static constexpr unsigned Width = 16;
+
+  explicit SwissGroup(const int8_t *Pos) {
+#if defined(LLVM_SWISSTABLE_SSE2)
+    Ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Pos));
+#elif defined(LLVM_SWISSTABLE_NEON)
+    Ctrl = vld1q_s8(Pos);
+#else
+    Ctrl = Pos;
+#endif
+  }
+
+  /// Returns the buckets whose control byte is \p Tag.
+  uint32_t match(int8_t Tag) const {
+#if defined(LLVM_SWISSTABLE_SSE2)
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(Tag), Ctrl));
+#elif defined(LLVM_SWISSTABLE_NEON)
+    return toMask(vceqq_s8(vdupq_n_s8(Tag), Ctrl));
+#else
+    uint32_t Mask = 0;
+    for (unsigned I = 0; I != Width; ++I)
+      Mask |= uint32_t(Ctrl[I] == Tag) << I;
+    return Mask;
+#endif
+  }
+
+  /// Returns the empty buckets.
+  uint32_t matchEmpty() const { return match(SwissEmpty); }
+
+  /// Returns the buckets that are empty or deleted.
+  uint32_t matchEmptyOrDeleted() const {
+#if defined(LLVM_SWISSTABLE_SSE2)
+    return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), Ctrl));
+#elif defined(LLVM_SWISSTABLE_NEON)
+    return toMask(vcltq_s8(Ctrl, vdupq_n_s8(-1)));
+#else
+    uint32_t Mask = 0;
+    for (unsigned I = 0; I != Width; ++I)
+      Mask |= uint32_t(Ctrl[I] < -1) << I;
+    return Mask;
+#endif
+  }
+
+private:
+#if defined(LLVM_SWISSTABLE_SSE2)
+  __m128i Ctrl;
+#elif defined(LLVM_SWISSTABLE_NEON)
+  int8x16_t Ctrl;
+
+  /// Compress a vector of all-ones/all-zeros bytes to one bit per byte.
+  static uint32_t toMask(uint8x16_t Cmp) {
+    static const uint8_t Bits[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                     1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t Masked = vandq_u8(Cmp, vld1q_u8(Bits));
+    return uint32_t(vaddv_u8(vget_low_u8(Masked))) |
+           (uint32_t(vaddv_u8(vget_high_u8(Masked))) << 8);
+  }
+#else
+  const int8_t *Ctrl;
+#endif
+};
+
+} // end namespace detail
+
+template <typename KeyT, typename ValueT,
+          typename KeyInfoT = DenseMapInfo<KeyT>,
+          typename Bucket = llvm::detail::DenseMapPair<KeyT, ValueT>,
+          bool IsConst = false>
+class SwissTableMapIterator;
+
+template <typename KeyT, typename ValueT,
+          typename KeyInfoT = DenseMapInfo<KeyT>,
+          typename BucketT = llvm::detail::DenseMapPair<KeyT, ValueT>>
+class SwissTableMap : public DebugEpochBase {
+  template <typename T>
+  using const_arg_type_t = typename const_pointer_or_const_ref<T>::type;
+
+  using Group = detail::SwissGroup;
+
+public:
+  using size_type = unsigned;
+  using key_type = KeyT;
+  using mapped_type = ValueT;
+  using value_type = BucketT;
+
+  using iterator = SwissTableMapIterator<KeyT, ValueT, KeyInfoT, BucketT>;
+  using const_iterator =
+      SwissTableMapIterator<KeyT, ValueT, KeyInfoT, BucketT, true>;
+
+  /// Create a SwissTableMap with an optional \p InitialReserve that guarantee
+  /// that this number of elements can be inserted in the map without grow()
+  explicit SwissTableMap(unsigned InitialReserve = 0) {
+    if (InitialReserve)
+      grow(getMinBucketToReserveForEntries(InitialReserve));
+  }
+
+  SwissTableMap(const SwissTableMap &Other) : SwissTableMap() {
+    copyFrom(Other);
+  }
+
+  SwissTableMap(SwissTableMap &&Other) : SwissTableMap() { swap(Other); }
+
+  template <typename InputIt> SwissTableMap(const InputIt &I, const InputIt &E) {
+    grow(getMinBucketToReserveForEntries(std::distance(I, E)));
+    insert(I, E);
+  }
+
+  SwissTableMap(std::initializer_list<value_type> Vals) {
+    grow(getMinBucketToReserveForEntries(Vals.size()));
+    insert(Vals.begin(), Vals.end());
+  }
+
+  ~SwissTableMap() {
+    destroyAll();
+    deallocateBuckets();
+  }
+
+  SwissTableMap &operator=(const SwissTableMap &Other) {
+    if (&Other != this)
+      copyFrom(Other);
+    return *this;
+  }
+
+  SwissTableMap &operator=(SwissTableMap &&Other) {
+    destroyAll();
+    deallocateBuckets();
+    init();
+    swap(Other);
+    return *this;
+  }
+
+  void swap(SwissTableMap &RHS) {
+    incrementEpoch();
+    RHS.incrementEpoch();
+    std::swap(Ctrl, RHS.Ctrl);
+    std::swap(Buckets, RHS.Buckets);
+    std::swap(NumBuckets, RHS.NumBuckets);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(GrowthLeft, RHS.GrowthLeft);
+  }
+
+  inline iterator begin() {
+    if (empty())
+      return end();
+    return iterator(Buckets, Ctrl, Buckets + NumBuckets, *this);
+  }
+  inline iterator end() {
+    return iterator(Buckets + NumBuckets, nullptr, Buckets + NumBuckets, *this,
+                    true);
+  }
+  inline const_iterator begin() const {
+    if (empty())
+      return end();
+    return const_iterator(Buckets, Ctrl, Buckets + NumBuckets, *this);
+  }
+  inline const_iterator end() const {
+    return const_iterator(Buckets + NumBuckets, nullptr, Buckets + NumBuckets,
+                          *this, true);
+  }
+
+  LLVM_NODISCARD bool empty() const { return NumEntries == 0; }
+  unsigned size() const { return NumEntries; }
+
+  /// Return the number of buckets, including the ones that are not usable
+  /// because of the maximum load factor.
+  unsigned getNumBuckets() const { return NumBuckets; }
+
+  /// Grow the map so that it can contain at least \p NumEntries items before
+  /// resizing again.
+  void reserve(size_type NumEntries) {
+    unsigned NumBuckets = getMinBucketToReserveForEntries(NumEntries);
+    incrementEpoch();
+    if (NumBuckets > getNumBuckets())
+      grow(NumBuckets);
+  }
+
+  void clear() {
+    incrementEpoch();
+    if (NumEntries == 0 && GrowthLeft == getMaxLoad(NumBuckets))
+      return;
+    destroyAll();
+    if (NumBuckets)
+      std::memset(Ctrl, detail::SwissEmpty, NumBuckets);
+    NumEntries = 0;
+    GrowthLeft = getMaxLoad(NumBuckets);
+  }
+
+  /// Return 1 if the specified key is in the map, 0 otherwise.
+  size_type count(const_arg_type_t<KeyT> Val) const {
+    size_t Idx;
+    return lookupBucket(Val, hashKey(Val), Idx) ? 1 : 0;
+  }
+
+  iterator find(const_arg_type_t<KeyT> Val) { return find_as(Val); }
+  const_iterator find(const_arg_type_t<KeyT> Val) const { return find_as(Val); }
+
+  /// Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template <class LookupKeyT> iterator find_as(const LookupKeyT &Val) {
+    size_t Idx;
+    if (lookupBucket(Val, hashKey(Val), Idx))
+      return makeIterator(Idx);
+    return end();
+  }
+  template <class LookupKeyT>
+  const_iterator find_as(const LookupKeyT &Val) const {
+    size_t Idx;
+    if (lookupBucket(Val, hashKey(Val), Idx))
+      return makeConstIterator(Idx);
+    return end();
+  }
+
+  /// lookup - Return the entry for the specified key, or a default
+  /// constructed value if no such entry exists.
+  ValueT lookup(const_arg_type_t<KeyT> Val) const {
+    size_t Idx;
+    if (lookupBucket(Val, hashKey(Val), Idx))
+      return Buckets[Idx].getSecond();
+    return ValueT();
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    return try_emplace(KV.first, KV.second);
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(std::pair<KeyT, ValueT> &&KV) {
+    return try_emplace(std::move(KV.first), std::move(KV.second));
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // The value is constructed in-place if the key is not in the map, otherwise
+  // it is not moved.
+  template <typename... Ts>
+  std::pair<iterator, bool> try_emplace(KeyT &&Key, Ts &&... Args) {
+    size_t Idx;
+    uint64_t Hash = hashKey(Key);
+    if (lookupBucket(Key, Hash, Idx))
+      return std::make_pair(makeIterator(Idx), false); // Already in map.
+
+    // Otherwise, insert the new element.
+    Idx = prepareInsert(Hash);
+    insertIntoBucket(Idx, std::move(Key), std::forward<Ts>(Args)...);
+    return std::make_pair(makeIterator(Idx), true);
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // The value is constructed in-place if the key is not in the map, otherwise
+  // it is not moved.
+  template <typename... Ts>
+  std::pair<iterator, bool> try_emplace(const KeyT &Key, Ts &&... Args) {
+    size_t Idx;
+    uint64_t Hash = hashKey(Key);
+    if (lookupBucket(Key, Hash, Idx))
+      return std::make_pair(makeIterator(Idx), false); // Already in map.
+
+    // Otherwise, insert the new element.
+    Idx = prepareInsert(Hash);
+    insertIntoBucket(Idx, Key, std::forward<Ts>(Args)...);
+    return std::make_pair(makeIterator(Idx), true);
+  }
+
+  /// insert - Range insertion of pairs.
+  template <typename InputIt> void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  bool erase(const KeyT &Val) {
+    size_t Idx;
+    if (!lookupBucket(Val, hashKey(Val), Idx))
+      return false; // not in map.
+    eraseBucket(Idx);
+    return true;
+  }
+  void erase(iterator I) { eraseBucket(&*I - Buckets); }
+
+  ValueT &operator[](const KeyT &Key) {
+    return try_emplace(Key).first->getSecond();
+  }
+
+  ValueT &operator[](KeyT &&Key) {
+    return try_emplace(std::move(Key)).first->getSecond();
+  }
+
+  /// Return the approximate size (in bytes) of the actual map.
+  /// This is just the raw memory used by the map, it doesn't include memory
+  /// owned by its elements.
+  size_t getMemorySize() const {
+    return NumBuckets ? getAllocationSize(NumBuckets) : 0;
+  }
+
+private:
+  /// Control bytes, one per bucket. Only valid if NumBuckets is not zero.
+  int8_t *Ctrl = nullptr;
+  BucketT *Buckets = nullptr;
+  /// Number of buckets, either zero or a power of two multiple of the group
+  /// width.
+  unsigned NumBuckets = 0;
+  unsigned NumEntries = 0;
+  /// Number of empty buckets that can be filled before the map has to grow.
+  /// Deleted buckets are not counted, so they are reclaimed by rehashing.
+  unsigned GrowthLeft = 0;
+
+  void init() {
+    Ctrl = nullptr;
+    Buckets = nullptr;
+    NumBuckets = NumEntries = GrowthLeft = 0;
+  }
+
+  /// Keep the load factor at or below 7/8.
+  static unsigned getMaxLoad(unsigned NumBuckets) {
+    return NumBuckets - NumBuckets / 8;
+  }
+
+  static unsigned getMinBucketToReserveForEntries(unsigned NumEntries) {
+    if (NumEntries == 0)
+      return 0;
+    // +1 is required because of the strict inequality in the 7/8 load factor.
+    return std::max<unsigned>(Group::Width,
+                              NextPowerOf2(NumEntries * 8 / 7 + 1));
+  }
+
+  static size_t getBucketsOffset(unsigned NumBuckets) {
+    return alignTo(NumBuckets, alignof(BucketT));
+  }
+
+  static size_t getAllocationSize(unsigned NumBuckets) {
+    return getBucketsOffset(NumBuckets) + NumBuckets * sizeof(BucketT);
+  }
+
+  static size_t getAllocationAlignment() {
+    return std::max<size_t>(alignof(BucketT), Group::Width);
+  }
+
+  /// The hash is split into two parts: the low 7 bits are stored in the
+  /// control byte, the rest selects the group to start probing at.
+  /// DenseMapInfo hashes are cheap but not always well mixed (e.g. pointers
+  /// and small integers), so mix them before use.
+  template <typename LookupKeyT> static uint64_t hashKey(const LookupKeyT &Val) {
+    uint64_t Hash = uint64_t(KeyInfoT::getHashValue(Val)) * 0x9E3779B97F4A7C15ULL;
+    return Hash ^ (Hash >> 32);
+  }
+  static int8_t getTag(uint64_t Hash) { return Hash & 0x7F; }
+  size_t getFirstGroup(uint64_t Hash) const {
+    return (Hash >> 7) & (NumBuckets / Group::Width - 1);
+  }
+  size_t getNextGroup(size_t G, unsigned Step) const {
+    // Triangular probing visits every group, since the number of groups is a
+    // power of two.
+    return (G + Step) & (NumBuckets / Group::Width - 1);
+  }
+
+  /// Find the bucket of \p Val, whose hash is \p Hash. Returns true and sets
+  /// \p Idx if the key is in the map.
+  template <typename LookupKeyT>
+  bool lookupBucket(const LookupKeyT &Val, uint64_t Hash, size_t &Idx) const {
+    if (NumBuckets == 0)
+      return false;
+    int8_t Tag = getTag(Hash);
+    size_t G = getFirstGroup(Hash);
+    for (unsigned Step = 1;; ++Step) {
+      size_t GroupStart = G * Group::Width;
+      Group Grp(Ctrl + GroupStart);
+      for (uint32_t Mask = Grp.match(Tag); Mask; Mask &= Mask - 1) {
+        size_t I = GroupStart + countTrailingZeros(Mask, ZB_Undefined);
+        if (LLVM_LIKELY(KeyInfoT::isEqual(Val, Buckets[I].getFirst()))) {
+          Idx = I;
+          return true;
+        }
+      }
+      // A key is never placed past a group that had room for it.
+      if (LLVM_LIKELY(Grp.matchEmpty()))
+        return false;
+      G = getNextGroup(G, Step);
+      assert(Step < NumBuckets / Group::Width + 1 && "Map is full!");
+    }
+  }
+
+  /// Return the first empty or deleted bucket on the probe sequence of
+  /// \p Hash.
+  size_t findFirstNonFull(uint64_t Hash) const {
+    size_t G = getFirstGroup(Hash);
+    for (unsigned Step = 1;; ++Step) {
+      size_t GroupStart = G * Group::Width;
+      if (uint32_t Mask = Group(Ctrl + GroupStart).matchEmptyOrDeleted())
+        return GroupStart + countTrailingZeros(Mask, ZB_Undefined);
+      G = getNextGroup(G, Step);
+      assert(Step < NumBuckets / Group::Width + 1 && "Map is full!");
+    }
+  }
+
+  /// Claim a bucket for a key with hash \p Hash that is known not to be in
+  /// the map, growing the map if needed.
+  size_t prepareInsert(uint64_t Hash) {
+    incrementEpoch();
+    size_t Idx = NumBuckets ? findFirstNonFull(Hash) : 0;
+    if (NumBuckets == 0 ||
+        (GrowthLeft == 0 && Ctrl[Idx] == detail::SwissEmpty)) {
+      // If more than half the usable buckets are deleted, rehashing in place
+      // is enough to make room. Otherwise double the size.
+      if (NumBuckets && NumEntries < getMaxLoad(NumBuckets) / 2)
+        grow(NumBuckets);
+      else
+        grow(std::max<unsigned>(NumBuckets * 2, Group::Width));
+      Idx = findFirstNonFull(Hash);
+    }
+    if (Ctrl[Idx] == detail::SwissEmpty)
+      --GrowthLeft;
+    Ctrl[Idx] = getTag(Hash);
+    ++NumEntries;
+    return Idx;
+  }
+
+  template <typename KeyArg, typename... ValueArgs>
+  void insertIntoBucket(size_t Idx, KeyArg &&Key, ValueArgs &&... Values) {
+    BucketT *TheBucket = Buckets + Idx;
+    ::new (&TheBucket->getFirst()) KeyT(std::forward<KeyArg>(Key));
+    ::new (&TheBucket->getSecond()) ValueT(std::forward<ValueArgs>(Values)...);
+  }
+
+  void eraseBucket(size_t Idx) {
+    incrementEpoch();
+    destroyBucket(Buckets[Idx]);
+    // If the group still has an empty bucket, no probe sequence has ever
+    // continued past it, so the bucket can become empty again rather than
+    // being marked deleted.
+    size_t GroupStart = Idx & ~size_t(Group::Width - 1);
+    if (Group(Ctrl + GroupStart).matchEmpty()) {
+      Ctrl[Idx] = detail::SwissEmpty;
+      ++GrowthLeft;
+    } else {
+      Ctrl[Idx] = detail::SwissDeleted;
+    }
+    --NumEntries;
+  }
+
+  static void destroyBucket(BucketT &B) {
+    B.getSecond().~ValueT();
+    B.getFirst().~KeyT();
+  }
+
+  void destroyAll() {
+    if (is_trivially_copyable<KeyT>::value &&
+        is_trivially_copyable<ValueT>::value)
+      return;
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (Ctrl[I] >= 0)
+        destroyBucket(Buckets[I]);
+  }
+
+  void deallocateBuckets() {
+    if (NumBuckets)
+      deallocate_buffer(Ctrl, getAllocationSize(NumBuckets),
+                        getAllocationAlignment());
+  }
+
+  void allocateBuckets(unsigned Num) {
+    NumBuckets = Num;
+    NumEntries = 0;
+    GrowthLeft = getMaxLoad(Num);
+    if (Num == 0) {
+      Ctrl = nullptr;
+      Buckets = nullptr;
+      return;
+    }
+    char *Mem = static_cast<char *>(
+        allocate_buffer(getAllocationSize(Num), getAllocationAlignment()));
+    Ctrl = reinterpret_cast<int8_t *>(Mem);
+    Buckets = reinterpret_cast<BucketT *>(Mem + getBucketsOffset(Num));
+    std::memset(Ctrl, detail::SwissEmpty, Num);
+  }
+
+  /// Rehash into \p AtLeast buckets, dropping all deleted buckets.
+  void grow(unsigned AtLeast) {
+    int8_t *OldCtrl = Ctrl;
+    BucketT *OldBuckets = Buckets;
+    unsigned OldNumBuckets = NumBuckets;
+
+    allocateBuckets(std::max<unsigned>(Group::Width, NextPowerOf2(AtLeast - 1)));
+    for (unsigned I = 0; I != OldNumBuckets; ++I) {
+      if (OldCtrl[I] < 0)
+        continue;
+      BucketT &B = OldBuckets[I];
+      uint64_t Hash = hashKey(B.getFirst());
+      size_t Idx = findFirstNonFull(Hash);
+      Ctrl[Idx] = getTag(Hash);
+      --GrowthLeft;
+      ++NumEntries;
+      insertIntoBucket(Idx, std::move(B.getFirst()), std::move(B.getSecond()));
+      destroyBucket(B);
+    }
+
+    if (OldNumBuckets)
+      deallocate_buffer(OldCtrl, getAllocationSize(OldNumBuckets),
+                        getAllocationAlignment());
+  }
+
+  void copyFrom(const SwissTableMap &Other) {
+    destroyAll();
+    deallocateBuckets();
+    allocateBuckets(Other.NumBuckets);
+    if (NumBuckets == 0)
+      return;
+    std::memcpy(Ctrl, Other.Ctrl, NumBuckets);
+    NumEntries = Other.NumEntries;
+    GrowthLeft = Other.GrowthLeft;
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (Ctrl[I] >= 0)
+        insertIntoBucket(I, Other.Buckets[I].getFirst(),
+                         Other.Buckets[I].getSecond());
+  }
+
+  iterator makeIterator(size_t Idx) {
+    return iterator(Buckets + Idx, Ctrl + Idx, Buckets + NumBuckets, *this,
+                    true);
+  }
+  const_iterator makeConstIterator(size_t Idx) const {
+    return const_iterator(Buckets + Idx, Ctrl + Idx, Buckets + NumBuckets,
+                          *this, true);
+  }
+};
+
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename Bucket,
+          bool IsConst>
+class SwissTableMapIterator : DebugEpochBase::HandleBase {
+  friend class SwissTableMapIterator<KeyT, ValueT, KeyInfoT, Bucket, true>;
+  friend class SwissTableMapIterator<KeyT, ValueT, KeyInfoT, Bucket, false>;
+
+  using ConstIterator =
+      SwissTableMapIterator<KeyT, ValueT, KeyInfoT, Bucket, true>;
+
+public:
+  using difference_type = ptrdiff_t;
+  using value_type =
+      typename std::conditional<IsConst, const Bucket, Bucket>::type;
+  using pointer = value_type *;
+  using reference = value_type &;
+  using iterator_category = std::forward_iterator_tag;
+
+private:
+  pointer Ptr = nullptr;
+  const int8_t *Ctrl = nullptr;
+  pointer End = nullptr;
+
+public:
+  SwissTableMapIterator() = default;
+
+  SwissTableMapIterator(pointer Pos, const int8_t *Ctrl, pointer E,
+                        const DebugEpochBase &Epoch, bool NoAdvance = false)
+      : DebugEpochBase::HandleBase(&Epoch), Ptr(Pos), Ctrl(Ctrl), End(E) {
+    assert(isHandleInSync() && "invalid construction!");
+
+    if (NoAdvance) return;
+    AdvancePastEmptyBuckets();
+  }
+
+  // Converting ctor from non-const iterators to const iterators. SFINAE'd out
+  // for const iterator destinations so it doesn't end up as a user defined copy
+  // constructor.
+  template <bool IsConstSrc,
+            typename = typename std::enable_if<!IsConstSrc && IsConst>::type>
+  SwissTableMapIterator(
+      const SwissTableMapIterator<KeyT, ValueT, KeyInfoT, Bucket, IsConstSrc>
+          &I)
+      : DebugEpochBase::HandleBase(I), Ptr(I.Ptr), Ctrl(I.Ctrl), End(I.End) {}
+
+  reference operator*() const {
+    assert(isHandleInSync() && "invalid iterator access!");
+    return *Ptr;
+  }
+  pointer operator->() const {
+    assert(isHandleInSync() && "invalid iterator access!");
+    return Ptr;
+  }
+
+  bool operator==(const ConstIterator &RHS) const {
+    assert((!Ptr || isHandleInSync()) && "handle not in sync!");
+    assert((!RHS.Ptr || RHS.isHandleInSync()) && "handle not in sync!");
+    assert(getEpochAddress() == RHS.getEpochAddress() &&
+           "comparing incomparable iterators!");
+    return Ptr == RHS.Ptr;
+  }
+  bool operator!=(const ConstIterator &RHS) const {
+    assert((!Ptr || isHandleInSync()) && "handle not in sync!");
+    assert((!RHS.Ptr || RHS.isHandleInSync()) && "handle not in sync!");
+    assert(getEpochAddress() == RHS.getEpochAddress() &&
+           "comparing incomparable iterators!");
+    return Ptr != RHS.Ptr;
+  }
+
+  inline SwissTableMapIterator &operator++() { // Preincrement
+    assert(isHandleInSync() && "invalid iterator access!");
+    ++Ptr;
+    ++Ctrl;
+    AdvancePastEmptyBuckets();
+    return *this;
+  }
+  SwissTableMapIterator operator++(int) { // Postincrement
+    assert(isHandleInSync() && "invalid iterator access!");
+    SwissTableMapIterator tmp = *this; ++*this; return tmp;
+  }
+
+private:
+  void AdvancePastEmptyBuckets() {
+    assert(Ptr <= End);
+    while (Ptr != End && *Ctrl < 0) {
+      ++Ptr;
+      ++Ctrl;
+    }
+  }
+};
+
+template <typename KeyT, typename ValueT, typename KeyInfoT>
+inline size_t capacity_in_bytes(const SwissTableMap<KeyT, ValueT, KeyInfoT> &X) {
+  return X.getMemorySize();
+}
+
+} // end namespace llvm
+
+#endif // LLVM_ADT_SWISSTABLEMAP_H
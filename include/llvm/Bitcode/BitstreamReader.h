@@ -302,6 +302,42 @@ struct BitstreamEntry {
   }
 };
 
+/// The entries of a block, including those of its sub-blocks, read ahead of
+/// time by BitstreamCursor::recordBlock(). A cursor replaying a recording
+/// returns its entries instead of reading the bitstream, with the abbreviated
+/// records already expanded, so that the blocks of a file can be decoded on
+/// other threads and interpreted later.
+class BitstreamBlockRecording {
+  friend class BitstreamCursor;
+
+  struct Entry {
+    BitstreamEntry E;
+    /// The code of a record, or the index of the entry following the end of a
+    /// sub-block.
+    size_t CodeOrEnd;
+    /// The operands of a record, in Ops.
+    size_t OpsBegin;
+    unsigned NumOps;
+    /// The blob of a record, if its abbreviation has one.
+    unsigned BlobSize;
+    const char *BlobData;
+  };
+
+  std::vector<Entry> Entries;
+  std::vector<uint64_t> Ops;
+  /// The position following the end of the block.
+  uint64_t EndBit = 0;
+
+public:
+  bool empty() const { return Entries.empty(); }
+
+  void clear() {
+    Entries.clear();
+    Ops.clear();
+    EndBit = 0;
+  }
+};
+
 /// This represents a position within a bitcode file, implemented on top of a
 /// SimpleBitstreamCursor.
 ///
@@ -327,6 +363,10 @@ class BitstreamCursor : SimpleBitstreamCursor {
 
   BitstreamBlockInfo *BlockInfo = nullptr;
 
+  /// The recording being replayed, if any, and the next entry to return.
+  const BitstreamBlockRecording *Replay = nullptr;
+  size_t ReplayPos = 0;
+
 public:
   static const size_t MaxChunkSize = sizeof(word_t) * 8;
 
@@ -344,12 +384,17 @@ public:
   using SimpleBitstreamCursor::GetCurrentBitNo;
   using SimpleBitstreamCursor::getCurrentByteNo;
   using SimpleBitstreamCursor::getPointerToByte;
-  using SimpleBitstreamCursor::JumpToBit;
   using SimpleBitstreamCursor::fillCurWord;
   using SimpleBitstreamCursor::Read;
   using SimpleBitstreamCursor::ReadVBR;
   using SimpleBitstreamCursor::ReadVBR64;
 
+  /// Move to \p BitNo, which stops replaying a recording.
+  void JumpToBit(uint64_t BitNo) {
+    Replay = nullptr;
+    SimpleBitstreamCursor::JumpToBit(BitNo);
+  }
+
   /// Return the number of bits used to encode an abbrev #.
   unsigned getAbbrevIDWidth() const { return CurCodeSize; }
 
@@ -366,6 +411,9 @@ public:
 
   /// Advance the current bitstream, returning the next entry in the stream.
   BitstreamEntry advance(unsigned Flags = 0) {
+    if (Replay)
+      return replayAdvance(Flags);
+
     while (true) {
       if (AtEndOfStream())
         return BitstreamEntry::getError();
@@ -409,6 +457,8 @@ public:
   }
 
   unsigned ReadCode() {
+    if (Replay)
+      return replayCode();
     return Read(CurCodeSize);
   }
 
@@ -423,6 +473,9 @@ public:
   /// Having read the ENTER_SUBBLOCK abbrevid and a BlockID, skip over the body
   /// of this block. If the block record is malformed, return true.
   bool SkipBlock() {
+    if (Replay)
+      return replaySkipBlock();
+
     // Read and ignore the codelen value.  Since we are skipping this block, we
     // don't care what code widths are used inside of it.
     ReadVBR(bitc::CodeLenWidth);
@@ -444,6 +497,9 @@ public:
   bool EnterSubBlock(unsigned BlockID, unsigned *NumWordsP = nullptr);
 
   bool ReadBlockEnd() {
+    if (Replay)
+      return replayBlockEnd();
+
     if (BlockScope.empty()) return true;
 
     // Block tail:
@@ -454,7 +510,32 @@ public:
     return false;
   }
 
+  /// Having read the ENTER_SUBBLOCK abbrevid and a BlockID, read the whole
+  /// block, including its sub-blocks, into \p Recording and move past its
+  /// end. Returns true if the block is malformed or has a BLOCKINFO block.
+  bool recordBlock(unsigned BlockID, BitstreamBlockRecording &Recording);
+
+  /// Return the entries of \p Recording, which must outlive the replay, until
+  /// the end of its block has been read, and then continue after the block.
+  /// EnterSubBlock() does nothing while replaying, as the entries of a block
+  /// follow the sub-block entry returned for it by advance(), and the
+  /// outermost block is already entered. Block sizes read as 0. As when
+  /// reading the bitstream, each record must be read or skipped.
+  void replayBlock(const BitstreamBlockRecording &Recording) {
+    assert(!Recording.empty() && "Replaying an empty recording");
+    Replay = &Recording;
+    ReplayPos = 0;
+  }
+
+  bool isReplaying() const { return Replay != nullptr; }
+
 private:
+  BitstreamEntry replayAdvance(unsigned Flags);
+  unsigned replayCode() const;
+  bool replaySkipBlock();
+  bool replayBlockEnd();
+  unsigned replayRecord(SmallVectorImpl<uint64_t> *Vals, StringRef *Blob);
+
   void popBlockScope() {
     CurCodeSize = BlockScope.back().PrevCodeSize;
 
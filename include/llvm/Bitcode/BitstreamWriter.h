@@ -173,6 +173,29 @@ public:
     Emit((uint32_t)Val, NumBits);
   }
 
+  /// Emit bits [BeginBit, EndBit) of \p Bytes, which another BitstreamWriter
+  /// wrote, and where BeginBit is on a word boundary. This splices in a block
+  /// body written separately, which does not depend on its position as blocks
+  /// start on word boundaries.
+  void EmitBits(ArrayRef<uint8_t> Bytes, uint64_t BeginBit, uint64_t EndBit) {
+    using namespace llvm::support;
+    assert(BeginBit % 32 == 0 && "Not 32-bit aligned");
+    assert(BeginBit <= EndBit && (EndBit + 31) / 32 * 4 <= Bytes.size() &&
+           "Invalid range");
+    const uint8_t *Ptr = Bytes.data() + BeginBit / 8;
+    uint64_t NumBits = EndBit - BeginBit;
+    if (CurBit == 0) {
+      size_t NumBytes = NumBits / 32 * 4;
+      Out.append(Ptr, Ptr + NumBytes);
+      Ptr += NumBytes;
+      NumBits %= 32;
+    }
+    for (; NumBits >= 32; NumBits -= 32, Ptr += 4)
+      Emit(endian::read32le(Ptr), 32);
+    if (NumBits)
+      Emit(endian::read32le(Ptr) & (~0U >> (32 - NumBits)), NumBits);
+  }
+
   /// EmitCode - Emit the specified code.
   void EmitCode(unsigned Val) {
     Emit(Val, CurCodeSize);
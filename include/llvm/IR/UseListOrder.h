@@ -32,7 +32,9 @@ struct UseListOrder {
       : V(V), F(F), Shuffle(ShuffleSize) {}
 
   UseListOrder() = default;
+  UseListOrder(const UseListOrder &) = default;
   UseListOrder(UseListOrder &&) = default;
+  UseListOrder &operator=(const UseListOrder &) = default;
   UseListOrder &operator=(UseListOrder &&) = default;
 };
 
@@ -16,6 +16,7 @@
 
 #include "llvm/ADT/StringRef.h"
 #include <chrono>
+#include <future>
 
 namespace llvm {
 
@@ -57,6 +58,12 @@ struct CachePruningPolicy {
   /// 4096 and large_dir disabled), there is a per-directory entry limit of
   /// 508*510*floor(4096/(40+8))~=20M for average filename length of 40.
   uint64_t MaxSizeFiles = 1000000;
+
+  /// Whether to keep an index of the sizes and access times of the files in
+  /// the cache directory, so that pruning only needs to look at the files
+  /// added since the last pruning, and at the files it is about to remove.
+  /// The directory is not listed at all if nothing was added or removed.
+  bool Incremental = false;
 };
 
 /// Parse the given string as a cache pruning policy. Defaults are taken from a
@@ -74,6 +81,10 @@ Expected<CachePruningPolicy> parseCachePruningPolicy(StringRef PolicyStr);
 /// pattern "llvmcache-*".
 bool pruneCache(StringRef Path, CachePruningPolicy Policy);
 
+/// Runs pruneCache() on another thread, if threads are enabled, so that it
+/// does not delay the caller. The result must be waited for before exiting.
+std::future<bool> pruneCacheAsync(StringRef Path, CachePruningPolicy Policy);
+
 } // namespace llvm
 
 #endif
@@ -286,6 +286,7 @@ public:
   SmallVector<OptionCategory *, 1>
       Categories;                    // The Categories this option belongs to
   SmallPtrSet<SubCommand *, 1> Subs; // The subcommands this option belongs to.
+  Option *NextPending = nullptr; // The next option waiting to be registered.
 
   inline enum NumOccurrencesFlag getNumOccurrencesFlag() const {
     return (enum NumOccurrencesFlag)Occurrences;
@@ -352,7 +353,10 @@ protected:
 public:
   virtual ~Option() = default;
 
-  // addArgument - Register this argument with the commandline system.
+  // addArgument - Register this argument with the commandline system.  The
+  // option is only queued here, since most of the options a tool links in are
+  // never looked at; the queue is drained into the option maps of the
+  // subcommands the first time the options are parsed, printed or queried.
   //
   void addArgument();
 
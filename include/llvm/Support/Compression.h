@@ -14,6 +14,7 @@
 #define LLVM_SUPPORT_COMPRESSION_H
 
 #include "llvm/Support/DataTypes.h"
+#include <memory>
 
 namespace llvm {
 template <typename T> class SmallVectorImpl;
@@ -32,6 +33,19 @@ bool isAvailable();
 Error compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
                int Level = DefaultCompression);
 
+static constexpr size_t DefaultParallelBlockSize = 1 << 20;
+
+/// Compresses \p InputBuffer into a zlib stream, in blocks of \p BlockSize
+/// bytes that are compressed in parallel. Each block is compressed with the
+/// 32 KiB of input before it as dictionary, so the result is only a little
+/// larger than with compress(), and it does not depend on the number of
+/// threads. Inputs of up to \p BlockSize bytes are compressed as by
+/// compress(). \p BlockSize must not be 0.
+Error compressParallel(StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       int Level = DefaultCompression,
+                       size_t BlockSize = DefaultParallelBlockSize);
+
 Error uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                  size_t &UncompressedSize);
 
@@ -43,6 +57,30 @@ uint32_t crc32(StringRef Buffer);
 
 }  // End of namespace zlib
 
+/// A compression format, for clients that support several.
+class CompressionCodec {
+public:
+  virtual ~CompressionCodec();
+
+  /// Returns the name of the format, such as "zlib".
+  virtual StringRef getName() const = 0;
+
+  /// Returns whether the format can be used in this build.
+  virtual bool isAvailable() const = 0;
+
+  virtual Error compress(StringRef Input, SmallVectorImpl<char> &Output) = 0;
+
+  /// Uncompresses \p Input, which must uncompress to \p UncompressedSize
+  /// bytes.
+  virtual Error uncompress(StringRef Input, SmallVectorImpl<char> &Output,
+                           size_t UncompressedSize) = 0;
+};
+
+/// Returns a codec for zlib streams, which are compressed in parallel with
+/// zlib::compressParallel() if \p Parallel is set.
+std::unique_ptr<CompressionCodec>
+createZlibCodec(int Level = zlib::DefaultCompression, bool Parallel = true);
+
 } // End of namespace llvm
 
 #endif
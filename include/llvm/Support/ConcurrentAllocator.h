@@ -0,0 +1,213 @@
+//===- ConcurrentAllocator.h - Thread-safe arena allocators -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file defines arena allocators that can be shared between threads
+/// without a lock. Every thread that allocates from the arena gets its own
+/// BumpPtrAllocator, so allocation is a bump of a thread-private pointer once
+/// the thread has found its allocator. All memory is released when the arena
+/// is destroyed, as with BumpPtrAllocator.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CONCURRENTALLOCATOR_H
+#define LLVM_SUPPORT_CONCURRENTALLOCATOR_H
+
+#include "llvm/Support/Allocator.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace llvm {
+
+namespace detail {
+
+/// Returns a new identifier for a PerThreadAllocator. Identifiers are never
+/// reused, so a stale thread-local cache entry can never match a new arena.
+uint64_t getNextPerThreadAllocatorID();
+
+/// Each thread caches the last per-thread allocator it used. Returns the
+/// cached allocator if it belongs to the arena \p ID, and null otherwise.
+void *getCachedThreadAllocator(uint64_t ID);
+void setCachedThreadAllocator(uint64_t ID, void *Alloc);
+
+/// A set of allocators of type \p AllocatorT, one for each thread that has
+/// allocated from it.
+///
+/// The allocators are kept in a list that only grows while the arena is in
+/// use. A thread looks up its allocator in a thread-local cache first, then in
+/// the list, and pushes a new allocator onto the list with a compare and swap
+/// if it has none yet.
+template <typename AllocatorT> class PerThreadAllocator {
+  struct Shard {
+    AllocatorT Alloc;
+    std::thread::id Owner;
+    Shard *Next = nullptr;
+  };
+
+  std::atomic<Shard *> Head{nullptr};
+  const uint64_t ID = getNextPerThreadAllocatorID();
+
+public:
+  PerThreadAllocator() = default;
+  PerThreadAllocator(const PerThreadAllocator &) = delete;
+  PerThreadAllocator &operator=(const PerThreadAllocator &) = delete;
+
+  ~PerThreadAllocator() {
+    Shard *S = Head.load(std::memory_order_acquire);
+    while (S) {
+      Shard *Next = S->Next;
+      delete S;
+      S = Next;
+    }
+  }
+
+  /// Returns the allocator of the calling thread, creating it if needed.
+  AllocatorT &get() {
+    if (void *Cached = getCachedThreadAllocator(ID))
+      return static_cast<Shard *>(Cached)->Alloc;
+    return getSlow();
+  }
+
+  /// Calls \p F on every allocator. This must not race with get().
+  template <typename Fn> void forEach(Fn F) {
+    for (Shard *S = Head.load(std::memory_order_acquire); S; S = S->Next)
+      F(S->Alloc);
+  }
+
+  template <typename Fn> void forEach(Fn F) const {
+    for (Shard *S = Head.load(std::memory_order_acquire); S; S = S->Next)
+      F(static_cast<const AllocatorT &>(S->Alloc));
+  }
+
+private:
+  AllocatorT &getSlow() {
+    std::thread::id Self = std::this_thread::get_id();
+    Shard *First = Head.load(std::memory_order_acquire);
+    // Only the calling thread can add a shard owned by itself, so a shard
+    // missing from this snapshot of the list cannot appear concurrently. A
+    // thread id may be reused after its thread exited, in which case the new
+    // thread inherits the old thread's shard.
+    for (Shard *S = First; S; S = S->Next)
+      if (S->Owner == Self) {
+        setCachedThreadAllocator(ID, S);
+        return S->Alloc;
+      }
+
+    Shard *New = new Shard();
+    New->Owner = Self;
+    New->Next = First;
+    while (!Head.compare_exchange_weak(New->Next, New,
+                                       std::memory_order_release,
+                                       std::memory_order_acquire))
+      ;
+    setCachedThreadAllocator(ID, New);
+    return New->Alloc;
+  }
+};
+
+} // end namespace detail
+
+/// A BumpPtrAllocator that can be used from several threads at once.
+///
+/// Allocate() is lock-free: every thread bumps a pointer in slabs of its own.
+/// Objects may be freely shared between threads once allocated. Reset() and
+/// the statistics functions must not be called while other threads allocate.
+class ConcurrentBumpPtrAllocator
+    : public AllocatorBase<ConcurrentBumpPtrAllocator> {
+  detail::PerThreadAllocator<BumpPtrAllocator> Allocators;
+
+public:
+  ConcurrentBumpPtrAllocator() = default;
+
+  LLVM_ATTRIBUTE_RETURNS_NONNULL LLVM_ATTRIBUTE_RETURNS_NOALIAS void *
+  Allocate(size_t Size, size_t Alignment) {
+    return Allocators.get().Allocate(Size, Alignment);
+  }
+
+  // Pull in base class overloads.
+  using AllocatorBase<ConcurrentBumpPtrAllocator>::Allocate;
+
+  // As with BumpPtrAllocator, memory is only released by Reset() or when the
+  // allocator is destroyed.
+  void Deallocate(const void *Ptr, size_t Size) {}
+
+  // Pull in base class overloads.
+  using AllocatorBase<ConcurrentBumpPtrAllocator>::Deallocate;
+
+  /// Returns the BumpPtrAllocator used by the calling thread. It can be handed
+  /// to interfaces that take a BumpPtrAllocator, as long as it is only used
+  /// from the calling thread.
+  BumpPtrAllocator &getThreadAllocator() { return Allocators.get(); }
+
+  /// Deallocate all but the current slab of every thread.
+  void Reset() {
+    Allocators.forEach([](BumpPtrAllocator &A) { A.Reset(); });
+  }
+
+  size_t GetNumSlabs() const {
+    size_t NumSlabs = 0;
+    Allocators.forEach(
+        [&](const BumpPtrAllocator &A) { NumSlabs += A.GetNumSlabs(); });
+    return NumSlabs;
+  }
+
+  size_t getTotalMemory() const {
+    size_t TotalMemory = 0;
+    Allocators.forEach(
+        [&](const BumpPtrAllocator &A) { TotalMemory += A.getTotalMemory(); });
+    return TotalMemory;
+  }
+
+  size_t getBytesAllocated() const {
+    size_t BytesAllocated = 0;
+    Allocators.forEach([&](const BumpPtrAllocator &A) {
+      BytesAllocated += A.getBytesAllocated();
+    });
+    return BytesAllocated;
+  }
+
+  void PrintStats() const {
+    detail::printBumpPtrAllocatorStats(GetNumSlabs(), getBytesAllocated(),
+                                       getTotalMemory());
+  }
+};
+
+/// A SpecificBumpPtrAllocator that can be used from several threads at once.
+///
+/// As with SpecificBumpPtrAllocator, the destructor of every allocated object
+/// is called by DestroyAll() and when the allocator is destroyed. DestroyAll()
+/// must not be called while other threads allocate.
+template <typename T> class ConcurrentSpecificBumpPtrAllocator {
+  detail::PerThreadAllocator<SpecificBumpPtrAllocator<T>> Allocators;
+
+public:
+  ConcurrentSpecificBumpPtrAllocator() = default;
+
+  /// Call the destructor of each allocated object and deallocate all but the
+  /// current slab of every thread.
+  void DestroyAll() {
+    Allocators.forEach([](SpecificBumpPtrAllocator<T> &A) { A.DestroyAll(); });
+  }
+
+  /// Allocate space for an array of objects without constructing them.
+  T *Allocate(size_t num = 1) { return Allocators.get().Allocate(num); }
+};
+
+} // end namespace llvm
+
+inline void *operator new(size_t Size,
+                          llvm::ConcurrentBumpPtrAllocator &Allocator) {
+  return Allocator.Allocate(
+      Size, std::min((size_t)llvm::NextPowerOf2(Size), alignof(std::max_align_t)));
+}
+
+inline void operator delete(void *, llvm::ConcurrentBumpPtrAllocator &) {}
+
+#endif // LLVM_SUPPORT_CONCURRENTALLOCATOR_H
@@ -34,6 +34,7 @@ struct FileCheckRequest {
   bool AllowDeprecatedDagOverlap = false;
   bool Verbose = false;
   bool VerboseVerbose = false;
+  bool TimeChecks = false;
 };
 
 //===----------------------------------------------------------------------===//
@@ -173,6 +174,11 @@ public:
   /// \returns a string containing the result of the substitution represented
   /// by this class instance or an error if substitution failed.
   virtual Expected<std::string> getResult() const = 0;
+
+  /// \returns the text that the substitution stands for or an error if
+  /// substitution failed. Unlike getResult(), the text is not escaped for use
+  /// in a regex.
+  virtual Expected<std::string> getLiteralResult() const = 0;
 };
 
 class FileCheckStringSubstitution : public FileCheckSubstitution {
@@ -182,8 +188,13 @@ public:
       : FileCheckSubstitution(Context, VarName, InsertIdx) {}
 
   /// \returns the text that the string variable in this substitution matched
-  /// when defined, or an error if the variable is undefined.
+  /// when defined, escaped for use in a regex, or an error if the variable is
+  /// undefined.
   Expected<std::string> getResult() const override;
+
+  /// \returns the text that the string variable in this substitution matched
+  /// when defined, or an error if the variable is undefined.
+  Expected<std::string> getLiteralResult() const override;
 };
 
 class FileCheckNumericSubstitution : public FileCheckSubstitution {
@@ -203,6 +214,12 @@ public:
   /// \returns a string containing the result of evaluating the expression in
   /// this substitution, or an error if evaluation failed.
   Expected<std::string> getResult() const override;
+
+  /// \returns the same as getResult(), since the decimal value of an
+  /// expression needs no escaping.
+  Expected<std::string> getLiteralResult() const override {
+    return getResult();
+  }
 };
 
 //===----------------------------------------------------------------------===//
@@ -427,6 +444,41 @@ class FileCheckPattern {
   /// variables.
   StringMap<FileCheckNumericVariableMatch> NumericVariableDefs;
 
+  /// A piece of the pattern that every match contains verbatim: either a
+  /// fixed string or a substitution, whose value is only known at match time.
+  struct LiteralPiece {
+    /// The fixed string, if Substitution is null.
+    StringRef Str;
+    /// The substitution providing the text of this piece, or null.
+    FileCheckSubstitution *Substitution;
+    /// Whether a regex piece separates this piece from the previous one.
+    /// Adjacent pieces are joined into a single literal at match time.
+    bool FollowsRegex;
+  };
+
+  /// The literal pieces of RegExStr, in order. They let match() find the
+  /// lines that may contain a match with a substring search and only run the
+  /// regex engine on those, or skip the regex engine entirely for patterns
+  /// that are literals separated by "{{.*}}".
+  std::vector<LiteralPiece> LiteralPieces;
+
+  /// Whether no match of RegExStr can span more than one line, which is the
+  /// case unless some regex piece can match a newline.
+  bool IsLineLocal = false;
+
+  /// Describes a pattern made of LiteralPieces separated by "{{.*}}"
+  /// wildcards, optionally starting with "{{^}}" and ending with "{{$}}".
+  struct WildcardPatternInfo {
+    bool AnchorStart = false;
+    bool AnchorEnd = false;
+    bool LeadingWildcard = false;
+    bool TrailingWildcard = false;
+  };
+
+  /// Set if RegExStr is such a wildcard pattern, which match() then matches
+  /// without the regex engine.
+  Optional<WildcardPatternInfo> WildcardPattern;
+
   /// Pointer to a class instance holding the global state shared by all
   /// patterns:
   /// - separate tables with the values of live string and numeric variables
@@ -524,6 +576,26 @@ private:
   /// at the start of \p Buffer; a distance of zero should correspond to a
   /// perfect match.
   unsigned computeMatchDistance(StringRef Buffer) const;
+  /// Computes the values of LiteralPieces, joining adjacent pieces, into
+  /// \p Literals. \returns an error if a substitution failed.
+  Error getLiterals(SmallVectorImpl<std::string> &Literals) const;
+  /// Matches the wildcard pattern made of \p Literals separated by ".*" and
+  /// described by \p Info against \p Buffer, without the regex engine.
+  /// \returns the position of the match, with the same leftmost longest
+  /// semantics as the equivalent regex, and sets \p MatchLen to its size, or
+  /// \returns npos if there is no match.
+  static size_t matchWildcardPattern(StringRef Buffer,
+                                     ArrayRef<std::string> Literals,
+                                     const WildcardPatternInfo &Info,
+                                     size_t &MatchLen);
+  /// Matches the same pattern against the single line \p Line, the first
+  /// occurrence of the first literal in which is at \p FirstPos. \returns
+  /// whether there is a match and sets \p Start and \p End to its bounds in
+  /// \p Line if so.
+  static bool matchWildcardLine(StringRef Line, size_t FirstPos,
+                                ArrayRef<std::string> Literals,
+                                const WildcardPatternInfo &Info, size_t &Start,
+                                size_t &End);
   /// Finds the closing sequence of a regex variable usage or definition.
   ///
   /// \p Str has to point in the beginning of the definition (right after the
@@ -18,6 +18,9 @@
 /// - functions to parse JSON text into Values, and to serialize Values to text.
 ///   See parse(), operator<<, and format_provider.
 ///
+/// - a streaming parser which reports the structure of JSON text to a
+///   json::Handler without materializing it as a json::Value.
+///
 /// - a convention and helpers for mapping between json::Value and user-defined
 ///   types. See fromJSON(), ObjectMapper, and the class comment on Value.
 ///
@@ -292,7 +295,7 @@ public:
 
   // It would be nice to have Value() be null. But that would make {} null too.
   Value(const Value &M) { copyFrom(M); }
-  Value(Value &&M) { moveFrom(std::move(M)); }
+  Value(Value &&M) noexcept { moveFrom(std::move(M)); }
   Value(std::initializer_list<Value> Elements);
   Value(json::Array &&Elements) : Type(T_Array) {
     create<json::Array>(std::move(Elements));
@@ -679,13 +682,58 @@ private:
 /// to the original source).
 llvm::Expected<Value> parse(llvm::StringRef JSON);
 
+/// A Handler receives the contents of a JSON document from the streaming
+/// parse() as a sequence of events, in document order:
+///
+///   {"name": "x", "sizes": [1, 2.5]}
+///
+/// produces objectBegin(), objectKey("name"), string("x"), objectKey("sizes"),
+/// arrayBegin(), integer(1), number(2.5), arrayEnd(), objectEnd().
+///
+/// Strings passed to the handler are valid UTF-8 and are only valid for the
+/// duration of the call: they refer to the parsed text or to a buffer that is
+/// reused for the next string with escape sequences.
+///
+/// Each callback returns false to stop parsing, in which case parse() returns
+/// a ParseError at the current position. The default implementations ignore
+/// the event.
+class Handler {
+public:
+  virtual ~Handler();
+
+  virtual bool null() { return true; }
+  virtual bool boolean(bool B) { return true; }
+  /// A number which is an integer that fits in 64 bits.
+  virtual bool integer(int64_t I) { return true; }
+  /// Any other number.
+  virtual bool number(double D) { return true; }
+  virtual bool string(llvm::StringRef S) { return true; }
+  virtual bool arrayBegin() { return true; }
+  virtual bool arrayEnd() { return true; }
+  virtual bool objectBegin() { return true; }
+  /// The key of the object property whose value is the next event.
+  virtual bool objectKey(llvm::StringRef Key) { return true; }
+  virtual bool objectEnd() { return true; }
+};
+
+/// Parses the provided JSON source, reporting its contents to \p H, or returns
+/// a ParseError. Events are reported as they are parsed, so \p H may have
+/// received some even if an error is returned.
+///
+/// This allocates no memory besides a stack for the nesting of arrays and
+/// objects, so it is much faster than building a Value and can process large
+/// documents, for example memory-mapped with MemoryBuffer::getFile(), in
+/// constant memory.
+llvm::Error parse(llvm::StringRef JSON, Handler &H);
+
 class ParseError : public llvm::ErrorInfo<ParseError> {
   const char *Msg;
-  unsigned Line, Column, Offset;
+  unsigned Line, Column;
+  uint64_t Offset;
 
 public:
   static char ID;
-  ParseError(const char *Msg, unsigned Line, unsigned Column, unsigned Offset)
+  ParseError(const char *Msg, unsigned Line, unsigned Column, uint64_t Offset)
       : Msg(Msg), Line(Line), Column(Column), Offset(Offset) {}
   void log(llvm::raw_ostream &OS) const override {
     OS << llvm::formatv("[{0}:{1}, byte={2}]: {3}", Line, Column, Offset, Msg);
@@ -783,6 +831,13 @@ class OStream {
     Contents();
     objectEnd();
   }
+  /// Emit an externally-serialized value.
+  /// The caller must write exactly one valid JSON value to the provided stream.
+  /// No validation or formatting of this value occurs.
+  void rawValue(llvm::function_ref<void(raw_ostream &)> Contents) {
+    valueBegin();
+    Contents(OS);
+  }
 
   // High level functions to output object attributes.
   // Valid only within an object (any number of times).
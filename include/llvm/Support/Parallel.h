@@ -41,6 +41,16 @@ struct is_execution_policy
 constexpr sequential_execution_policy seq{};
 constexpr parallel_execution_policy par{};
 
+/// Limit the number of threads used by the parallel algorithms to \p N. A
+/// value of 0 selects hardware_concurrency(). This only has an effect if it
+/// is called before the first parallel algorithm is run, since the worker
+/// threads are created on first use. A limit of 1 runs everything on the
+/// calling thread.
+void setMaxThreads(unsigned N);
+
+/// Returns the number of threads the parallel algorithms will use.
+unsigned getMaxThreads();
+
 namespace detail {
 
 #if LLVM_ENABLE_THREADS
@@ -59,18 +69,34 @@ public:
     ++Count;
   }
 
-  void dec() {
+  /// Returns true if this brought the count to zero. The latch may be gone as
+  /// soon as that happens, so the caller must not touch it afterwards.
+  bool dec() {
     std::lock_guard<std::mutex> lock(Mutex);
-    if (--Count == 0)
-      Cond.notify_all();
+    if (--Count != 0)
+      return false;
+    Cond.notify_all();
+    return true;
   }
 
   void sync() const {
     std::unique_lock<std::mutex> lock(Mutex);
     Cond.wait(lock, [&] { return Count == 0; });
   }
+
+  /// Returns true if the count has reached zero. Does not block.
+  bool isDone() const {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Count == 0;
+  }
 };
 
+/// A group of tasks that can be waited on as a unit.
+///
+/// Task groups may be nested: a task running on a worker thread can create
+/// its own TaskGroup and wait for it. While waiting, a worker thread runs
+/// other pending tasks, and only sleeps when there are none, so nesting cannot
+/// exhaust the executor's threads.
 class TaskGroup {
   Latch L;
   bool Parallel;
@@ -81,7 +107,7 @@ public:
 
   void spawn(std::function<void()> f);
 
-  void sync() const { L.sync(); }
+  void sync() const;
 };
 
 #if defined(_MSC_VER)
@@ -21,6 +21,7 @@
 struct llvm_regex;
 
 namespace llvm {
+  class RegexDFA;
   class StringRef;
   template<typename T> class SmallVectorImpl;
 
@@ -49,6 +50,7 @@ namespace llvm {
     Regex &operator=(Regex regex) {
       std::swap(preg, regex.preg);
       std::swap(error, regex.error);
+      std::swap(dfa, regex.dfa);
       return *this;
     }
     Regex(Regex &&regex);
@@ -95,6 +97,10 @@ namespace llvm {
   private:
     struct llvm_regex *preg;
     int error;
+    /// Matcher that runs in linear time, used instead of the backtracking
+    /// engine when the regex allows it. Null for basic regular expressions
+    /// and for regexes with backreferences or word boundaries.
+    RegexDFA *dfa;
   };
 }
 
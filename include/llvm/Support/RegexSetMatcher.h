@@ -0,0 +1,113 @@
+//===-- RegexSetMatcher.h - many regexes for SpecialCaseList ----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//===----------------------------------------------------------------------===//
+//
+// RegexSetMatcher matches a query against many regular expressions at once,
+// for SpecialCaseList, where lists of tens of thousands of entries are common.
+//
+// Each expression has a required literal: a string that occurs in every text
+// the expression matches, such as "chrome" in "_ZN6chrome.*". The required
+// literals are added to an Aho-Corasick automaton, so that a single pass over
+// the query finds the few expressions that can match it, and only those are
+// checked.
+//
+// Most entries are wildcards: literal characters, '.', bracket expressions
+// and '.*'. Those are split at their '.*' into segments of fixed length and
+// checked by placing the segments from the left, which is exact for such
+// expressions. The other expressions are checked with Regex.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_REGEXSETMATCHER_H
+#define LLVM_SUPPORT_REGEXSETMATCHER_H
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Regex.h"
+#include <bitset>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class StringRef;
+
+class RegexSetMatcher {
+public:
+  RegexSetMatcher();
+  ~RegexSetMatcher();
+
+  /// Adds the extended regular expression \p Regex, which must match all of
+  /// a query. Returns false and sets \p Error if it is not valid.
+  bool insert(StringRef Regex, std::string &Error);
+
+  /// Prepares the matcher for queries. Must be called after inserting
+  /// expressions and before calling match().
+  void finalize();
+
+  /// Returns the number of expressions added so far.
+  unsigned size() const { return Entries.size(); }
+
+  /// Returns the index, in order of insertion, of the first expression that
+  /// matches all of \p Query, if any.
+  Optional<unsigned> match(StringRef Query) const;
+
+private:
+  /// One character of a wildcard.
+  struct Atom {
+    enum KindTy : uint8_t { Char, Any, Set };
+    KindTy Kind;
+    uint8_t C;
+    /// The index in CharSets of a Set.
+    unsigned SetIndex;
+  };
+
+  struct Entry {
+    /// The expression, if it is not a wildcard.
+    std::unique_ptr<Regex> RE;
+    /// The atoms of all segments of a wildcard, and where each segment ends.
+    unsigned AtomsBegin = 0, AtomsEnd = 0;
+    unsigned SegmentsBegin = 0, SegmentsEnd = 0;
+    /// Whether the wildcard starts or ends with '.*'.
+    bool LeadingGap = false, TrailingGap = false;
+  };
+
+  /// A node of the trie of required literals.
+  struct Node {
+    SmallVector<std::pair<uint8_t, unsigned>, 2> Children;
+    /// The longest proper suffix of this node that is in the trie.
+    unsigned Fail = 0;
+    /// The longest proper suffix of this node that is a literal, if any.
+    unsigned NextOutput = 0;
+    /// The entries requiring the literal that ends here.
+    SmallVector<unsigned, 1> Entries;
+  };
+
+  bool insertWildcard(StringRef Regex);
+  bool atomMatches(const Atom &A, uint8_t C) const;
+  bool segmentMatchesAt(unsigned Begin, unsigned End, const char *S) const;
+  bool wildcardMatches(const Entry &E, StringRef Query) const;
+  unsigned getChild(unsigned N, uint8_t C) const;
+  void addRequiredLiteral(StringRef Literal, unsigned Index);
+
+  std::vector<Entry> Entries;
+  std::vector<Atom> Atoms;
+  std::vector<unsigned> SegmentEnds;
+  std::vector<std::bitset<256>> CharSets;
+
+  /// The trie of required literals, and the links of the Aho-Corasick
+  /// automaton once finalized.
+  std::vector<Node> Nodes;
+  bool Finalized = true;
+  /// The transitions of the root, which are looked up for most characters.
+  unsigned RootChildren[256];
+  /// The entries without a required literal, which are always checked.
+  std::vector<unsigned> Unfiltered;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_REGEXSETMATCHER_H
@@ -18,6 +18,7 @@
 #include "llvm/ADT/ArrayRef.h"
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 namespace llvm {
@@ -56,6 +57,13 @@ public:
   /// Returns a raw 160-bit SHA1 hash for the given data.
   static std::array<uint8_t, 20> hash(ArrayRef<uint8_t> Data);
 
+  /// Returns a raw 160-bit hash of \p Data, split into chunks of
+  /// \p ChunkSize bytes that are hashed in parallel. The result is the SHA1
+  /// of the sizes and of the SHA1 of each chunk, which differs from hash()
+  /// and depends on \p ChunkSize, a multiple of 64.
+  static std::array<uint8_t, 20> hashTree(ArrayRef<uint8_t> Data,
+                                          size_t ChunkSize = 1 << 20);
+
 private:
   /// Define some constants.
   /// "static constexpr" would be cleaner but MSVC does not support it yet.
@@ -64,12 +72,9 @@ private:
 
   // Internal State
   struct {
-    union {
-      uint8_t C[BLOCK_LENGTH];
-      uint32_t L[BLOCK_LENGTH / 4];
-    } Buffer;
+    uint8_t Buffer[BLOCK_LENGTH];
     uint32_t State[HASH_LENGTH / 4];
-    uint32_t ByteCount;
+    uint64_t ByteCount;
     uint8_t BufferOffset;
   } InternalState;
 
@@ -77,8 +82,6 @@ private:
   uint32_t HashResult[HASH_LENGTH / 4];
 
   // Helper
-  void writebyte(uint8_t data);
-  void hashBlock();
   void addUncounted(uint8_t data);
   void pad();
 };
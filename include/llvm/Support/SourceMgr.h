@@ -74,13 +74,40 @@ private:
     /// offset corresponding to a particular SMLoc).
     mutable VariableSizeOffsets OffsetCache;
 
-    /// Populate \c OffsetCache and look up a given \p Ptr in it, assuming
-    /// it points somewhere into \c Buffer. The static type parameter \p T
-    /// must be an unsigned integer type from uint{8,16,32,64}_t large
-    /// enough to store offsets inside \c Buffer.
-    template<typename T>
+    /// Number of bytes at the start of Buffer that have been scanned into
+    /// \c OffsetCache. The cache is only extended as far as lookups need, so
+    /// a diagnostic near the start of a large buffer does not scan all of it.
+    mutable size_t OffsetCacheEnd = 0;
+
+    /// Return \c OffsetCache, with the line-endings before offset \p End
+    /// indexed. The static type parameter \p T must be an unsigned integer
+    /// type from uint{8,16,32,64}_t large enough to store offsets inside
+    /// \c Buffer.
+    template <typename T> std::vector<T> &getOffsets(size_t End) const;
+
+    /// Return \c OffsetCache, with at least \p NumLines line-endings
+    /// indexed if the buffer has that many.
+    template <typename T>
+    std::vector<T> &getOffsetsForLines(size_t NumLines) const;
+
+    /// Look up a given \p Ptr in \c OffsetCache, assuming it points
+    /// somewhere into \c Buffer.
+    template <typename T>
+    unsigned getLineNumberSpecialized(const char *Ptr) const;
+
+    /// Return the start of line \p LineNo, or null if the buffer has fewer
+    /// lines.
+    template <typename T>
+    const char *getPointerForLineNumberSpecialized(unsigned LineNo) const;
+
+    /// Return the 1-based line number containing \p Ptr, which must point
+    /// into \c Buffer.
     unsigned getLineNumber(const char *Ptr) const;
 
+    /// Return a pointer to the first character of line \p LineNo, or null if
+    /// the buffer has fewer lines.
+    const char *getPointerForLineNumber(unsigned LineNo) const;
+
     /// This is the location of the parent include, or null if at the top level.
     SMLoc IncludeLoc;
 
@@ -172,16 +199,23 @@ public:
   unsigned FindBufferContainingLoc(SMLoc Loc) const;
 
   /// Find the line number for the specified location in the specified file.
-  /// This is not a fast method.
+  /// The line endings of the buffer are indexed up to the location, so this
+  /// is a binary search once earlier lookups have indexed that far.
   unsigned FindLineNumber(SMLoc Loc, unsigned BufferID = 0) const {
     return getLineAndColumn(Loc, BufferID).first;
   }
 
   /// Find the line and column number for the specified location in the
-  /// specified file. This is not a fast method.
+  /// specified file. Both come from the same index as FindLineNumber().
   std::pair<unsigned, unsigned> getLineAndColumn(SMLoc Loc,
                                                  unsigned BufferID = 0) const;
 
+  /// Given a line and column number in a mapped buffer, turn it into an SMLoc.
+  /// This will return a null SMLoc if the line/column location is invalid.
+  /// Columns are counted in bytes from 1, as in getLineAndColumn().
+  SMLoc FindLocForLineAndColumn(unsigned BufferID, unsigned LineNo,
+                                unsigned ColNo);
+
   /// Emit a message about the specified location with the specified string.
   ///
   /// \param ShowColors Display colored messages if output is a terminal and
@@ -54,7 +54,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Regex.h"
-#include "llvm/Support/TrigramIndex.h"
+#include "llvm/Support/RegexSetMatcher.h"
 #include <string>
 #include <vector>
 
@@ -113,18 +113,21 @@ protected:
   /// Represents a set of regular expressions.  Regular expressions which are
   /// "literal" (i.e. no regex metacharacters) are stored in Strings.  The
   /// reason for doing so is efficiency; StringMap is much faster at matching
-  /// literal strings than Regex.
+  /// literal strings than Regex.  The others are matched all at once by a
+  /// RegexSetMatcher.
   class Matcher {
   public:
     bool insert(std::string Regexp, unsigned LineNumber, std::string &REError);
+    // Prepares the matcher for queries after the last insert.
+    void finalize();
     // Returns the line number in the source file that this query matches to.
     // Returns zero if no match is found.
     unsigned match(StringRef Query) const;
 
   private:
     StringMap<unsigned> Strings;
-    TrigramIndex Trigrams;
-    std::vector<std::pair<std::unique_ptr<Regex>, unsigned>> RegExes;
+    RegexSetMatcher RegExes;
+    std::vector<unsigned> RegExLines;
   };
 
   using SectionEntries = StringMap<StringMap<Matcher>>;
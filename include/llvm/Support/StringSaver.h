@@ -16,6 +16,8 @@
 
 namespace llvm {
 
+class ConcurrentBumpPtrAllocator;
+
 /// Saves strings in the provided stable storage and returns a
 /// StringRef with a stable character pointer.
 class StringSaver final {
@@ -31,6 +33,21 @@ public:
   StringRef save(const std::string &S) { return save(StringRef(S)); }
 };
 
+/// A StringSaver that can be shared between threads. Strings are saved in the
+/// calling thread's slabs of a ConcurrentBumpPtrAllocator.
+class ConcurrentStringSaver final {
+  ConcurrentBumpPtrAllocator &Alloc;
+
+public:
+  ConcurrentStringSaver(ConcurrentBumpPtrAllocator &Alloc) : Alloc(Alloc) {}
+
+  // All returned strings are null-terminated: *save(S).end() == 0.
+  StringRef save(const char *S) { return save(StringRef(S)); }
+  StringRef save(StringRef S);
+  StringRef save(const Twine &S) { return save(StringRef(S.str())); }
+  StringRef save(const std::string &S) { return save(StringRef(S)); }
+};
+
 /// Saves strings in the provided stable storage and returns a StringRef with a
 /// stable character pointer. Saving the same string yields the same StringRef.
 ///
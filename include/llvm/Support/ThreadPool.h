@@ -13,30 +13,86 @@
 #ifndef LLVM_SUPPORT_THREAD_POOL_H
 #define LLVM_SUPPORT_THREAD_POOL_H
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/FunctionExtras.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/thread.h"
 
 #include <future>
 
-#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 namespace llvm {
 
+class ThreadPoolTaskGroup;
+
+namespace detail {
+/// Member pointers are wrapped with std::mem_fn so that every callable given
+/// to the pool can be invoked with plain call syntax.
+template <typename Function>
+typename std::enable_if<
+    std::is_member_pointer<typename std::decay<Function>::type>::value,
+    decltype(std::mem_fn(std::declval<typename std::decay<Function>::type>()))>::type
+asPoolCallable(Function &&F) {
+  return std::mem_fn(F);
+}
+
+template <typename Function>
+typename std::enable_if<
+    !std::is_member_pointer<typename std::decay<Function>::type>::value,
+    typename std::decay<Function>::type>::type
+asPoolCallable(Function &&F) {
+  return std::forward<Function>(F);
+}
+
+/// A callable and a copy of the arguments to call it with. As with std::bind,
+/// the arguments are decayed and std::reference_wrapper arguments are passed
+/// by reference, but there is no support for placeholders or nested binds.
+template <typename Function, typename... Args> class BoundPoolTask {
+  using CallableTy =
+      decltype(asPoolCallable(std::declval<Function>()));
+  using ArgsTy = decltype(std::make_tuple(std::declval<Args>()...));
+
+  CallableTy F;
+  ArgsTy ArgList;
+
+public:
+  using ResultTy = decltype(
+      apply_tuple(std::declval<CallableTy &>(), std::declval<ArgsTy &>()));
+
+  BoundPoolTask(Function &&F, Args &&... ArgList)
+      : F(asPoolCallable(std::forward<Function>(F))),
+        ArgList(std::make_tuple(std::forward<Args>(ArgList)...)) {}
+
+  ResultTy operator()() { return apply_tuple(F, ArgList); }
+};
+} // namespace detail
+
 /// A ThreadPool for asynchronous parallel execution on a defined number of
 /// threads.
 ///
 /// The pool keeps a vector of threads alive, waiting on a condition variable
 /// for some work to become available.
+///
+/// Tasks can also be submitted through a ThreadPoolTaskGroup, which can be
+/// waited on independently of the rest of the pool, can be scheduled ahead of
+/// normal priority work, and can hold tasks back until other groups are done.
 class ThreadPool {
 public:
-  using TaskTy = std::function<void()>;
-  using PackagedTaskTy = std::packaged_task<void()>;
+  using TaskTy = unique_function<void()>;
+
+  /// Scheduling lanes. Queued high priority tasks are always started before
+  /// queued normal priority tasks.
+  enum class Priority { Normal, High };
 
   /// Construct a pool with the number of threads found by
   /// hardware_concurrency().
@@ -51,50 +107,184 @@ public:
   /// Asynchronous submission of a task to the pool. The returned future can be
   /// used to wait for the task to finish and is *non-blocking* on destruction.
   template <typename Function, typename... Args>
-  inline std::shared_future<void> async(Function &&F, Args &&... ArgList) {
-    auto Task =
-        std::bind(std::forward<Function>(F), std::forward<Args>(ArgList)...);
-    return asyncImpl(std::move(Task));
+  inline std::shared_future<
+      typename detail::BoundPoolTask<Function, Args...>::ResultTy>
+  async(Function &&F, Args &&... ArgList) {
+    return asyncImpl(
+        detail::BoundPoolTask<Function, Args...>(
+            std::forward<Function>(F), std::forward<Args>(ArgList)...),
+        nullptr, None);
   }
 
   /// Asynchronous submission of a task to the pool. The returned future can be
   /// used to wait for the task to finish and is *non-blocking* on destruction.
   template <typename Function>
-  inline std::shared_future<void> async(Function &&F) {
-    return asyncImpl(std::forward<Function>(F));
+  inline auto async(Function &&F) -> std::shared_future<decltype(F())> {
+    return asyncImpl(std::forward<Function>(F), nullptr, None);
   }
 
   /// Blocking wait for all the threads to complete and the queue to be empty.
-  /// It is an error to try to add new tasks while blocking on this call.
+  /// It is an error to try to add new tasks while blocking on this call, or to
+  /// call it from a task running on this pool.
   void wait();
 
+  /// Blocking wait for the tasks of \p Group to complete. When called from a
+  /// task running on this pool, the calling thread runs queued tasks while it
+  /// waits, so groups can be waited on from within other tasks.
+  void wait(ThreadPoolTaskGroup &Group);
+
 private:
+  friend class ThreadPoolTaskGroup;
+
+  struct QueuedTask {
+    TaskTy Task;
+    ThreadPoolTaskGroup *Group = nullptr;
+  };
+
+  struct DeferredTask {
+    QueuedTask Task;
+    /// Groups that still have pending tasks. The task is queued once this is
+    /// empty.
+    SmallVector<ThreadPoolTaskGroup *, 2> Deps;
+  };
+
   /// Asynchronous submission of a task to the pool. The returned future can be
   /// used to wait for the task to finish and is *non-blocking* on destruction.
-  std::shared_future<void> asyncImpl(TaskTy F);
+  template <typename Function>
+  auto asyncImpl(Function &&F, ThreadPoolTaskGroup *Group,
+                 ArrayRef<ThreadPoolTaskGroup *> Deps)
+      -> std::shared_future<decltype(F())> {
+    using ResTy = decltype(F());
+#if LLVM_ENABLE_THREADS
+    /// Wrap the Task in a packaged_task to return a future object.
+    std::packaged_task<ResTy()> PackagedTask(std::forward<Function>(F));
+    std::shared_future<ResTy> Future = PackagedTask.get_future().share();
+    enqueue(std::move(PackagedTask), Group, Deps);
+#else
+    // Get a Future with launch::deferred execution using std::async, and wrap
+    // it so that both ThreadPool::wait() can operate and the returned future
+    // can be sync'ed on.
+    std::shared_future<ResTy> Future =
+        std::async(std::launch::deferred, std::forward<Function>(F)).share();
+    enqueue([Future]() { Future.get(); }, Group, Deps);
+#endif
+    return Future;
+  }
+
+  /// Queue \p Task, or hold it back until every group in \p Deps is idle.
+  void enqueue(TaskTy Task, ThreadPoolTaskGroup *Group,
+               ArrayRef<ThreadPoolTaskGroup *> Deps);
+
+  /// Remove and return the next task to run, preferring tasks of \p Group if
+  /// it is non-null. Requires QueueLock.
+  QueuedTask popTask(ThreadPoolTaskGroup *Group);
+
+  /// Returns true if there are queued tasks. Requires QueueLock.
+  bool hasQueuedTasks() const {
+    return !HighPriorityTasks.empty() || !Tasks.empty();
+  }
+
+  /// Run \p Task and account for its completion.
+  void runTask(QueuedTask &Task);
+
+  /// Account for the completion of a task of \p Group, releasing deferred
+  /// tasks whose dependencies are now complete. Requires QueueLock. Returns
+  /// true if any task was queued.
+  bool taskDone(ThreadPoolTaskGroup *Group);
 
   /// Threads in flight
   std::vector<llvm::thread> Threads;
 
-  /// Tasks waiting for execution in the pool.
-  std::queue<PackagedTaskTy> Tasks;
+  /// Tasks waiting for execution in the pool, one queue per priority.
+  std::deque<QueuedTask> HighPriorityTasks;
+  std::deque<QueuedTask> Tasks;
+
+  /// Tasks waiting for other groups to complete.
+  std::vector<DeferredTask> DeferredTasks;
 
-  /// Locking and signaling for accessing the Tasks queue.
+  /// Locking and signaling for accessing the task queues.
   std::mutex QueueLock;
   std::condition_variable QueueCondition;
 
-  /// Locking and signaling for job completion
-  std::mutex CompletionLock;
+  /// Signaling for job completion, also guarded by QueueLock.
   std::condition_variable CompletionCondition;
 
   /// Keep track of the number of thread actually busy
-  std::atomic<unsigned> ActiveThreads;
+  unsigned ActiveThreads = 0;
 
 #if LLVM_ENABLE_THREADS // avoids warning for unused variable
   /// Signal for the destruction of the pool, asking thread to exit.
   bool EnableFlag;
 #endif
 };
-}
+
+/// A group of tasks submitted to a ThreadPool.
+///
+/// A group can be waited on without waiting for unrelated work in the pool,
+/// and tasks in other groups can be made to wait until it has finished, which
+/// lets pipelines start a stage as soon as the stages it reads from are done:
+///
+/// \code
+///   ThreadPoolTaskGroup Load(Pool), Merge(Pool);
+///   for (auto &Input : Inputs)
+///     Load.async([&] { load(Input); });
+///   Merge.asyncAfter({&Load}, [&] { merge(); });
+///   Merge.wait();
+/// \endcode
+///
+/// The group must outlive the tasks submitted through it; the destructor
+/// waits for them.
+class ThreadPoolTaskGroup {
+public:
+  explicit ThreadPoolTaskGroup(
+      ThreadPool &Pool, ThreadPool::Priority Prio = ThreadPool::Priority::Normal)
+      : Pool(Pool), Prio(Prio) {}
+
+  /// Blocking destructor: waits for all tasks of the group to complete.
+  ~ThreadPoolTaskGroup() { wait(); }
+
+  /// Asynchronous submission of a task to the group, see ThreadPool::async().
+  template <typename Function, typename... Args>
+  inline std::shared_future<
+      typename detail::BoundPoolTask<Function, Args...>::ResultTy>
+  async(Function &&F, Args &&... ArgList) {
+    return Pool.asyncImpl(
+        detail::BoundPoolTask<Function, Args...>(
+            std::forward<Function>(F), std::forward<Args>(ArgList)...),
+        this, None);
+  }
+
+  /// Asynchronous submission of a task to the group, see ThreadPool::async().
+  template <typename Function>
+  inline auto async(Function &&F) -> std::shared_future<decltype(F())> {
+    return Pool.asyncImpl(std::forward<Function>(F), this, None);
+  }
+
+  /// Submit \p F to the group, to be started only once none of the groups in
+  /// \p Deps have pending tasks. Tasks added to those groups after this call
+  /// are not waited for if the groups have become idle in the meantime.
+  template <typename Function>
+  inline auto asyncAfter(ArrayRef<ThreadPoolTaskGroup *> Deps, Function &&F)
+      -> std::shared_future<decltype(F())> {
+    return Pool.asyncImpl(std::forward<Function>(F), this, Deps);
+  }
+
+  /// Blocking wait for the tasks of this group, see ThreadPool::wait().
+  void wait() { Pool.wait(*this); }
+
+  ThreadPool &getPool() const { return Pool; }
+  ThreadPool::Priority getPriority() const { return Prio; }
+
+private:
+  friend class ThreadPool;
+
+  ThreadPool &Pool;
+  ThreadPool::Priority Prio;
+
+  /// Number of deferred, queued and running tasks. Guarded by the pool's
+  /// QueueLock.
+  unsigned Pending = 0;
+};
+} // namespace llvm
 
 #endif // LLVM_SUPPORT_THREAD_POOL_H
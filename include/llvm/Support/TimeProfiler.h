@@ -18,10 +18,13 @@ extern TimeTraceProfiler *TimeTraceProfilerInstance;
 
 /// Initialize the time trace profiler.
 /// This sets up the global \p TimeTraceProfilerInstance
-/// variable to be the profiler instance.
+/// variable to be the profiler instance. Every thread that begins a time
+/// section afterwards gets a profiler of its own, so sections may be traced
+/// from any number of threads at once.
 void timeTraceProfilerInitialize();
 
-/// Cleanup the time trace profiler, if it was initialized.
+/// Cleanup the time trace profiler, if it was initialized. No thread may be
+/// tracing anymore.
 void timeTraceProfilerCleanup();
 
 /// Is the time trace profiler enabled, i.e. initialized?
@@ -32,6 +35,8 @@ inline bool timeTraceProfilerEnabled() {
 /// Write profiling data to output file.
 /// Data produced is JSON, in Chrome "Trace Event" format, see
 /// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU/preview
+/// The events of every thread are written, each thread with its own id. All
+/// time sections must have been ended, and no thread may be tracing anymore.
 void timeTraceProfilerWrite(raw_pwrite_stream &OS);
 
 /// Manually begin a time section, with the given \p Name and \p Detail.
@@ -45,6 +50,14 @@ void timeTraceProfilerBegin(StringRef Name,
 /// Manually end the last time section.
 void timeTraceProfilerEnd();
 
+/// Record an event with no duration, such as a cache miss or the start of a
+/// job, on the calling thread.
+void timeTraceProfilerInstant(StringRef Name, StringRef Detail = "");
+
+/// Record the current value of the counter \p Name, such as the number of
+/// jobs in a queue. Counters are shown as graphs over time.
+void timeTraceProfilerCounter(StringRef Name, int64_t Value);
+
 /// The TimeTraceScope is a helper class to call the begin and end functions
 /// of the time trace profiler.  When the object is constructed, it begins
 /// the section; and when it is destroyed, it stops it. If the time profiler
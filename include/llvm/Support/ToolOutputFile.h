@@ -49,6 +49,12 @@ public:
 
   ToolOutputFile(StringRef Filename, int FD);
 
+  /// Open \p Filename for mapped output if \p Mapped is true, see
+  /// raw_fd_ostream::enableMappedOutput(). Outputs that cannot be mapped,
+  /// such as "-" or a pipe, silently use ordinary writes.
+  ToolOutputFile(StringRef Filename, std::error_code &EC,
+                 sys::fs::OpenFlags Flags, bool Mapped);
+
   /// Return the contained raw_fd_ostream.
   raw_fd_ostream &os() { return OS; }
 
@@ -18,6 +18,8 @@
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/Chrono.h"
@@ -29,6 +31,7 @@
 #include <cstdint>
 #include <ctime>
 #include <memory>
+#include <mutex>
 #include <stack>
 #include <string>
 #include <system_error>
@@ -395,6 +398,67 @@ private:
   virtual void anchor();
 };
 
+/// A file system that caches the results of status() and dir_begin() of the
+/// underlying file system, for clients that probe many paths, such as search
+/// paths for headers, sources or debug files.
+///
+/// Missing paths are cached too. After a miss, the parent directory is listed
+/// once, so that later lookups of other names in it that are not in the
+/// listing fail without asking the underlying file system. This must not be
+/// used with case-insensitive file systems, and by default it is only used on
+/// platforms whose file systems are usually case-sensitive.
+///
+/// The cache assumes that the underlying file system only changes through
+/// invalidate(), and that its working directory only changes through this
+/// file system. It may be used from several threads.
+class CachingFileSystem : public ProxyFileSystem {
+public:
+  explicit CachingFileSystem(IntrusiveRefCntPtr<FileSystem> FS,
+                             Optional<bool> UseDirectoryListings = None);
+  ~CachingFileSystem() override;
+
+  llvm::ErrorOr<Status> status(const Twine &Path) override;
+  llvm::ErrorOr<std::unique_ptr<File>>
+  openFileForRead(const Twine &Path) override;
+  directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override;
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
+
+  /// Forgets what is known about \p Path, and the listings of it and of its
+  /// parent directory, after it has been created, changed or removed.
+  void invalidate(const Twine &Path);
+
+  /// Forgets everything.
+  void invalidateAll();
+
+private:
+  struct DirectoryListing {
+    std::vector<directory_entry> Entries;
+    /// The file names of the entries.
+    StringSet<> Names;
+    /// Set if the directory does not exist.
+    std::error_code EC;
+  };
+
+  /// Makes \p Path absolute and removes its '.' components, or returns false
+  /// if the working directory is not known.
+  bool getKey(const Twine &Path, SmallVectorImpl<char> &Key) const;
+  /// Returns whether the listing of a directory containing \p Key shows that
+  /// it does not exist. Must be called with Mutex held.
+  bool isMissingFromListing(StringRef Key) const;
+  /// Lists \p Dir, unless it was listed already, and returns its listing, or
+  /// null if it could not be listed for another reason than not existing.
+  std::shared_ptr<DirectoryListing> listDirectory(StringRef Dir,
+                                                  std::error_code &EC);
+  void recordStatus(StringRef Key, const llvm::ErrorOr<Status> &S);
+
+  bool UseDirectoryListings;
+  mutable std::mutex Mutex;
+  Optional<std::string> WorkingDirectory;
+  /// The results of status(), successful or not, by absolute path.
+  StringMap<llvm::ErrorOr<Status>> Statuses;
+  StringMap<std::shared_ptr<DirectoryListing>> Listings;
+};
+
 namespace detail {
 
 class InMemoryDirectory;
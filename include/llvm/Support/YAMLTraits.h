@@ -1487,10 +1487,24 @@ private:
 
     static bool classof(const MapHNode *) { return true; }
 
-    using NameToNode = StringMap<std::unique_ptr<HNode>>;
+    struct Entry {
+      Entry(StringRef Key, std::unique_ptr<HNode> Value)
+          : Key(Key), Value(std::move(Value)) {}
+
+      StringRef Key;
+      std::unique_ptr<HNode> Value;
+      /// Whether the key was mapped since beginMapping().
+      bool Used = false;
+    };
+
+    /// Returns the entry for \p Key, if any. Searches start after the last
+    /// entry found, so that mapping the keys in the order they are written,
+    /// as is usual, takes constant time per key.
+    Entry *find(StringRef Key);
 
-    NameToNode Mapping;
-    SmallVector<std::string, 6> ValidKeys;
+    /// The keys and values in document order.
+    std::vector<Entry> Mapping;
+    unsigned NextEntry = 0;
   };
 
   class SequenceHNode : public HNode {
@@ -19,6 +19,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -35,6 +36,7 @@ namespace fs {
 enum FileAccess : unsigned;
 enum OpenFlags : unsigned;
 enum CreationDisposition : unsigned;
+class mapped_file_region;
 } // end namespace fs
 } // end namespace sys
 
@@ -378,9 +380,38 @@ class raw_fd_ostream : public raw_pwrite_stream {
 
   uint64_t pos;
 
+  /// The window of the file being written to in mapped output mode, see
+  /// enableMappedOutput(). The stream's buffer points into it.
+  std::unique_ptr<sys::fs::mapped_file_region> Mapping;
+
+  /// The file offset of the start of Mapping.
+  uint64_t MappingOffset = 0;
+
+  /// The size of the next window to map. Windows grow geometrically.
+  size_t MappedChunkSize = 0;
+
+  /// The size the file has been extended to while mapped, and the end of the
+  /// data in it. The file is truncated to the latter when mapping ends.
+  uint64_t MappedFileSize = 0;
+  uint64_t MappedDataEnd = 0;
+
   /// See raw_ostream::write_impl.
   void write_impl(const char *Ptr, size_t Size) override;
 
+  /// Copy data to the mapped file and advance the stream's buffer.
+  void write_mapped(const char *Ptr, size_t Size);
+
+  /// Map the window of the file containing \p Offset, extending the file if
+  /// needed.
+  std::error_code mapWindowAt(uint64_t Offset);
+
+  /// Point the stream's buffer at the rest of the current window.
+  void resetMappedBuffer();
+
+  /// Unmap the file, truncate it to the data written and continue with
+  /// ordinary writes.
+  void exitMappedOutput();
+
   void pwrite_impl(const char *Ptr, size_t Size, uint64_t Offset) override;
 
   /// Return the current position within the stream, not counting the bytes
@@ -428,6 +459,19 @@ public:
 
   bool supportsSeeking() { return SupportsSeeking; }
 
+  /// Write the rest of the output through a memory mapping of the file
+  /// instead of write(2) calls. Output is formatted directly into the
+  /// mapping, which is extended in growing chunks, and the file is truncated
+  /// to the data written when the stream is closed or destroyed.
+  ///
+  /// The file must be a regular file opened for both reading and writing
+  /// (sys::fs::FA_Read | sys::fs::FA_Write). Otherwise an error is returned
+  /// and the stream keeps using ordinary writes.
+  std::error_code enableMappedOutput();
+
+  /// Return true if output goes through a memory mapping of the file.
+  bool isMappedOutput() const { return Mapping != nullptr; }
+
   /// Flushes the stream and repositions the underlying file descriptor position
   /// to the offset specified from the beginning of the file.
   uint64_t seek(uint64_t off);
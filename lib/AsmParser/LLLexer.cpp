@@ -18,10 +18,19 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/SourceMgr.h"
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LLVM_LLLEXER_SSE2 1
+#include <emmintrin.h>
+#endif
 
 using namespace llvm;
 
@@ -110,11 +119,8 @@ void LLLexer::FP80HexToIntPair(const char *Buffer, const char *End,
 }
 
 // UnEscapeLexed - Run through the specified buffer and change \xx codes to the
-// appropriate character.
-static void UnEscapeLexed(std::string &Str) {
-  if (Str.empty()) return;
-
-  char *Buffer = &Str[0], *EndBuffer = Buffer+Str.size();
+// appropriate character, in place. Returns the new end of the buffer.
+static char *UnEscapeLexed(char *Buffer, char *EndBuffer) {
   char *BOut = Buffer;
   for (char *BIn = Buffer; BIn != EndBuffer; ) {
     if (BIn[0] == '\\') {
@@ -134,22 +140,100 @@ static void UnEscapeLexed(std::string &Str) {
       *BOut++ = *BIn++;
     }
   }
-  Str.resize(BOut-Buffer);
+  return BOut;
 }
 
 /// isLabelChar - Return true for [-a-zA-Z$._0-9].
 static bool isLabelChar(char C) {
-  return isalnum(static_cast<unsigned char>(C)) || C == '-' || C == '$' ||
-         C == '.' || C == '_';
+  return isAlnum(C) || C == '-' || C == '$' || C == '.' || C == '_';
+}
+
+#if LLVM_LLLEXER_SSE2
+static __m128i load16(const char *Ptr) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+}
+
+/// Return the bytes of Chunk in [Lo, Hi]. The bounds are ASCII, so bytes with
+/// the high bit set, which compare as negative, are never in range.
+static __m128i inRange(__m128i Chunk, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(Chunk, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmplt_epi8(Chunk, _mm_set1_epi8(Hi + 1)));
+}
+
+/// Return a bit mask of the bytes of Chunk that are not in [-a-zA-Z$._0-9].
+static unsigned nonLabelCharMask(__m128i Chunk) {
+  // Setting bit 5 maps [A-Z] onto [a-z] and nothing else onto [a-z].
+  __m128i Lower = _mm_or_si128(Chunk, _mm_set1_epi8(0x20));
+  __m128i Label = _mm_or_si128(inRange(Lower, 'a', 'z'),
+                               inRange(Chunk, '0', '9'));
+  Label = _mm_or_si128(Label, inRange(Chunk, '-', '.'));
+  Label = _mm_or_si128(Label, _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('$')));
+  Label = _mm_or_si128(Label, _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('_')));
+  return ~_mm_movemask_epi8(Label) & 0xFFFF;
+}
+
+/// Return a bit mask of the bytes of Chunk that are not ' ', '\t' or '\n'.
+static unsigned nonSpaceMask(__m128i Chunk) {
+  __m128i Space = _mm_or_si128(_mm_cmpeq_epi8(Chunk, _mm_set1_epi8(' ')),
+                               _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('\t')));
+  Space = _mm_or_si128(Space, _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('\n')));
+  return ~_mm_movemask_epi8(Space) & 0xFFFF;
+}
+
+/// Return a bit mask of the bytes of Chunk that are '\n' or '\r'.
+static unsigned lineEndMask(__m128i Chunk) {
+  return _mm_movemask_epi8(
+      _mm_or_si128(_mm_cmpeq_epi8(Chunk, _mm_set1_epi8('\n')),
+                   _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('\r'))));
+}
+#endif
+
+// The scanners below look at 16 bytes at a time where SSE2 is available. They
+// never read past End, the nul at the end of the buffer, which also stops the
+// scalar loops that handle the tail.
+
+/// skipLabelChars - Return the first character at or after Ptr that is not in
+/// [-a-zA-Z$._0-9].
+static const char *skipLabelChars(const char *Ptr, const char *End) {
+#if LLVM_LLLEXER_SSE2
+  for (; End - Ptr >= 16; Ptr += 16)
+    if (unsigned Mask = nonLabelCharMask(load16(Ptr)))
+      return Ptr + countTrailingZeros(Mask);
+#endif
+  while (isLabelChar(*Ptr))
+    ++Ptr;
+  return Ptr;
+}
+
+/// skipSpaces - Return the first character at or after Ptr that is not a
+/// space, tab or newline.
+static const char *skipSpaces(const char *Ptr, const char *End) {
+#if LLVM_LLLEXER_SSE2
+  for (; End - Ptr >= 16; Ptr += 16)
+    if (unsigned Mask = nonSpaceMask(load16(Ptr)))
+      return Ptr + countTrailingZeros(Mask);
+#endif
+  while (*Ptr == ' ' || *Ptr == '\t' || *Ptr == '\n')
+    ++Ptr;
+  return Ptr;
+}
+
+/// findLineEnd - Return the first '\n' or '\r' at or after Ptr, or End.
+static const char *findLineEnd(const char *Ptr, const char *End) {
+#if LLVM_LLLEXER_SSE2
+  for (; End - Ptr >= 16; Ptr += 16)
+    if (unsigned Mask = lineEndMask(load16(Ptr)))
+      return Ptr + countTrailingZeros(Mask);
+#endif
+  while (Ptr != End && *Ptr != '\n' && *Ptr != '\r')
+    ++Ptr;
+  return Ptr;
 }
 
 /// isLabelTail - Return true if this pointer points to a valid end of a label.
-static const char *isLabelTail(const char *CurPtr) {
-  while (true) {
-    if (CurPtr[0] == ':') return CurPtr+1;
-    if (!isLabelChar(CurPtr[0])) return nullptr;
-    ++CurPtr;
-  }
+static const char *isLabelTail(const char *CurPtr, const char *End) {
+  CurPtr = skipLabelChars(CurPtr, End);
+  return CurPtr[0] == ':' ? CurPtr + 1 : nullptr;
 }
 
 //===----------------------------------------------------------------------===//
@@ -163,6 +247,23 @@ LLLexer::LLLexer(StringRef StartBuf, SourceMgr &SM, SMDiagnostic &Err,
   CurPtr = CurBuf.begin();
 }
 
+void LLLexer::setStrVal(const char *Begin, const char *End) {
+  StrVal = StringRef(Begin, End - Begin);
+}
+
+/// setEscapedStrVal - Set StrVal to the unescaped text in [Begin, End). Text
+/// without escapes is referenced in place, and only text with escapes is
+/// copied.
+void LLLexer::setEscapedStrVal(const char *Begin, const char *End) {
+  if (!memchr(Begin, '\\', End - Begin)) {
+    setStrVal(Begin, End);
+    return;
+  }
+  char *Buf = StrAlloc.Allocate<char>(End - Begin);
+  memcpy(Buf, Begin, End - Begin);
+  StrVal = StringRef(Buf, UnEscapeLexed(Buf, Buf + (End - Begin)) - Buf);
+}
+
 int LLLexer::getNextChar() {
   char CurChar = *CurPtr++;
   switch (CurChar) {
@@ -187,7 +288,7 @@ lltok::Kind LLLexer::LexToken() {
     switch (CurChar) {
     default:
       // Handle letters: [a-zA-Z_]
-      if (isalpha(static_cast<unsigned char>(CurChar)) || CurChar == '_')
+      if (isAlpha(CurChar) || CurChar == '_')
         return LexIdentifier();
 
       return lltok::Error;
@@ -197,7 +298,8 @@ lltok::Kind LLLexer::LexToken() {
     case '\t':
     case '\n':
     case '\r':
-      // Ignore whitespace.
+      // Ignore whitespace. Indentation and blank lines come in runs.
+      CurPtr = skipSpaces(CurPtr, CurBuf.end());
       continue;
     case '+': return LexPositive();
     case '@': return LexAt();
@@ -205,9 +307,9 @@ lltok::Kind LLLexer::LexToken() {
     case '%': return LexPercent();
     case '"': return LexQuote();
     case '.':
-      if (const char *Ptr = isLabelTail(CurPtr)) {
+      if (const char *Ptr = isLabelTail(CurPtr, CurBuf.end())) {
         CurPtr = Ptr;
-        StrVal.assign(TokStart, CurPtr-1);
+        setStrVal(TokStart, CurPtr - 1);
         return lltok::LabelStr;
       }
       if (CurPtr[0] == '.' && CurPtr[1] == '.') {
@@ -245,10 +347,21 @@ lltok::Kind LLLexer::LexToken() {
 }
 
 void LLLexer::SkipLineComment() {
-  while (true) {
-    if (CurPtr[0] == '\n' || CurPtr[0] == '\r' || getNextChar() == EOF)
-      return;
+  CurPtr = findLineEnd(CurPtr, CurBuf.end());
+}
+
+/// ReadQuoted - Move CurPtr past the closing quote of a string whose opening
+/// quote has been read. Returns true, having reported ErrorMsg, if the string
+/// is not closed.
+bool LLLexer::ReadQuoted(const char *ErrorMsg) {
+  const void *Quote = memchr(CurPtr, '"', CurBuf.end() - CurPtr);
+  if (!Quote) {
+    CurPtr = CurBuf.end();
+    Error(ErrorMsg);
+    return true;
   }
+  CurPtr = static_cast<const char *>(Quote) + 1;
+  return false;
 }
 
 /// Lex all tokens that start with an @ character.
@@ -260,9 +373,9 @@ lltok::Kind LLLexer::LexAt() {
 }
 
 lltok::Kind LLLexer::LexDollar() {
-  if (const char *Ptr = isLabelTail(TokStart)) {
+  if (const char *Ptr = isLabelTail(TokStart, CurBuf.end())) {
     CurPtr = Ptr;
-    StrVal.assign(TokStart, CurPtr - 1);
+    setStrVal(TokStart, CurPtr - 1);
     return lltok::LabelStr;
   }
 
@@ -270,23 +383,14 @@ lltok::Kind LLLexer::LexDollar() {
   if (CurPtr[0] == '"') {
     ++CurPtr;
 
-    while (true) {
-      int CurChar = getNextChar();
-
-      if (CurChar == EOF) {
-        Error("end of file in COMDAT variable name");
-        return lltok::Error;
-      }
-      if (CurChar == '"') {
-        StrVal.assign(TokStart + 2, CurPtr - 1);
-        UnEscapeLexed(StrVal);
-        if (StringRef(StrVal).find_first_of(0) != StringRef::npos) {
-          Error("Null bytes are not allowed in names");
-          return lltok::Error;
-        }
-        return lltok::ComdatVar;
-      }
+    if (ReadQuoted("end of file in COMDAT variable name"))
+      return lltok::Error;
+    setEscapedStrVal(TokStart + 2, CurPtr - 1);
+    if (StrVal.find_first_of(0) != StringRef::npos) {
+      Error("Null bytes are not allowed in names");
+      return lltok::Error;
     }
+    return lltok::ComdatVar;
   }
 
   // Handle ComdatVarName: $[-a-zA-Z$._][-a-zA-Z$._0-9]*
@@ -299,34 +403,18 @@ lltok::Kind LLLexer::LexDollar() {
 /// ReadString - Read a string until the closing quote.
 lltok::Kind LLLexer::ReadString(lltok::Kind kind) {
   const char *Start = CurPtr;
-  while (true) {
-    int CurChar = getNextChar();
-
-    if (CurChar == EOF) {
-      Error("end of file in string constant");
-      return lltok::Error;
-    }
-    if (CurChar == '"') {
-      StrVal.assign(Start, CurPtr-1);
-      UnEscapeLexed(StrVal);
-      return kind;
-    }
-  }
+  if (ReadQuoted("end of file in string constant"))
+    return lltok::Error;
+  setEscapedStrVal(Start, CurPtr - 1);
+  return kind;
 }
 
 /// ReadVarName - Read the rest of a token containing a variable name.
 bool LLLexer::ReadVarName() {
   const char *NameStart = CurPtr;
-  if (isalpha(static_cast<unsigned char>(CurPtr[0])) ||
-      CurPtr[0] == '-' || CurPtr[0] == '$' ||
-      CurPtr[0] == '.' || CurPtr[0] == '_') {
-    ++CurPtr;
-    while (isalnum(static_cast<unsigned char>(CurPtr[0])) ||
-           CurPtr[0] == '-' || CurPtr[0] == '$' ||
-           CurPtr[0] == '.' || CurPtr[0] == '_')
-      ++CurPtr;
-
-    StrVal.assign(NameStart, CurPtr);
+  if (isLabelChar(CurPtr[0]) && !isDigit(CurPtr[0])) {
+    CurPtr = skipLabelChars(CurPtr + 1, CurBuf.end());
+    setStrVal(NameStart, CurPtr);
     return true;
   }
   return false;
@@ -353,23 +441,14 @@ lltok::Kind LLLexer::LexVar(lltok::Kind Var, lltok::Kind VarID) {
   if (CurPtr[0] == '"') {
     ++CurPtr;
 
-    while (true) {
-      int CurChar = getNextChar();
-
-      if (CurChar == EOF) {
-        Error("end of file in global variable name");
-        return lltok::Error;
-      }
-      if (CurChar == '"') {
-        StrVal.assign(TokStart+2, CurPtr-1);
-        UnEscapeLexed(StrVal);
-        if (StringRef(StrVal).find_first_of(0) != StringRef::npos) {
-          Error("Null bytes are not allowed in names");
-          return lltok::Error;
-        }
-        return Var;
-      }
+    if (ReadQuoted("end of file in global variable name"))
+      return lltok::Error;
+    setEscapedStrVal(TokStart + 2, CurPtr - 1);
+    if (StrVal.find_first_of(0) != StringRef::npos) {
+      Error("Null bytes are not allowed in names");
+      return lltok::Error;
     }
+    return Var;
   }
 
   // Handle VarName: [-a-zA-Z$._][-a-zA-Z$._0-9]*
@@ -398,7 +477,7 @@ lltok::Kind LLLexer::LexQuote() {
 
   if (CurPtr[0] == ':') {
     ++CurPtr;
-    if (StringRef(StrVal).find_first_of(0) != StringRef::npos) {
+    if (StrVal.find_first_of(0) != StringRef::npos) {
       Error("Null bytes are not allowed in names");
       kind = lltok::Error;
     } else {
@@ -414,17 +493,12 @@ lltok::Kind LLLexer::LexQuote() {
 ///    !
 lltok::Kind LLLexer::LexExclaim() {
   // Lex a metadata name as a MetadataVar.
-  if (isalpha(static_cast<unsigned char>(CurPtr[0])) ||
-      CurPtr[0] == '-' || CurPtr[0] == '$' ||
-      CurPtr[0] == '.' || CurPtr[0] == '_' || CurPtr[0] == '\\') {
+  if ((isLabelChar(CurPtr[0]) && !isDigit(CurPtr[0])) || CurPtr[0] == '\\') {
     ++CurPtr;
-    while (isalnum(static_cast<unsigned char>(CurPtr[0])) ||
-           CurPtr[0] == '-' || CurPtr[0] == '$' ||
-           CurPtr[0] == '.' || CurPtr[0] == '_' || CurPtr[0] == '\\')
+    while (isLabelChar(CurPtr[0]) || CurPtr[0] == '\\')
       ++CurPtr;
 
-    StrVal.assign(TokStart+1, CurPtr);   // Skip !
-    UnEscapeLexed(StrVal);
+    setEscapedStrVal(TokStart + 1, CurPtr); // Skip !
     return lltok::MetadataVar;
   }
   return lltok::exclaim;
@@ -451,28 +525,20 @@ lltok::Kind LLLexer::LexHash() {
 ///    HexIntConstant  [us]0x[0-9A-Fa-f]+
 lltok::Kind LLLexer::LexIdentifier() {
   const char *StartChar = CurPtr;
-  const char *IntEnd = CurPtr[-1] == 'i' ? nullptr : StartChar;
-  const char *KeywordEnd = nullptr;
-
-  for (; isLabelChar(*CurPtr); ++CurPtr) {
-    // If we decide this is an integer, remember the end of the sequence.
-    if (!IntEnd && !isdigit(static_cast<unsigned char>(*CurPtr)))
-      IntEnd = CurPtr;
-    if (!KeywordEnd && !isalnum(static_cast<unsigned char>(*CurPtr)) &&
-        *CurPtr != '_')
-      KeywordEnd = CurPtr;
-  }
+  CurPtr = skipLabelChars(CurPtr, CurBuf.end());
 
   // If we stopped due to a colon, unless we were directed to ignore it,
   // this really is a label.
   if (!IgnoreColonInIdentifiers && *CurPtr == ':') {
-    StrVal.assign(StartChar-1, CurPtr++);
+    setStrVal(StartChar - 1, CurPtr++);
     return lltok::LabelStr;
   }
 
   // Otherwise, this wasn't a label.  If this was valid as an integer type,
   // return it.
-  if (!IntEnd) IntEnd = CurPtr;
+  const char *IntEnd = StartChar;
+  if (StartChar[-1] == 'i')
+    IntEnd = std::find_if(StartChar, CurPtr, [](char C) { return !isDigit(C); });
   if (IntEnd != StartChar) {
     CurPtr = IntEnd;
     uint64_t NumBits = atoull(StartChar, CurPtr);
@@ -486,8 +552,8 @@ lltok::Kind LLLexer::LexIdentifier() {
   }
 
   // Otherwise, this was a letter sequence.  See which keyword this is.
-  if (!KeywordEnd) KeywordEnd = CurPtr;
-  CurPtr = KeywordEnd;
+  CurPtr = std::find_if(StartChar, CurPtr,
+                        [](char C) { return !isAlnum(C) && C != '_'; });
   --StartChar;
   StringRef Keyword(StartChar, CurPtr - StartChar);
 
@@ -889,7 +955,7 @@ lltok::Kind LLLexer::LexIdentifier() {
 #define DWKEYWORD(TYPE, TOKEN)                                                 \
   do {                                                                         \
     if (Keyword.startswith("DW_" #TYPE "_")) {                                 \
-      StrVal.assign(Keyword.begin(), Keyword.end());                           \
+      StrVal = Keyword;                                                        \
       return lltok::TOKEN;                                                     \
     }                                                                          \
   } while (false)
@@ -905,28 +971,28 @@ lltok::Kind LLLexer::LexIdentifier() {
 #undef DWKEYWORD
 
   if (Keyword.startswith("DIFlag")) {
-    StrVal.assign(Keyword.begin(), Keyword.end());
+    StrVal = Keyword;
     return lltok::DIFlag;
   }
 
   if (Keyword.startswith("DISPFlag")) {
-    StrVal.assign(Keyword.begin(), Keyword.end());
+    StrVal = Keyword;
     return lltok::DISPFlag;
   }
 
   if (Keyword.startswith("CSK_")) {
-    StrVal.assign(Keyword.begin(), Keyword.end());
+    StrVal = Keyword;
     return lltok::ChecksumKind;
   }
 
   if (Keyword == "NoDebug" || Keyword == "FullDebug" ||
       Keyword == "LineTablesOnly" || Keyword == "DebugDirectivesOnly") {
-    StrVal.assign(Keyword.begin(), Keyword.end());
+    StrVal = Keyword;
     return lltok::EmissionKind;
   }
 
   if (Keyword == "GNU" || Keyword == "None" || Keyword == "Default") {
-    StrVal.assign(Keyword.begin(), Keyword.end());
+    StrVal = Keyword;
     return lltok::NameTableKind;
   }
 
@@ -1036,8 +1102,8 @@ lltok::Kind LLLexer::LexDigitOrNegative() {
   if (!isdigit(static_cast<unsigned char>(TokStart[0])) &&
       !isdigit(static_cast<unsigned char>(CurPtr[0]))) {
     // Okay, this is not a number after the -, it's probably a label.
-    if (const char *End = isLabelTail(CurPtr)) {
-      StrVal.assign(TokStart, End-1);
+    if (const char *End = isLabelTail(CurPtr, CurBuf.end())) {
+      setStrVal(TokStart, End - 1);
       CurPtr = End;
       return lltok::LabelStr;
     }
@@ -1063,8 +1129,8 @@ lltok::Kind LLLexer::LexDigitOrNegative() {
 
   // Check to see if this really is a string label, e.g. "-1:".
   if (isLabelChar(CurPtr[0]) || CurPtr[0] == ':') {
-    if (const char *End = isLabelTail(CurPtr)) {
-      StrVal.assign(TokStart, End-1);
+    if (const char *End = isLabelTail(CurPtr, CurBuf.end())) {
+      setStrVal(TokStart, End - 1);
       CurPtr = End;
       return lltok::LabelStr;
     }
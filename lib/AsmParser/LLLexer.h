@@ -16,8 +16,9 @@
 #include "LLToken.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/SourceMgr.h"
-#include <string>
 
 namespace llvm {
   class MemoryBuffer;
@@ -35,7 +36,9 @@ namespace llvm {
     // Information about the current token.
     const char *TokStart;
     lltok::Kind CurKind;
-    std::string StrVal;
+    /// Either points into CurBuf or, for names and strings with escapes, into
+    /// StrAlloc, so it stays valid for the lifetime of the lexer.
+    StringRef StrVal;
     unsigned UIntVal;
     Type *TyVal;
     APFloat APFloatVal;
@@ -45,6 +48,9 @@ namespace llvm {
     // When true, the ':' is treated as a separate token.
     bool IgnoreColonInIdentifiers;
 
+    /// Holds the unescaped copies of names and strings with escapes.
+    BumpPtrAllocator StrAlloc;
+
   public:
     explicit LLLexer(StringRef StartBuf, SourceMgr &SM, SMDiagnostic &,
                      LLVMContext &C);
@@ -56,7 +62,7 @@ namespace llvm {
     typedef SMLoc LocTy;
     LocTy getLoc() const { return SMLoc::getFromPointer(TokStart); }
     lltok::Kind getKind() const { return CurKind; }
-    const std::string &getStrVal() const { return StrVal; }
+    StringRef getStrVal() const { return StrVal; }
     Type *getTyVal() const { return TyVal; }
     unsigned getUIntVal() const { return UIntVal; }
     const APSInt &getAPSIntVal() const { return APSIntVal; }
@@ -77,6 +83,9 @@ namespace llvm {
 
     int getNextChar();
     void SkipLineComment();
+    void setStrVal(const char *Begin, const char *End);
+    void setEscapedStrVal(const char *Begin, const char *End);
+    bool ReadQuoted(const char *ErrorMsg);
     lltok::Kind ReadString(lltok::Kind kind);
     bool ReadVarName();
 
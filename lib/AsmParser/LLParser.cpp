@@ -2825,10 +2825,17 @@ LLParser::PerFunctionState::~PerFunctionState() {
 }
 
 bool LLParser::PerFunctionState::FinishFunction() {
-  if (!ForwardRefVals.empty())
-    return P.Error(ForwardRefVals.begin()->second.second,
-                   "use of undefined value '%" + ForwardRefVals.begin()->first +
-                   "'");
+  if (!ForwardRefVals.empty()) {
+    // Report the first name in sorted order, as the map is unordered.
+    auto I = std::min_element(
+        ForwardRefVals.begin(), ForwardRefVals.end(),
+        [](const StringMapEntry<std::pair<Value *, LocTy>> &A,
+           const StringMapEntry<std::pair<Value *, LocTy>> &B) {
+          return A.getKey() < B.getKey();
+        });
+    return P.Error(I->second.second,
+                   "use of undefined value '%" + I->getKey() + "'");
+  }
   if (!ForwardRefValIDs.empty())
     return P.Error(ForwardRefValIDs.begin()->second.second,
                    "use of undefined value '%" +
@@ -2839,7 +2846,7 @@ bool LLParser::PerFunctionState::FinishFunction() {
 /// GetVal - Get a value with the specified name or ID, creating a
 /// forward reference record if needed.  This can return null if the value
 /// exists but does not have the right type.
-Value *LLParser::PerFunctionState::GetVal(const std::string &Name, Type *Ty,
+Value *LLParser::PerFunctionState::GetVal(StringRef Name, Type *Ty,
                                           LocTy Loc, bool IsCall) {
   // Look this name up in the normal function symbol table.
   Value *Val = F.getValueSymbolTable()->lookup(Name);
@@ -2910,8 +2917,7 @@ Value *LLParser::PerFunctionState::GetVal(unsigned ID, Type *Ty, LocTy Loc,
 
 /// SetInstName - After an instruction is parsed and inserted into its
 /// basic block, this installs its name.
-bool LLParser::PerFunctionState::SetInstName(int NameID,
-                                             const std::string &NameStr,
+bool LLParser::PerFunctionState::SetInstName(int NameID, StringRef NameStr,
                                              LocTy NameLoc, Instruction *Inst) {
   // If this instruction has void type, it cannot have a name or ID specified.
   if (Inst->getType()->isVoidTy()) {
@@ -2971,8 +2977,7 @@ bool LLParser::PerFunctionState::SetInstName(int NameID,
 
 /// GetBB - Get a basic block with the specified name or ID, creating a
 /// forward reference record if needed.
-BasicBlock *LLParser::PerFunctionState::GetBB(const std::string &Name,
-                                              LocTy Loc) {
+BasicBlock *LLParser::PerFunctionState::GetBB(StringRef Name, LocTy Loc) {
   return dyn_cast_or_null<BasicBlock>(
       GetVal(Name, Type::getLabelTy(F.getContext()), Loc, /*IsCall=*/false));
 }
@@ -2985,8 +2990,8 @@ BasicBlock *LLParser::PerFunctionState::GetBB(unsigned ID, LocTy Loc) {
 /// DefineBB - Define the specified basic block, which is either named or
 /// unnamed.  If there is an error, this returns null otherwise it returns
 /// the block being defined.
-BasicBlock *LLParser::PerFunctionState::DefineBB(const std::string &Name,
-                                                 int NameID, LocTy Loc) {
+BasicBlock *LLParser::PerFunctionState::DefineBB(StringRef Name, int NameID,
+                                                 LocTy Loc) {
   BasicBlock *BB;
   if (Name.empty()) {
     if (NameID != -1 && unsigned(NameID) != NumberedVals.size()) {
@@ -5581,7 +5586,7 @@ bool LLParser::ParseFunctionBody(Function &Fn) {
 ///   ::= (LabelStr|LabelID)? Instruction*
 bool LLParser::ParseBasicBlock(PerFunctionState &PFS) {
   // If this basic block starts out with a name, remember it.
-  std::string Name;
+  StringRef Name;
   int NameID = -1;
   LocTy NameLoc = Lex.getLoc();
   if (Lex.getKind() == lltok::LabelStr) {
@@ -5596,7 +5601,7 @@ bool LLParser::ParseBasicBlock(PerFunctionState &PFS) {
   if (!BB)
     return true;
 
-  std::string NameStr;
+  StringRef NameStr;
 
   // Parse the instructions in this block until we get a terminator.
   Instruction *Inst;
@@ -70,6 +70,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -92,6 +93,12 @@ static cl::opt<bool> PrintSummaryGUIDs(
     cl::desc(
         "Print the global id for each value when reading the module summary"));
 
+static cl::opt<unsigned> MaterializeThreads(
+    "bitcode-materialize-threads", cl::init(0), cl::Hidden,
+    cl::desc("Number of threads decoding the function blocks ahead of time "
+             "when materializing a whole module (0 to decode them when "
+             "materialized)"));
+
 namespace {
 
 enum {
@@ -493,6 +500,10 @@ class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   /// where to find deferred function body in the stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// The function blocks materializeModule() decoded ahead of time, which
+  /// materialize() replays instead of reading the stream.
+  DenseMap<Function *, BitstreamBlockRecording> DecodedFunctionBlocks;
+
   /// When Metadata block is initially scanned when parsing the module, we may
   /// choose to defer parsing of the metadata. This vector contains info about
   /// which Metadata blocks are deferred.
@@ -535,7 +546,8 @@ public:
   /// Main interface to parsing a bitcode buffer.
   /// \returns true if an error occurred.
   Error parseBitcodeInto(Module *M, bool ShouldLazyLoadMetadata = false,
-                         bool IsImporting = false);
+                         bool IsImporting = false,
+                         bool LoadMetadataOnDemand = false);
 
   static uint64_t decodeSignRotatedValue(uint64_t V);
 
@@ -3450,9 +3462,11 @@ Error BitcodeReader::parseModule(uint64_t ResumeBit,
 }
 
 Error BitcodeReader::parseBitcodeInto(Module *M, bool ShouldLazyLoadMetadata,
-                                      bool IsImporting) {
+                                      bool IsImporting,
+                                      bool LoadMetadataOnDemand) {
   TheModule = M;
   MDLoader = MetadataLoader(Stream, *M, ValueList, IsImporting,
+                            LoadMetadataOnDemand,
                             [&](unsigned ID) { return getTypeByID(ID); });
   return parseModule(0, ShouldLazyLoadMetadata);
 }
@@ -4923,6 +4937,9 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
 
   // Move the bit stream to the saved position of the deferred function body.
   Stream.JumpToBit(DFII->second);
+  auto DFBI = DecodedFunctionBlocks.find(F);
+  if (DFBI != DecodedFunctionBlocks.end())
+    Stream.replayBlock(DFBI->second);
 
   if (Error Err = parseFunctionBody(F))
     return Err;
@@ -4972,14 +4989,71 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
 Error BitcodeReader::materializeModule() {
   if (Error Err = materializeMetadata())
     return Err;
+  MDLoader->materializeAllMetadata();
 
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
+  // With -bitcode-materialize-threads, the blocks of the functions whose
+  // position is known are decoded by a thread pool, a bounded number of
+  // functions ahead of the one being materialized. The IR is still built in
+  // module order on this thread, as the LLVMContext is not thread-safe.
+  struct AheadBlock {
+    Function *F;
+    uint64_t Bit;
+    BitstreamBlockRecording Recording;
+    bool Failed = false;
+    std::shared_future<void> Decoded;
+  };
+  std::vector<AheadBlock> Ahead;
+  if (MaterializeThreads > 0) {
+    for (Function &F : *TheModule) {
+      if (!F.isMaterializable())
+        continue;
+      auto DFII = DeferredFunctionInfo.find(&F);
+      if (DFII != DeferredFunctionInfo.end() && DFII->second) {
+        Ahead.emplace_back();
+        Ahead.back().F = &F;
+        Ahead.back().Bit = DFII->second;
+      }
+    }
+  }
+  BitstreamCursor AheadCursor(Stream);
+  // Declared last, for the pending decodes to finish first on errors.
+  std::unique_ptr<ThreadPool> Pool;
+  if (Ahead.size() > 1)
+    Pool = llvm::make_unique<ThreadPool>(MaterializeThreads);
+  else
+    Ahead.clear();
+  size_t NextAhead = 0, NumDecoding = 0;
+  const size_t MaxAhead = 8 * MaterializeThreads;
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Function &F : *TheModule) {
-    if (Error Err = materialize(&F))
+    if (NextAhead < Ahead.size() && Ahead[NextAhead].F == &F) {
+      for (; NumDecoding < Ahead.size() && NumDecoding < NextAhead + MaxAhead;
+           ++NumDecoding) {
+        AheadBlock &B = Ahead[NumDecoding];
+        const BitstreamCursor &Base = AheadCursor;
+        B.Decoded = Pool->async([&B, &Base] {
+          BitstreamCursor Cursor(Base);
+          Cursor.JumpToBit(B.Bit);
+          B.Failed = Cursor.recordBlock(bitc::FUNCTION_BLOCK_ID, B.Recording);
+        });
+      }
+      // A block that did not decode is read again from the stream, for the
+      // error to be reported in context.
+      AheadBlock &B = Ahead[NextAhead++];
+      B.Decoded.wait();
+      if (!B.Failed)
+        DecodedFunctionBlocks[&F] = std::move(B.Recording);
+      B.Recording.clear();
+    }
+
+    Error Err = materialize(&F);
+    DecodedFunctionBlocks.erase(&F);
+    if (Err)
       return Err;
   }
   // At this point, if there are any function bodies, parse the rest of
@@ -6024,9 +6098,11 @@ BitcodeModule::getModuleImpl(LLVMContext &Context, bool MaterializeAll,
       llvm::make_unique<Module>(ModuleIdentifier, Context);
   M->setMaterializer(R);
 
-  // Delay parsing Metadata if ShouldLazyLoadMetadata is true.
-  if (Error Err =
-          R->parseBitcodeInto(M.get(), ShouldLazyLoadMetadata, IsImporting))
+  // Delay parsing Metadata if ShouldLazyLoadMetadata is true. Unless the whole
+  // module is about to be materialized, only load the module-level metadata
+  // that the materialized functions refer to.
+  if (Error Err = R->parseBitcodeInto(M.get(), ShouldLazyLoadMetadata,
+                                      IsImporting, !MaterializeAll))
     return std::move(Err);
 
   if (MaterializeAll) {
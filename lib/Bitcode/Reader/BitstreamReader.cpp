@@ -20,6 +20,11 @@ using namespace llvm;
 /// EnterSubBlock - Having read the ENTER_SUBBLOCK abbrevid, enter
 /// the block, and return true if the block has an error.
 bool BitstreamCursor::EnterSubBlock(unsigned BlockID, unsigned *NumWordsP) {
+  if (Replay) {
+    if (NumWordsP) *NumWordsP = 0;
+    return false;
+  }
+
   // Save the current block's state on BlockScope.
   BlockScope.push_back(Block(CurCodeSize));
   BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
@@ -93,6 +98,9 @@ static void skipAbbreviatedField(BitstreamCursor &Cursor,
 
 /// skipRecord - Read the current record and discard it.
 unsigned BitstreamCursor::skipRecord(unsigned AbbrevID) {
+  if (Replay)
+    return replayRecord(nullptr, nullptr);
+
   // Skip unabbreviated records by reading past their entries.
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     unsigned Code = ReadVBR(6);
@@ -178,6 +186,9 @@ unsigned BitstreamCursor::skipRecord(unsigned AbbrevID) {
 unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
                                      SmallVectorImpl<uint64_t> &Vals,
                                      StringRef *Blob) {
+  if (Replay)
+    return replayRecord(&Vals, Blob);
+
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     unsigned Code = ReadVBR(6);
     unsigned NumElts = ReadVBR(6);
@@ -281,6 +292,125 @@ unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
   return Code;
 }
 
+bool BitstreamCursor::recordBlock(unsigned BlockID,
+                                  BitstreamBlockRecording &Recording) {
+  Recording.clear();
+  if (EnterSubBlock(BlockID))
+    return true;
+
+  // The sub-blocks entered and not yet ended.
+  SmallVector<size_t, 8> OpenBlocks;
+  SmallVector<uint64_t, 64> Vals;
+  while (true) {
+    BitstreamEntry Entry = advance();
+    BitstreamBlockRecording::Entry E;
+    E.E = Entry;
+    E.CodeOrEnd = 0;
+    E.OpsBegin = Recording.Ops.size();
+    E.NumOps = 0;
+    E.BlobSize = 0;
+    E.BlobData = nullptr;
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return true;
+    case BitstreamEntry::SubBlock:
+      // The abbreviations a BLOCKINFO block defines would have to apply while
+      // the recording is made.
+      if (Entry.ID == bitc::BLOCKINFO_BLOCK_ID || EnterSubBlock(Entry.ID))
+        return true;
+      OpenBlocks.push_back(Recording.Entries.size());
+      break;
+    case BitstreamEntry::EndBlock:
+      Recording.Entries.push_back(E);
+      if (OpenBlocks.empty()) {
+        Recording.EndBit = GetCurrentBitNo();
+        return false;
+      }
+      Recording.Entries[OpenBlocks.pop_back_val()].CodeOrEnd =
+          Recording.Entries.size();
+      continue;
+    case BitstreamEntry::Record: {
+      StringRef Blob;
+      Vals.clear();
+      E.CodeOrEnd = readRecord(Entry.ID, Vals, &Blob);
+      Recording.Ops.insert(Recording.Ops.end(), Vals.begin(), Vals.end());
+      E.NumOps = Vals.size();
+      E.BlobSize = Blob.size();
+      E.BlobData = Blob.data();
+      break;
+    }
+    }
+    Recording.Entries.push_back(E);
+  }
+}
+
+// A record entry is consumed by reading the record, as if advance() had only
+// read its abbreviation ID.
+BitstreamEntry BitstreamCursor::replayAdvance(unsigned Flags) {
+  BitstreamEntry Entry = Replay->Entries[ReplayPos].E;
+  if (Entry.Kind == BitstreamEntry::SubBlock)
+    ++ReplayPos;
+  else if (Entry.Kind == BitstreamEntry::EndBlock &&
+           !(Flags & AF_DontPopBlockAtEnd))
+    replayBlockEnd();
+  return Entry;
+}
+
+unsigned BitstreamCursor::replayCode() const {
+  const BitstreamEntry &Entry = Replay->Entries[ReplayPos].E;
+  switch (Entry.Kind) {
+  case BitstreamEntry::Record:
+    return Entry.ID;
+  case BitstreamEntry::SubBlock:
+    return bitc::ENTER_SUBBLOCK;
+  default:
+    return bitc::END_BLOCK;
+  }
+}
+
+bool BitstreamCursor::replaySkipBlock() {
+  assert(ReplayPos &&
+         Replay->Entries[ReplayPos - 1].E.Kind == BitstreamEntry::SubBlock &&
+         "Not at the start of a sub-block");
+  ReplayPos = Replay->Entries[ReplayPos - 1].CodeOrEnd;
+  return false;
+}
+
+bool BitstreamCursor::replayBlockEnd() {
+  if (Replay->Entries[ReplayPos].E.Kind != BitstreamEntry::EndBlock)
+    return true;
+
+  // Once the recorded block ends, continue with the bitstream after it.
+  if (++ReplayPos == Replay->Entries.size()) {
+    uint64_t EndBit = Replay->EndBit;
+    Replay = nullptr;
+    SimpleBitstreamCursor::JumpToBit(EndBit);
+  }
+  return false;
+}
+
+unsigned BitstreamCursor::replayRecord(SmallVectorImpl<uint64_t> *Vals,
+                                       StringRef *Blob) {
+  const BitstreamBlockRecording::Entry &E = Replay->Entries[ReplayPos];
+  if (E.E.Kind != BitstreamEntry::Record)
+    report_fatal_error("Invalid abbrev number");
+  ++ReplayPos;
+
+  if (Vals) {
+    const uint64_t *Ops = Replay->Ops.data() + E.OpsBegin;
+    Vals->append(Ops, Ops + E.NumOps);
+    if (E.BlobData) {
+      const unsigned char *Ptr = (const unsigned char *)E.BlobData;
+      if (Blob)
+        *Blob = StringRef(E.BlobData, E.BlobSize);
+      else
+        Vals->append(Ptr, Ptr + E.BlobSize); // Zero extended, as above.
+    }
+  }
+  return E.CodeOrEnd;
+}
+
 void BitstreamCursor::ReadAbbrevRecord() {
   auto Abbv = std::make_shared<BitCodeAbbrev>();
   unsigned NumOpInfo = ReadVBR(5);
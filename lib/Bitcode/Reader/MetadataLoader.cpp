@@ -99,7 +99,7 @@ static cl::opt<bool> ImportFullTypeDefinitions(
 static cl::opt<bool> DisableLazyLoading(
     "disable-ondemand-mds-loading", cl::init(false), cl::Hidden,
     cl::desc("Force disable the lazy-loading on-demand of metadata when "
-             "loading bitcode for importing."));
+             "loading bitcode."));
 
 namespace {
 
@@ -458,6 +458,10 @@ class MetadataLoader::MetadataLoaderImpl {
   /// True if metadata is being parsed for a module being ThinLTO imported.
   bool IsImporting = false;
 
+  /// True if module-level metadata is loaded as the functions referring to it
+  /// are materialized, rather than all at once.
+  bool LoadOnDemand = false;
+
   Error parseOneMetadata(SmallVectorImpl<uint64_t> &Record, unsigned Code,
                          PlaceholderQueue &Placeholders, StringRef Blob,
                          unsigned &NextMetadataNo);
@@ -624,15 +628,19 @@ public:
   MetadataLoaderImpl(BitstreamCursor &Stream, Module &TheModule,
                      BitcodeReaderValueList &ValueList,
                      std::function<Type *(unsigned)> getTypeByID,
-                     bool IsImporting)
+                     bool IsImporting, bool LoadOnDemand)
       : MetadataList(TheModule.getContext()), ValueList(ValueList),
         Stream(Stream), Context(TheModule.getContext()), TheModule(TheModule),
-        getTypeByID(std::move(getTypeByID)), IsImporting(IsImporting) {}
+        getTypeByID(std::move(getTypeByID)), IsImporting(IsImporting),
+        LoadOnDemand(LoadOnDemand) {}
 
   Error parseMetadata(bool ModuleLevel);
 
   bool hasFwdRefs() const { return MetadataList.hasFwdRefs(); }
 
+  /// Load the indexed metadata that hasn't been loaded on demand yet.
+  void materializeAllMetadata();
+
   Metadata *getMetadataFwdRefOrLoad(unsigned ID) {
     if (ID < MDStringRef.size())
       return lazyLoadOneMDString(ID);
@@ -853,7 +861,11 @@ Error MetadataLoader::MetadataLoaderImpl::parseMetadata(bool ModuleLevel) {
 
   // We lazy-load module-level metadata: we build an index for each record, and
   // then load individual record as needed, starting with the named metadata.
-  if (ModuleLevel && IsImporting && MetadataList.empty() &&
+  // The records only referenced by functions, such as the DISubprogram graph
+  // of each function, are loaded when the function is materialized, so most
+  // of the debug info of a module that is never fully materialized is never
+  // read.
+  if (ModuleLevel && LoadOnDemand && MetadataList.empty() &&
       !DisableLazyLoading) {
     auto SuccessOrErr = lazyLoadModuleMetadataBlock();
     if (!SuccessOrErr)
@@ -938,6 +950,18 @@ void MetadataLoader::MetadataLoaderImpl::lazyLoadOneMetadata(
     report_fatal_error("Can't lazyload MD");
 }
 
+/// Loading the records in order finds the operands of most nodes already
+/// loaded, which is much cheaper than loading each operand on demand.
+void MetadataLoader::MetadataLoaderImpl::materializeAllMetadata() {
+  PlaceholderQueue Placeholders;
+  for (unsigned ID = MDStringRef.size(),
+                E = ID + GlobalMetadataBitPosIndex.size();
+       ID != E; ++ID)
+    if (!MetadataList.lookup(ID))
+      lazyLoadOneMetadata(ID, Placeholders);
+  resolveForwardRefsAndPlaceholders(Placeholders);
+}
+
 /// Ensure that all forward-references and placeholders are resolved.
 /// Iteratively lazy-loading metadata on-demand if needed.
 void MetadataLoader::MetadataLoaderImpl::resolveForwardRefsAndPlaceholders(
@@ -2036,10 +2060,11 @@ MetadataLoader::MetadataLoader(MetadataLoader &&RHS)
 MetadataLoader::~MetadataLoader() = default;
 MetadataLoader::MetadataLoader(BitstreamCursor &Stream, Module &TheModule,
                                BitcodeReaderValueList &ValueList,
-                               bool IsImporting,
+                               bool IsImporting, bool LoadOnDemand,
                                std::function<Type *(unsigned)> getTypeByID)
     : Pimpl(llvm::make_unique<MetadataLoaderImpl>(
-          Stream, TheModule, ValueList, std::move(getTypeByID), IsImporting)) {}
+          Stream, TheModule, ValueList, std::move(getTypeByID), IsImporting,
+          LoadOnDemand)) {}
 
 Error MetadataLoader::parseMetadata(bool ModuleLevel) {
   return Pimpl->parseMetadata(ModuleLevel);
@@ -2047,6 +2072,10 @@ Error MetadataLoader::parseMetadata(bool ModuleLevel) {
 
 bool MetadataLoader::hasFwdRefs() const { return Pimpl->hasFwdRefs(); }
 
+void MetadataLoader::materializeAllMetadata() {
+  Pimpl->materializeAllMetadata();
+}
+
 /// Return the given metadata, creating a replaceable forward reference if
 /// necessary.
 Metadata *MetadataLoader::getMetadataFwdRefOrLoad(unsigned Idx) {
@@ -41,6 +41,7 @@ public:
   ~MetadataLoader();
   MetadataLoader(BitstreamCursor &Stream, Module &TheModule,
                  BitcodeReaderValueList &ValueList, bool IsImporting,
+                 bool LoadOnDemand,
                  std::function<Type *(unsigned)> getTypeByID);
   MetadataLoader &operator=(MetadataLoader &&);
   MetadataLoader(MetadataLoader &&);
@@ -60,6 +61,10 @@ public:
   // Return true there are remaining unresolved forward references.
   bool hasFwdRefs() const;
 
+  /// Load the module-level metadata that is loaded on demand, ahead of
+  /// materializing all of the functions.
+  void materializeAllMetadata();
+
   /// Return the given metadata, creating a replaceable forward reference if
   /// necessary.
   Metadata *getMetadataFwdRefOrLoad(unsigned Idx);
@@ -67,8 +67,10 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -86,6 +88,11 @@ static cl::opt<unsigned>
                    cl::desc("Number of metadatas above which we emit an index "
                             "to enable lazy-loading"));
 
+static cl::opt<unsigned> WriteThreads(
+    "bitcode-write-threads", cl::Hidden, cl::init(0),
+    cl::desc("Number of threads writing the function blocks of a module "
+             "(0 to write them on the calling thread)"));
+
 cl::opt<bool> WriteRelBFToSummary(
     "write-relbf-to-summary", cl::Hidden, cl::init(false),
     cl::desc("Write relative block frequency to function summary "));
@@ -202,6 +209,14 @@ public:
               assignValueId(CallEdge.first.getGUID());
   }
 
+  /// Constructs a ModuleBitcodeWriterBase object writing the function blocks
+  /// of the module of \p Parent to \p Stream, with a copy of its value
+  /// enumerator.
+  ModuleBitcodeWriterBase(const ModuleBitcodeWriterBase &Parent,
+                          BitstreamWriter &Stream)
+      : BitcodeWriterBase(Stream, Parent.StrtabBuilder), M(Parent.M),
+        VE(Parent.VE), Index(nullptr), GlobalValueId(Parent.GlobalValueId) {}
+
 protected:
   void writePerModuleGlobalValueSummary();
 
@@ -269,6 +284,14 @@ public:
         Buffer(Buffer), GenerateHash(GenerateHash), ModHash(ModHash),
         BitcodeStartBit(Stream.GetCurrentBitNo()) {}
 
+  /// Constructs a ModuleBitcodeWriter object writing the function blocks of
+  /// the module of \p Parent to the provided \p Buffer.
+  ModuleBitcodeWriter(const ModuleBitcodeWriter &Parent,
+                      SmallVectorImpl<char> &Buffer, BitstreamWriter &Stream)
+      : ModuleBitcodeWriterBase(Parent, Stream), Buffer(Buffer),
+        GenerateHash(false), ModHash(nullptr),
+        BitcodeStartBit(Stream.GetCurrentBitNo()) {}
+
   /// Emit the current module to the bitstream.
   void write();
 
@@ -387,6 +410,9 @@ private:
   void
   writeFunction(const Function &F,
                 DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
+  void writeFunctionBody(const Function &F);
+  void writeFunctionsInParallel(
+      DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
   void writeBlockInfo();
   void writeModuleHash(size_t BlockStartPos);
 
@@ -3157,6 +3183,12 @@ void ModuleBitcodeWriter::writeFunction(
   FunctionToBitcodeIndex[&F] = Stream.GetCurrentBitNo();
 
   Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+  writeFunctionBody(F);
+  Stream.ExitBlock();
+}
+
+/// Emit the contents of the function block of \p F.
+void ModuleBitcodeWriter::writeFunctionBody(const Function &F) {
   VE.incorporateFunction(F);
 
   SmallVector<unsigned, 64> Vals;
@@ -3224,7 +3256,57 @@ void ModuleBitcodeWriter::writeFunction(
   if (VE.shouldPreserveUseListOrder())
     writeUseListBlock(&F);
   VE.purgeFunction();
-  Stream.ExitBlock();
+}
+
+/// Emit the function blocks with -bitcode-write-threads. The body of a block
+/// only depends on the module-level value IDs, and starts on a word boundary,
+/// so workers write the bodies into buffers of their own, with a copy of the
+/// value enumerator each, and they are then spliced into the stream in module
+/// order. The output is the same as writing them on this thread.
+void ModuleBitcodeWriter::writeFunctionsInParallel(
+    DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex) {
+  std::vector<const Function *> Functions;
+  for (const Function &F : M)
+    if (!F.isDeclaration())
+      Functions.push_back(&F);
+
+  struct FunctionBody {
+    unsigned Worker;
+    uint64_t BeginBit, EndBit;
+  };
+  std::vector<FunctionBody> Bodies(Functions.size());
+  unsigned NumWorkers = std::min<size_t>(WriteThreads, Functions.size());
+  std::vector<SmallVector<char, 0>> Buffers(NumWorkers);
+  std::atomic<size_t> NextFunction(0);
+  {
+    ThreadPool Pool(NumWorkers);
+    for (unsigned W = 0; W != NumWorkers; ++W) {
+      Pool.async([&, W] {
+        BitstreamWriter WorkerStream(Buffers[W]);
+        ModuleBitcodeWriter Writer(*this, Buffers[W], WorkerStream);
+        // Install the abbreviations of the function blocks.
+        Writer.writeBlockInfo();
+        for (size_t I; (I = NextFunction++) < Functions.size();) {
+          WorkerStream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+          Bodies[I].Worker = W;
+          Bodies[I].BeginBit = WorkerStream.GetCurrentBitNo();
+          Writer.writeFunctionBody(*Functions[I]);
+          Bodies[I].EndBit = WorkerStream.GetCurrentBitNo();
+          WorkerStream.ExitBlock();
+        }
+      });
+    }
+  }
+
+  for (size_t I = 0, E = Functions.size(); I != E; ++I) {
+    const FunctionBody &Body = Bodies[I];
+    const SmallVector<char, 0> &Bits = Buffers[Body.Worker];
+    FunctionToBitcodeIndex[Functions[I]] = Stream.GetCurrentBitNo();
+    Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+    Stream.EmitBits(makeArrayRef((const uint8_t *)Bits.data(), Bits.size()),
+                    Body.BeginBit, Body.EndBit);
+    Stream.ExitBlock();
+  }
 }
 
 // Emit blockinfo, which defines the standard abbreviations etc.
@@ -4167,9 +4249,13 @@ void ModuleBitcodeWriter::write() {
 
   // Emit function bodies.
   DenseMap<const Function *, uint64_t> FunctionToBitcodeIndex;
-  for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
-    if (!F->isDeclaration())
-      writeFunction(*F, FunctionToBitcodeIndex);
+  // Use-list orders are written with the functions in the order of a stack.
+  if (WriteThreads > 0 && !VE.shouldPreserveUseListOrder())
+    writeFunctionsInParallel(FunctionToBitcodeIndex);
+  else
+    for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
+      if (!F->isDeclaration())
+        writeFunction(*F, FunctionToBitcodeIndex);
 
   // Need to write after the above call to WriteFunction which populates
   // the summary information in the index.
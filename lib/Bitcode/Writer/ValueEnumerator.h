@@ -140,7 +140,8 @@ private:
 
 public:
   ValueEnumerator(const Module &M, bool ShouldPreserveUseListOrder);
-  ValueEnumerator(const ValueEnumerator &) = delete;
+  /// Copied to write function blocks on other threads.
+  ValueEnumerator(const ValueEnumerator &) = default;
   ValueEnumerator &operator=(const ValueEnumerator &) = delete;
 
   void dump() const;
@@ -68,13 +68,16 @@
 #include "llvm/IR/Value.h"
 #include "llvm/Support/AtomicOrdering.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cctype>
 #include <cstddef>
@@ -88,6 +91,11 @@
 
 using namespace llvm;
 
+static cl::opt<unsigned> PrintThreads(
+    "asm-print-threads", cl::Hidden, cl::init(0),
+    cl::desc("Number of threads printing the functions of a module "
+             "(0 to print them on the calling thread)"));
+
 // Make virtual table appear in this compilation unit.
 AssemblyAnnotationWriter::~AssemblyAnnotationWriter() = default;
 
@@ -676,7 +684,14 @@ private:
 
   /// TheFunction - The function for which we are holding slot numbers.
   const Function* TheFunction = nullptr;
+
+  /// The values and attribute sets, and the metadata, of the module and of
+  /// the function are numbered separately, on first use, so that printing a
+  /// function without metadata does not walk all the module's metadata.
+  bool ModuleProcessed = false;
+  bool ModuleMetadataProcessed = false;
   bool FunctionProcessed = false;
+  bool FunctionMetadataProcessed = false;
   bool ShouldInitializeAllMetadata;
 
   /// The summary index for which we are holding slot numbers.
@@ -730,7 +745,8 @@ public:
   /// Construct from a module summary index.
   explicit SlotTracker(const ModuleSummaryIndex *Index);
 
-  SlotTracker(const SlotTracker &) = delete;
+  /// Copied to print functions on other threads.
+  SlotTracker(const SlotTracker &) = default;
   SlotTracker &operator=(const SlotTracker &) = delete;
 
   /// Return the slot number of the specified value in it's type
@@ -748,6 +764,7 @@ public:
   void incorporateFunction(const Function *F) {
     TheFunction = F;
     FunctionProcessed = false;
+    FunctionMetadataProcessed = false;
   }
 
   const Function *getFunction() const { return TheFunction; }
@@ -780,6 +797,11 @@ public:
   inline void initializeIfNeeded();
   void initializeIndexIfNeeded();
 
+  /// Number the values and attribute sets, or the metadata, of the module and
+  /// of the incorporated function, if that has not been done yet.
+  void initializeValuesIfNeeded();
+  void initializeMetadataIfNeeded();
+
   // Implementation Details
 private:
   /// CreateModuleSlot - Insert the specified GlobalValue* into the slot table.
@@ -801,6 +823,8 @@ private:
   /// Add all of the module level global variables (and their initializers)
   /// and function declarations, but not the contents of those functions.
   void processModule();
+  /// Add the metadata attached to globals and used by named metadata.
+  void processModuleMetadata();
   void processIndex();
 
   /// Add all of the functions arguments, basic blocks, and instructions.
@@ -906,15 +930,30 @@ SlotTracker::SlotTracker(const ModuleSummaryIndex *Index)
     : TheModule(nullptr), ShouldInitializeAllMetadata(false), TheIndex(Index) {}
 
 inline void SlotTracker::initializeIfNeeded() {
-  if (TheModule) {
+  initializeValuesIfNeeded();
+  initializeMetadataIfNeeded();
+}
+
+void SlotTracker::initializeValuesIfNeeded() {
+  if (TheModule && !ModuleProcessed)
     processModule();
-    TheModule = nullptr; ///< Prevent re-processing next time we're called.
-  }
 
   if (TheFunction && !FunctionProcessed)
     processFunction();
 }
 
+void SlotTracker::initializeMetadataIfNeeded() {
+  if (TheModule && !ModuleMetadataProcessed)
+    processModuleMetadata();
+
+  // Process function metadata if it wasn't hit at the module-level.
+  if (TheFunction && !FunctionMetadataProcessed) {
+    if (!ShouldInitializeAllMetadata)
+      processFunctionMetadata(*TheFunction);
+    FunctionMetadataProcessed = true;
+  }
+}
+
 void SlotTracker::initializeIndexIfNeeded() {
   if (!TheIndex)
     return;
@@ -931,7 +970,6 @@ void SlotTracker::processModule() {
   for (const GlobalVariable &Var : TheModule->globals()) {
     if (!Var.hasName())
       CreateModuleSlot(&Var);
-    processGlobalObjectMetadata(Var);
     auto Attrs = Var.getAttributes();
     if (Attrs.hasAttributes())
       CreateAttributeSetSlot(Attrs);
@@ -947,20 +985,11 @@ void SlotTracker::processModule() {
       CreateModuleSlot(&I);
   }
 
-  // Add metadata used by named metadata.
-  for (const NamedMDNode &NMD : TheModule->named_metadata()) {
-    for (unsigned i = 0, e = NMD.getNumOperands(); i != e; ++i)
-      CreateMetadataSlot(NMD.getOperand(i));
-  }
-
   for (const Function &F : *TheModule) {
     if (!F.hasName())
       // Add all the unnamed functions to the table.
       CreateModuleSlot(&F);
 
-    if (ShouldInitializeAllMetadata)
-      processFunctionMetadata(F);
-
     // Add all the function attributes to the table.
     // FIXME: Add attributes of other objects?
     AttributeSet FnAttrs = F.getAttributes().getFnAttributes();
@@ -968,18 +997,39 @@ void SlotTracker::processModule() {
       CreateAttributeSetSlot(FnAttrs);
   }
 
+  ModuleProcessed = true;
+
   ST_DEBUG("end processModule!\n");
 }
 
+// Create slots for the metadata of the module, and of all its functions if
+// ShouldInitializeAllMetadata.
+void SlotTracker::processModuleMetadata() {
+  ST_DEBUG("begin processModuleMetadata!\n");
+
+  for (const GlobalVariable &Var : TheModule->globals())
+    processGlobalObjectMetadata(Var);
+
+  // Add metadata used by named metadata.
+  for (const NamedMDNode &NMD : TheModule->named_metadata()) {
+    for (unsigned i = 0, e = NMD.getNumOperands(); i != e; ++i)
+      CreateMetadataSlot(NMD.getOperand(i));
+  }
+
+  if (ShouldInitializeAllMetadata)
+    for (const Function &F : *TheModule)
+      processFunctionMetadata(F);
+
+  ModuleMetadataProcessed = true;
+
+  ST_DEBUG("end processModuleMetadata!\n");
+}
+
 // Process the arguments, basic blocks, and instructions  of a function.
 void SlotTracker::processFunction() {
   ST_DEBUG("begin processFunction!\n");
   fNext = 0;
 
-  // Process function metadata if it wasn't hit at the module-level.
-  if (!ShouldInitializeAllMetadata)
-    processFunctionMetadata(*TheFunction);
-
   // Add all the function arguments with no names.
   for(Function::const_arg_iterator AI = TheFunction->arg_begin(),
       AE = TheFunction->arg_end(); AI != AE; ++AI)
@@ -1083,13 +1133,14 @@ void SlotTracker::purgeFunction() {
   fMap.clear(); // Simply discard the function level map
   TheFunction = nullptr;
   FunctionProcessed = false;
+  FunctionMetadataProcessed = false;
   ST_DEBUG("end purgeFunction!\n");
 }
 
 /// getGlobalSlot - Get the slot number of a global value.
 int SlotTracker::getGlobalSlot(const GlobalValue *V) {
   // Check for uninitialized state and do lazy initialization.
-  initializeIfNeeded();
+  initializeValuesIfNeeded();
 
   // Find the value in the module map
   ValueMap::iterator MI = mMap.find(V);
@@ -1099,7 +1150,7 @@ int SlotTracker::getGlobalSlot(const GlobalValue *V) {
 /// getMetadataSlot - Get the slot number of a MDNode.
 int SlotTracker::getMetadataSlot(const MDNode *N) {
   // Check for uninitialized state and do lazy initialization.
-  initializeIfNeeded();
+  initializeMetadataIfNeeded();
 
   // Find the MDNode in the module map
   mdn_iterator MI = mdnMap.find(N);
@@ -1111,7 +1162,7 @@ int SlotTracker::getLocalSlot(const Value *V) {
   assert(!isa<Constant>(V) && "Can't get a constant or global slot with this!");
 
   // Check for uninitialized state and do lazy initialization.
-  initializeIfNeeded();
+  initializeValuesIfNeeded();
 
   ValueMap::iterator FI = fMap.find(V);
   return FI == fMap.end() ? -1 : (int)FI->second;
@@ -1119,7 +1170,7 @@ int SlotTracker::getLocalSlot(const Value *V) {
 
 int SlotTracker::getAttributeGroupSlot(AttributeSet AS) {
   // Check for uninitialized state and do lazy initialization.
-  initializeIfNeeded();
+  initializeValuesIfNeeded();
 
   // Find the AttributeSet in the module map.
   as_iterator AI = asMap.find(AS);
@@ -1281,6 +1332,95 @@ static void WriteOptimizationInfo(raw_ostream &Out, const User *U) {
   }
 }
 
+static void WriteAPFloatInternal(raw_ostream &Out, const APFloat &APF) {
+  if (&APF.getSemantics() == &APFloat::IEEEsingle() ||
+      &APF.getSemantics() == &APFloat::IEEEdouble()) {
+    // We would like to output the FP constant value in exponential notation,
+    // but we cannot do this if doing so will lose precision.  Check here to
+    // make sure that we only output it in exponential format if we can parse
+    // the value back and get the same value.
+    //
+    bool ignored;
+    bool isDouble = &APF.getSemantics() == &APFloat::IEEEdouble();
+    bool isInf = APF.isInfinity();
+    bool isNaN = APF.isNaN();
+    if (!isInf && !isNaN) {
+      double Val = isDouble ? APF.convertToDouble() : APF.convertToFloat();
+      SmallString<128> StrVal;
+      APF.toString(StrVal, 6, 0, false);
+      // Check to make sure that the stringized number is not some string like
+      // "Inf" or NaN, that atof will accept, but the lexer will not.  Check
+      // that the string matches the "[-+]?[0-9]" regex.
+      //
+      assert(((StrVal[0] >= '0' && StrVal[0] <= '9') ||
+              ((StrVal[0] == '-' || StrVal[0] == '+') &&
+               (StrVal[1] >= '0' && StrVal[1] <= '9'))) &&
+             "[-+]?[0-9] regex does not match!");
+      // Reparse stringized version!
+      if (APFloat(APFloat::IEEEdouble(), StrVal).convertToDouble() == Val) {
+        Out << StrVal;
+        return;
+      }
+    }
+    // Otherwise we could not reparse it to exactly the same value, so we must
+    // output the string in hexadecimal format!  Note that loading and storing
+    // floating point types changes the bits of NaNs on some hosts, notably
+    // x86, so we must not use these types.
+    static_assert(sizeof(double) == sizeof(uint64_t),
+                  "assuming that double is 64 bits!");
+    APFloat apf = APF;
+    // Floats are represented in ASCII IR as double, convert.
+    if (!isDouble)
+      apf.convert(APFloat::IEEEdouble(), APFloat::rmNearestTiesToEven,
+                  &ignored);
+    Out << format_hex(apf.bitcastToAPInt().getZExtValue(), 0, /*Upper=*/true);
+    return;
+  }
+
+  // Either half, or some form of long double.
+  // These appear as a magic letter identifying the type, then a
+  // fixed number of hex digits.
+  Out << "0x";
+  APInt API = APF.bitcastToAPInt();
+  if (&APF.getSemantics() == &APFloat::x87DoubleExtended()) {
+    Out << 'K';
+    Out << format_hex_no_prefix(API.getHiBits(16).getZExtValue(), 4,
+                                /*Upper=*/true);
+    Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+    return;
+  } else if (&APF.getSemantics() == &APFloat::IEEEquad()) {
+    Out << 'L';
+    Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+    Out << format_hex_no_prefix(API.getHiBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+  } else if (&APF.getSemantics() == &APFloat::PPCDoubleDouble()) {
+    Out << 'M';
+    Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+    Out << format_hex_no_prefix(API.getHiBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+  } else if (&APF.getSemantics() == &APFloat::IEEEhalf()) {
+    Out << 'H';
+    Out << format_hex_no_prefix(API.getZExtValue(), 4,
+                                /*Upper=*/true);
+  } else
+    llvm_unreachable("Unsupported floating point type");
+}
+
+/// Prints the element \p Idx of \p CDS the way its constant would be printed,
+/// without creating the constant, which would modify the context while
+/// functions may be printed in parallel.
+static void WriteDataElement(raw_ostream &Out,
+                             const ConstantDataSequential *CDS, unsigned Idx) {
+  Type *ETy = CDS->getElementType();
+  if (ETy->isFloatingPointTy())
+    WriteAPFloatInternal(Out, CDS->getElementAsAPFloat(Idx));
+  else
+    Out << APInt(ETy->getIntegerBitWidth(), CDS->getElementAsInteger(Idx));
+}
+
 static void WriteConstantInternal(raw_ostream &Out, const Constant *CV,
                                   TypePrinting &TypePrinter,
                                   SlotTracker *Machine,
@@ -1295,81 +1435,7 @@ static void WriteConstantInternal(raw_ostream &Out, const Constant *CV,
   }
 
   if (const ConstantFP *CFP = dyn_cast<ConstantFP>(CV)) {
-    const APFloat &APF = CFP->getValueAPF();
-    if (&APF.getSemantics() == &APFloat::IEEEsingle() ||
-        &APF.getSemantics() == &APFloat::IEEEdouble()) {
-      // We would like to output the FP constant value in exponential notation,
-      // but we cannot do this if doing so will lose precision.  Check here to
-      // make sure that we only output it in exponential format if we can parse
-      // the value back and get the same value.
-      //
-      bool ignored;
-      bool isDouble = &APF.getSemantics() == &APFloat::IEEEdouble();
-      bool isInf = APF.isInfinity();
-      bool isNaN = APF.isNaN();
-      if (!isInf && !isNaN) {
-        double Val = isDouble ? APF.convertToDouble() : APF.convertToFloat();
-        SmallString<128> StrVal;
-        APF.toString(StrVal, 6, 0, false);
-        // Check to make sure that the stringized number is not some string like
-        // "Inf" or NaN, that atof will accept, but the lexer will not.  Check
-        // that the string matches the "[-+]?[0-9]" regex.
-        //
-        assert(((StrVal[0] >= '0' && StrVal[0] <= '9') ||
-                ((StrVal[0] == '-' || StrVal[0] == '+') &&
-                 (StrVal[1] >= '0' && StrVal[1] <= '9'))) &&
-               "[-+]?[0-9] regex does not match!");
-        // Reparse stringized version!
-        if (APFloat(APFloat::IEEEdouble(), StrVal).convertToDouble() == Val) {
-          Out << StrVal;
-          return;
-        }
-      }
-      // Otherwise we could not reparse it to exactly the same value, so we must
-      // output the string in hexadecimal format!  Note that loading and storing
-      // floating point types changes the bits of NaNs on some hosts, notably
-      // x86, so we must not use these types.
-      static_assert(sizeof(double) == sizeof(uint64_t),
-                    "assuming that double is 64 bits!");
-      APFloat apf = APF;
-      // Floats are represented in ASCII IR as double, convert.
-      if (!isDouble)
-        apf.convert(APFloat::IEEEdouble(), APFloat::rmNearestTiesToEven,
-                          &ignored);
-      Out << format_hex(apf.bitcastToAPInt().getZExtValue(), 0, /*Upper=*/true);
-      return;
-    }
-
-    // Either half, or some form of long double.
-    // These appear as a magic letter identifying the type, then a
-    // fixed number of hex digits.
-    Out << "0x";
-    APInt API = APF.bitcastToAPInt();
-    if (&APF.getSemantics() == &APFloat::x87DoubleExtended()) {
-      Out << 'K';
-      Out << format_hex_no_prefix(API.getHiBits(16).getZExtValue(), 4,
-                                  /*Upper=*/true);
-      Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-      return;
-    } else if (&APF.getSemantics() == &APFloat::IEEEquad()) {
-      Out << 'L';
-      Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-      Out << format_hex_no_prefix(API.getHiBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-    } else if (&APF.getSemantics() == &APFloat::PPCDoubleDouble()) {
-      Out << 'M';
-      Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-      Out << format_hex_no_prefix(API.getHiBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-    } else if (&APF.getSemantics() == &APFloat::IEEEhalf()) {
-      Out << 'H';
-      Out << format_hex_no_prefix(API.getZExtValue(), 4,
-                                  /*Upper=*/true);
-    } else
-      llvm_unreachable("Unsupported floating point type");
+    WriteAPFloatInternal(Out, CFP->getValueAPF());
     return;
   }
 
@@ -1422,15 +1488,12 @@ static void WriteConstantInternal(raw_ostream &Out, const Constant *CV,
     Out << '[';
     TypePrinter.print(ETy, Out);
     Out << ' ';
-    WriteAsOperandInternal(Out, CA->getElementAsConstant(0),
-                           &TypePrinter, Machine,
-                           Context);
+    WriteDataElement(Out, CA, 0);
     for (unsigned i = 1, e = CA->getNumElements(); i != e; ++i) {
       Out << ", ";
       TypePrinter.print(ETy, Out);
       Out << ' ';
-      WriteAsOperandInternal(Out, CA->getElementAsConstant(i), &TypePrinter,
-                             Machine, Context);
+      WriteDataElement(Out, CA, i);
     }
     Out << ']';
     return;
@@ -1469,16 +1532,16 @@ static void WriteConstantInternal(raw_ostream &Out, const Constant *CV,
   if (isa<ConstantVector>(CV) || isa<ConstantDataVector>(CV)) {
     Type *ETy = CV->getType()->getVectorElementType();
     Out << '<';
-    TypePrinter.print(ETy, Out);
-    Out << ' ';
-    WriteAsOperandInternal(Out, CV->getAggregateElement(0U), &TypePrinter,
-                           Machine, Context);
-    for (unsigned i = 1, e = CV->getType()->getVectorNumElements(); i != e;++i){
-      Out << ", ";
+    for (unsigned i = 0, e = CV->getType()->getVectorNumElements(); i != e;++i){
+      if (i)
+        Out << ", ";
       TypePrinter.print(ETy, Out);
       Out << ' ';
-      WriteAsOperandInternal(Out, CV->getAggregateElement(i), &TypePrinter,
-                             Machine, Context);
+      if (const auto *CDV = dyn_cast<ConstantDataVector>(CV))
+        WriteDataElement(Out, CDV, i);
+      else
+        WriteAsOperandInternal(Out, CV->getOperand(i), &TypePrinter, Machine,
+                               Context);
     }
     Out << '>';
     return;
@@ -2398,6 +2461,7 @@ public:
   void printIndirectSymbol(const GlobalIndirectSymbol *GIS);
   void printComdat(const Comdat *C);
   void printFunction(const Function *F);
+  void printFunctionsInParallel(const Module *M);
   void printArgument(const Argument *FA, AttributeSet Attrs);
   void printBasicBlock(const BasicBlock *BB);
   void printInstructionLine(const Instruction &I);
@@ -2638,8 +2702,11 @@ void AssemblyWriter::printModule(const Module *M) {
   printUseLists(nullptr);
 
   // Output all of the functions.
-  for (const Function &F : *M)
-    printFunction(&F);
+  if (PrintThreads > 0 && !ShouldPreserveUseListOrder && !AnnotationWriter)
+    printFunctionsInParallel(M);
+  else
+    for (const Function &F : *M)
+      printFunction(&F);
   assert(UseListOrders.empty() && "All use-lists should have been consumed");
 
   // Output all attribute groups.
@@ -3497,6 +3564,52 @@ void AssemblyWriter::printFunction(const Function *F) {
   Machine.purgeFunction();
 }
 
+/// Print the functions with -asm-print-threads. The metadata and attribute
+/// groups used by the functions are numbered up front, in module order, and
+/// workers then print the functions into buffers of their own, with a copy of
+/// the slot tracker each. The text is copied out in module order, so it is
+/// the same as printing on the calling thread.
+void AssemblyWriter::printFunctionsInParallel(const Module *M) {
+  std::vector<const Function *> Functions;
+  for (const Function &F : *M) {
+    Functions.push_back(&F);
+    Machine.incorporateFunction(&F);
+    Machine.initializeIfNeeded();
+    Machine.purgeFunction();
+  }
+
+  struct FunctionText {
+    unsigned Worker;
+    uint64_t Begin, End;
+  };
+  std::vector<FunctionText> Texts(Functions.size());
+  unsigned NumWorkers = std::min<size_t>(PrintThreads, Functions.size());
+  std::vector<std::string> Buffers(NumWorkers);
+  std::atomic<size_t> NextFunction(0);
+  {
+    ThreadPool Pool(NumWorkers);
+    for (unsigned W = 0; W != NumWorkers; ++W) {
+      Pool.async([&, W] {
+        SlotTracker WorkerMachine(Machine);
+        raw_string_ostream ROS(Buffers[W]);
+        formatted_raw_ostream OS(ROS);
+        AssemblyWriter Writer(OS, WorkerMachine, M, nullptr, IsForDebug);
+        for (size_t I; (I = NextFunction++) < Functions.size();) {
+          Texts[I].Worker = W;
+          Texts[I].Begin = OS.tell();
+          Writer.printFunction(Functions[I]);
+          Texts[I].End = OS.tell();
+        }
+        OS.flush();
+        ROS.flush();
+      });
+    }
+  }
+
+  for (const FunctionText &Text : Texts)
+    Out << StringRef(Buffers[Text.Worker]).slice(Text.Begin, Text.End);
+}
+
 /// printArgument - This member is called for every argument that is passed into
 /// the function.  Simply print it out
 void AssemblyWriter::printArgument(const Argument *Arg, AttributeSet Attrs) {
@@ -11,7 +11,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/ConcurrentAllocator.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
 
 namespace llvm {
 
@@ -26,6 +29,26 @@ void printBumpPtrAllocatorStats(unsigned NumSlabs, size_t BytesAllocated,
          << " (includes alignment, etc)\n";
 }
 
+static std::atomic<uint64_t> NextPerThreadAllocatorID{1};
+
+// The per-thread allocator a thread used last, and the arena it belongs to.
+// Zero is never a valid arena ID.
+static LLVM_THREAD_LOCAL uint64_t CachedArenaID = 0;
+static LLVM_THREAD_LOCAL void *CachedThreadAllocator = nullptr;
+
+uint64_t getNextPerThreadAllocatorID() {
+  return NextPerThreadAllocatorID.fetch_add(1, std::memory_order_relaxed);
+}
+
+void *getCachedThreadAllocator(uint64_t ID) {
+  return CachedArenaID == ID ? CachedThreadAllocator : nullptr;
+}
+
+void setCachedThreadAllocator(uint64_t ID, void *Alloc) {
+  CachedArenaID = ID;
+  CachedThreadAllocator = Alloc;
+}
+
 } // End namespace detail.
 
 void PrintRecyclerStats(size_t Size,
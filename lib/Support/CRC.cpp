@@ -8,25 +8,45 @@
 //
 //  This file implements llvm::crc32 function.
 //
+//  Large inputs are folded 64 bytes at a time with carry-less multiplication
+//  where the host supports it, as described in "Fast CRC Computation for
+//  Generic Polynomials Using PCLMULQDQ Instruction" (Gopal et al., Intel,
+//  2009), or with the CRC32 instructions of ARMv8. The rest is computed with
+//  zlib if available, or with tables eight bytes at a time.
+//
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/CRC.h"
 #include "llvm/Config/config.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/Threading.h"
 #include <array>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LLVM_CRC32_PCLMUL 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define LLVM_CRC32_ARM 1
+#include <arm_acle.h>
+#endif
+
 using namespace llvm;
 
+// The functions below update the CRC register, which is the complement of the
+// CRC value, with the bytes [P, P + Len).
+
 #if LLVM_ENABLE_ZLIB == 0 || !HAVE_ZLIB_H
-using CRC32Table = std::array<uint32_t, 256>;
+using CRC32Tables = std::array<std::array<uint32_t, 256>, 8>;
 
-static void initCRC32Table(CRC32Table *Tbl) {
+static void initCRC32Tables(CRC32Tables *Tbl) {
   auto Shuffle = [](uint32_t V) {
     return (V & 1) ? (V >> 1) ^ 0xEDB88320U : V >> 1;
   };
 
-  for (size_t I = 0; I < Tbl->size(); ++I) {
+  for (size_t I = 0; I < 256; ++I) {
     uint32_t V = Shuffle(I);
     V = Shuffle(V);
     V = Shuffle(V);
@@ -34,35 +54,134 @@ static void initCRC32Table(CRC32Table *Tbl) {
     V = Shuffle(V);
     V = Shuffle(V);
     V = Shuffle(V);
-    (*Tbl)[I] = Shuffle(V);
+    (*Tbl)[0][I] = Shuffle(V);
   }
+  // Tbl[K][I] is the register for byte I followed by K zero bytes.
+  for (size_t K = 1; K < 8; ++K)
+    for (size_t I = 0; I < 256; ++I)
+      (*Tbl)[K][I] = (*Tbl)[0][(*Tbl)[K - 1][I] & 0xFF] ^
+                     ((*Tbl)[K - 1][I] >> 8);
 }
 
-uint32_t llvm::crc32(uint32_t CRC, StringRef S) {
+static uint32_t updatePortable(uint32_t CRC, const uint8_t *P, size_t Len) {
   static llvm::once_flag InitFlag;
-  static CRC32Table Tbl;
-  llvm::call_once(InitFlag, initCRC32Table, &Tbl);
-
-  const uint8_t *P = reinterpret_cast<const uint8_t *>(S.data());
-  size_t Len = S.size();
-  CRC ^= 0xFFFFFFFFU;
-  for (; Len >= 8; Len -= 8) {
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
+  static CRC32Tables Tbl;
+  llvm::call_once(InitFlag, initCRC32Tables, &Tbl);
+
+  for (; Len >= 8; Len -= 8, P += 8) {
+    uint32_t Lo = CRC ^ support::endian::read32le(P);
+    uint32_t Hi = support::endian::read32le(P + 4);
+    CRC = Tbl[7][Lo & 0xFF] ^ Tbl[6][(Lo >> 8) & 0xFF] ^
+          Tbl[5][(Lo >> 16) & 0xFF] ^ Tbl[4][Lo >> 24] ^ Tbl[3][Hi & 0xFF] ^
+          Tbl[2][(Hi >> 8) & 0xFF] ^ Tbl[1][(Hi >> 16) & 0xFF] ^
+          Tbl[0][Hi >> 24];
   }
   while (Len--)
-    CRC = Tbl[(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
-  return CRC ^ 0xFFFFFFFFU;
+    CRC = Tbl[0][(CRC ^ *P++) & 0xFF] ^ (CRC >> 8);
+  return CRC;
 }
 #else
 #include <zlib.h>
-uint32_t llvm::crc32(uint32_t CRC, StringRef S) {
-  return ::crc32(CRC, (const Bytef *)S.data(), S.size());
+static uint32_t updatePortable(uint32_t CRC, const uint8_t *P, size_t Len) {
+  // zlib takes the length as a uInt.
+  for (; Len > 0x40000000; Len -= 0x40000000, P += 0x40000000)
+    CRC = ~::crc32(~CRC, P, 0x40000000);
+  return ~::crc32(~CRC, P, Len);
 }
 #endif
+
+#if LLVM_CRC32_PCLMUL
+#define LLVM_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+
+LLVM_TARGET_PCLMUL static inline __m128i load128(const uint8_t *P) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(P));
+}
+
+// Multiplies X by x^128 or x^512 modulo P(x), depending on K, and adds Y.
+LLVM_TARGET_PCLMUL static inline __m128i fold128(__m128i X, __m128i K,
+                                                 __m128i Y) {
+  return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(X, K, 0x00),
+                                     _mm_clmulepi64_si128(X, K, 0x11)),
+                       Y);
+}
+
+// Folds the bytes [P, P + Len), where Len is a multiple of 16 and at least 64,
+// into the register.
+LLVM_TARGET_PCLMUL static uint32_t updatePCLMUL(uint32_t CRC, const uint8_t *P,
+                                                size_t Len) {
+  // The constants x^(4*128+32) mod P(x), x^(4*128-32) mod P(x), and so on, in
+  // the bit-reflected domain, and the polynomial with its Barrett constant.
+  const __m128i K1K2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+  const __m128i K3K4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+  const __m128i K5K0 = _mm_set_epi64x(0, 0x0163cd6124);
+  const __m128i Poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+  const __m128i Mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  __m128i X1 = _mm_xor_si128(load128(P), _mm_cvtsi32_si128(CRC));
+  __m128i X2 = load128(P + 16), X3 = load128(P + 32), X4 = load128(P + 48);
+  P += 64;
+  Len -= 64;
+
+  // Fold four lanes of 128 bits at a time.
+  for (; Len >= 64; Len -= 64, P += 64) {
+    X1 = fold128(X1, K1K2, load128(P));
+    X2 = fold128(X2, K1K2, load128(P + 16));
+    X3 = fold128(X3, K1K2, load128(P + 32));
+    X4 = fold128(X4, K1K2, load128(P + 48));
+  }
+
+  // Fold the lanes into one, and the remaining blocks of 16 bytes into it.
+  X1 = fold128(X1, K3K4, X2);
+  X1 = fold128(X1, K3K4, X3);
+  X1 = fold128(X1, K3K4, X4);
+  for (; Len >= 16; Len -= 16, P += 16)
+    X1 = fold128(X1, K3K4, load128(P));
+
+  // Reduce 128 bits to 64.
+  __m128i T = _mm_clmulepi64_si128(X1, K3K4, 0x10);
+  X1 = _mm_xor_si128(_mm_srli_si128(X1, 8), T);
+  T = _mm_srli_si128(X1, 4);
+  X1 = _mm_clmulepi64_si128(_mm_and_si128(X1, Mask32), K5K0, 0x00);
+  X1 = _mm_xor_si128(X1, T);
+
+  // Barrett reduction to 32 bits.
+  T = _mm_clmulepi64_si128(_mm_and_si128(X1, Mask32), Poly, 0x10);
+  T = _mm_clmulepi64_si128(_mm_and_si128(T, Mask32), Poly, 0x00);
+  X1 = _mm_xor_si128(X1, T);
+  return _mm_extract_epi32(X1, 1);
+}
+#undef LLVM_TARGET_PCLMUL
+
+static bool hostHasPCLMUL() {
+  StringMap<bool> Features;
+  return sys::getHostCPUFeatures(Features) && Features.lookup("pclmul") &&
+         Features.lookup("sse4.1");
+}
+
+static uint32_t update(uint32_t CRC, const uint8_t *P, size_t Len) {
+  static const bool HasPCLMUL = hostHasPCLMUL();
+  if (HasPCLMUL && Len >= 64) {
+    size_t Folded = Len & ~size_t(15);
+    CRC = updatePCLMUL(CRC, P, Folded);
+    P += Folded;
+    Len -= Folded;
+  }
+  return updatePortable(CRC, P, Len);
+}
+#elif LLVM_CRC32_ARM
+static uint32_t update(uint32_t CRC, const uint8_t *P, size_t Len) {
+  for (; Len >= 8; Len -= 8, P += 8)
+    CRC = __crc32d(CRC, support::endian::read64le(P));
+  while (Len--)
+    CRC = __crc32b(CRC, *P++);
+  return CRC;
+}
+#else
+static uint32_t update(uint32_t CRC, const uint8_t *P, size_t Len) {
+  return updatePortable(CRC, P, Len);
+}
+#endif
+
+uint32_t llvm::crc32(uint32_t CRC, StringRef S) {
+  return ~update(~CRC, reinterpret_cast<const uint8_t *>(S.data()), S.size());
+}
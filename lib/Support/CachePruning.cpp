@@ -12,10 +12,15 @@
 
 #include "llvm/Support/CachePruning.h"
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -39,8 +44,175 @@ struct FileInfo {
            std::tie(Other.Time, Size, Other.Path);
   }
 };
+
+/// What is known about a file of the cache.
+struct IndexEntry {
+  sys::TimePoint<> Time;
+  uint64_t Size;
+  /// Whether Time and Size were read from the file system during this
+  /// pruning, rather than from the index.
+  bool Fresh;
+};
+
+/// The index of a cache directory, with the sizes and access times of its
+/// files as of the last pruning. The access times of the files may have been
+/// updated since, but not set back.
+///
+/// The index is stored as "llvmcache.index/index" in the cache directory. It
+/// has a directory of its own so that replacing it does not change the
+/// modification time of the cache directory. Its format is:
+///
+///   "LLVMCIX1"
+///   the modification time of the directory when it was last listed
+///   the time when it was last listed
+///   the number of files
+///   for each file: its access time, its size, and its name
+///
+/// Times are 64-bit nanoseconds since the epoch, and names are prefixed by
+/// their 32-bit size, all little-endian.
+struct CacheIndex {
+  sys::TimePoint<> DirModTime, ListTime;
+  StringMap<IndexEntry> Entries;
+
+  bool read(StringRef IndexDir);
+  void write(StringRef IndexDir) const;
+};
 } // anonymous namespace
 
+static const char IndexMagic[] = {'L', 'L', 'V', 'M', 'C', 'I', 'X', '1'};
+
+static sys::TimePoint<> toTimePoint(uint64_t NS) {
+  return sys::TimePoint<>(std::chrono::nanoseconds(NS));
+}
+
+/// Returns whether \p Name, read from the index, can be a file of the cache.
+/// The index may have been written by anybody, and the names in it are
+/// removed from the cache directory.
+static bool isCacheFileName(StringRef Name) {
+  return Name.startswith("llvmcache-") &&
+         llvm::none_of(Name, [](char C) {
+           return C == '\0' || sys::path::is_separator(C);
+         });
+}
+
+bool CacheIndex::read(StringRef IndexDir) {
+  using namespace support;
+  SmallString<128> IndexPath(IndexDir);
+  sys::path::append(IndexPath, "index");
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buf = MemoryBuffer::getFile(
+      IndexPath, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+  if (!Buf)
+    return false;
+  StringRef Data = (*Buf)->getBuffer();
+  if (Data.size() < 32 || !Data.startswith(StringRef(IndexMagic, 8)))
+    return false;
+  const char *P = Data.data() + 8, *End = Data.end();
+  DirModTime = toTimePoint(endian::read64le(P));
+  ListTime = toTimePoint(endian::read64le(P + 8));
+  uint64_t NumEntries = endian::read64le(P + 16);
+  P += 24;
+  for (uint64_t I = 0; I != NumEntries; ++I) {
+    if (End - P < 20)
+      return false;
+    IndexEntry E = {toTimePoint(endian::read64le(P)), endian::read64le(P + 8),
+                    false};
+    uint32_t NameSize = endian::read32le(P + 16);
+    P += 20;
+    if (uint64_t(End - P) < NameSize)
+      return false;
+    StringRef Name(P, NameSize);
+    if (!isCacheFileName(Name)) {
+      LLVM_DEBUG(dbgs() << "Ignore the index (bad file name)\n");
+      return false;
+    }
+    Entries[Name] = E;
+    P += NameSize;
+  }
+  return true;
+}
+
+void CacheIndex::write(StringRef IndexDir) const {
+  using namespace support;
+  // The new index is renamed into place, so that concurrent prunings see
+  // either the old index or the new one.
+  sys::fs::create_directory(IndexDir);
+  SmallString<128> Model(IndexDir);
+  sys::path::append(Model, "index-%%%%%%");
+  Expected<sys::fs::TempFile> Temp = sys::fs::TempFile::create(Model);
+  if (!Temp) {
+    consumeError(Temp.takeError());
+    return;
+  }
+  raw_fd_ostream OS(Temp->FD, /*shouldClose=*/false);
+  endian::Writer W(OS, little);
+  OS.write(IndexMagic, sizeof(IndexMagic));
+  W.write<uint64_t>(DirModTime.time_since_epoch().count());
+  W.write<uint64_t>(ListTime.time_since_epoch().count());
+  W.write<uint64_t>(Entries.size());
+  for (const auto &E : Entries) {
+    W.write<uint64_t>(E.second.Time.time_since_epoch().count());
+    W.write<uint64_t>(E.second.Size);
+    W.write<uint32_t>(E.first().size());
+    OS << E.first();
+  }
+  OS.flush();
+  if (OS.has_error()) {
+    OS.clear_error();
+    consumeError(Temp->discard());
+    return;
+  }
+  SmallString<128> IndexPath(IndexDir);
+  sys::path::append(IndexPath, "index");
+  consumeError(Temp->keep(IndexPath));
+}
+
+/// Updates \p Index with the files of the cache directory \p Path. Only the
+/// files that are not in the index are looked at, and the directory is only
+/// listed if files were added or removed since it was last listed. Returns
+/// whether the directory was listed.
+static bool updateIndex(StringRef Path, CacheIndex &Index) {
+  // Directory times may be as coarse as two seconds, so a listing made in
+  // the same interval as a change may have missed it.
+  sys::fs::file_status DirStatus;
+  if (!sys::fs::status(Path, DirStatus) &&
+      DirStatus.getLastModificationTime() == Index.DirModTime &&
+      Index.DirModTime + std::chrono::seconds(2) < Index.ListTime) {
+    LLVM_DEBUG(dbgs() << "Directory unchanged, use the index\n");
+    return false;
+  }
+
+  StringMap<IndexEntry> Entries;
+  Index.DirModTime = DirStatus.getLastModificationTime();
+  Index.ListTime = std::chrono::system_clock::now();
+  std::error_code EC;
+  SmallString<128> CachePathNative;
+  sys::path::native(Path, CachePathNative);
+  for (sys::fs::directory_iterator File(CachePathNative, EC), FileEnd;
+       File != FileEnd && !EC; File.increment(EC)) {
+    // Ignore any files not beginning with the string "llvmcache-". This
+    // includes the timestamp and index files as well as any files created by
+    // the user.
+    StringRef Name = sys::path::filename(File->path());
+    if (!Name.startswith("llvmcache-"))
+      continue;
+
+    auto I = Index.Entries.find(Name);
+    if (I != Index.Entries.end()) {
+      Entries[Name] = I->second;
+      continue;
+    }
+    ErrorOr<sys::fs::basic_file_status> StatusOrErr = File->status();
+    if (!StatusOrErr) {
+      LLVM_DEBUG(dbgs() << "Ignore " << File->path() << " (can't stat)\n");
+      continue;
+    }
+    Entries[Name] = {StatusOrErr->getLastAccessedTime(),
+                     StatusOrErr->getSize(), true};
+  }
+  Index.Entries = std::move(Entries);
+  return true;
+}
+
 /// Write a new timestamp file with the given path. This is used for the pruning
 /// interval option.
 static void writeTimestampFile(StringRef TimestampFile) {
@@ -131,6 +303,11 @@ llvm::parseCachePruningPolicy(StringRef PolicyStr) {
       if (Value.getAsInteger(0, Policy.MaxSizeFiles))
         return make_error<StringError>("'" + Value + "' not an integer",
                                        inconvertibleErrorCode());
+    } else if (Key == "incremental") {
+      if (Value != "0" && Value != "1")
+        return make_error<StringError>("'" + Value + "' must be 0 or 1",
+                                       inconvertibleErrorCode());
+      Policy.Incremental = Value == "1";
     } else {
       return make_error<StringError>("Unknown key: '" + Key + "'",
                                      inconvertibleErrorCode());
@@ -199,67 +376,83 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
     writeTimestampFile(TimestampFile);
   }
 
+  SmallString<128> IndexDir(Path);
+  sys::path::append(IndexDir, "llvmcache.index");
+  CacheIndex Index;
+  if (Policy.Incremental && !Index.read(IndexDir))
+    Index = CacheIndex();
+  bool IndexChanged = updateIndex(Path, Index);
+
   // Keep track of files to delete to get below the size limit.
   // Order by time of last use so that recently used files are preserved.
   std::set<FileInfo> FileInfos;
   uint64_t TotalSize = 0;
-
-  // Walk the entire directory cache, looking for unused files.
-  std::error_code EC;
-  SmallString<128> CachePathNative;
-  sys::path::native(Path, CachePathNative);
-  // Walk all of the files within this directory.
-  for (sys::fs::directory_iterator File(CachePathNative, EC), FileEnd;
-       File != FileEnd && !EC; File.increment(EC)) {
-    // Ignore any files not beginning with the string "llvmcache-". This
-    // includes the timestamp file as well as any files created by the user.
-    // This acts as a safeguard against data loss if the user specifies the
-    // wrong directory as their cache directory.
-    if (!sys::path::filename(File->path()).startswith("llvmcache-"))
-      continue;
-
-    // Look at this file. If we can't stat it, there's nothing interesting
-    // there.
-    ErrorOr<sys::fs::basic_file_status> StatusOrErr = File->status();
-    if (!StatusOrErr) {
-      LLVM_DEBUG(dbgs() << "Ignore " << File->path() << " (can't stat)\n");
-      continue;
-    }
-
-    // If the file hasn't been used recently enough, delete it
-    const auto FileAccessTime = StatusOrErr->getLastAccessedTime();
-    auto FileAge = CurrentTime - FileAccessTime;
-    if (Policy.Expiration != seconds(0) && FileAge > Policy.Expiration) {
-      LLVM_DEBUG(dbgs() << "Remove " << File->path() << " ("
-                        << duration_cast<seconds>(FileAge).count()
-                        << "s old)\n");
-      sys::fs::remove(File->path());
-      continue;
-    }
-
-    // Leave it here for now, but add it to the list of size-based pruning.
-    TotalSize += StatusOrErr->getSize();
-    FileInfos.insert({FileAccessTime, StatusOrErr->getSize(), File->path()});
+  for (const auto &E : Index.Entries) {
+    TotalSize += E.second.Size;
+    FileInfos.insert({E.second.Time, E.second.Size, E.first()});
   }
-
-  auto FileInfo = FileInfos.begin();
   size_t NumFiles = FileInfos.size();
+  bool Removed = false;
+
+  // Makes the least recently used file known to be so, by reading the access
+  // time of the files that come first from the index, which may be out of
+  // date. Returns false if there are no files left.
+  auto FindLeastRecentlyUsed = [&]() {
+    while (!FileInfos.empty()) {
+      FileInfo Oldest = *FileInfos.begin();
+      IndexEntry &E = Index.Entries[Oldest.Path];
+      if (E.Fresh)
+        return true;
+      SmallString<128> FilePath(Path);
+      sys::path::append(FilePath, Oldest.Path);
+      FileInfos.erase(FileInfos.begin());
+      TotalSize -= Oldest.Size;
+      sys::fs::file_status Status;
+      if (sys::fs::status(FilePath, Status)) {
+        Index.Entries.erase(Oldest.Path);
+        IndexChanged = true;
+        NumFiles--;
+        continue;
+      }
+      E = {Status.getLastAccessedTime(), Status.getSize(), true};
+      IndexChanged = true;
+      TotalSize += E.Size;
+      FileInfos.insert({E.Time, E.Size, Oldest.Path});
+    }
+    return false;
+  };
 
   auto RemoveCacheFile = [&]() {
+    FileInfo Oldest = *FileInfos.begin();
+    SmallString<128> FilePath(Path);
+    sys::path::append(FilePath, Oldest.Path);
     // Remove the file.
-    sys::fs::remove(FileInfo->Path);
+    sys::fs::remove(FilePath);
+    Index.Entries.erase(Oldest.Path);
+    FileInfos.erase(FileInfos.begin());
+    Removed = IndexChanged = true;
     // Update size
-    TotalSize -= FileInfo->Size;
+    TotalSize -= Oldest.Size;
     NumFiles--;
-    LLVM_DEBUG(dbgs() << " - Remove " << FileInfo->Path << " (size "
-                      << FileInfo->Size << "), new occupancy is " << TotalSize
-                      << "%\n");
-    ++FileInfo;
+    LLVM_DEBUG(dbgs() << " - Remove " << FilePath << " (size " << Oldest.Size
+                      << "), new occupancy is " << TotalSize << "%\n");
   };
 
+  // Remove the files that haven't been used recently enough.
+  if (Policy.Expiration != seconds(0))
+    while (FindLeastRecentlyUsed() &&
+           CurrentTime - FileInfos.begin()->Time > Policy.Expiration) {
+      LLVM_DEBUG(dbgs() << "Expired: "
+                        << duration_cast<seconds>(CurrentTime -
+                                                  FileInfos.begin()->Time)
+                               .count()
+                        << "s old\n");
+      RemoveCacheFile();
+    }
+
   // Prune for number of files.
   if (Policy.MaxSizeFiles)
-    while (NumFiles > Policy.MaxSizeFiles)
+    while (NumFiles > Policy.MaxSizeFiles && FindLeastRecentlyUsed())
       RemoveCacheFile();
 
   // Prune for size now if needed
@@ -285,8 +478,33 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
                       << Policy.MaxSizeBytes << " bytes\n");
 
     // Remove the oldest accessed files first, till we get below the threshold.
-    while (TotalSize > TotalSizeTarget && FileInfo != FileInfos.end())
+    while (TotalSize > TotalSizeTarget && FindLeastRecentlyUsed())
       RemoveCacheFile();
   }
+
+  if (Policy.Incremental && IndexChanged) {
+    // Removing files changed the directory. Files added by others meanwhile
+    // are missed until the directory changes again, which only affects the
+    // accounting of the size of the cache.
+    sys::fs::file_status DirStatus;
+    if (Removed && !sys::fs::status(Path, DirStatus)) {
+      Index.DirModTime = DirStatus.getLastModificationTime();
+      Index.ListTime = system_clock::now();
+    }
+    Index.write(IndexDir);
+  }
   return true;
 }
+
+std::future<bool> llvm::pruneCacheAsync(StringRef Path,
+                                        CachePruningPolicy Policy) {
+  std::string PathStr = Path;
+#if LLVM_ENABLE_THREADS
+  std::launch Launch = std::launch::async;
+#else
+  std::launch Launch = std::launch::deferred;
+#endif
+  return std::async(Launch, [PathStr, Policy]() {
+    return pruneCache(PathStr, Policy);
+  });
+}
@@ -157,6 +157,8 @@ public:
 
   void ResetAllOptionOccurrences();
 
+  void addPendingOptions();
+
   bool ParseCommandLineOptions(int argc, const char *const *argv,
                                StringRef Overview, raw_ostream *Errs = nullptr,
                                bool LongOptionsUseDoubleDash = false);
@@ -303,7 +305,8 @@ public:
             nullptr != Sub.ConsumeAfterOpt);
   }
 
-  bool hasOptions() const {
+  bool hasOptions() {
+    addPendingOptions();
     for (const auto &S : RegisteredSubCommands) {
       if (hasOptions(*S))
         return true;
@@ -383,6 +386,8 @@ public:
   }
 
   void reset() {
+    // Options constructed before the reset are forgotten with the others.
+    addPendingOptions();
     ActiveSubCommand = nullptr;
     ProgramName.clear();
     ProgramOverview = StringRef();
@@ -419,6 +424,24 @@ private:
 
 static ManagedStatic<CommandLineParser> GlobalParser;
 
+// The options whose constructors have run but that are not in the option maps
+// yet, in construction order. Both pointers are constant initialized, since
+// options are constructed during dynamic initialization in an arbitrary order.
+static Option *PendingOptions = nullptr;
+static Option **PendingOptionsTail = &PendingOptions;
+
+void CommandLineParser::addPendingOptions() {
+  // Take the options one by one, so that a diagnostic about one of them does
+  // not leave the queue in an inconsistent state.
+  while (Option *O = PendingOptions) {
+    PendingOptions = O->NextPending;
+    if (!PendingOptions)
+      PendingOptionsTail = &PendingOptions;
+    O->NextPending = nullptr;
+    addOption(O);
+  }
+}
+
 void cl::AddLiteralOption(Option &O, StringRef Name) {
   GlobalParser->addLiteralOption(O, Name);
 }
@@ -428,15 +451,21 @@ extrahelp::extrahelp(StringRef Help) : morehelp(Help) {
 }
 
 void Option::addArgument() {
-  GlobalParser->addOption(this);
+  *PendingOptionsTail = this;
+  PendingOptionsTail = &NextPending;
   FullyInitialized = true;
 }
 
-void Option::removeArgument() { GlobalParser->removeOption(this); }
+void Option::removeArgument() {
+  GlobalParser->addPendingOptions();
+  GlobalParser->removeOption(this);
+}
 
 void Option::setArgStr(StringRef S) {
-  if (FullyInitialized)
+  if (FullyInitialized) {
+    GlobalParser->addPendingOptions();
     GlobalParser->updateArgStr(this, S);
+  }
   assert((S.empty() || S[0] != '-') && "Option can't start with '-");
   ArgStr = S;
   if (ArgStr.size() == 1)
@@ -483,6 +512,8 @@ void SubCommand::registerSubCommand() {
 }
 
 void SubCommand::unregisterSubCommand() {
+  // Options of this subcommand must not be registered once it is gone.
+  GlobalParser->addPendingOptions();
   GlobalParser->unregisterSubCommand(this);
 }
 
@@ -512,6 +543,10 @@ Option *CommandLineParser::LookupOption(SubCommand &Sub, StringRef &Arg,
     return nullptr;
   assert(&Sub != &*AllSubCommands);
 
+  // Options may be constructed while parsing, e.g. by a plugin that -load
+  // opens, and must be found by the arguments that follow.
+  addPendingOptions();
+
   size_t EqualPos = Arg.find('=');
 
   // If we have an equals sign, remember the value.
@@ -1246,6 +1281,7 @@ bool cl::ParseCommandLineOptions(int argc, const char *const *argv,
 void CommandLineParser::ResetAllOptionOccurrences() {
   // So that we can parse different command lines multiple times in succession
   // we reset all option values to look like they have never been seen before.
+  addPendingOptions();
   for (auto SC : RegisteredSubCommands) {
     for (auto &O : SC->OptionsMap)
       O.second->reset();
@@ -1257,6 +1293,7 @@ bool CommandLineParser::ParseCommandLineOptions(int argc,
                                                 StringRef Overview,
                                                 raw_ostream *Errs,
                                                 bool LongOptionsUseDoubleDash) {
+  addPendingOptions();
   assert(hasOptions() && "No options specified!");
 
   // Expand response files.
@@ -1557,6 +1594,7 @@ bool CommandLineParser::ParseCommandLineOptions(int argc,
   }
 
   // Loop over args and make sure all required args are specified!
+  addPendingOptions();
   for (const auto &Opt : OptionsMap) {
     switch (Opt.second->getNumOccurrencesFlag()) {
     case Required:
@@ -2088,6 +2126,7 @@ public:
   }
 
   void printHelp() {
+    GlobalParser->addPendingOptions();
     SubCommand *Sub = GlobalParser->getActiveSubCommand();
     auto &OptionsMap = Sub->OptionsMap;
     auto &PositionalOpts = Sub->PositionalOpts;
@@ -2347,6 +2386,7 @@ void CommandLineParser::printOptionValues() {
   if (!PrintOptions && !PrintAllOptions)
     return;
 
+  addPendingOptions();
   SmallVector<std::pair<const char *, Option *>, 128> Opts;
   sortOpts(ActiveSubCommand->OptionsMap, Opts, /*ShowHidden*/ true);
 
@@ -2452,6 +2492,7 @@ void cl::AddExtraVersionPrinter(VersionPrinterTy func) {
 }
 
 StringMap<Option *> &cl::getRegisteredOptions(SubCommand &Sub) {
+  GlobalParser->addPendingOptions();
   auto &Subs = GlobalParser->RegisteredSubCommands;
   (void)Subs;
   assert(is_contained(Subs, &Sub));
@@ -2464,6 +2505,7 @@ cl::getRegisteredSubcommands() {
 }
 
 void cl::HideUnrelatedOptions(cl::OptionCategory &Category, SubCommand &Sub) {
+  GlobalParser->addPendingOptions();
   for (auto &I : Sub.OptionsMap) {
     for (auto &Cat : I.second->Categories) {
       if (Cat != &Category &&
@@ -2475,6 +2517,7 @@ void cl::HideUnrelatedOptions(cl::OptionCategory &Category, SubCommand &Sub) {
 
 void cl::HideUnrelatedOptions(ArrayRef<const cl::OptionCategory *> Categories,
                               SubCommand &Sub) {
+  GlobalParser->addPendingOptions();
   for (auto &I : Sub.OptionsMap) {
     for (auto &Cat : I.second->Categories) {
       if (find(Categories, Cat) == Categories.end() && Cat != &GenericCategory)
@@ -11,12 +11,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Compression.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Parallel.h"
+#include <vector>
 #if LLVM_ENABLE_ZLIB == 1 && HAVE_ZLIB_H
 #include <zlib.h>
 #endif
@@ -60,6 +63,84 @@ Error zlib::compress(StringRef InputBuffer,
   return Res ? createError(convertZlibCodeToString(Res)) : Error::success();
 }
 
+// Compresses Input into raw deflate blocks, with Dict as the preceding data.
+// The output ends with an empty stored block, so that it is byte-aligned and
+// can be followed by other blocks, unless Last is set.
+static int deflateBlock(StringRef Dict, StringRef Input, bool Last, int Level,
+                        SmallVectorImpl<char> &Output) {
+  z_stream Stream = {};
+  int Res = deflateInit2(&Stream, Level, Z_DEFLATED, -MAX_WBITS, 8,
+                         Z_DEFAULT_STRATEGY);
+  if (Res != Z_OK)
+    return Res;
+  if (!Dict.empty())
+    deflateSetDictionary(&Stream, (const Bytef *)Dict.data(), Dict.size());
+  // The empty stored block of a flush takes up to 5 bytes, and the bits of
+  // the last block up to one more.
+  Output.resize(deflateBound(&Stream, Input.size()) + 6);
+  Stream.next_in = (Bytef *)Input.data();
+  Stream.avail_in = Input.size();
+  Stream.next_out = (Bytef *)Output.data();
+  Stream.avail_out = Output.size();
+  Res = deflate(&Stream, Last ? Z_FINISH : Z_SYNC_FLUSH);
+  if (Res == (Last ? Z_STREAM_END : Z_OK) && Stream.avail_in == 0)
+    Res = Z_OK;
+  else if (Res == Z_OK || Res == Z_STREAM_END)
+    Res = Z_BUF_ERROR;
+  __msan_unpoison(Output.data(), Output.size() - Stream.avail_out);
+  Output.resize(Output.size() - Stream.avail_out);
+  deflateEnd(&Stream);
+  return Res;
+}
+
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level, size_t BlockSize) {
+  assert(BlockSize > 0 && "Blocks must not be empty");
+  if (InputBuffer.size() <= BlockSize)
+    return compress(InputBuffer, CompressedBuffer, Level);
+
+  // zlib streams use 32-bit lengths, so keep the blocks below 4 GiB.
+  BlockSize = std::min<size_t>(BlockSize, 1u << 30);
+  size_t NumBlocks = (InputBuffer.size() + BlockSize - 1) / BlockSize;
+  std::vector<SmallVector<char, 0>> Blocks(NumBlocks);
+  std::vector<uLong> Checksums(NumBlocks);
+  std::vector<int> Results(NumBlocks);
+  parallel::for_each_n(parallel::par, size_t(0), NumBlocks, [&](size_t I) {
+    size_t Begin = I * BlockSize;
+    StringRef Block = InputBuffer.substr(Begin, BlockSize);
+    StringRef Dict = InputBuffer.slice(Begin - std::min<size_t>(Begin, 32768),
+                                       Begin);
+    Results[I] =
+        deflateBlock(Dict, Block, I == NumBlocks - 1, Level, Blocks[I]);
+    Checksums[I] = adler32(adler32(0, nullptr, 0),
+                           (const Bytef *)Block.data(), Block.size());
+  });
+  for (int Res : Results)
+    if (Res != Z_OK)
+      return createError(convertZlibCodeToString(Res));
+
+  // The zlib header, as deflateInit would write it, and the Adler-32
+  // checksum of the whole input.
+  unsigned LevelFlags = Level < 2 ? 0 : Level < 6 ? 1 : Level == 6 ? 2 : 3;
+  unsigned Header = (0x78 << 8) | (LevelFlags << 6);
+  Header += 31 - Header % 31;
+  uLong Checksum = Checksums[0];
+  for (size_t I = 1; I != NumBlocks; ++I)
+    Checksum = adler32_combine(Checksum, Checksums[I],
+                               std::min(BlockSize,
+                                        InputBuffer.size() - I * BlockSize));
+
+  CompressedBuffer.clear();
+  CompressedBuffer.push_back(Header >> 8);
+  CompressedBuffer.push_back(Header & 0xFF);
+  for (const SmallVector<char, 0> &Block : Blocks)
+    CompressedBuffer.append(Block.begin(), Block.end());
+  for (int Shift = 24; Shift >= 0; Shift -= 8)
+    CompressedBuffer.push_back((Checksum >> Shift) & 0xFF);
+  return Error::success();
+}
+
 Error zlib::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                        size_t &UncompressedSize) {
   int Res =
@@ -91,6 +172,11 @@ Error zlib::compress(StringRef InputBuffer,
                      SmallVectorImpl<char> &CompressedBuffer, int Level) {
   llvm_unreachable("zlib::compress is unavailable");
 }
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level, size_t BlockSize) {
+  llvm_unreachable("zlib::compressParallel is unavailable");
+}
 Error zlib::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                        size_t &UncompressedSize) {
   llvm_unreachable("zlib::uncompress is unavailable");
@@ -104,3 +190,34 @@ uint32_t zlib::crc32(StringRef Buffer) {
   llvm_unreachable("zlib::crc32 is unavailable");
 }
 #endif
+
+CompressionCodec::~CompressionCodec() = default;
+
+namespace {
+class ZlibCodec : public CompressionCodec {
+  int Level;
+  bool Parallel;
+
+public:
+  ZlibCodec(int Level, bool Parallel) : Level(Level), Parallel(Parallel) {}
+
+  StringRef getName() const override { return "zlib"; }
+  bool isAvailable() const override { return zlib::isAvailable(); }
+
+  Error compress(StringRef Input, SmallVectorImpl<char> &Output) override {
+    if (Parallel)
+      return zlib::compressParallel(Input, Output, Level);
+    return zlib::compress(Input, Output, Level);
+  }
+
+  Error uncompress(StringRef Input, SmallVectorImpl<char> &Output,
+                   size_t UncompressedSize) override {
+    return zlib::uncompress(Input, Output, UncompressedSize);
+  }
+};
+} // namespace
+
+std::unique_ptr<CompressionCodec> llvm::createZlibCodec(int Level,
+                                                        bool Parallel) {
+  return llvm::make_unique<ZlibCodec>(Level, Parallel);
+}
@@ -16,6 +16,7 @@
 #include "llvm/Support/FileCheck.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Timer.h"
 #include <cstdint>
 #include <list>
 #include <map>
@@ -62,6 +63,13 @@ Expected<std::string> FileCheckStringSubstitution::getResult() const {
   return Regex::escape(*VarVal);
 }
 
+Expected<std::string> FileCheckStringSubstitution::getLiteralResult() const {
+  Expected<StringRef> VarVal = Context->getPatternVarValue(FromStr);
+  if (!VarVal)
+    return VarVal.takeError();
+  return VarVal->str();
+}
+
 bool FileCheckPattern::isValidVarNameStart(char C) {
   return C == '_' || isalpha(C);
 }
@@ -258,6 +266,15 @@ Expected<FileCheckExpression *> FileCheckPattern::parseNumericSubstitutionBlock(
   return parseBinop(Expr, SM);
 }
 
+/// \returns whether the regex \p RS, compiled with Regex::Newline, can match
+/// a newline. Neither "." nor a negated bracket expression can, so only a
+/// character class or range that includes one, or a literal newline, may.
+static bool mayMatchNewline(StringRef RS) {
+  if (RS.contains("[:space:]") || RS.contains("[:cntrl:]"))
+    return true;
+  return llvm::any_of(RS, [](char C) { return C >= 0 && C <= '\n'; });
+}
+
 bool FileCheckPattern::parsePattern(StringRef PatternStr, StringRef Prefix,
                                     SourceMgr &SM,
                                     const FileCheckRequest &Req) {
@@ -316,6 +333,28 @@ bool FileCheckPattern::parsePattern(StringRef PatternStr, StringRef Prefix,
   // values add from there.
   unsigned CurParen = 1;
 
+  // Record the literal pieces of the pattern as it is parsed, along with
+  // whether the regex pieces between them keep it a wildcard pattern and
+  // confined to a single line.
+  IsLineLocal = true;
+  if (!MatchFullLinesHere)
+    WildcardPattern = WildcardPatternInfo();
+  bool AfterRegex = false;
+  auto AddRegexPiece = [&](StringRef RS, bool IsWildcard) {
+    if (mayMatchNewline(RS))
+      IsLineLocal = false;
+    if (!IsWildcard)
+      WildcardPattern = None;
+    AfterRegex = true;
+  };
+  auto AddLiteralPiece = [&](StringRef Str,
+                             FileCheckSubstitution *Substitution) {
+    if (WildcardPattern && LiteralPieces.empty() && AfterRegex)
+      WildcardPattern->LeadingWildcard = true;
+    LiteralPieces.push_back({Str, Substitution, AfterRegex});
+    AfterRegex = false;
+  };
+
   // Otherwise, there is at least one regex piece.  Build up the regex pattern
   // by escaping scary characters in fixed strings, building up one big regex.
   while (!PatternStr.empty()) {
@@ -334,14 +373,22 @@ bool FileCheckPattern::parsePattern(StringRef PatternStr, StringRef Prefix,
       // capturing the result for any purpose.  This is required in case the
       // expression contains an alternation like: CHECK:  abc{{x|z}}def.  We
       // want this to turn into: "abc(x|z)def" not "abcx|zdef".
+      StringRef RS = PatternStr.substr(2, End - 2);
+      bool IsFirst = RegExStr.empty();
       RegExStr += '(';
       ++CurParen;
 
-      if (AddRegExToRegEx(PatternStr.substr(2, End - 2), CurParen, SM))
+      if (AddRegExToRegEx(RS, CurParen, SM))
         return true;
       RegExStr += ')';
 
       PatternStr = PatternStr.substr(End + 2);
+      if (WildcardPattern && RS == "^" && IsFirst)
+        WildcardPattern->AnchorStart = true;
+      else if (WildcardPattern && RS == "$" && PatternStr.empty())
+        WildcardPattern->AnchorEnd = true;
+      else
+        AddRegexPiece(RS, RS == ".*");
       continue;
     }
 
@@ -461,6 +508,7 @@ bool FileCheckPattern::parsePattern(StringRef PatternStr, StringRef Prefix,
             return true;
           }
           AddBackrefToRegEx(CaptureParenGroup);
+          AddRegexPiece(StringRef(), /*IsWildcard=*/false);
         } else {
           // Handle substitution of string variables ([[<var>]]) defined in
           // previous CHECK patterns, and substitution of expressions.
@@ -470,6 +518,7 @@ bool FileCheckPattern::parsePattern(StringRef PatternStr, StringRef Prefix,
                                                      SubstInsertIdx)
                   : Context->makeStringSubstitution(SubstStr, SubstInsertIdx);
           Substitutions.push_back(Substitution);
+          AddLiteralPiece(StringRef(), Substitution);
         }
         continue;
       }
@@ -502,6 +551,7 @@ bool FileCheckPattern::parsePattern(StringRef PatternStr, StringRef Prefix,
         return true;
 
       RegExStr += ')';
+      AddRegexPiece(MatchRegexp, /*IsWildcard=*/false);
     }
 
     // Handle fixed string matches.
@@ -509,9 +559,18 @@ bool FileCheckPattern::parsePattern(StringRef PatternStr, StringRef Prefix,
     size_t FixedMatchEnd = PatternStr.find("{{");
     FixedMatchEnd = std::min(FixedMatchEnd, PatternStr.find("[["));
     RegExStr += Regex::escape(PatternStr.substr(0, FixedMatchEnd));
+    if (FixedMatchEnd != 0)
+      AddLiteralPiece(PatternStr.substr(0, FixedMatchEnd), nullptr);
     PatternStr = PatternStr.substr(FixedMatchEnd);
   }
 
+  if (WildcardPattern) {
+    WildcardPattern->TrailingWildcard = AfterRegex;
+    // A pattern without any literal text is left to the regex engine.
+    if (LiteralPieces.empty())
+      WildcardPattern = None;
+  }
+
   if (MatchFullLinesHere) {
     if (!Req.NoCanonicalizeWhiteSpace)
       RegExStr += " *";
@@ -541,6 +600,126 @@ void FileCheckPattern::AddBackrefToRegEx(unsigned BackrefNum) {
   RegExStr += Backref;
 }
 
+Error FileCheckPattern::getLiterals(
+    SmallVectorImpl<std::string> &Literals) const {
+  for (const LiteralPiece &Piece : LiteralPieces) {
+    if (Literals.empty() || Piece.FollowsRegex)
+      Literals.emplace_back();
+    if (!Piece.Substitution) {
+      Literals.back() += Piece.Str;
+      continue;
+    }
+    Expected<std::string> Value = Piece.Substitution->getLiteralResult();
+    if (!Value)
+      return Value.takeError();
+    Literals.back() += *Value;
+  }
+  return Error::success();
+}
+
+bool FileCheckPattern::matchWildcardLine(StringRef Line, size_t FirstPos,
+                                         ArrayRef<std::string> Literals,
+                                         const WildcardPatternInfo &Info,
+                                         size_t &Start, size_t &End) {
+  StringRef First = Literals.front();
+  StringRef Last = Literals.back();
+  bool AnchorEnd = Info.AnchorEnd && !Info.TrailingWildcard;
+
+  // A single literal anchored at the end can only be its last occurrence.
+  if (Literals.size() == 1 && AnchorEnd) {
+    if (!Line.endswith(First))
+      return false;
+    FirstPos = Line.size() - First.size();
+  }
+  if (Info.AnchorStart && !Info.LeadingWildcard && FirstPos != 0)
+    return false;
+
+  // The line has a match if and only if the literals can be placed in order,
+  // each as early as possible. Starting at the first occurrence of the first
+  // literal thus gives the leftmost match.
+  size_t Pos = FirstPos + First.size();
+  for (size_t I = 1; I + 1 < Literals.size(); ++I) {
+    size_t LiteralPos = Line.find(Literals[I], Pos);
+    if (LiteralPos == StringRef::npos)
+      return false;
+    Pos = LiteralPos + Literals[I].size();
+  }
+
+  // The longest match ends with the last occurrence of the last literal. A
+  // single literal only moves there after a leading wildcard, as the match
+  // otherwise starts with its first occurrence.
+  if (Literals.size() > 1 || Info.LeadingWildcard) {
+    if (Literals.size() == 1)
+      Pos = FirstPos;
+    StringRef Rest = Line.substr(Pos);
+    size_t LastPos = AnchorEnd ? (Rest.endswith(Last)
+                                      ? Rest.size() - Last.size()
+                                      : StringRef::npos)
+                               : Rest.rfind(Last);
+    if (LastPos == StringRef::npos)
+      return false;
+    Pos += LastPos + Last.size();
+  }
+
+  Start = Info.LeadingWildcard ? 0 : FirstPos;
+  End = Info.TrailingWildcard ? Line.size() : Pos;
+  return true;
+}
+
+size_t FileCheckPattern::matchWildcardPattern(
+    StringRef Buffer, ArrayRef<std::string> Literals,
+    const WildcardPatternInfo &Info, size_t &MatchLen) {
+  // Wildcards do not match newlines, so a match lies on the first line that
+  // contains the first literal and matches the rest of the pattern. Pos is
+  // always at the start of a line.
+  size_t Pos = 0;
+  while (true) {
+    size_t FirstPos = Buffer.find(Literals.front(), Pos);
+    if (FirstPos == StringRef::npos)
+      return StringRef::npos;
+    size_t LineStart = Buffer.slice(Pos, FirstPos).rfind('\n');
+    LineStart = LineStart == StringRef::npos ? Pos : Pos + LineStart + 1;
+    size_t LineEnd = std::min(Buffer.find('\n', FirstPos), Buffer.size());
+
+    size_t Start, End;
+    if (matchWildcardLine(Buffer.slice(LineStart, LineEnd),
+                          FirstPos - LineStart, Literals, Info, Start, End)) {
+      MatchLen = End - Start;
+      return LineStart + Start;
+    }
+    if (LineEnd == Buffer.size())
+      return StringRef::npos;
+    Pos = LineEnd + 1;
+  }
+}
+
+/// Matches \p R against \p Buffer, filling \p Matches as Regex::match() does.
+/// If \p Literal is not empty, every match of \p R is known to be contained
+/// in a line containing \p Literal, and \p R only runs on such lines.
+static bool matchLinesContaining(Regex &R, StringRef Buffer, StringRef Literal,
+                                 SmallVectorImpl<StringRef> &Matches) {
+  if (Literal.empty())
+    return R.match(Buffer, &Matches);
+
+  size_t Pos = 0;
+  while (true) {
+    size_t LiteralPos = Buffer.find(Literal, Pos);
+    if (LiteralPos == StringRef::npos)
+      return false;
+    size_t LineStart = Buffer.slice(Pos, LiteralPos).rfind('\n');
+    LineStart = LineStart == StringRef::npos ? Pos : Pos + LineStart + 1;
+    size_t LineEnd = std::min(Buffer.find('\n', LiteralPos), Buffer.size());
+
+    // The line is matched on its own, which is how ^ and $ see it anyway
+    // since the regex is compiled with Regex::Newline.
+    if (R.match(Buffer.slice(LineStart, LineEnd), &Matches))
+      return true;
+    if (LineEnd == Buffer.size())
+      return false;
+    Pos = LineEnd + 1;
+  }
+}
+
 Expected<size_t> FileCheckPattern::match(StringRef Buffer, size_t &MatchLen,
                                          const SourceMgr &SM) const {
   // If this is the EOF pattern, match it immediately.
@@ -587,8 +766,36 @@ Expected<size_t> FileCheckPattern::match(StringRef Buffer, size_t &MatchLen,
     RegExToMatch = TmpStr;
   }
 
+  // Every match contains the literal pieces of the pattern. If a match cannot
+  // span lines, it must lie on a line containing the longest of them, so the
+  // regex only needs to run on such lines. Wildcard patterns are matched
+  // directly.
+  StringRef LongestLiteral;
+  SmallVector<std::string, 4> Literals;
+  if (IsLineLocal && !LiteralPieces.empty()) {
+    if (Error Err = getLiterals(Literals))
+      return std::move(Err);
+    for (const std::string &Literal : Literals) {
+      // A substituted value may span lines.
+      if (StringRef(Literal).contains('\n')) {
+        LongestLiteral = StringRef();
+        break;
+      }
+      if (Literal.size() > LongestLiteral.size())
+        LongestLiteral = Literal;
+    }
+    if (!LongestLiteral.empty() && WildcardPattern) {
+      size_t Pos = matchWildcardPattern(Buffer, Literals, *WildcardPattern,
+                                        MatchLen);
+      if (Pos == StringRef::npos)
+        return make_error<FileCheckNotFoundError>();
+      return Pos;
+    }
+  }
+
   SmallVector<StringRef, 4> MatchInfo;
-  if (!Regex(RegExToMatch, Regex::Newline).match(Buffer, &MatchInfo))
+  Regex R(RegExToMatch, Regex::Newline);
+  if (!matchLinesContaining(R, Buffer, LongestLiteral, MatchInfo))
     return make_error<FileCheckNotFoundError>();
 
   // Successful regex match.
@@ -1856,6 +2063,22 @@ bool FileCheck::CheckInput(SourceMgr &SM, StringRef Buffer,
                            std::vector<FileCheckDiag> *Diags) {
   bool ChecksFailed = false;
 
+  // With TimeChecks, accumulate the time spent matching the checks of each
+  // prefix. The group prints its report once the timers are destroyed.
+  Optional<TimerGroup> CheckTimerGroup;
+  StringMap<std::unique_ptr<Timer>> CheckTimers;
+  if (Req.TimeChecks)
+    CheckTimerGroup.emplace("filecheck", "FileCheck Match Time per Prefix");
+  auto GetCheckTimer = [&](const FileCheckString &CheckStr) -> Timer * {
+    if (!CheckTimerGroup)
+      return nullptr;
+    std::unique_ptr<Timer> &T = CheckTimers[CheckStr.Prefix];
+    if (!T)
+      T = llvm::make_unique<Timer>(CheckStr.Prefix, CheckStr.Prefix,
+                                   *CheckTimerGroup);
+    return T.get();
+  };
+
   unsigned i = 0, j = 0, e = CheckStrings.size();
   while (true) {
     StringRef CheckRegion;
@@ -1870,8 +2093,12 @@ bool FileCheck::CheckInput(SourceMgr &SM, StringRef Buffer,
 
       // Scan to next CHECK-LABEL match, ignoring CHECK-NOT and CHECK-DAG
       size_t MatchLabelLen = 0;
-      size_t MatchLabelPos =
-          CheckLabelStr.Check(SM, Buffer, true, MatchLabelLen, Req, Diags);
+      size_t MatchLabelPos;
+      {
+        TimeRegion T(GetCheckTimer(CheckLabelStr));
+        MatchLabelPos =
+            CheckLabelStr.Check(SM, Buffer, true, MatchLabelLen, Req, Diags);
+      }
       if (MatchLabelPos == StringRef::npos)
         // Immediately bail if CHECK-LABEL fails, nothing else we can do.
         return false;
@@ -1893,8 +2120,11 @@ bool FileCheck::CheckInput(SourceMgr &SM, StringRef Buffer,
       // Check each string within the scanned region, including a second check
       // of any final CHECK-LABEL (to verify CHECK-NOT and CHECK-DAG)
       size_t MatchLen = 0;
-      size_t MatchPos =
-          CheckStr.Check(SM, CheckRegion, false, MatchLen, Req, Diags);
+      size_t MatchPos;
+      {
+        TimeRegion T(GetCheckTimer(CheckStr));
+        MatchPos = CheckStr.Check(SM, CheckRegion, false, MatchLen, Req, Diags);
+      }
 
       if (MatchPos == StringRef::npos) {
         ChecksFailed = true;
@@ -214,6 +214,7 @@ public:
   }
 
   bool parseValue(Value &Out);
+  bool parseEvents(Handler &H);
 
   bool assertEnd() {
     eatWhitespace();
@@ -235,7 +236,10 @@ private:
 
   // On invalid syntax, parseX() functions return false and set Err.
   bool parseNumber(char First, Value &Out);
+  bool parseNumber(char First, Optional<int64_t> &Int, double &Double);
   bool parseString(std::string &Out);
+  bool parseString(StringRef &Out);
+  bool parseKey(Handler &H);
   bool parseUnicode(std::string &Out);
   bool parseError(const char *Msg); // always returns false
 
@@ -249,6 +253,8 @@ private:
 
   Optional<Error> Err;
   const char *Start, *P, *End;
+  // The decoded contents of the last string with escapes, for parseEvents().
+  std::string Scratch;
 };
 
 bool Parser::parseValue(Value &Out) {
@@ -340,7 +346,129 @@ bool Parser::parseValue(Value &Out) {
   }
 }
 
+// Parses the events of a document without recursion, keeping only the kinds
+// of the enclosing containers.
+bool Parser::parseEvents(Handler &H) {
+  auto Stopped = [this] { return parseError("Stopped by handler"); };
+  // Whether each enclosing container is an object, rather than an array.
+  SmallVector<bool, 16> Stack;
+  for (;;) {
+    eatWhitespace();
+    if (P == End)
+      return parseError("Unexpected EOF");
+    bool Continue;
+    switch (char C = next()) {
+    case 'n':
+      if (!(next() == 'u' && next() == 'l' && next() == 'l'))
+        return parseError("Invalid JSON value (null?)");
+      Continue = H.null();
+      break;
+    case 't':
+      if (!(next() == 'r' && next() == 'u' && next() == 'e'))
+        return parseError("Invalid JSON value (true?)");
+      Continue = H.boolean(true);
+      break;
+    case 'f':
+      if (!(next() == 'a' && next() == 'l' && next() == 's' && next() == 'e'))
+        return parseError("Invalid JSON value (false?)");
+      Continue = H.boolean(false);
+      break;
+    case '"': {
+      StringRef S;
+      if (!parseString(S))
+        return false;
+      Continue = H.string(S);
+      break;
+    }
+    case '[':
+      if (!H.arrayBegin())
+        return Stopped();
+      eatWhitespace();
+      if (peek() != ']') {
+        Stack.push_back(false);
+        continue;
+      }
+      ++P;
+      Continue = H.arrayEnd();
+      break;
+    case '{':
+      if (!H.objectBegin())
+        return Stopped();
+      eatWhitespace();
+      if (peek() != '}') {
+        Stack.push_back(true);
+        if (!parseKey(H))
+          return false;
+        continue;
+      }
+      ++P;
+      Continue = H.objectEnd();
+      break;
+    default: {
+      if (!isNumber(C))
+        return parseError("Invalid JSON value");
+      Optional<int64_t> Int;
+      double Double;
+      if (!parseNumber(C, Int, Double))
+        return false;
+      Continue = Int ? H.integer(*Int) : H.number(Double);
+      break;
+    }
+    }
+    if (!Continue)
+      return Stopped();
+
+    // Close the containers which end after this value, up to the next value.
+    for (;;) {
+      if (Stack.empty())
+        return true;
+      eatWhitespace();
+      bool InObject = Stack.back();
+      char C = next();
+      if (C == (InObject ? '}' : ']')) {
+        Stack.pop_back();
+        if (!(InObject ? H.objectEnd() : H.arrayEnd()))
+          return Stopped();
+        continue;
+      }
+      if (C != ',')
+        return parseError(InObject ? "Expected , or } after object property"
+                                   : "Expected , or ] after array element");
+      eatWhitespace();
+      if (InObject && !parseKey(H))
+        return false;
+      break;
+    }
+  }
+}
+
+// Parses an object key and the following colon, for parseEvents().
+bool Parser::parseKey(Handler &H) {
+  if (next() != '"')
+    return parseError("Expected object key");
+  StringRef K;
+  if (!parseString(K))
+    return false;
+  eatWhitespace();
+  if (next() != ':')
+    return parseError("Expected : after object key");
+  return H.objectKey(K) || parseError("Stopped by handler");
+}
+
 bool Parser::parseNumber(char First, Value &Out) {
+  Optional<int64_t> Int;
+  double Double;
+  if (!parseNumber(First, Int, Double))
+    return false;
+  if (Int)
+    Out = *Int;
+  else
+    Out = Double;
+  return true;
+}
+
+// Sets Int if the number is an integer that fits in 64 bits, and Double if not.
+bool Parser::parseNumber(char First, Optional<int64_t> &Int, double &Double) {
   // Read the number into a string. (Must be null-terminated for strto*).
   SmallString<24> S;
   S.push_back(First);
@@ -352,14 +480,39 @@ bool Parser::parseNumber(char First, Value &Out) {
   auto I = std::strtoll(S.c_str(), &End, 10);
   if (End == S.end() && I >= std::numeric_limits<int64_t>::min() &&
       I <= std::numeric_limits<int64_t>::max()) {
-    Out = int64_t(I);
+    Int = int64_t(I);
     return true;
   }
   // If it's not an integer
-  Out = std::strtod(S.c_str(), &End);
+  Double = std::strtod(S.c_str(), &End);
   return End == S.end() || parseError("Invalid JSON value (number?)");
 }
 
+// Parses a string for parseEvents(), which unlike parse() does not check the
+// whole document is UTF-8 up front. Strings without escapes are returned in
+// place, others are decoded into Scratch.
+bool Parser::parseString(StringRef &Out) {
+  // leading quote was already consumed.
+  const char *Begin = P;
+  while (P != End && *P != '"' && *P != '\\' && (*P & 0x1f) != *P)
+    ++P;
+  if (LLVM_LIKELY(P != End && *P == '"')) {
+    Out = StringRef(Begin, P - Begin);
+    ++P;
+  } else {
+    Scratch.assign(Begin, P);
+    if (!parseString(Scratch))
+      return false;
+    Out = Scratch;
+  }
+  // Escapes are ASCII and decode to valid UTF-8, so check the source text.
+  size_t ErrOffset;
+  if (LLVM_LIKELY(isUTF8(StringRef(Begin, P - 1 - Begin), &ErrOffset)))
+    return true;
+  P = Begin + ErrOffset;
+  return parseError("Invalid UTF-8 sequence");
+}
+
 bool Parser::parseString(std::string &Out) {
   // leading quote was already consumed.
   for (char C = next(); C != '"'; C = next()) {
@@ -516,6 +669,16 @@ Expected<Value> parse(StringRef JSON) {
         return std::move(E);
   return P.takeError();
 }
+
+Handler::~Handler() = default;
+
+Error parse(StringRef JSON, Handler &H) {
+  Parser P(JSON);
+  if (P.parseEvents(H))
+    if (P.assertEnd())
+      return Error::success();
+  return P.takeError();
+}
 char ParseError::ID = 0;
 
 static std::vector<const Object::value_type *> sortedElements(const Object &O) {
@@ -562,14 +725,19 @@ std::string fixUTF8(llvm::StringRef S) {
 
 static void quote(llvm::raw_ostream &OS, llvm::StringRef S) {
   OS << '\"';
-  for (unsigned char C : S) {
-    if (C == 0x22 || C == 0x5C)
-      OS << '\\';
+  // Characters which need no escaping are written in runs.
+  const char *Run = S.begin();
+  for (const char *I = S.begin(), *E = S.end(); I != E; ++I) {
+    unsigned char C = *I;
+    if (LLVM_LIKELY(C >= 0x20 && C != 0x22 && C != 0x5C))
+      continue;
+    OS.write(Run, I - Run);
+    Run = I + 1;
+    OS << '\\';
     if (C >= 0x20) {
       OS << C;
       continue;
     }
-    OS << '\\';
     switch (C) {
     // A few characters are common enough to make short escapes worthwhile.
     case '\t':
@@ -587,6 +755,7 @@ static void quote(llvm::raw_ostream &OS, llvm::StringRef S) {
       break;
     }
   }
+  OS.write(Run, S.end() - Run);
   OS << '\"';
 }
 
@@ -8,14 +8,31 @@
 
 #include "llvm/Support/Parallel.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Threading.h"
+
+#include <atomic>
 
+static std::atomic<unsigned> MaxThreads{0};
+
+void llvm::parallel::setMaxThreads(unsigned N) { MaxThreads = N; }
+
+unsigned llvm::parallel::getMaxThreads() {
 #if LLVM_ENABLE_THREADS
+  unsigned N = MaxThreads;
+  return N ? N : hardware_concurrency();
+#else
+  return 1;
+#endif
+}
 
-#include "llvm/Support/Threading.h"
+#if LLVM_ENABLE_THREADS
 
-#include <atomic>
-#include <stack>
+#include "llvm/Support/Compiler.h"
+
+#include <deque>
+#include <memory>
 #include <thread>
+#include <vector>
 
 namespace llvm {
 namespace parallel {
@@ -29,6 +46,14 @@ public:
   virtual ~Executor() = default;
   virtual void add(std::function<void()> func) = 0;
 
+  /// Block until \p L is done. Worker threads of this executor run pending
+  /// tasks while they wait.
+  virtual void wait(const Latch &L) { L.sync(); }
+
+  /// Called when the latch of a task group reaches zero, to wake the threads
+  /// waiting for it in wait().
+  virtual void latchDone() {}
+
   static Executor *getDefaultExecutor();
 };
 
@@ -60,66 +85,163 @@ Executor *Executor::getDefaultExecutor() {
 }
 
 #else
-/// An implementation of an Executor that runs closures on a thread pool
-///   in filo order.
+/// Index of the current thread's work queue in the default executor, or -1 if
+/// the current thread is not one of its workers.
+static LLVM_THREAD_LOCAL int WorkerIndex = -1;
+
+/// An implementation of an Executor that runs closures on a thread pool using
+/// work stealing.
+///
+/// Every worker owns a deque. Tasks spawned by a worker are pushed onto and
+/// popped from the back of its own deque (filo order, which keeps recursive
+/// algorithms such as parallel_sort cache friendly), while idle workers steal
+/// from the front of other workers' deques. Tasks added from threads outside
+/// the pool are distributed round-robin. Each deque has its own lock, so
+/// workers only contend with each other when stealing.
 class ThreadPoolExecutor : public Executor {
 public:
   explicit ThreadPoolExecutor(unsigned ThreadCount = hardware_concurrency())
       : Done(ThreadCount) {
+    Queues.reserve(ThreadCount);
+    for (unsigned I = 0; I < ThreadCount; ++I)
+      Queues.push_back(llvm::make_unique<WorkQueue>());
+
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     std::thread([&, ThreadCount] {
-      for (size_t i = 1; i < ThreadCount; ++i) {
-        std::thread([=] { work(); }).detach();
+      for (unsigned I = 1; I < ThreadCount; ++I) {
+        std::thread([=] { work(I); }).detach();
       }
-      work();
+      work(0);
     }).detach();
   }
 
   ~ThreadPoolExecutor() override {
-    std::unique_lock<std::mutex> Lock(Mutex);
+    std::unique_lock<std::mutex> Lock(SleepMutex);
     Stop = true;
     Lock.unlock();
-    Cond.notify_all();
+    SleepCond.notify_all();
     // Wait for ~Latch.
   }
 
   void add(std::function<void()> F) override {
-    std::unique_lock<std::mutex> Lock(Mutex);
-    WorkStack.push(F);
-    Lock.unlock();
-    Cond.notify_one();
+    unsigned Idx = WorkerIndex >= 0
+                       ? WorkerIndex
+                       : NextQueue.fetch_add(1, std::memory_order_relaxed);
+    WorkQueue &Q = *Queues[Idx % Queues.size()];
+    {
+      std::lock_guard<std::mutex> Lock(Q.Mutex);
+      Q.Tasks.push_back(std::move(F));
+    }
+    ++Pending;
+    // Only take the sleep lock if somebody may be waiting on it. Pending and
+    // Sleepers are sequentially consistent, so either we observe the sleeper
+    // here or the sleeper observes the new task before going to sleep.
+    if (Sleepers > 0) {
+      { std::lock_guard<std::mutex> Lock(SleepMutex); }
+      SleepCond.notify_one();
+    }
+  }
+
+  void wait(const Latch &L) override {
+    // Threads outside the pool simply block. Workers keep draining the pool,
+    // since the tasks of the group may be queued behind tasks that nobody else
+    // is free to run, and sleep with the idle workers when there is nothing to
+    // run. Either a new task or the end of the group wakes them up.
+    if (WorkerIndex < 0) {
+      L.sync();
+      return;
+    }
+    while (true) {
+      std::function<void()> Task;
+      if (getTask(WorkerIndex, Task)) {
+        Task();
+        continue;
+      }
+      std::unique_lock<std::mutex> Lock(SleepMutex);
+      ++Sleepers;
+      SleepCond.wait(Lock, [&] { return Pending > 0 || L.isDone(); });
+      --Sleepers;
+      if (L.isDone())
+        return;
+    }
+  }
+
+  void latchDone() override {
+    // Taking the lock orders this with the check of the latch by a thread
+    // about to sleep in wait().
+    { std::lock_guard<std::mutex> Lock(SleepMutex); }
+    SleepCond.notify_all();
   }
 
 private:
-  void work() {
+  struct WorkQueue {
+    std::mutex Mutex;
+    std::deque<std::function<void()>> Tasks;
+  };
+
+  /// Pop a task from the back of queue \p Idx, or steal one from the front of
+  /// another queue.
+  bool getTask(unsigned Idx, std::function<void()> &Task) {
+    {
+      WorkQueue &Q = *Queues[Idx];
+      std::lock_guard<std::mutex> Lock(Q.Mutex);
+      if (!Q.Tasks.empty()) {
+        Task = std::move(Q.Tasks.back());
+        Q.Tasks.pop_back();
+        --Pending;
+        return true;
+      }
+    }
+    for (size_t I = 1, E = Queues.size(); I < E; ++I) {
+      WorkQueue &Q = *Queues[(Idx + I) % E];
+      std::lock_guard<std::mutex> Lock(Q.Mutex);
+      if (!Q.Tasks.empty()) {
+        Task = std::move(Q.Tasks.front());
+        Q.Tasks.pop_front();
+        --Pending;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void work(unsigned Idx) {
+    WorkerIndex = Idx;
     while (true) {
-      std::unique_lock<std::mutex> Lock(Mutex);
-      Cond.wait(Lock, [&] { return Stop || !WorkStack.empty(); });
+      std::function<void()> Task;
+      if (getTask(Idx, Task)) {
+        Task();
+        continue;
+      }
+      std::unique_lock<std::mutex> Lock(SleepMutex);
+      ++Sleepers;
+      SleepCond.wait(Lock, [&] { return Stop || Pending > 0; });
+      --Sleepers;
       if (Stop)
         break;
-      auto Task = WorkStack.top();
-      WorkStack.pop();
-      Lock.unlock();
-      Task();
     }
     Done.dec();
   }
 
+  std::vector<std::unique_ptr<WorkQueue>> Queues;
+  std::atomic<unsigned> NextQueue{0};
+  std::atomic<unsigned> Pending{0};
+  std::atomic<unsigned> Sleepers{0};
   std::atomic<bool> Stop{false};
-  std::stack<std::function<void()>> WorkStack;
-  std::mutex Mutex;
-  std::condition_variable Cond;
+  std::mutex SleepMutex;
+  std::condition_variable SleepCond;
   parallel::detail::Latch Done;
 };
 
 Executor *Executor::getDefaultExecutor() {
-  static ThreadPoolExecutor exec;
+  static ThreadPoolExecutor exec(getMaxThreads());
   return &exec;
 }
 #endif
 }
 
+#if defined(_MSC_VER)
 static std::atomic<int> TaskGroupInstances;
 
 // Latch::sync() called by the dtor may cause one thread to block. If is a dead
@@ -128,19 +250,34 @@ static std::atomic<int> TaskGroupInstances;
 // of nested parallel_for_each(), only the outermost one runs parallelly.
 TaskGroup::TaskGroup() : Parallel(TaskGroupInstances++ == 0) {}
 TaskGroup::~TaskGroup() { --TaskGroupInstances; }
+#else
+// Nested task groups are safe to run in parallel because sync() called on a
+// worker thread keeps running pending tasks while there are any.
+TaskGroup::TaskGroup() : Parallel(getMaxThreads() > 1) {}
+TaskGroup::~TaskGroup() { sync(); }
+#endif
 
 void TaskGroup::spawn(std::function<void()> F) {
   if (Parallel) {
     L.inc();
     Executor::getDefaultExecutor()->add([&, F] {
       F();
-      L.dec();
+      if (L.dec())
+        Executor::getDefaultExecutor()->latchDone();
     });
   } else {
     F();
   }
 }
 
+void TaskGroup::sync() const {
+  if (!Parallel) {
+    L.sync();
+    return;
+  }
+  Executor::getDefaultExecutor()->wait(L);
+}
+
 } // namespace detail
 } // namespace parallel
 } // namespace llvm
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Regex.h"
+#include "RegexDFA.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
@@ -23,7 +24,7 @@
 
 using namespace llvm;
 
-Regex::Regex() : preg(nullptr), error(REG_BADPAT) {}
+Regex::Regex() : preg(nullptr), error(REG_BADPAT), dfa(nullptr) {}
 
 Regex::Regex(StringRef regex, unsigned Flags) {
   unsigned flags = 0;
@@ -36,13 +37,16 @@ Regex::Regex(StringRef regex, unsigned Flags) {
   if (!(Flags & BasicRegex))
     flags |= REG_EXTENDED;
   error = llvm_regcomp(preg, regex.data(), flags|REG_PEND);
+  dfa = error ? nullptr : RegexDFA::create(regex, Flags).release();
 }
 
 Regex::Regex(Regex &&regex) {
   preg = regex.preg;
   error = regex.error;
+  dfa = regex.dfa;
   regex.preg = nullptr;
   regex.error = REG_BADPAT;
+  regex.dfa = nullptr;
 }
 
 Regex::~Regex() {
@@ -50,6 +54,7 @@ Regex::~Regex() {
     llvm_regfree(preg);
     delete preg;
   }
+  delete dfa;
 }
 
 bool Regex::isValid(std::string &Error) const {
@@ -80,8 +85,50 @@ bool Regex::match(StringRef String, SmallVectorImpl<StringRef> *Matches){
   pm.resize(nmatch > 0 ? nmatch : 1);
   pm[0].rm_so = 0;
   pm[0].rm_eo = String.size();
+  int eflags = REG_STARTEND;
+
+  // Let the DFA find the match, if it can. The backtracking engine is then
+  // only needed for the parenthesized matches, within the matched text.
+  size_t Start = 0, End = 0;
+  bool WithinMatch = false;
+  switch (dfa ? dfa->match(String, Start, End) : RegexDFA::Busy) {
+  case RegexDFA::NoMatch:
+    return false;
+  case RegexDFA::Match: {
+    if (nmatch <= 1) {
+      if (Matches) {
+        Matches->clear();
+        Matches->push_back(String.slice(Start, End));
+      }
+      return true;
+    }
+    pm[0].rm_so = Start;
+    pm[0].rm_eo = End;
+    WithinMatch = true;
+    // Anchors only see the line boundaries of the matched text.
+    bool NewlineSensitive = dfa->isNewlineSensitive();
+    if (Start != 0 && !(NewlineSensitive && String[Start - 1] == '\n'))
+      eflags |= REG_NOTBOL;
+    if (End != String.size() && !(NewlineSensitive && String[End] == '\n'))
+      eflags |= REG_NOTEOL;
+    break;
+  }
+  case RegexDFA::Busy:
+    break;
+  }
 
-  int rc = llvm_regexec(preg, String.data(), nmatch, pm.data(), REG_STARTEND);
+  int rc = llvm_regexec(preg, String.data(), nmatch, pm.data(), eflags);
+
+  // The backtracking engine gets a few corner cases of the leftmost longest
+  // rule wrong, such as "(x?|[^a])c" in "]c", where it misses the match at 0.
+  // Stay consistent with it when the parenthesized matches are requested.
+  if (WithinMatch &&
+      (rc == REG_NOMATCH || (rc == 0 && (size_t(pm[0].rm_so) != Start ||
+                                         size_t(pm[0].rm_eo) != End)))) {
+    pm[0].rm_so = 0;
+    pm[0].rm_eo = String.size();
+    rc = llvm_regexec(preg, String.data(), nmatch, pm.data(), REG_STARTEND);
+  }
 
   if (rc == REG_NOMATCH)
     return false;
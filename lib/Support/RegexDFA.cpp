@@ -0,0 +1,861 @@
+//===-- RegexDFA.cpp - Lazy DFA matcher for llvm::Regex -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The regex is parsed the way regcomp.c parses extended regular expressions,
+// compiled into Thompson automata for the regex and for its reverse, and those
+// are simulated by DFAs whose states are sets of automaton states, built as the
+// input needs them.
+//
+// A DFA can tell where matches end but not where they start, so the leftmost
+// longest match is found in four linear passes:
+//  1. Scan forward, starting a thread at every position, to the earliest end
+//     of any match. The leftmost match starts no later than that.
+//  2. Keep extending the threads started so far, without starting new ones,
+//     to the last end of a match starting no later than the first end.
+//  3. Run the reversed regex backward from that end, starting a thread at
+//     every position, which finds the leftmost start.
+//  4. Scan forward from the start to the longest match.
+//
+//===----------------------------------------------------------------------===//
+
+#include "RegexDFA.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/Regex.h"
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+using ByteSet = std::bitset<256>;
+
+/// A node of the syntax tree of a regex.
+struct RegexNode {
+  enum NodeKind { Bytes, Concat, Alternate, Repeat, LineStart, LineEnd, Empty };
+
+  static const unsigned Unbounded = ~0u;
+
+  NodeKind Kind;
+  /// The bytes matched by a Bytes node, as an index into the parser's sets.
+  unsigned Set = 0;
+  /// The bounds of a Repeat node.
+  unsigned Min = 0, Max = 0;
+  SmallVector<unsigned, 2> Children;
+
+  explicit RegexNode(NodeKind Kind) : Kind(Kind) {}
+};
+
+/// Parses an extended regular expression the way p_ere() and its helpers in
+/// regcomp.c do, so that the syntax tree describes the same language as the
+/// program regcomp() builds. The regex has already been accepted by regcomp(),
+/// so anything unexpected simply makes it unsupported.
+class RegexParser {
+public:
+  RegexParser(StringRef Pattern, unsigned Flags)
+      : Pattern(Pattern), Flags(Flags) {}
+
+  /// Returns the root of the syntax tree, or None if the regex uses a feature
+  /// that the DFA does not support.
+  Optional<unsigned> parse() {
+    Optional<unsigned> Root = parseAlternation(/*InGroup=*/false);
+    if (!Root || more())
+      return None;
+    return Root;
+  }
+
+  std::vector<RegexNode> Nodes;
+  std::vector<ByteSet> Sets;
+
+private:
+  StringRef Pattern;
+  unsigned Flags;
+  size_t Pos = 0;
+
+  bool more() const { return Pos < Pattern.size(); }
+  bool see(char C) const { return more() && Pattern[Pos] == C; }
+  bool seeDigitAt(size_t I) const {
+    return I < Pattern.size() && isdigit((unsigned char)Pattern[I]);
+  }
+
+  unsigned addNode(RegexNode::NodeKind Kind) {
+    Nodes.emplace_back(Kind);
+    return Nodes.size() - 1;
+  }
+
+  unsigned addBytes(const ByteSet &Set) {
+    unsigned Node = addNode(RegexNode::Bytes);
+    Nodes[Node].Set = Sets.size();
+    Sets.push_back(Set);
+    return Node;
+  }
+
+  /// Adds the other case of every letter in \p Set, as done for REG_ICASE.
+  static void addOtherCases(ByteSet &Set) {
+    ByteSet Letters = Set;
+    for (int C = 0; C < 256; ++C) {
+      if (!Letters.test(C) || !isalpha(C))
+        continue;
+      if (isupper(C))
+        Set.set((unsigned char)tolower(C));
+      else if (islower(C))
+        Set.set((unsigned char)toupper(C));
+    }
+  }
+
+  bool containsAnchor(unsigned Node) const {
+    if (Nodes[Node].Kind == RegexNode::LineStart ||
+        Nodes[Node].Kind == RegexNode::LineEnd)
+      return true;
+    return any_of(Nodes[Node].Children,
+                  [&](unsigned Child) { return containsAnchor(Child); });
+  }
+
+  unsigned ordinary(char C) {
+    ByteSet Set;
+    Set.set((unsigned char)C);
+    if (Flags & Regex::IgnoreCase)
+      addOtherCases(Set);
+    return addBytes(Set);
+  }
+
+  Optional<unsigned> parseAlternation(bool InGroup);
+  Optional<unsigned> parseExpression();
+  Optional<unsigned> parseCount();
+  Optional<unsigned> parseBracket();
+  bool parseBracketTerm(ByteSet &Set);
+};
+
+} // end anonymous namespace
+
+Optional<unsigned> RegexParser::parseAlternation(bool InGroup) {
+  unsigned Alternation = addNode(RegexNode::Alternate);
+  while (true) {
+    unsigned Branch = addNode(RegexNode::Concat);
+    while (more() && !see('|') && !(InGroup && see(')'))) {
+      Optional<unsigned> Expression = parseExpression();
+      if (!Expression)
+        return None;
+      Nodes[Branch].Children.push_back(*Expression);
+    }
+    // Empty branches are rejected by regcomp().
+    if (Nodes[Branch].Children.empty())
+      return None;
+    Nodes[Alternation].Children.push_back(Branch);
+    if (!see('|'))
+      return Alternation;
+    ++Pos;
+  }
+}
+
+Optional<unsigned> RegexParser::parseExpression() {
+  char C = Pattern[Pos++];
+  Optional<unsigned> Atom;
+  bool WasCaret = false;
+  switch (C) {
+  case '(':
+    if (!more())
+      return None;
+    if (see(')'))
+      Atom = addNode(RegexNode::Empty);
+    else if (!(Atom = parseAlternation(/*InGroup=*/true)))
+      return None;
+    if (!see(')'))
+      return None;
+    ++Pos;
+    break;
+  case ')':
+  case '|':
+  case '*':
+  case '+':
+  case '?':
+    return None;
+  case '^':
+    Atom = addNode(RegexNode::LineStart);
+    WasCaret = true;
+    break;
+  case '$':
+    Atom = addNode(RegexNode::LineEnd);
+    break;
+  case '.': {
+    ByteSet Set;
+    Set.set();
+    if (Flags & Regex::Newline)
+      Set.reset('\n');
+    Atom = addBytes(Set);
+    break;
+  }
+  case '[':
+    if (!(Atom = parseBracket()))
+      return None;
+    break;
+  case '\\':
+    if (!more())
+      return None;
+    C = Pattern[Pos++];
+    // Backreferences are left to the backtracking engine.
+    if (C >= '1' && C <= '9')
+      return None;
+    Atom = ordinary(C);
+    break;
+  case '{':
+    if (seeDigitAt(Pos))
+      return None;
+    LLVM_FALLTHROUGH;
+  default:
+    Atom = ordinary(C);
+    break;
+  }
+
+  // A '{' only starts a repetition if a digit follows.
+  auto SeeRepetition = [&] {
+    if (!more())
+      return false;
+    char Next = Pattern[Pos];
+    return Next == '*' || Next == '+' || Next == '?' ||
+           (Next == '{' && seeDigitAt(Pos + 1));
+  };
+  if (!SeeRepetition())
+    return Atom;
+  if (WasCaret)
+    return None;
+
+  unsigned Min, Max;
+  switch (Pattern[Pos++]) {
+  case '*':
+    Min = 0;
+    Max = RegexNode::Unbounded;
+    break;
+  case '+':
+    Min = 1;
+    Max = RegexNode::Unbounded;
+    break;
+  case '?':
+    Min = 0;
+    Max = 1;
+    break;
+  default: {
+    Optional<unsigned> Count = parseCount();
+    if (!Count)
+      return None;
+    Min = Max = *Count;
+    if (see(',')) {
+      ++Pos;
+      if (seeDigitAt(Pos)) {
+        Count = parseCount();
+        if (!Count || *Count < Min)
+          return None;
+        Max = *Count;
+      } else {
+        Max = RegexNode::Unbounded;
+      }
+    }
+    if (!see('}'))
+      return None;
+    ++Pos;
+    break;
+  }
+  }
+
+  // regcomp() rejects a second repetition of the same atom. Repeated anchors
+  // are left to the backtracking engine, which has its own ideas about them:
+  // it never matches "${2}", for instance.
+  if (SeeRepetition() || containsAnchor(*Atom))
+    return None;
+
+  unsigned Repetition = addNode(RegexNode::Repeat);
+  Nodes[Repetition].Min = Min;
+  Nodes[Repetition].Max = Max;
+  Nodes[Repetition].Children.push_back(*Atom);
+  return Repetition;
+}
+
+Optional<unsigned> RegexParser::parseCount() {
+  // RE_DUP_MAX, as enforced by p_count().
+  const unsigned MaxCount = 255;
+  unsigned Count = 0;
+  size_t Start = Pos;
+  while (seeDigitAt(Pos) && Count <= MaxCount)
+    Count = Count * 10 + (Pattern[Pos++] - '0');
+  if (Pos == Start || Count > MaxCount)
+    return None;
+  return Count;
+}
+
+Optional<unsigned> RegexParser::parseBracket() {
+  // Word boundaries need the characters on both sides of a position, which the
+  // DFA does not track.
+  StringRef Rest = Pattern.substr(Pos);
+  if (Rest.startswith("[:<:]]") || Rest.startswith("[:>:]]"))
+    return None;
+
+  bool Invert = false;
+  if (see('^')) {
+    ++Pos;
+    Invert = true;
+  }
+  ByteSet Set;
+  if (see(']') || see('-'))
+    Set.set((unsigned char)Pattern[Pos++]);
+  while (more() && !see(']') &&
+         !(see('-') && Pos + 1 < Pattern.size() && Pattern[Pos + 1] == ']'))
+    if (!parseBracketTerm(Set))
+      return None;
+  if (see('-')) {
+    ++Pos;
+    Set.set('-');
+  }
+  if (!see(']'))
+    return None;
+  ++Pos;
+
+  if (Flags & Regex::IgnoreCase)
+    addOtherCases(Set);
+  if (Invert) {
+    Set.flip();
+    if (Flags & Regex::Newline)
+      Set.reset('\n');
+  }
+  return addBytes(Set);
+}
+
+bool RegexParser::parseBracketTerm(ByteSet &Set) {
+  StringRef Rest = Pattern.substr(Pos);
+  if (Rest.startswith("-"))
+    return false;
+  // Collating symbols and equivalence classes are left to regcomp().
+  if (Rest.startswith("[.") || Rest.startswith("[="))
+    return false;
+
+  if (Rest.startswith("[:")) {
+    Pos += 2;
+    size_t NameStart = Pos;
+    while (more() && isalpha((unsigned char)Pattern[Pos]))
+      ++Pos;
+    StringRef Name = Pattern.slice(NameStart, Pos);
+    if (!Pattern.substr(Pos).startswith(":]"))
+      return false;
+    Pos += 2;
+
+    // The classes of regcomp.c, which only contain ASCII characters.
+    enum ClassKind { Alnum, Alpha, Blank, Cntrl, Digit, Graph, Lower, Print,
+                     Punct, Space, Upper, XDigit, Unknown };
+    ClassKind Class = StringSwitch<ClassKind>(Name)
+                          .Case("alnum", Alnum)
+                          .Case("alpha", Alpha)
+                          .Case("blank", Blank)
+                          .Case("cntrl", Cntrl)
+                          .Case("digit", Digit)
+                          .Case("graph", Graph)
+                          .Case("lower", Lower)
+                          .Case("print", Print)
+                          .Case("punct", Punct)
+                          .Case("space", Space)
+                          .Case("upper", Upper)
+                          .Case("xdigit", XDigit)
+                          .Default(Unknown);
+    if (Class == Unknown)
+      return false;
+    for (unsigned C = 0; C < 128; ++C) {
+      bool IsLower = C >= 'a' && C <= 'z';
+      bool IsUpper = C >= 'A' && C <= 'Z';
+      bool IsDigit = C >= '0' && C <= '9';
+      bool IsGraph = C > ' ' && C < 127;
+      bool In;
+      switch (Class) {
+      case Alnum: In = IsLower || IsUpper || IsDigit; break;
+      case Alpha: In = IsLower || IsUpper; break;
+      case Blank: In = C == ' ' || C == '\t'; break;
+      case Cntrl: In = (C >= 1 && C < ' ') || C == 127; break;
+      case Digit: In = IsDigit; break;
+      case Graph: In = IsGraph; break;
+      case Lower: In = IsLower; break;
+      case Print: In = IsGraph || C == ' '; break;
+      case Punct: In = IsGraph && !(IsLower || IsUpper || IsDigit); break;
+      case Space: In = C == ' ' || (C >= '\t' && C <= '\r'); break;
+      case Upper: In = IsUpper; break;
+      case XDigit:
+        In = IsDigit || (C >= 'a' && C <= 'f') || (C >= 'A' && C <= 'F');
+        break;
+      case Unknown: llvm_unreachable("unknown character class");
+      }
+      if (In)
+        Set.set(C);
+    }
+    return true;
+  }
+
+  // A character or a range. As in p_b_term(), the bounds are compared as
+  // plain chars.
+  char Start = Pattern[Pos++], Finish = Start;
+  if (see('-') && Pos + 1 < Pattern.size() && Pattern[Pos + 1] != ']') {
+    ++Pos;
+    if (Pattern.substr(Pos).startswith("[."))
+      return false;
+    Finish = Pattern[Pos++];
+  }
+  if (Start > Finish)
+    return false;
+  for (int C = Start; C <= Finish; ++C)
+    Set.set((unsigned char)C);
+  return true;
+}
+
+/// A Thompson automaton for a regex, or for the reverse of a regex.
+class RegexDFA::Automaton {
+public:
+  struct State {
+    enum StateKind : uint8_t {
+      /// Consumes a byte of Set and moves to Out.
+      Bytes,
+      /// Moves to both Out and Out1.
+      Split,
+      /// Moves to Out if the position is at a line boundary on the side of
+      /// the input that has been consumed, or on the side still to come.
+      AssertConsumedSide,
+      AssertComingSide,
+      Match
+    };
+    StateKind Kind;
+    unsigned Set;
+    unsigned Out;
+    unsigned Out1;
+  };
+
+  std::vector<State> States;
+  unsigned Start;
+  std::vector<ByteSet> Sets;
+
+  /// Bytes that no set tells apart share a class, so that the DFA only needs
+  /// a transition per class. The newline has a class of its own.
+  uint8_t ByteClass[256];
+  unsigned NumClasses;
+
+  /// Builds the automaton for the syntax tree of \p Parser, or returns null
+  /// if it would be too large.
+  static std::unique_ptr<Automaton> compile(const RegexParser &Parser,
+                                            unsigned Root, bool Reverse);
+
+private:
+  /// An arbitrary limit, well above what counted repetitions of reasonable
+  /// regexes expand to.
+  static const unsigned MaxStates = 100000;
+
+  const RegexParser *Parser;
+  bool Reverse;
+
+  unsigned addState(State::StateKind Kind, unsigned Out,
+                    unsigned Out1 = ~0u) {
+    States.push_back({Kind, 0, Out, Out1});
+    return States.size() - 1;
+  }
+
+  Optional<unsigned> compileNode(unsigned Node, unsigned Next);
+  void computeByteClasses();
+};
+
+std::unique_ptr<RegexDFA::Automaton>
+RegexDFA::Automaton::compile(const RegexParser &Parser, unsigned Root,
+                             bool Reverse) {
+  std::unique_ptr<Automaton> A(new Automaton());
+  A->Parser = &Parser;
+  A->Reverse = Reverse;
+  A->Sets = Parser.Sets;
+  unsigned Match = A->addState(State::Match, ~0u);
+  Optional<unsigned> Start = A->compileNode(Root, Match);
+  if (!Start)
+    return nullptr;
+  // Give the automaton an entry state that no other state leads to, so that a
+  // DFA state holding only the entry state has no thread started earlier.
+  A->Start = A->addState(State::Split, *Start, *Start);
+  A->Parser = nullptr;
+  A->computeByteClasses();
+  return A;
+}
+
+// Nodes are compiled back to front: each node gets the state its matches
+// continue with, and returns the state its matches start with.
+Optional<unsigned> RegexDFA::Automaton::compileNode(unsigned NodeIdx,
+                                                    unsigned Next) {
+  if (States.size() > MaxStates)
+    return None;
+  const RegexNode &Node = Parser->Nodes[NodeIdx];
+  switch (Node.Kind) {
+  case RegexNode::Empty:
+    return Next;
+  case RegexNode::Bytes: {
+    unsigned S = addState(State::Bytes, Next);
+    States[S].Set = Node.Set;
+    return S;
+  }
+  case RegexNode::LineStart:
+    return addState(Reverse ? State::AssertComingSide
+                            : State::AssertConsumedSide,
+                    Next);
+  case RegexNode::LineEnd:
+    return addState(Reverse ? State::AssertConsumedSide
+                            : State::AssertComingSide,
+                    Next);
+  case RegexNode::Concat: {
+    SmallVector<unsigned, 8> Children(Node.Children.begin(),
+                                      Node.Children.end());
+    if (!Reverse)
+      std::reverse(Children.begin(), Children.end());
+    for (unsigned Child : Children) {
+      Optional<unsigned> Entry = compileNode(Child, Next);
+      if (!Entry)
+        return None;
+      Next = *Entry;
+    }
+    return Next;
+  }
+  case RegexNode::Alternate: {
+    Optional<unsigned> Entry = compileNode(Node.Children.back(), Next);
+    for (unsigned I = Node.Children.size() - 1; Entry && I != 0; --I) {
+      Optional<unsigned> Branch = compileNode(Node.Children[I - 1], Next);
+      if (!Branch)
+        return None;
+      Entry = addState(State::Split, *Branch, *Entry);
+    }
+    return Entry;
+  }
+  case RegexNode::Repeat: {
+    unsigned Child = Node.Children.front();
+    unsigned Entry = Next;
+    if (Node.Max == RegexNode::Unbounded) {
+      // A loop that either runs the child once more or leaves.
+      unsigned Loop = addState(State::Split, ~0u, Next);
+      Optional<unsigned> Body = compileNode(Child, Loop);
+      if (!Body)
+        return None;
+      States[Loop].Out = *Body;
+      Entry = Loop;
+    } else {
+      // Nested optional copies: x{0,2} is (x(x)?)?.
+      for (unsigned I = Node.Min; I != Node.Max; ++I) {
+        Optional<unsigned> Body = compileNode(Child, Entry);
+        if (!Body)
+          return None;
+        Entry = addState(State::Split, *Body, Next);
+      }
+    }
+    for (unsigned I = 0; I != Node.Min; ++I) {
+      Optional<unsigned> Body = compileNode(Child, Entry);
+      if (!Body)
+        return None;
+      Entry = *Body;
+    }
+    return Entry;
+  }
+  }
+  llvm_unreachable("unknown regex node");
+}
+
+void RegexDFA::Automaton::computeByteClasses() {
+  std::fill(std::begin(ByteClass), std::end(ByteClass), 0);
+  NumClasses = 1;
+  // Split every class into the bytes inside and outside of Set.
+  auto Refine = [&](const ByteSet &Set) {
+    SmallVector<int, 64> Renumber(2 * NumClasses, -1);
+    unsigned NewNumClasses = 0;
+    for (unsigned C = 0; C != 256; ++C) {
+      int &Class = Renumber[2 * ByteClass[C] + Set.test(C)];
+      if (Class < 0)
+        Class = NewNumClasses++;
+      ByteClass[C] = Class;
+    }
+    NumClasses = NewNumClasses;
+  };
+  ByteSet Newline;
+  Newline.set('\n');
+  Refine(Newline);
+  for (const ByteSet &Set : Sets)
+    if (NumClasses < 256)
+      Refine(Set);
+}
+
+/// The states of a DFA simulating an automaton, and the transitions between
+/// them found so far.
+///
+/// A DFA state is the set of automaton states reached right after consuming a
+/// byte, before following any empty transition, along with whether the byte
+/// was a line boundary. The empty transitions are followed when the next byte
+/// is known, since assertions on the coming side depend on it.
+class RegexDFA::StateCache {
+public:
+  static const unsigned Dead = ~0u;
+
+  StateCache(const Automaton &A, bool Unanchored, bool Newline)
+      : A(A), Unanchored(Unanchored), Newline(Newline),
+        MaxStates(std::max(64u, (1u << 20) / A.NumClasses)),
+        Marks(A.States.size(), 0) {}
+
+  /// Returns the state that starts matching at a position, which is at a line
+  /// boundary on the consumed side if \p AtBoundary.
+  unsigned getStartState(bool AtBoundary) {
+    return getState(A.Start, AtBoundary);
+  }
+
+  /// Returns the DFA state for the automaton states \p Kernel.
+  unsigned getState(ArrayRef<unsigned> Kernel, bool AtBoundary) {
+    if (Kernel.empty())
+      return Dead;
+    SmallString<64> Key(
+        StringRef(reinterpret_cast<const char *>(Kernel.data()),
+                  Kernel.size() * sizeof(unsigned)));
+    Key.push_back(AtBoundary);
+    auto Inserted = StateIDs.insert(std::make_pair(Key, States.size()));
+    if (!Inserted.second)
+      return Inserted.first->second;
+
+    DFAState S;
+    S.KernelBegin = Kernels.size();
+    S.KernelSize = Kernel.size();
+    S.AtBoundary = AtBoundary;
+    S.OnlyStart = Kernel.size() == 1 && Kernel[0] == A.Start;
+    Kernels.insert(Kernels.end(), Kernel.begin(), Kernel.end());
+    SmallVector<unsigned, 16> Reached;
+    S.AcceptsInLine = closure(Kernel, AtBoundary, false, Reached);
+    Reached.clear();
+    S.AcceptsAtBoundary = closure(Kernel, AtBoundary, true, Reached);
+    States.push_back(S);
+    Transitions.resize(Transitions.size() + A.NumClasses, Unknown);
+    return States.size() - 1;
+  }
+
+  /// Returns the state reached from \p S by consuming \p C.
+  unsigned next(unsigned S, unsigned char C) {
+    size_t Index = S * A.NumClasses + A.ByteClass[C];
+    if (Transitions[Index] != Unknown)
+      return Transitions[Index];
+
+    bool IsBoundary = Newline && C == '\n';
+    SmallVector<unsigned, 16> Reached;
+    closure(getKernel(S), States[S].AtBoundary, IsBoundary, Reached);
+    SmallVector<unsigned, 16> Kernel;
+    for (unsigned R : Reached)
+      if (A.Sets[A.States[R].Set].test(C))
+        Kernel.push_back(A.States[R].Out);
+    if (Unanchored)
+      Kernel.push_back(A.Start);
+    llvm::sort(Kernel);
+    Kernel.erase(std::unique(Kernel.begin(), Kernel.end()), Kernel.end());
+
+    // Start over when the cache is full. Matching stays linear, only slower,
+    // for regexes with huge DFAs.
+    if (States.size() >= MaxStates) {
+      States.clear();
+      Kernels.clear();
+      Transitions.clear();
+      StateIDs.clear();
+      return getState(Kernel, IsBoundary);
+    }
+    unsigned To = getState(Kernel, IsBoundary);
+    Transitions[Index] = To;
+    return To;
+  }
+
+  /// Returns whether \p S accepts before the byte \p C.
+  bool acceptsBefore(unsigned S, unsigned char C) const {
+    return Newline && C == '\n' ? States[S].AcceptsAtBoundary
+                                : States[S].AcceptsInLine;
+  }
+
+  /// Returns whether \p S accepts at the end of the input.
+  bool acceptsAtEnd(unsigned S) const { return States[S].AcceptsAtBoundary; }
+
+  /// Returns whether no thread but the one just started is alive in \p S.
+  bool hasOnlyStart(unsigned S) const { return States[S].OnlyStart; }
+
+  bool isAtBoundary(unsigned S) const { return States[S].AtBoundary; }
+
+  ArrayRef<unsigned> getKernel(unsigned S) const {
+    return makeArrayRef(Kernels).slice(States[S].KernelBegin,
+                                       States[S].KernelSize);
+  }
+
+private:
+  static const unsigned Unknown = ~0u - 1;
+
+  struct DFAState {
+    unsigned KernelBegin;
+    unsigned KernelSize;
+    bool AtBoundary;
+    bool OnlyStart;
+    bool AcceptsInLine;
+    bool AcceptsAtBoundary;
+  };
+
+  /// Follows the empty transitions from \p Kernel, given whether each side of
+  /// the position is a line boundary. Adds the Bytes states reached to
+  /// \p Reached and returns whether the Match state is reached.
+  bool closure(ArrayRef<unsigned> Kernel, bool ConsumedSide, bool ComingSide,
+               SmallVectorImpl<unsigned> &Reached) {
+    if (++Generation == 0) {
+      std::fill(Marks.begin(), Marks.end(), 0);
+      Generation = 1;
+    }
+    bool Accepts = false;
+    SmallVector<unsigned, 16> Worklist(Kernel.rbegin(), Kernel.rend());
+    while (!Worklist.empty()) {
+      unsigned S = Worklist.pop_back_val();
+      if (Marks[S] == Generation)
+        continue;
+      Marks[S] = Generation;
+      const Automaton::State &State = A.States[S];
+      switch (State.Kind) {
+      case Automaton::State::Bytes:
+        Reached.push_back(S);
+        break;
+      case Automaton::State::Split:
+        Worklist.push_back(State.Out1);
+        Worklist.push_back(State.Out);
+        break;
+      case Automaton::State::AssertConsumedSide:
+        if (ConsumedSide)
+          Worklist.push_back(State.Out);
+        break;
+      case Automaton::State::AssertComingSide:
+        if (ComingSide)
+          Worklist.push_back(State.Out);
+        break;
+      case Automaton::State::Match:
+        Accepts = true;
+        break;
+      }
+    }
+    return Accepts;
+  }
+
+  const Automaton &A;
+  bool Unanchored;
+  bool Newline;
+  unsigned MaxStates;
+
+  std::vector<DFAState> States;
+  std::vector<unsigned> Kernels;
+  std::vector<unsigned> Transitions;
+  StringMap<unsigned> StateIDs;
+
+  std::vector<unsigned> Marks;
+  unsigned Generation = 0;
+};
+
+const unsigned RegexDFA::StateCache::Dead;
+const unsigned RegexDFA::StateCache::Unknown;
+
+RegexDFA::RegexDFA(std::unique_ptr<Automaton> Forward,
+                   std::unique_ptr<Automaton> Backward, bool Newline)
+    : Forward(std::move(Forward)), Backward(std::move(Backward)),
+      Newline(Newline) {}
+
+RegexDFA::~RegexDFA() = default;
+
+std::unique_ptr<RegexDFA> RegexDFA::create(StringRef Pattern,
+                                           unsigned Flags) {
+  if (Flags & Regex::BasicRegex)
+    return nullptr;
+  RegexParser Parser(Pattern, Flags);
+  Optional<unsigned> Root = Parser.parse();
+  if (!Root)
+    return nullptr;
+  std::unique_ptr<Automaton> Forward =
+      Automaton::compile(Parser, *Root, /*Reverse=*/false);
+  std::unique_ptr<Automaton> Backward =
+      Automaton::compile(Parser, *Root, /*Reverse=*/true);
+  if (!Forward || !Backward)
+    return nullptr;
+  return std::unique_ptr<RegexDFA>(new RegexDFA(
+      std::move(Forward), std::move(Backward), Flags & Regex::Newline));
+}
+
+RegexDFA::MatchResult RegexDFA::match(StringRef String, size_t &Start,
+                                      size_t &End) {
+  std::unique_lock<std::mutex> Guard(Lock, std::try_to_lock);
+  if (!Guard.owns_lock())
+    return Busy;
+
+  if (!SearchForward) {
+    SearchForward.reset(new StateCache(*Forward, /*Unanchored=*/true, Newline));
+    MatchForward.reset(new StateCache(*Forward, /*Unanchored=*/false, Newline));
+    SearchBackward.reset(
+        new StateCache(*Backward, /*Unanchored=*/true, Newline));
+  }
+  const unsigned char *Str = String.bytes_begin();
+  size_t Size = String.size();
+  auto IsBoundaryAt = [&](size_t I) {
+    return I == Size || (Newline && Str[I] == '\n');
+  };
+
+  // 1. Find the earliest end of a match. Positions before the last one where
+  // no thread is alive cannot start a match.
+  StateCache &Search = *SearchForward;
+  unsigned S = Search.getStartState(/*AtBoundary=*/true);
+  size_t Pos = 0, FirstStartBound = 0;
+  while (true) {
+    if (Search.hasOnlyStart(S))
+      FirstStartBound = Pos;
+    if (Pos == Size) {
+      if (!Search.acceptsAtEnd(S))
+        return NoMatch;
+      break;
+    }
+    if (Search.acceptsBefore(S, Str[Pos]))
+      break;
+    S = Search.next(S, Str[Pos++]);
+  }
+
+  // 2. Find the last end of a match starting no later than that.
+  StateCache &Extend = *MatchForward;
+  unsigned M = Extend.getState(Search.getKernel(S), Search.isAtBoundary(S));
+  size_t LastEnd = Pos;
+  while (Pos != Size) {
+    M = Extend.next(M, Str[Pos++]);
+    if (M == StateCache::Dead)
+      break;
+    if (Pos == Size ? Extend.acceptsAtEnd(M) : Extend.acceptsBefore(M, Str[Pos]))
+      LastEnd = Pos;
+  }
+
+  // 3. Find the leftmost start of a match ending no later than that.
+  StateCache &Back = *SearchBackward;
+  Pos = LastEnd;
+  unsigned B = Back.getStartState(IsBoundaryAt(Pos));
+  size_t First = Pos;
+  while (true) {
+    if (Pos == 0 ? Back.acceptsAtEnd(B) : Back.acceptsBefore(B, Str[Pos - 1]))
+      First = Pos;
+    if (Pos == FirstStartBound)
+      break;
+    B = Back.next(B, Str[--Pos]);
+  }
+
+  // 4. Find the longest match from there.
+  M = Extend.getStartState(First == 0 || (Newline && Str[First - 1] == '\n'));
+  Pos = First;
+  End = First;
+  while (true) {
+    if (Pos == Size ? Extend.acceptsAtEnd(M) : Extend.acceptsBefore(M, Str[Pos]))
+      End = Pos;
+    if (Pos == Size)
+      break;
+    M = Extend.next(M, Str[Pos++]);
+    if (M == StateCache::Dead)
+      break;
+  }
+  Start = First;
+  return Match;
+}
@@ -0,0 +1,78 @@
+//===-- RegexDFA.h - Lazy DFA matcher for llvm::Regex -----------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the DFA based matcher used by llvm::Regex for the regular
+// expressions it supports, which are the extended regular expressions that
+// use neither backreferences nor word boundaries.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_SUPPORT_REGEXDFA_H
+#define LLVM_LIB_SUPPORT_REGEXDFA_H
+
+#include "llvm/ADT/StringRef.h"
+#include <memory>
+#include <mutex>
+
+namespace llvm {
+
+/// Finds the leftmost longest match of a regular expression in time linear in
+/// the length of the input, by simulating its automaton with a DFA whose
+/// states are built as the input needs them and cached for later matches.
+///
+/// The matcher only reports where the match is. Finding the subexpressions is
+/// left to the backtracking engine, which only needs to run over the matched
+/// text then.
+class RegexDFA {
+public:
+  enum MatchResult {
+    NoMatch,
+    Match,
+    /// Another thread is using the matcher.
+    Busy
+  };
+
+  /// Returns a matcher for \p Pattern, which must be a valid regex for the
+  /// llvm::Regex flags \p Flags, or null if the regex is not supported.
+  static std::unique_ptr<RegexDFA> create(StringRef Pattern, unsigned Flags);
+
+  ~RegexDFA();
+
+  /// Looks for the leftmost longest match in \p String and sets \p Start and
+  /// \p End to its bounds if there is one. Returns Busy rather than waiting if
+  /// another thread is matching with this instance.
+  MatchResult match(StringRef String, size_t &Start, size_t &End);
+
+  /// Returns true if the regex was compiled with Regex::Newline.
+  bool isNewlineSensitive() const { return Newline; }
+
+  class Automaton;
+  class StateCache;
+
+private:
+  RegexDFA(std::unique_ptr<Automaton> Forward,
+           std::unique_ptr<Automaton> Backward, bool Newline);
+
+  std::unique_ptr<Automaton> Forward;
+  std::unique_ptr<Automaton> Backward;
+
+  /// The DFAs built so far: unanchored and anchored for the regex, and
+  /// unanchored for the reversed regex.
+  std::unique_ptr<StateCache> SearchForward;
+  std::unique_ptr<StateCache> MatchForward;
+  std::unique_ptr<StateCache> SearchBackward;
+
+  /// Serializes the use of the state caches.
+  std::mutex Lock;
+
+  bool Newline;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_LIB_SUPPORT_REGEXDFA_H
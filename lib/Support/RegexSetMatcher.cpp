@@ -0,0 +1,451 @@
+//===-- RegexSetMatcher.cpp - many regexes for SpecialCaseList ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// RegexSetMatcher matches a query against many regular expressions at once,
+// by finding the expressions whose required literal occurs in the query with
+// an Aho-Corasick automaton and only checking those.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/RegexSetMatcher.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace llvm;
+
+// The characters that make an extended regular expression more than a
+// wildcard. '*' is only allowed after an unescaped '.'.
+static const char UnsupportedMetachars[] = "()^$|+?{}*";
+
+RegexSetMatcher::RegexSetMatcher() : Nodes(1) {
+  std::fill(std::begin(RootChildren), std::end(RootChildren), 0);
+}
+
+RegexSetMatcher::~RegexSetMatcher() = default;
+
+/// Parses the bracket expression at the start of \p Regex, after the '[', into
+/// \p Set. Returns the number of characters used, including the ']', or 0 if
+/// the expression is not one of the plain forms handled here. This follows
+/// p_bracket in regcomp.c, leaving character classes, collating elements and
+/// other unusual forms to Regex.
+static size_t parseBracket(StringRef Regex, std::bitset<256> &Set) {
+  size_t I = 0;
+  bool Invert = I < Regex.size() && Regex[I] == '^';
+  if (Invert)
+    ++I;
+  // A leading ']' or '-' is a literal.
+  if (I < Regex.size() && (Regex[I] == ']' || Regex[I] == '-'))
+    Set.set((uint8_t)Regex[I++]);
+
+  auto IsPlain = [](char C) {
+    return C != '[' && C != ']' && C != '-' && !(C & 0x80);
+  };
+  while (I < Regex.size() && Regex[I] != ']' &&
+         !Regex.substr(I).startswith("-]")) {
+    char Start = Regex[I];
+    if (!IsPlain(Start))
+      return 0;
+    char Finish = Start;
+    if (I + 2 < Regex.size() && Regex[I + 1] == '-' && Regex[I + 2] != ']') {
+      Finish = Regex[I + 2];
+      // Reversed ranges are errors, which Regex reports.
+      if (!IsPlain(Finish) || Finish < Start)
+        return 0;
+      I += 2;
+    }
+    for (unsigned C = Start; C <= (unsigned)Finish; ++C)
+      Set.set(C);
+    ++I;
+  }
+  if (Regex.substr(I).startswith("-]")) {
+    Set.set('-');
+    ++I;
+  }
+  if (I == Regex.size())
+    return 0;
+  if (Invert)
+    Set.flip();
+  return I + 1;
+}
+
+/// Returns the position after the bracket expression that starts at \p I,
+/// after the '[', or StringRef::npos if it does not end.
+static size_t skipBracket(StringRef Regex, size_t I) {
+  if (I < Regex.size() && Regex[I] == '^')
+    ++I;
+  if (I < Regex.size() && Regex[I] == ']')
+    ++I;
+  while (I < Regex.size() && Regex[I] != ']') {
+    // Skip character classes, equivalence classes and collating elements,
+    // which may contain a ']'.
+    if (Regex[I] == '[' && I + 1 < Regex.size() &&
+        std::strchr(":.=", Regex[I + 1])) {
+      char Terminator[] = {Regex[I + 1], ']', 0};
+      size_t End = Regex.find(Terminator, I + 2);
+      if (End == StringRef::npos)
+        return StringRef::npos;
+      I = End + 2;
+      continue;
+    }
+    ++I;
+  }
+  return I < Regex.size() ? I + 1 : StringRef::npos;
+}
+
+/// Returns the longest run of literal characters that occurs in every text
+/// matched by the extended regular expression \p Regex, or an empty string
+/// if none is found. Only the characters outside of parentheses that are not
+/// made optional by a quantifier are considered, and none at all if there is
+/// an alternation outside of parentheses.
+static std::string getRequiredLiteral(StringRef Regex) {
+  std::string Literal, Run;
+  auto EndRun = [&] {
+    if (Run.size() > Literal.size())
+      Literal = Run;
+    Run.clear();
+  };
+
+  unsigned Depth = 0;
+  for (size_t I = 0, E = Regex.size(); I < E;) {
+    char C = Regex[I];
+    if (C == '[') {
+      I = skipBracket(Regex, I + 1);
+      if (I == StringRef::npos)
+        return "";
+      EndRun();
+      continue;
+    }
+    if (C == '(') {
+      ++Depth;
+      EndRun();
+      ++I;
+      continue;
+    }
+    if (C == ')') {
+      if (!Depth)
+        return "";
+      --Depth;
+      ++I;
+      continue;
+    }
+    if (Depth) {
+      I += C == '\\' ? 2 : 1;
+      continue;
+    }
+    if (C == '|')
+      return "";
+    if (C == '{') {
+      // Skip a bound, which applies to what came before.
+      I = Regex.find('}', I);
+      if (I == StringRef::npos)
+        return "";
+      EndRun();
+      ++I;
+      continue;
+    }
+
+    char Lit = C;
+    size_t Next = I + 1;
+    bool IsLiteral = !std::strchr(".^$*+?}", C);
+    if (C == '\\') {
+      if (Next == E)
+        return "";
+      Lit = Regex[Next++];
+      IsLiteral = !(Lit >= '1' && Lit <= '9');
+    }
+    // A character followed by '*', '?' or a bound may not be there at all.
+    char Quantifier = Next < E ? Regex[Next] : 0;
+    if (!IsLiteral || Quantifier == '*' || Quantifier == '?' ||
+        Quantifier == '{') {
+      EndRun();
+    } else {
+      Run += Lit;
+      if (Quantifier == '+')
+        EndRun();
+    }
+    I = Next;
+  }
+  if (Depth)
+    return "";
+  EndRun();
+  return Literal;
+}
+
+bool RegexSetMatcher::insert(StringRef Pattern, std::string &Error) {
+  // Most entries are wildcards, which are checked without Regex.
+  if (insertWildcard(Pattern))
+    return true;
+
+  std::unique_ptr<Regex> RE =
+      make_unique<Regex>((Twine("^(") + Pattern + ")$").str());
+  if (!RE->isValid(Error))
+    return false;
+
+  unsigned Index = Entries.size();
+  Entries.emplace_back();
+  Entries.back().RE = std::move(RE);
+  std::string Literal = getRequiredLiteral(Pattern);
+  if (Literal.empty())
+    Unfiltered.push_back(Index);
+  else
+    addRequiredLiteral(Literal, Index);
+  return true;
+}
+
+bool RegexSetMatcher::insertWildcard(StringRef Regex) {
+  SmallVector<Atom, 32> NewAtoms;
+  SmallVector<unsigned, 4> NewSegmentEnds;
+  SmallVector<std::bitset<256>, 2> NewSets;
+  bool LeadingGap = false, TrailingGap = false;
+
+  auto EndSegment = [&] {
+    if (NewSegmentEnds.empty() ? !NewAtoms.empty()
+                               : NewSegmentEnds.back() != NewAtoms.size())
+      NewSegmentEnds.push_back(NewAtoms.size());
+  };
+
+  for (size_t I = 0, E = Regex.size(); I != E;) {
+    char C = Regex[I];
+    Atom A = {Atom::Char, (uint8_t)C, 0};
+    if (C == '\\') {
+      // An escaped character is a literal, except for backreferences.
+      if (I + 1 == E || (Regex[I + 1] >= '1' && Regex[I + 1] <= '9'))
+        return false;
+      A.C = Regex[I + 1];
+      I += 2;
+    } else if (C == '.') {
+      if (I + 1 != E && Regex[I + 1] == '*') {
+        EndSegment();
+        if (NewAtoms.empty())
+          LeadingGap = true;
+        TrailingGap = true;
+        I += 2;
+        continue;
+      }
+      A.Kind = Atom::Any;
+      ++I;
+    } else if (C == '[') {
+      std::bitset<256> Set;
+      size_t Length = parseBracket(Regex.substr(I + 1), Set);
+      if (!Length)
+        return false;
+      A.Kind = Atom::Set;
+      A.SetIndex = CharSets.size() + NewSets.size();
+      NewSets.push_back(Set);
+      I += 1 + Length;
+    } else if (std::strchr(UnsupportedMetachars, C)) {
+      return false;
+    } else {
+      ++I;
+    }
+    // '*' applies to the atom just parsed, which is only handled after '.'.
+    if (I != E && Regex[I] == '*')
+      return false;
+    NewAtoms.push_back(A);
+    TrailingGap = false;
+  }
+  EndSegment();
+
+  // Pick the longest run of literal characters as the filter.
+  std::string Literal, Run;
+  for (size_t I = 0, Segment = 0; I <= NewAtoms.size(); ++I) {
+    bool SegmentEnd = Segment != NewSegmentEnds.size() &&
+                      I == NewSegmentEnds[Segment];
+    if (I == NewAtoms.size() || SegmentEnd || NewAtoms[I].Kind != Atom::Char) {
+      if (Run.size() > Literal.size())
+        Literal = Run;
+      Run.clear();
+    }
+    if (SegmentEnd)
+      ++Segment;
+    if (I != NewAtoms.size() && NewAtoms[I].Kind == Atom::Char)
+      Run += NewAtoms[I].C;
+  }
+
+  unsigned Index = Entries.size();
+  Entries.emplace_back();
+  Entry &W = Entries.back();
+  W.AtomsBegin = Atoms.size();
+  W.AtomsEnd = Atoms.size() + NewAtoms.size();
+  W.SegmentsBegin = SegmentEnds.size();
+  W.SegmentsEnd = SegmentEnds.size() + NewSegmentEnds.size();
+  W.LeadingGap = LeadingGap;
+  W.TrailingGap = TrailingGap;
+  Atoms.insert(Atoms.end(), NewAtoms.begin(), NewAtoms.end());
+  for (unsigned End : NewSegmentEnds)
+    SegmentEnds.push_back(W.AtomsBegin + End);
+  CharSets.insert(CharSets.end(), NewSets.begin(), NewSets.end());
+
+  if (Literal.empty())
+    Unfiltered.push_back(Index);
+  else
+    addRequiredLiteral(Literal, Index);
+  return true;
+}
+
+unsigned RegexSetMatcher::getChild(unsigned N, uint8_t C) const {
+  if (N == 0)
+    return RootChildren[C];
+  for (const auto &Child : Nodes[N].Children)
+    if (Child.first == C)
+      return Child.second;
+  return 0;
+}
+
+void RegexSetMatcher::addRequiredLiteral(StringRef Literal, unsigned Index) {
+  unsigned N = 0;
+  for (char C : Literal) {
+    unsigned Child = getChild(N, C);
+    if (!Child) {
+      Child = Nodes.size();
+      Nodes.emplace_back();
+      if (N == 0)
+        RootChildren[(uint8_t)C] = Child;
+      else
+        Nodes[N].Children.push_back({(uint8_t)C, Child});
+    }
+    N = Child;
+  }
+  Nodes[N].Entries.push_back(Index);
+  Finalized = false;
+}
+
+void RegexSetMatcher::finalize() {
+  if (Finalized)
+    return;
+  // Compute the links breadth first, since the links of a node point to
+  // shallower nodes.
+  std::vector<unsigned> Worklist;
+  for (unsigned Child : RootChildren)
+    if (Child) {
+      Nodes[Child].Fail = Nodes[Child].NextOutput = 0;
+      Worklist.push_back(Child);
+    }
+  for (size_t I = 0; I != Worklist.size(); ++I) {
+    unsigned N = Worklist[I];
+    for (const auto &Child : Nodes[N].Children) {
+      unsigned F = Nodes[N].Fail;
+      while (F && !getChild(F, Child.first))
+        F = Nodes[F].Fail;
+      F = getChild(F, Child.first);
+      Node &ChildNode = Nodes[Child.second];
+      ChildNode.Fail = F;
+      ChildNode.NextOutput =
+          Nodes[F].Entries.empty() ? Nodes[F].NextOutput : F;
+      Worklist.push_back(Child.second);
+    }
+  }
+  Finalized = true;
+}
+
+bool RegexSetMatcher::atomMatches(const Atom &A, uint8_t C) const {
+  switch (A.Kind) {
+  case Atom::Char:
+    return A.C == C;
+  case Atom::Any:
+    return true;
+  case Atom::Set:
+    return CharSets[A.SetIndex].test(C);
+  }
+  llvm_unreachable("Unknown atom kind");
+}
+
+bool RegexSetMatcher::segmentMatchesAt(unsigned Begin, unsigned End,
+                                       const char *S) const {
+  for (unsigned I = Begin; I != End; ++I, ++S)
+    if (!atomMatches(Atoms[I], *S))
+      return false;
+  return true;
+}
+
+bool RegexSetMatcher::wildcardMatches(const Entry &W,
+                                      StringRef Query) const {
+  if (Query.size() < W.AtomsEnd - W.AtomsBegin)
+    return false;
+  if (!W.LeadingGap && !W.TrailingGap && W.SegmentsEnd - W.SegmentsBegin <= 1)
+    return Query.size() == W.AtomsEnd - W.AtomsBegin &&
+           segmentMatchesAt(W.AtomsBegin, W.AtomsEnd, Query.data());
+
+  // The segments have fixed lengths, so placing each as far to the left as it
+  // matches leaves the most room to the others. The first and last segments
+  // are anchored unless there is a gap before or after them.
+  size_t Begin = 0, End = Query.size();
+  unsigned Segment = W.SegmentsBegin, LastSegment = W.SegmentsEnd;
+  unsigned SegmentBegin = W.AtomsBegin;
+  if (!W.LeadingGap) {
+    unsigned SegmentEnd = SegmentEnds[Segment++];
+    if (!segmentMatchesAt(SegmentBegin, SegmentEnd, Query.data()))
+      return false;
+    Begin = SegmentEnd - SegmentBegin;
+    SegmentBegin = SegmentEnd;
+  }
+  if (!W.TrailingGap) {
+    --LastSegment;
+    unsigned LastBegin =
+        LastSegment == W.SegmentsBegin ? W.AtomsBegin
+                                       : SegmentEnds[LastSegment - 1];
+    End -= W.AtomsEnd - LastBegin;
+    if (!segmentMatchesAt(LastBegin, W.AtomsEnd, Query.data() + End))
+      return false;
+  }
+  for (; Segment != LastSegment; ++Segment) {
+    unsigned SegmentEnd = SegmentEnds[Segment];
+    size_t Length = SegmentEnd - SegmentBegin;
+    while (true) {
+      if (End - Begin < Length)
+        return false;
+      if (segmentMatchesAt(SegmentBegin, SegmentEnd, Query.data() + Begin))
+        break;
+      ++Begin;
+    }
+    Begin += Length;
+    SegmentBegin = SegmentEnd;
+  }
+  return Begin <= End;
+}
+
+Optional<unsigned> RegexSetMatcher::match(StringRef Query) const {
+  assert(Finalized && "Matching before finalize()");
+  // Find the literals in the query. A literal may occur many times, and many
+  // expressions may share it, so the expressions are only looked up once.
+  SmallVector<unsigned, 8> Found;
+  unsigned N = 0;
+  for (char C : Query) {
+    unsigned Next;
+    while (!(Next = getChild(N, C)) && N)
+      N = Nodes[N].Fail;
+    N = Next;
+    for (unsigned Out = Nodes[N].Entries.empty() ? Nodes[N].NextOutput : N;
+         Out; Out = Nodes[Out].NextOutput)
+      Found.push_back(Out);
+  }
+  if (Found.empty() && Unfiltered.empty())
+    return None;
+  llvm::sort(Found);
+  Found.erase(std::unique(Found.begin(), Found.end()), Found.end());
+
+  SmallVector<unsigned, 16> Candidates(Unfiltered.begin(), Unfiltered.end());
+  for (unsigned Out : Found)
+    Candidates.append(Nodes[Out].Entries.begin(), Nodes[Out].Entries.end());
+
+  // Check the candidates in order of insertion, so that the first match is
+  // the one to report.
+  llvm::sort(Candidates);
+  Candidates.erase(std::unique(Candidates.begin(), Candidates.end()),
+                   Candidates.end());
+  for (unsigned Index : Candidates) {
+    const Entry &E = Entries[Index];
+    if (E.RE ? E.RE->match(Query) : wildcardMatches(E, Query))
+      return Index;
+  }
+  return None;
+}
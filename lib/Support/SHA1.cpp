@@ -16,11 +16,24 @@
 
 #include "llvm/Support/SHA1.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/Parallel.h"
 using namespace llvm;
 
+#include <algorithm>
 #include <stdint.h>
 #include <string.h>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LLVM_SHA1_SHANI 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+#define LLVM_SHA1_ARM 1
+#include <arm_neon.h>
+#endif
 
 #if defined(BYTE_ORDER) && defined(BIG_ENDIAN) && BYTE_ORDER == BIG_ENDIAN
 #define SHA_BIG_ENDIAN
@@ -91,127 +104,392 @@ void SHA1::init() {
   InternalState.BufferOffset = 0;
 }
 
-void SHA1::hashBlock() {
-  uint32_t A = InternalState.State[0];
-  uint32_t B = InternalState.State[1];
-  uint32_t C = InternalState.State[2];
-  uint32_t D = InternalState.State[3];
-  uint32_t E = InternalState.State[4];
-
-  // 4 rounds of 20 operations each. Loop unrolled.
-  r0(A, B, C, D, E, 0, InternalState.Buffer.L);
-  r0(E, A, B, C, D, 1, InternalState.Buffer.L);
-  r0(D, E, A, B, C, 2, InternalState.Buffer.L);
-  r0(C, D, E, A, B, 3, InternalState.Buffer.L);
-  r0(B, C, D, E, A, 4, InternalState.Buffer.L);
-  r0(A, B, C, D, E, 5, InternalState.Buffer.L);
-  r0(E, A, B, C, D, 6, InternalState.Buffer.L);
-  r0(D, E, A, B, C, 7, InternalState.Buffer.L);
-  r0(C, D, E, A, B, 8, InternalState.Buffer.L);
-  r0(B, C, D, E, A, 9, InternalState.Buffer.L);
-  r0(A, B, C, D, E, 10, InternalState.Buffer.L);
-  r0(E, A, B, C, D, 11, InternalState.Buffer.L);
-  r0(D, E, A, B, C, 12, InternalState.Buffer.L);
-  r0(C, D, E, A, B, 13, InternalState.Buffer.L);
-  r0(B, C, D, E, A, 14, InternalState.Buffer.L);
-  r0(A, B, C, D, E, 15, InternalState.Buffer.L);
-  r1(E, A, B, C, D, 16, InternalState.Buffer.L);
-  r1(D, E, A, B, C, 17, InternalState.Buffer.L);
-  r1(C, D, E, A, B, 18, InternalState.Buffer.L);
-  r1(B, C, D, E, A, 19, InternalState.Buffer.L);
-
-  r2(A, B, C, D, E, 20, InternalState.Buffer.L);
-  r2(E, A, B, C, D, 21, InternalState.Buffer.L);
-  r2(D, E, A, B, C, 22, InternalState.Buffer.L);
-  r2(C, D, E, A, B, 23, InternalState.Buffer.L);
-  r2(B, C, D, E, A, 24, InternalState.Buffer.L);
-  r2(A, B, C, D, E, 25, InternalState.Buffer.L);
-  r2(E, A, B, C, D, 26, InternalState.Buffer.L);
-  r2(D, E, A, B, C, 27, InternalState.Buffer.L);
-  r2(C, D, E, A, B, 28, InternalState.Buffer.L);
-  r2(B, C, D, E, A, 29, InternalState.Buffer.L);
-  r2(A, B, C, D, E, 30, InternalState.Buffer.L);
-  r2(E, A, B, C, D, 31, InternalState.Buffer.L);
-  r2(D, E, A, B, C, 32, InternalState.Buffer.L);
-  r2(C, D, E, A, B, 33, InternalState.Buffer.L);
-  r2(B, C, D, E, A, 34, InternalState.Buffer.L);
-  r2(A, B, C, D, E, 35, InternalState.Buffer.L);
-  r2(E, A, B, C, D, 36, InternalState.Buffer.L);
-  r2(D, E, A, B, C, 37, InternalState.Buffer.L);
-  r2(C, D, E, A, B, 38, InternalState.Buffer.L);
-  r2(B, C, D, E, A, 39, InternalState.Buffer.L);
-
-  r3(A, B, C, D, E, 40, InternalState.Buffer.L);
-  r3(E, A, B, C, D, 41, InternalState.Buffer.L);
-  r3(D, E, A, B, C, 42, InternalState.Buffer.L);
-  r3(C, D, E, A, B, 43, InternalState.Buffer.L);
-  r3(B, C, D, E, A, 44, InternalState.Buffer.L);
-  r3(A, B, C, D, E, 45, InternalState.Buffer.L);
-  r3(E, A, B, C, D, 46, InternalState.Buffer.L);
-  r3(D, E, A, B, C, 47, InternalState.Buffer.L);
-  r3(C, D, E, A, B, 48, InternalState.Buffer.L);
-  r3(B, C, D, E, A, 49, InternalState.Buffer.L);
-  r3(A, B, C, D, E, 50, InternalState.Buffer.L);
-  r3(E, A, B, C, D, 51, InternalState.Buffer.L);
-  r3(D, E, A, B, C, 52, InternalState.Buffer.L);
-  r3(C, D, E, A, B, 53, InternalState.Buffer.L);
-  r3(B, C, D, E, A, 54, InternalState.Buffer.L);
-  r3(A, B, C, D, E, 55, InternalState.Buffer.L);
-  r3(E, A, B, C, D, 56, InternalState.Buffer.L);
-  r3(D, E, A, B, C, 57, InternalState.Buffer.L);
-  r3(C, D, E, A, B, 58, InternalState.Buffer.L);
-  r3(B, C, D, E, A, 59, InternalState.Buffer.L);
-
-  r4(A, B, C, D, E, 60, InternalState.Buffer.L);
-  r4(E, A, B, C, D, 61, InternalState.Buffer.L);
-  r4(D, E, A, B, C, 62, InternalState.Buffer.L);
-  r4(C, D, E, A, B, 63, InternalState.Buffer.L);
-  r4(B, C, D, E, A, 64, InternalState.Buffer.L);
-  r4(A, B, C, D, E, 65, InternalState.Buffer.L);
-  r4(E, A, B, C, D, 66, InternalState.Buffer.L);
-  r4(D, E, A, B, C, 67, InternalState.Buffer.L);
-  r4(C, D, E, A, B, 68, InternalState.Buffer.L);
-  r4(B, C, D, E, A, 69, InternalState.Buffer.L);
-  r4(A, B, C, D, E, 70, InternalState.Buffer.L);
-  r4(E, A, B, C, D, 71, InternalState.Buffer.L);
-  r4(D, E, A, B, C, 72, InternalState.Buffer.L);
-  r4(C, D, E, A, B, 73, InternalState.Buffer.L);
-  r4(B, C, D, E, A, 74, InternalState.Buffer.L);
-  r4(A, B, C, D, E, 75, InternalState.Buffer.L);
-  r4(E, A, B, C, D, 76, InternalState.Buffer.L);
-  r4(D, E, A, B, C, 77, InternalState.Buffer.L);
-  r4(C, D, E, A, B, 78, InternalState.Buffer.L);
-  r4(B, C, D, E, A, 79, InternalState.Buffer.L);
-
-  InternalState.State[0] += A;
-  InternalState.State[1] += B;
-  InternalState.State[2] += C;
-  InternalState.State[3] += D;
-  InternalState.State[4] += E;
+// Hashes NumBlocks blocks of 64 bytes into State.
+static void compressPortable(uint32_t *State, const uint8_t *Data,
+                             size_t NumBlocks) {
+  for (; NumBlocks; --NumBlocks, Data += 64) {
+    uint32_t Buf[16];
+    for (int I = 0; I != 16; ++I)
+      Buf[I] = support::endian::read32be(Data + 4 * I);
+
+    uint32_t A = State[0];
+    uint32_t B = State[1];
+    uint32_t C = State[2];
+    uint32_t D = State[3];
+    uint32_t E = State[4];
+
+    // 4 rounds of 20 operations each. Loop unrolled.
+    r0(A, B, C, D, E, 0, Buf);
+    r0(E, A, B, C, D, 1, Buf);
+    r0(D, E, A, B, C, 2, Buf);
+    r0(C, D, E, A, B, 3, Buf);
+    r0(B, C, D, E, A, 4, Buf);
+    r0(A, B, C, D, E, 5, Buf);
+    r0(E, A, B, C, D, 6, Buf);
+    r0(D, E, A, B, C, 7, Buf);
+    r0(C, D, E, A, B, 8, Buf);
+    r0(B, C, D, E, A, 9, Buf);
+    r0(A, B, C, D, E, 10, Buf);
+    r0(E, A, B, C, D, 11, Buf);
+    r0(D, E, A, B, C, 12, Buf);
+    r0(C, D, E, A, B, 13, Buf);
+    r0(B, C, D, E, A, 14, Buf);
+    r0(A, B, C, D, E, 15, Buf);
+    r1(E, A, B, C, D, 16, Buf);
+    r1(D, E, A, B, C, 17, Buf);
+    r1(C, D, E, A, B, 18, Buf);
+    r1(B, C, D, E, A, 19, Buf);
+
+    r2(A, B, C, D, E, 20, Buf);
+    r2(E, A, B, C, D, 21, Buf);
+    r2(D, E, A, B, C, 22, Buf);
+    r2(C, D, E, A, B, 23, Buf);
+    r2(B, C, D, E, A, 24, Buf);
+    r2(A, B, C, D, E, 25, Buf);
+    r2(E, A, B, C, D, 26, Buf);
+    r2(D, E, A, B, C, 27, Buf);
+    r2(C, D, E, A, B, 28, Buf);
+    r2(B, C, D, E, A, 29, Buf);
+    r2(A, B, C, D, E, 30, Buf);
+    r2(E, A, B, C, D, 31, Buf);
+    r2(D, E, A, B, C, 32, Buf);
+    r2(C, D, E, A, B, 33, Buf);
+    r2(B, C, D, E, A, 34, Buf);
+    r2(A, B, C, D, E, 35, Buf);
+    r2(E, A, B, C, D, 36, Buf);
+    r2(D, E, A, B, C, 37, Buf);
+    r2(C, D, E, A, B, 38, Buf);
+    r2(B, C, D, E, A, 39, Buf);
+
+    r3(A, B, C, D, E, 40, Buf);
+    r3(E, A, B, C, D, 41, Buf);
+    r3(D, E, A, B, C, 42, Buf);
+    r3(C, D, E, A, B, 43, Buf);
+    r3(B, C, D, E, A, 44, Buf);
+    r3(A, B, C, D, E, 45, Buf);
+    r3(E, A, B, C, D, 46, Buf);
+    r3(D, E, A, B, C, 47, Buf);
+    r3(C, D, E, A, B, 48, Buf);
+    r3(B, C, D, E, A, 49, Buf);
+    r3(A, B, C, D, E, 50, Buf);
+    r3(E, A, B, C, D, 51, Buf);
+    r3(D, E, A, B, C, 52, Buf);
+    r3(C, D, E, A, B, 53, Buf);
+    r3(B, C, D, E, A, 54, Buf);
+    r3(A, B, C, D, E, 55, Buf);
+    r3(E, A, B, C, D, 56, Buf);
+    r3(D, E, A, B, C, 57, Buf);
+    r3(C, D, E, A, B, 58, Buf);
+    r3(B, C, D, E, A, 59, Buf);
+
+    r4(A, B, C, D, E, 60, Buf);
+    r4(E, A, B, C, D, 61, Buf);
+    r4(D, E, A, B, C, 62, Buf);
+    r4(C, D, E, A, B, 63, Buf);
+    r4(B, C, D, E, A, 64, Buf);
+    r4(A, B, C, D, E, 65, Buf);
+    r4(E, A, B, C, D, 66, Buf);
+    r4(D, E, A, B, C, 67, Buf);
+    r4(C, D, E, A, B, 68, Buf);
+    r4(B, C, D, E, A, 69, Buf);
+    r4(A, B, C, D, E, 70, Buf);
+    r4(E, A, B, C, D, 71, Buf);
+    r4(D, E, A, B, C, 72, Buf);
+    r4(C, D, E, A, B, 73, Buf);
+    r4(B, C, D, E, A, 74, Buf);
+    r4(A, B, C, D, E, 75, Buf);
+    r4(E, A, B, C, D, 76, Buf);
+    r4(D, E, A, B, C, 77, Buf);
+    r4(C, D, E, A, B, 78, Buf);
+    r4(B, C, D, E, A, 79, Buf);
+
+    State[0] += A;
+    State[1] += B;
+    State[2] += C;
+    State[3] += D;
+    State[4] += E;
+  }
 }
 
-void SHA1::addUncounted(uint8_t Data) {
-#ifdef SHA_BIG_ENDIAN
-  InternalState.Buffer.C[InternalState.BufferOffset] = Data;
-#else
-  InternalState.Buffer.C[InternalState.BufferOffset ^ 3] = Data;
+#if LLVM_SHA1_SHANI
+// Hashes blocks with the SHA extensions, four rounds at a time.
+__attribute__((target("sha,sse4.1,ssse3"))) static void
+compressSHANI(uint32_t *State, const uint8_t *Data, size_t NumBlocks) {
+  // Reverses the bytes of each message word and the order of the words.
+  const __m128i Mask =
+      _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  __m128i ABCD = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(State)), 0x1B);
+  __m128i E = _mm_set_epi32(State[4], 0, 0, 0);
+  for (; NumBlocks; --NumBlocks, Data += 64) {
+    __m128i SavedABCD = ABCD, SavedE = E, Prev;
+    __m128i W0 = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Data)), Mask);
+    __m128i W1 = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Data + 16)), Mask);
+    __m128i W2 = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Data + 32)), Mask);
+    __m128i W3 = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Data + 48)), Mask);
+
+    // 20 groups of 4 rounds, the message schedule computed as it goes.
+    E = _mm_add_epi32(E, W0);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 0);
+    E = _mm_sha1nexte_epu32(Prev, W1);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 0);
+    E = _mm_sha1nexte_epu32(Prev, W2);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 0);
+    E = _mm_sha1nexte_epu32(Prev, W3);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 0);
+    W0 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W0, W1), W2), W3);
+    E = _mm_sha1nexte_epu32(Prev, W0);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 0);
+    W1 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W1, W2), W3), W0);
+    E = _mm_sha1nexte_epu32(Prev, W1);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 1);
+    W2 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W2, W3), W0), W1);
+    E = _mm_sha1nexte_epu32(Prev, W2);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 1);
+    W3 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W3, W0), W1), W2);
+    E = _mm_sha1nexte_epu32(Prev, W3);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 1);
+    W0 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W0, W1), W2), W3);
+    E = _mm_sha1nexte_epu32(Prev, W0);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 1);
+    W1 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W1, W2), W3), W0);
+    E = _mm_sha1nexte_epu32(Prev, W1);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 1);
+    W2 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W2, W3), W0), W1);
+    E = _mm_sha1nexte_epu32(Prev, W2);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 2);
+    W3 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W3, W0), W1), W2);
+    E = _mm_sha1nexte_epu32(Prev, W3);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 2);
+    W0 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W0, W1), W2), W3);
+    E = _mm_sha1nexte_epu32(Prev, W0);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 2);
+    W1 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W1, W2), W3), W0);
+    E = _mm_sha1nexte_epu32(Prev, W1);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 2);
+    W2 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W2, W3), W0), W1);
+    E = _mm_sha1nexte_epu32(Prev, W2);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 2);
+    W3 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W3, W0), W1), W2);
+    E = _mm_sha1nexte_epu32(Prev, W3);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 3);
+    W0 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W0, W1), W2), W3);
+    E = _mm_sha1nexte_epu32(Prev, W0);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 3);
+    W1 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W1, W2), W3), W0);
+    E = _mm_sha1nexte_epu32(Prev, W1);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 3);
+    W2 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W2, W3), W0), W1);
+    E = _mm_sha1nexte_epu32(Prev, W2);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 3);
+    W3 = _mm_sha1msg2_epu32(
+        _mm_xor_si128(_mm_sha1msg1_epu32(W3, W0), W1), W2);
+    E = _mm_sha1nexte_epu32(Prev, W3);
+    Prev = ABCD;
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, 3);
+
+    E = _mm_sha1nexte_epu32(Prev, SavedE);
+    ABCD = _mm_add_epi32(ABCD, SavedABCD);
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(State),
+                   _mm_shuffle_epi32(ABCD, 0x1B));
+  State[4] = _mm_extract_epi32(E, 3);
+}
+
+static bool hostHasSHANI() {
+  StringMap<bool> Features;
+  return sys::getHostCPUFeatures(Features) && Features.lookup("sha") &&
+         Features.lookup("sse4.1") && Features.lookup("ssse3");
+}
 #endif
 
+#if LLVM_SHA1_ARM
+// Hashes blocks with the ARMv8 cryptography extension, four rounds at a time.
+static void compressARM(uint32_t *State, const uint8_t *Data,
+                        size_t NumBlocks) {
+  const uint32x4_t K0 = vdupq_n_u32(SHA1_K0), K1 = vdupq_n_u32(SHA1_K20),
+                   K2 = vdupq_n_u32(SHA1_K40), K3 = vdupq_n_u32(SHA1_K60);
+  uint32x4_t ABCD = vld1q_u32(State);
+  uint32_t E = State[4];
+  for (; NumBlocks; --NumBlocks, Data += 64) {
+    uint32x4_t SavedABCD = ABCD;
+    uint32_t SavedE = E, Next;
+    uint32x4_t W0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(Data)));
+    uint32x4_t W1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(Data + 16)));
+    uint32x4_t W2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(Data + 32)));
+    uint32x4_t W3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(Data + 48)));
+
+    // 20 groups of 4 rounds, the message schedule computed as it goes.
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1cq_u32(ABCD, E, vaddq_u32(W0, K0));
+    E = Next;
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1cq_u32(ABCD, E, vaddq_u32(W1, K0));
+    E = Next;
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1cq_u32(ABCD, E, vaddq_u32(W2, K0));
+    E = Next;
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1cq_u32(ABCD, E, vaddq_u32(W3, K0));
+    E = Next;
+    W0 = vsha1su1q_u32(vsha1su0q_u32(W0, W1, W2), W3);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1cq_u32(ABCD, E, vaddq_u32(W0, K0));
+    E = Next;
+    W1 = vsha1su1q_u32(vsha1su0q_u32(W1, W2, W3), W0);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W1, K1));
+    E = Next;
+    W2 = vsha1su1q_u32(vsha1su0q_u32(W2, W3, W0), W1);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W2, K1));
+    E = Next;
+    W3 = vsha1su1q_u32(vsha1su0q_u32(W3, W0, W1), W2);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W3, K1));
+    E = Next;
+    W0 = vsha1su1q_u32(vsha1su0q_u32(W0, W1, W2), W3);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W0, K1));
+    E = Next;
+    W1 = vsha1su1q_u32(vsha1su0q_u32(W1, W2, W3), W0);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W1, K1));
+    E = Next;
+    W2 = vsha1su1q_u32(vsha1su0q_u32(W2, W3, W0), W1);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1mq_u32(ABCD, E, vaddq_u32(W2, K2));
+    E = Next;
+    W3 = vsha1su1q_u32(vsha1su0q_u32(W3, W0, W1), W2);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1mq_u32(ABCD, E, vaddq_u32(W3, K2));
+    E = Next;
+    W0 = vsha1su1q_u32(vsha1su0q_u32(W0, W1, W2), W3);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1mq_u32(ABCD, E, vaddq_u32(W0, K2));
+    E = Next;
+    W1 = vsha1su1q_u32(vsha1su0q_u32(W1, W2, W3), W0);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1mq_u32(ABCD, E, vaddq_u32(W1, K2));
+    E = Next;
+    W2 = vsha1su1q_u32(vsha1su0q_u32(W2, W3, W0), W1);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1mq_u32(ABCD, E, vaddq_u32(W2, K2));
+    E = Next;
+    W3 = vsha1su1q_u32(vsha1su0q_u32(W3, W0, W1), W2);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W3, K3));
+    E = Next;
+    W0 = vsha1su1q_u32(vsha1su0q_u32(W0, W1, W2), W3);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W0, K3));
+    E = Next;
+    W1 = vsha1su1q_u32(vsha1su0q_u32(W1, W2, W3), W0);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W1, K3));
+    E = Next;
+    W2 = vsha1su1q_u32(vsha1su0q_u32(W2, W3, W0), W1);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W2, K3));
+    E = Next;
+    W3 = vsha1su1q_u32(vsha1su0q_u32(W3, W0, W1), W2);
+    Next = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+    ABCD = vsha1pq_u32(ABCD, E, vaddq_u32(W3, K3));
+    E = Next;
+
+    E += SavedE;
+    ABCD = vaddq_u32(ABCD, SavedABCD);
+  }
+  vst1q_u32(State, ABCD);
+  State[4] = E;
+}
+#endif
+
+// Hashes NumBlocks blocks of 64 bytes into State, with the fastest
+// implementation the host supports.
+static void compressBlocks(uint32_t *State, const uint8_t *Data,
+                           size_t NumBlocks) {
+#if LLVM_SHA1_SHANI
+  static const bool HasSHANI = hostHasSHANI();
+  if (HasSHANI)
+    return compressSHANI(State, Data, NumBlocks);
+#elif LLVM_SHA1_ARM
+  return compressARM(State, Data, NumBlocks);
+#endif
+  compressPortable(State, Data, NumBlocks);
+}
+
+void SHA1::addUncounted(uint8_t Data) {
+  InternalState.Buffer[InternalState.BufferOffset] = Data;
+
   InternalState.BufferOffset++;
   if (InternalState.BufferOffset == BLOCK_LENGTH) {
-    hashBlock();
+    compressBlocks(InternalState.State, InternalState.Buffer, 1);
     InternalState.BufferOffset = 0;
   }
 }
 
-void SHA1::writebyte(uint8_t Data) {
-  ++InternalState.ByteCount;
-  addUncounted(Data);
-}
-
 void SHA1::update(ArrayRef<uint8_t> Data) {
-  for (auto &C : Data)
-    writebyte(C);
+  InternalState.ByteCount += Data.size();
+
+  // Finish the block in the buffer, if any.
+  if (InternalState.BufferOffset) {
+    size_t N = std::min<size_t>(BLOCK_LENGTH - InternalState.BufferOffset,
+                                Data.size());
+    memcpy(InternalState.Buffer + InternalState.BufferOffset, Data.data(), N);
+    InternalState.BufferOffset += N;
+    Data = Data.drop_front(N);
+    if (InternalState.BufferOffset != BLOCK_LENGTH)
+      return;
+    compressBlocks(InternalState.State, InternalState.Buffer, 1);
+    InternalState.BufferOffset = 0;
+  }
+
+  // Hash whole blocks in place, and buffer the rest.
+  size_t NumBlocks = Data.size() / BLOCK_LENGTH;
+  if (NumBlocks)
+    compressBlocks(InternalState.State, Data.data(), NumBlocks);
+  Data = Data.drop_front(NumBlocks * BLOCK_LENGTH);
+  memcpy(InternalState.Buffer, Data.data(), Data.size());
+  InternalState.BufferOffset = Data.size();
 }
 
 void SHA1::pad() {
@@ -222,16 +500,10 @@ void SHA1::pad() {
   while (InternalState.BufferOffset != 56)
     addUncounted(0x00);
 
-  // Append length in the last 8 bytes
-  addUncounted(0); // We're only using 32 bit lengths
-  addUncounted(0); // But SHA-1 supports 64 bit lengths
-  addUncounted(0); // So zero pad the top bits
-  addUncounted(InternalState.ByteCount >> 29); // Shifting to multiply by 8
-  addUncounted(InternalState.ByteCount >>
-               21); // as SHA-1 supports bitstreams as well as
-  addUncounted(InternalState.ByteCount >> 13); // byte.
-  addUncounted(InternalState.ByteCount >> 5);
-  addUncounted(InternalState.ByteCount << 3);
+  // Append the length in bits in the last 8 bytes
+  uint64_t BitCount = InternalState.ByteCount << 3;
+  for (int I = 56; I >= 0; I -= 8)
+    addUncounted(BitCount >> I);
 }
 
 StringRef SHA1::final() {
@@ -278,3 +550,31 @@ std::array<uint8_t, 20> SHA1::hash(ArrayRef<uint8_t> Data) {
   memcpy(Arr.data(), S.data(), S.size());
   return Arr;
 }
+
+std::array<uint8_t, 20> SHA1::hashTree(ArrayRef<uint8_t> Data,
+                                       size_t ChunkSize) {
+  assert(ChunkSize && ChunkSize % BLOCK_LENGTH == 0 &&
+         "Chunks must be whole blocks");
+  size_t NumChunks =
+      std::max<size_t>((Data.size() + ChunkSize - 1) / ChunkSize, 1);
+  std::vector<std::array<uint8_t, 20>> Leaves(NumChunks);
+  parallel::for_each_n(parallel::par, size_t(0), NumChunks, [&](size_t I) {
+    size_t Begin = I * ChunkSize;
+    Leaves[I] =
+        hash(Data.slice(Begin, std::min(ChunkSize, Data.size() - Begin)));
+  });
+
+  // The root also covers the sizes, so that trees of different shapes differ.
+  SHA1 Root;
+  uint8_t Sizes[16];
+  support::endian::write64le(Sizes, Data.size());
+  support::endian::write64le(Sizes + 8, ChunkSize);
+  Root.update(Sizes);
+  for (const std::array<uint8_t, 20> &Leaf : Leaves)
+    Root.update(Leaf);
+  StringRef S = Root.final();
+
+  std::array<uint8_t, 20> Arr;
+  memcpy(Arr.data(), S.data(), S.size());
+  return Arr;
+}
@@ -19,6 +19,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Locale.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -28,11 +29,18 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LLVM_SOURCEMGR_SSE2 1
+#include <emmintrin.h>
+#endif
+
 using namespace llvm;
 
 static const size_t TabStop = 8;
@@ -68,43 +76,135 @@ unsigned SourceMgr::FindBufferContainingLoc(SMLoc Loc) const {
   return 0;
 }
 
+/// Append the offsets of the '\n' characters in Buf[Begin, End) to Offsets.
 template <typename T>
-unsigned SourceMgr::SrcBuffer::getLineNumber(const char *Ptr) const {
+static void findLineEndings(const char *Buf, size_t Begin, size_t End,
+                            std::vector<T> &Offsets) {
+  size_t I = Begin;
+#if LLVM_SOURCEMGR_SSE2
+  // Compare 16 bytes at a time and walk the bits of the match mask. Unlike a
+  // memchr() loop this has no per-line call overhead, which dominates for
+  // the short lines typical of assembly and IR.
+  const __m128i Newline = _mm_set1_epi8('\n');
+  for (; I + 16 <= End; I += 16) {
+    __m128i Chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Buf + I));
+    unsigned Mask = _mm_movemask_epi8(_mm_cmpeq_epi8(Chunk, Newline));
+    while (Mask) {
+      Offsets.push_back(static_cast<T>(I + countTrailingZeros(Mask)));
+      Mask &= Mask - 1;
+    }
+  }
+#endif
+  while (I < End) {
+    const void *P = memchr(Buf + I, '\n', End - I);
+    if (!P)
+      break;
+    I = static_cast<const char *>(P) - Buf;
+    Offsets.push_back(static_cast<T>(I));
+    ++I;
+  }
+}
 
+template <typename T>
+std::vector<T> &SourceMgr::SrcBuffer::getOffsets(size_t End) const {
   // Ensure OffsetCache is allocated and populated with offsets of all the
-  // '\n' bytes.
+  // '\n' bytes before End.
   std::vector<T> *Offsets = nullptr;
   if (OffsetCache.isNull()) {
     Offsets = new std::vector<T>();
     OffsetCache = Offsets;
-    size_t Sz = Buffer->getBufferSize();
-    assert(Sz <= std::numeric_limits<T>::max());
-    StringRef S = Buffer->getBuffer();
-    for (size_t N = 0; N < Sz; ++N) {
-      if (S[N] == '\n') {
-        Offsets->push_back(static_cast<T>(N));
-      }
-    }
+    assert(Buffer->getBufferSize() <= std::numeric_limits<T>::max());
   } else {
     Offsets = OffsetCache.get<std::vector<T> *>();
   }
 
+  if (End > OffsetCacheEnd) {
+    assert(End <= Buffer->getBufferSize());
+    findLineEndings(Buffer->getBufferStart(), OffsetCacheEnd, End, *Offsets);
+    OffsetCacheEnd = End;
+  }
+  return *Offsets;
+}
+
+template <typename T>
+std::vector<T> &SourceMgr::SrcBuffer::getOffsetsForLines(size_t NumLines) const {
+  // Index in chunks that double in size until enough lines are found, so the
+  // total work is linear in the part of the buffer that is needed.
+  size_t Sz = Buffer->getBufferSize();
+  std::vector<T> *Offsets = &getOffsets<T>(OffsetCacheEnd);
+  size_t Chunk = 4096;
+  while (Offsets->size() < NumLines && OffsetCacheEnd < Sz) {
+    Offsets = &getOffsets<T>(std::min(Sz, OffsetCacheEnd + Chunk));
+    Chunk *= 2;
+  }
+  return *Offsets;
+}
+
+template <typename T>
+unsigned
+SourceMgr::SrcBuffer::getLineNumberSpecialized(const char *Ptr) const {
   const char *BufStart = Buffer->getBufferStart();
   assert(Ptr >= BufStart && Ptr <= Buffer->getBufferEnd());
   ptrdiff_t PtrDiff = Ptr - BufStart;
   assert(PtrDiff >= 0 && static_cast<size_t>(PtrDiff) <= std::numeric_limits<T>::max());
   T PtrOffset = static_cast<T>(PtrDiff);
 
+  // Only the line-endings before Ptr matter.
+  std::vector<T> &Offsets = getOffsets<T>(PtrDiff);
+
   // llvm::lower_bound gives the number of EOL before PtrOffset. Add 1 to get
   // the line number.
-  return llvm::lower_bound(*Offsets, PtrOffset) - Offsets->begin() + 1;
+  return llvm::lower_bound(Offsets, PtrOffset) - Offsets.begin() + 1;
+}
+
+template <typename T>
+const char *
+SourceMgr::SrcBuffer::getPointerForLineNumberSpecialized(unsigned LineNo) const {
+  if (LineNo == 0)
+    return nullptr;
+  // Line 1 starts at the beginning of the buffer, line N after the N-1th
+  // line-ending.
+  std::vector<T> &Offsets = getOffsetsForLines<T>(LineNo - 1);
+  if (LineNo - 1 > Offsets.size())
+    return nullptr;
+  const char *BufStart = Buffer->getBufferStart();
+  if (LineNo == 1)
+    return BufStart;
+  return BufStart + Offsets[LineNo - 2] + 1;
+}
+
+unsigned SourceMgr::SrcBuffer::getLineNumber(const char *Ptr) const {
+  size_t Sz = Buffer->getBufferSize();
+  if (Sz <= std::numeric_limits<uint8_t>::max())
+    return getLineNumberSpecialized<uint8_t>(Ptr);
+  else if (Sz <= std::numeric_limits<uint16_t>::max())
+    return getLineNumberSpecialized<uint16_t>(Ptr);
+  else if (Sz <= std::numeric_limits<uint32_t>::max())
+    return getLineNumberSpecialized<uint32_t>(Ptr);
+  else
+    return getLineNumberSpecialized<uint64_t>(Ptr);
+}
+
+const char *SourceMgr::SrcBuffer::getPointerForLineNumber(unsigned LineNo) const {
+  size_t Sz = Buffer->getBufferSize();
+  if (Sz <= std::numeric_limits<uint8_t>::max())
+    return getPointerForLineNumberSpecialized<uint8_t>(LineNo);
+  else if (Sz <= std::numeric_limits<uint16_t>::max())
+    return getPointerForLineNumberSpecialized<uint16_t>(LineNo);
+  else if (Sz <= std::numeric_limits<uint32_t>::max())
+    return getPointerForLineNumberSpecialized<uint32_t>(LineNo);
+  else
+    return getPointerForLineNumberSpecialized<uint64_t>(LineNo);
 }
 
 SourceMgr::SrcBuffer::SrcBuffer(SourceMgr::SrcBuffer &&Other)
   : Buffer(std::move(Other.Buffer)),
     OffsetCache(Other.OffsetCache),
+    OffsetCacheEnd(Other.OffsetCacheEnd),
     IncludeLoc(Other.IncludeLoc) {
   Other.OffsetCache = nullptr;
+  Other.OffsetCacheEnd = 0;
 }
 
 SourceMgr::SrcBuffer::~SrcBuffer() {
@@ -130,21 +230,33 @@ SourceMgr::getLineAndColumn(SMLoc Loc, unsigned BufferID) const {
   auto &SB = getBufferInfo(BufferID);
   const char *Ptr = Loc.getPointer();
 
-  size_t Sz = SB.Buffer->getBufferSize();
-  unsigned LineNo;
-  if (Sz <= std::numeric_limits<uint8_t>::max())
-    LineNo = SB.getLineNumber<uint8_t>(Ptr);
-  else if (Sz <= std::numeric_limits<uint16_t>::max())
-    LineNo = SB.getLineNumber<uint16_t>(Ptr);
-  else if (Sz <= std::numeric_limits<uint32_t>::max())
-    LineNo = SB.getLineNumber<uint32_t>(Ptr);
-  else
-    LineNo = SB.getLineNumber<uint64_t>(Ptr);
+  unsigned LineNo = SB.getLineNumber(Ptr);
 
-  const char *BufStart = SB.Buffer->getBufferStart();
-  size_t NewlineOffs = StringRef(BufStart, Ptr-BufStart).find_last_of("\n\r");
-  if (NewlineOffs == StringRef::npos) NewlineOffs = ~(size_t)0;
-  return std::make_pair(LineNo, Ptr-BufStart-NewlineOffs);
+  // The column is counted from the last '\n' or '\r' before Ptr. The index
+  // gives the start of the line; only that line needs to be searched for a
+  // '\r'.
+  const char *LineStart = SB.getPointerForLineNumber(LineNo);
+  size_t CROffs = StringRef(LineStart, Ptr - LineStart).find_last_of('\r');
+  if (CROffs != StringRef::npos)
+    LineStart += CROffs + 1;
+  return std::make_pair(LineNo, Ptr - LineStart + 1);
+}
+
+SMLoc SourceMgr::FindLocForLineAndColumn(unsigned BufferID, unsigned LineNo,
+                                         unsigned ColNo) {
+  auto &SB = getBufferInfo(BufferID);
+  const char *Ptr = SB.getPointerForLineNumber(LineNo);
+  if (!Ptr || ColNo == 0)
+    return SMLoc();
+
+  // We start counting columns from 1, so the first character is at Ptr.
+  Ptr += ColNo - 1;
+  if (Ptr > SB.Buffer->getBufferEnd())
+    return SMLoc();
+  // The column must be within the line, or point at its line-ending.
+  if (StringRef(Ptr - (ColNo - 1), ColNo - 1).find('\n') != StringRef::npos)
+    return SMLoc();
+  return SMLoc::getFromPointer(Ptr);
 }
 
 void SourceMgr::PrintIncludeStack(SMLoc IncludeLoc, raw_ostream &OS) const {
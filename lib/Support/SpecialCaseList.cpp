@@ -37,7 +37,6 @@ bool SpecialCaseList::Matcher::insert(std::string Regexp,
     Strings[Regexp] = LineNumber;
     return true;
   }
-  Trigrams.insert(Regexp);
 
   // Replace * with .*
   for (size_t pos = 0; (pos = Regexp.find('*', pos)) != std::string::npos;
@@ -45,27 +44,20 @@ bool SpecialCaseList::Matcher::insert(std::string Regexp,
     Regexp.replace(pos, strlen("*"), ".*");
   }
 
-  Regexp = (Twine("^(") + StringRef(Regexp) + ")$").str();
-
-  // Check that the regexp is valid.
-  Regex CheckRE(Regexp);
-  if (!CheckRE.isValid(REError))
+  if (!RegExes.insert(Regexp, REError))
     return false;
-
-  RegExes.emplace_back(
-      std::make_pair(make_unique<Regex>(std::move(CheckRE)), LineNumber));
+  RegExLines.push_back(LineNumber);
   return true;
 }
 
+void SpecialCaseList::Matcher::finalize() { RegExes.finalize(); }
+
 unsigned SpecialCaseList::Matcher::match(StringRef Query) const {
   auto It = Strings.find(Query);
   if (It != Strings.end())
     return It->second;
-  if (Trigrams.isDefinitelyOut(Query))
-    return false;
-  for (auto& RegExKV : RegExes)
-    if (RegExKV.first->match(Query))
-      return RegExKV.second;
+  if (Optional<unsigned> Index = RegExes.match(Query))
+    return RegExLines[*Index];
   return 0;
 }
 
@@ -182,6 +174,7 @@ bool SpecialCaseList::parse(const MemoryBuffer *MB,
         return false;
       }
 
+      M->finalize();
       SectionsMap[Section] = Sections.size();
       Sections.emplace_back(std::move(M));
     }
@@ -194,6 +187,11 @@ bool SpecialCaseList::parse(const MemoryBuffer *MB,
       return false;
     }
   }
+
+  for (auto &S : Sections)
+    for (auto &Prefix : S.Entries)
+      for (auto &Category : Prefix.getValue())
+        Category.getValue().finalize();
   return true;
 }
 
@@ -21,18 +21,27 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/LockFileManager.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstring>
+#include <thread>
 using namespace llvm;
 
 /// -stats - Command line option to cause transformations to emit stats about
@@ -47,9 +56,103 @@ static cl::opt<bool> StatsAsJSON("stats-json",
                                  cl::desc("Display statistics as json data"),
                                  cl::Hidden);
 
+static cl::opt<std::string>
+    StatsFile("stats-file-merge",
+              cl::desc("Add the statistics to the given stats file at exit"),
+              cl::value_desc("filename"), cl::Hidden);
+
 static bool Enabled;
 static bool PrintOnExit;
 
+namespace {
+/// The slots of one thread. They are allocated in chunks by the owning thread
+/// as it first touches them, and never move, so that other threads can read
+/// them at any time.
+struct StatisticShard {
+  static const unsigned ChunkSize = 1024;
+  static const unsigned MaxChunks = 256;
+
+  std::atomic<std::atomic<uint64_t> *> Chunks[MaxChunks];
+  std::thread::id Owner;
+  StatisticShard *Next = nullptr;
+
+  StatisticShard() {
+    for (auto &Chunk : Chunks)
+      Chunk.store(nullptr, std::memory_order_relaxed);
+  }
+};
+} // end anonymous namespace
+
+/// The shards of all threads that have touched a statistic. The list only
+/// grows, and shards live until the process exits, since statistics may be
+/// bumped from static destructors.
+static std::atomic<StatisticShard *> StatisticShards{nullptr};
+static LLVM_THREAD_LOCAL StatisticShard *CurrentStatisticShard = nullptr;
+
+static StatisticShard *getThreadStatisticShard() {
+  std::thread::id Self = std::this_thread::get_id();
+  StatisticShard *First = StatisticShards.load(std::memory_order_acquire);
+  // Only the calling thread can add a shard owned by itself. A thread id may
+  // be reused after its thread exited, in which case the new thread carries on
+  // counting in the old thread's shard.
+  for (StatisticShard *S = First; S; S = S->Next)
+    if (S->Owner == Self)
+      return S;
+
+  StatisticShard *New = new StatisticShard();
+  New->Owner = Self;
+  New->Next = First;
+  while (!StatisticShards.compare_exchange_weak(New->Next, New,
+                                                std::memory_order_release,
+                                                std::memory_order_acquire))
+    ;
+  return New;
+}
+
+std::atomic<uint64_t> &llvm::detail::getStatisticSlot(unsigned Index) {
+  StatisticShard *S = CurrentStatisticShard;
+  if (LLVM_UNLIKELY(!S))
+    S = CurrentStatisticShard = getThreadStatisticShard();
+  std::atomic<uint64_t> *Chunk =
+      S->Chunks[Index / StatisticShard::ChunkSize].load(
+          std::memory_order_relaxed);
+  if (LLVM_UNLIKELY(!Chunk)) {
+    Chunk = new std::atomic<uint64_t>[StatisticShard::ChunkSize]();
+    S->Chunks[Index / StatisticShard::ChunkSize].store(
+        Chunk, std::memory_order_release);
+  }
+  return Chunk[Index % StatisticShard::ChunkSize];
+}
+
+/// Returns the sum of the slots \p Index of all threads.
+static uint64_t sumStatisticSlots(unsigned Index) {
+  uint64_t Sum = 0;
+  for (StatisticShard *S = StatisticShards.load(std::memory_order_acquire); S;
+       S = S->Next)
+    if (std::atomic<uint64_t> *Chunk =
+            S->Chunks[Index / StatisticShard::ChunkSize].load(
+                std::memory_order_acquire))
+      Sum += Chunk[Index % StatisticShard::ChunkSize].load(
+          std::memory_order_relaxed);
+  return Sum;
+}
+
+static void clearStatisticSlots(unsigned Index) {
+  for (StatisticShard *S = StatisticShards.load(std::memory_order_acquire); S;
+       S = S->Next)
+    if (std::atomic<uint64_t> *Chunk =
+            S->Chunks[Index / StatisticShard::ChunkSize].load(
+                std::memory_order_acquire))
+      Chunk[Index % StatisticShard::ChunkSize].store(0,
+                                                     std::memory_order_relaxed);
+}
+
+/// The next free slot index. Index 0 is never used, so that it can stand for
+/// a statistic that has not been registered yet.
+static unsigned NextSlotIndex = 1;
+
+static json::Object getStatisticsFileObject();
+
 namespace {
 /// This class is used in a ManagedStatic so that it is created on demand (when
 /// the first statistic is bumped) and destroyed only when llvm_shutdown is
@@ -58,10 +161,12 @@ namespace {
 /// use LLVM.
 class StatisticInfo {
   std::vector<Statistic*> Stats;
+  std::vector<HistogramStatistic *> Histograms;
 
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
   friend void llvm::PrintStatisticsJSON(raw_ostream &OS);
+  friend json::Object(::getStatisticsFileObject)();
 
   /// Sort statistics by debugtype,name,description.
   void sort();
@@ -75,6 +180,8 @@ public:
     Stats.push_back(S);
   }
 
+  void addHistogram(HistogramStatistic *H) { Histograms.push_back(H); }
+
   const_iterator begin() const { return Stats.begin(); }
   const_iterator end() const { return Stats.end(); }
   iterator_range<const_iterator> statistics() const {
@@ -88,6 +195,21 @@ public:
 static ManagedStatic<StatisticInfo> StatInfo;
 static ManagedStatic<sys::SmartMutex<true> > StatLock;
 
+/// Returns the first of \p NumSlots consecutive new slots. StatLock must be
+/// held.
+static unsigned allocateStatisticSlots(unsigned NumSlots) {
+  if (NextSlotIndex + NumSlots >
+      StatisticShard::ChunkSize * StatisticShard::MaxChunks)
+    report_fatal_error("too many statistics");
+  // Keep the slots of a statistic in a single chunk.
+  unsigned ChunkEnd = alignTo(NextSlotIndex, StatisticShard::ChunkSize);
+  if (NextSlotIndex + NumSlots > ChunkEnd)
+    NextSlotIndex = ChunkEnd;
+  unsigned Index = NextSlotIndex;
+  NextSlotIndex += NumSlots;
+  return Index;
+}
+
 /// RegisterStatistic - The first time a statistic is bumped, this method is
 /// called.
 void Statistic::RegisterStatistic() {
@@ -106,7 +228,9 @@ void Statistic::RegisterStatistic() {
     // Check Initialized again after acquiring the lock.
     if (Initialized.load(std::memory_order_relaxed))
       return;
-    if (Stats || Enabled)
+    if (!SlotIndex)
+      SlotIndex = allocateStatisticSlots(1);
+    if (AreStatisticsEnabled())
       SI.addStatistic(this);
 
     // Remember we have been registered.
@@ -114,6 +238,73 @@ void Statistic::RegisterStatistic() {
   }
 }
 
+void HistogramStatistic::RegisterStatistic() {
+  // See Statistic::RegisterStatistic for the order of the locks.
+  if (!Initialized.load(std::memory_order_relaxed)) {
+    sys::SmartMutex<true> &Lock = *StatLock;
+    StatisticInfo &SI = *StatInfo;
+    sys::SmartScopedLock<true> Writer(Lock);
+    if (Initialized.load(std::memory_order_relaxed))
+      return;
+    if (!SlotIndex)
+      SlotIndex = allocateStatisticSlots(NumBuckets + 1);
+    if (AreStatisticsEnabled())
+      SI.addHistogram(this);
+    Initialized.store(true, std::memory_order_release);
+  }
+}
+
+uint64_t Statistic::getValue() const {
+  uint64_t V = Value.load(std::memory_order_relaxed);
+  if (Initialized.load(std::memory_order_acquire))
+    V += sumStatisticSlots(SlotIndex);
+  return V;
+}
+
+#if LLVM_ENABLE_STATS
+const Statistic &Statistic::operator=(uint64_t Val) {
+  init();
+  // The slots are left alone, since other threads may be adding to theirs.
+  Value.store(Val - sumStatisticSlots(SlotIndex), std::memory_order_relaxed);
+  return *this;
+}
+
+void Statistic::updateMax(uint64_t V) {
+  init();
+  IsMaximum.store(true, std::memory_order_relaxed);
+  uint64_t Base = Value.load(std::memory_order_relaxed);
+  // Keep trying to update max until we succeed or another thread produces
+  // a bigger max than us.
+  while (true) {
+    uint64_t Max = Base + sumStatisticSlots(SlotIndex);
+    if (V <= Max ||
+        Value.compare_exchange_weak(Base, Base + (V - Max),
+                                    std::memory_order_relaxed))
+      return;
+  }
+}
+#endif // LLVM_ENABLE_STATS
+
+uint64_t HistogramStatistic::getBucketCount(unsigned Bucket) const {
+  assert(Bucket < NumBuckets && "Invalid bucket");
+  if (!Initialized.load(std::memory_order_acquire))
+    return 0;
+  return sumStatisticSlots(SlotIndex + Bucket);
+}
+
+uint64_t HistogramStatistic::getCount() const {
+  uint64_t Count = 0;
+  for (unsigned I = 0; I != NumBuckets; ++I)
+    Count += getBucketCount(I);
+  return Count;
+}
+
+uint64_t HistogramStatistic::getSum() const {
+  if (!Initialized.load(std::memory_order_acquire))
+    return 0;
+  return sumStatisticSlots(SlotIndex + NumBuckets);
+}
+
 StatisticInfo::StatisticInfo() {
   // Ensure timergroup lists are created first so they are destructed after us.
   TimerGroup::ConstructTimerLists();
@@ -123,6 +314,10 @@ StatisticInfo::StatisticInfo() {
 StatisticInfo::~StatisticInfo() {
   if (::Stats || PrintOnExit)
     llvm::PrintStatistics();
+  if (!StatsFile.empty())
+    if (Error E = MergeStatisticsIntoFile(StatsFile))
+      logAllUnhandledErrors(std::move(E), errs(),
+                            "error writing '" + StatsFile + "': ");
 }
 
 void llvm::EnableStatistics(bool PrintOnExit) {
@@ -131,7 +326,7 @@ void llvm::EnableStatistics(bool PrintOnExit) {
 }
 
 bool llvm::AreStatisticsEnabled() {
-  return Enabled || Stats;
+  return Enabled || Stats || !StatsFile.empty();
 }
 
 void StatisticInfo::sort() {
@@ -144,6 +339,12 @@ void StatisticInfo::sort() {
 
     return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
   });
+  llvm::stable_sort(Histograms, [](const HistogramStatistic *LHS,
+                                   const HistogramStatistic *RHS) {
+    if (int Cmp = std::strcmp(LHS->getDebugType(), RHS->getDebugType()))
+      return Cmp < 0;
+    return std::strcmp(LHS->getName(), RHS->getName()) < 0;
+  });
 }
 
 void StatisticInfo::reset() {
@@ -158,6 +359,13 @@ void StatisticInfo::reset() {
     // iteration for that statistic will be lost as intended.
     Stat->Initialized = false;
     Stat->Value = 0;
+    Stat->IsMaximum = false;
+    clearStatisticSlots(Stat->SlotIndex);
+  }
+  for (auto *Histogram : Histograms) {
+    Histogram->Initialized = false;
+    for (unsigned I = 0; I <= HistogramStatistic::NumBuckets; ++I)
+      clearStatisticSlots(Histogram->SlotIndex + I);
   }
 
   // Clear the registration list and release the lock once we're done. Any
@@ -166,6 +374,7 @@ void StatisticInfo::reset() {
   // but it's their responsibility to prevent concurrent compilations to make
   // a single compilation measurable.
   Stats.clear();
+  Histograms.clear();
 }
 
 void llvm::PrintStatistics(raw_ostream &OS) {
@@ -189,10 +398,20 @@ void llvm::PrintStatistics(raw_ostream &OS) {
 
   // Print all of the statistics.
   for (size_t i = 0, e = Stats.Stats.size(); i != e; ++i)
-    OS << format("%*u %-*s - %s\n",
-                 MaxValLen, Stats.Stats[i]->getValue(),
-                 MaxDebugTypeLen, Stats.Stats[i]->getDebugType(),
-                 Stats.Stats[i]->getDesc());
+    OS << right_justify(utostr(Stats.Stats[i]->getValue()), MaxValLen) << ' '
+       << left_justify(Stats.Stats[i]->getDebugType(), MaxDebugTypeLen)
+       << " - " << Stats.Stats[i]->getDesc() << '\n';
+
+  // And the histograms, by number of values and mean.
+  if (!Stats.Histograms.empty()) {
+    OS << "\n" << std::string(31, ' ') << "... Histograms ...\n\n";
+    for (const HistogramStatistic *H : Stats.Histograms) {
+      uint64_t Count = H->getCount();
+      OS << right_justify(utostr(Count), MaxValLen) << " values, mean "
+         << (Count ? H->getSum() / Count : 0) << ' ' << H->getDebugType()
+         << " - " << H->getDesc() << '\n';
+    }
+  }
 
   OS << '\n';  // Flush the output stream.
   OS.flush();
@@ -217,6 +436,12 @@ void llvm::PrintStatisticsJSON(raw_ostream &OS) {
        << Stat->getValue();
     delim = ",\n";
   }
+  for (const HistogramStatistic *H : Stats.Histograms) {
+    OS << delim << "\t\"" << H->getDebugType() << '.' << H->getName()
+       << ".count\": " << H->getCount() << ",\n\t\"" << H->getDebugType()
+       << '.' << H->getName() << ".sum\": " << H->getSum();
+    delim = ",\n";
+  }
   // Print timers.
   TimerGroup::printAllJSONValues(OS, delim);
 
@@ -252,9 +477,9 @@ void llvm::PrintStatistics() {
 #endif
 }
 
-const std::vector<std::pair<StringRef, unsigned>> llvm::GetStatistics() {
+const std::vector<std::pair<StringRef, uint64_t>> llvm::GetStatistics() {
   sys::SmartScopedLock<true> Reader(*StatLock);
-  std::vector<std::pair<StringRef, unsigned>> ReturnStats;
+  std::vector<std::pair<StringRef, uint64_t>> ReturnStats;
 
   for (const auto &Stat : StatInfo->statistics())
     ReturnStats.emplace_back(Stat->getName(), Stat->getValue());
@@ -264,3 +489,181 @@ const std::vector<std::pair<StringRef, unsigned>> llvm::GetStatistics() {
 void llvm::ResetStatistics() {
   StatInfo->reset();
 }
+
+/// Returns the statistics of this process in the format of a stats file.
+static json::Object getStatisticsFileObject() {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  StatisticInfo &Stats = *StatInfo;
+  json::Object Counters, Maxima, Histograms;
+  for (const Statistic *Stat : Stats.Stats) {
+    std::string Key =
+        (Twine(Stat->getDebugType()) + "." + Stat->getName()).str();
+    int64_t Value = Stat->getValue();
+    if (Stat->IsMaximum.load(std::memory_order_relaxed))
+      Maxima[Key] = Value;
+    else
+      Counters[Key] = Value;
+  }
+  for (const HistogramStatistic *H : Stats.Histograms) {
+    json::Array Buckets;
+    for (unsigned I = 0; I != HistogramStatistic::NumBuckets; ++I)
+      Buckets.push_back(int64_t(H->getBucketCount(I)));
+    Histograms[(Twine(H->getDebugType()) + "." + H->getName()).str()] =
+        json::Object{{"count", int64_t(H->getCount())},
+                     {"sum", int64_t(H->getSum())},
+                     {"buckets", std::move(Buckets)}};
+  }
+  return json::Object{{"version", 1},
+                      {"invocations", 1},
+                      {"counters", std::move(Counters)},
+                      {"maxima", std::move(Maxima)},
+                      {"histograms", std::move(Histograms)}};
+}
+
+static Error makeStatsFileError(const Twine &Msg) {
+  return make_error<StringError>("invalid stats file: " + Msg,
+                                 inconvertibleErrorCode());
+}
+
+/// Merges the stats file \p From into \p Into.
+static Error mergeStatisticsObject(json::Object &Into,
+                                   const json::Value &From) {
+  const json::Object *FromObj = From.getAsObject();
+  if (!FromObj)
+    return makeStatsFileError("expected an object");
+  if (FromObj->getInteger("version") != Into.getInteger("version"))
+    return makeStatsFileError("unsupported version");
+
+  auto MergeIntegers = [&](StringRef Field, bool Max) -> Error {
+    const json::Object *FromFields = FromObj->getObject(Field);
+    if (!FromFields)
+      return makeStatsFileError("expected an object for '" + Field + "'");
+    json::Object &IntoFields = *Into.getObject(Field);
+    for (const auto &KV : *FromFields) {
+      Optional<int64_t> V = KV.second.getAsInteger();
+      if (!V)
+        return makeStatsFileError("expected an integer for '" + KV.first +
+                                  "'");
+      json::Value &Existing = IntoFields[KV.first];
+      int64_t Old = Existing.getAsInteger().getValueOr(0);
+      Existing = Max ? std::max(Old, *V) : int64_t(uint64_t(Old) + *V);
+    }
+    return Error::success();
+  };
+  if (Error E = MergeIntegers("counters", /*Max=*/false))
+    return E;
+  if (Error E = MergeIntegers("maxima", /*Max=*/true))
+    return E;
+
+  const json::Object *FromHistograms = FromObj->getObject("histograms");
+  if (!FromHistograms)
+    return makeStatsFileError("expected an object for 'histograms'");
+  json::Object &IntoHistograms = *Into.getObject("histograms");
+  for (const auto &KV : *FromHistograms) {
+    const json::Object *H = KV.second.getAsObject();
+    const json::Array *Buckets = H ? H->getArray("buckets") : nullptr;
+    if (!H || !H->getInteger("count") || !H->getInteger("sum") || !Buckets ||
+        Buckets->size() != HistogramStatistic::NumBuckets)
+      return makeStatsFileError("invalid histogram '" + KV.first + "'");
+    json::Value &Existing = IntoHistograms[KV.first];
+    if (!Existing.getAsObject()) {
+      Existing = KV.second;
+      continue;
+    }
+    json::Object &Into = *Existing.getAsObject();
+    for (StringRef Field : {"count", "sum"})
+      Into[Field] = int64_t(uint64_t(*Into.getInteger(Field)) +
+                            *H->getInteger(Field));
+    json::Array &IntoBuckets = *Into.getArray("buckets");
+    for (unsigned I = 0; I != HistogramStatistic::NumBuckets; ++I)
+      IntoBuckets[I] = *IntoBuckets[I].getAsInteger() +
+                       (*Buckets)[I].getAsInteger().getValueOr(0);
+  }
+
+  Into["invocations"] = *Into.getInteger("invocations") +
+                        FromObj->getInteger("invocations").getValueOr(1);
+  return Error::success();
+}
+
+/// Returns an empty stats file.
+static json::Object getEmptyStatisticsFileObject() {
+  return json::Object{{"version", 1},
+                      {"invocations", 0},
+                      {"counters", json::Object()},
+                      {"maxima", json::Object()},
+                      {"histograms", json::Object()}};
+}
+
+/// Merges the stats file \p Path into \p Into.
+static Error mergeStatisticsFile(json::Object &Into, StringRef Path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return createFileError(Path, errorCodeToError(Buffer.getError()));
+  Expected<json::Value> Contents = json::parse((*Buffer)->getBuffer());
+  if (!Contents)
+    return createFileError(Path, Contents.takeError());
+  if (Error E = mergeStatisticsObject(Into, *Contents))
+    return createFileError(Path, std::move(E));
+  return Error::success();
+}
+
+Error llvm::MergeStatisticsFiles(ArrayRef<std::string> Inputs,
+                                 raw_ostream &OS) {
+  json::Object Merged = getEmptyStatisticsFileObject();
+  for (const std::string &Input : Inputs)
+    if (Error E = mergeStatisticsFile(Merged, Input))
+      return E;
+  OS << formatv("{0:2}", json::Value(std::move(Merged))) << '\n';
+  return Error::success();
+}
+
+Error llvm::MergeStatisticsIntoFile(StringRef Path) {
+  json::Object Merged = getEmptyStatisticsFileObject();
+  if (Error E = mergeStatisticsObject(Merged, getStatisticsFileObject()))
+    return E;
+
+  while (true) {
+    LockFileManager Lock(Path);
+    switch (Lock) {
+    case LockFileManager::LFS_Error:
+      return make_error<StringError>("cannot lock '" + Path +
+                                         "': " + Lock.getErrorMessage(),
+                                     inconvertibleErrorCode());
+    case LockFileManager::LFS_Shared:
+      // Another process is merging. Try again once it is done, or take over
+      // the lock if it takes too long.
+      if (Lock.waitForUnlock() == LockFileManager::Res_Timeout)
+        Lock.unsafeRemoveLockFile();
+      continue;
+    case LockFileManager::LFS_Owned:
+      break;
+    }
+
+    if (sys::fs::exists(Path))
+      if (Error E = mergeStatisticsFile(Merged, Path))
+        return E;
+
+    // Write a temporary file and rename it over the stats file, so that a
+    // crash never leaves a truncated stats file behind.
+    int FD;
+    SmallString<128> TempPath;
+    if (std::error_code EC =
+            sys::fs::createUniqueFile(Path + "-%%%%%%%%.tmp", FD, TempPath))
+      return createFileError(Path, errorCodeToError(EC));
+    {
+      raw_fd_ostream OS(FD, /*shouldClose=*/true);
+      OS << formatv("{0:2}", json::Value(std::move(Merged))) << '\n';
+      OS.close();
+      if (OS.has_error()) {
+        OS.clear_error();
+        sys::fs::remove(TempPath);
+        return createFileError(TempPath, errorCodeToError(OS.error()));
+      }
+    }
+    if (std::error_code EC = sys::fs::rename(TempPath, Path)) {
+      sys::fs::remove(TempPath);
+      return createFileError(Path, errorCodeToError(EC));
+    }
+    return Error::success();
+  }
+}
@@ -13,90 +13,192 @@
 #include "llvm/Support/ThreadPool.h"
 
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
 
+void ThreadPool::enqueue(TaskTy Task, ThreadPoolTaskGroup *Group,
+                         ArrayRef<ThreadPoolTaskGroup *> Deps) {
+  {
+    // Lock the queue and push the new task
+    std::unique_lock<std::mutex> LockGuard(QueueLock);
+
+#if LLVM_ENABLE_THREADS
+    // Don't allow enqueueing after disabling the pool
+    assert(EnableFlag && "Queuing a thread during ThreadPool destruction");
+#endif
+
+    if (Group) {
+      assert(&Group->Pool == this && "Group belongs to another pool");
+      ++Group->Pending;
+    }
+    QueuedTask QT;
+    QT.Task = std::move(Task);
+    QT.Group = Group;
+
+    // Only remember the dependencies that are still running. Groups drop out
+    // of the list as they become idle, so a deferred task never points to a
+    // group that may have been destroyed.
+    DeferredTask DT;
+    for (ThreadPoolTaskGroup *Dep : Deps) {
+      assert(&Dep->Pool == this && "Dependency belongs to another pool");
+      if (Dep->Pending && Dep != Group)
+        DT.Deps.push_back(Dep);
+    }
+    if (!DT.Deps.empty()) {
+      DT.Task = std::move(QT);
+      DeferredTasks.push_back(std::move(DT));
+      return;
+    }
+
+    if (Group && Group->Prio == Priority::High)
+      HighPriorityTasks.push_back(std::move(QT));
+    else
+      Tasks.push_back(std::move(QT));
+  }
+  QueueCondition.notify_one();
+  // Threads waiting on a group may pick up the task as well.
+  CompletionCondition.notify_all();
+}
+
+ThreadPool::QueuedTask ThreadPool::popTask(ThreadPoolTaskGroup *Group) {
+  if (Group) {
+    for (std::deque<QueuedTask> *Q : {&HighPriorityTasks, &Tasks}) {
+      auto It = find_if(*Q, [&](const QueuedTask &T) { return T.Group == Group; });
+      if (It != Q->end()) {
+        QueuedTask Result = std::move(*It);
+        Q->erase(It);
+        return Result;
+      }
+    }
+  }
+  std::deque<QueuedTask> &Q = HighPriorityTasks.empty() ? Tasks : HighPriorityTasks;
+  QueuedTask Result = std::move(Q.front());
+  Q.pop_front();
+  return Result;
+}
+
+bool ThreadPool::taskDone(ThreadPoolTaskGroup *Group) {
+  if (!Group || --Group->Pending)
+    return false;
+
+  // The group is now idle: drop it from the dependencies of deferred tasks and
+  // queue the ones that have nothing left to wait for, in submission order.
+  bool Queued = false;
+  for (DeferredTask &DT : DeferredTasks) {
+    erase_if(DT.Deps, [&](ThreadPoolTaskGroup *G) { return G == Group; });
+    if (!DT.Deps.empty())
+      continue;
+    ThreadPoolTaskGroup *TaskGroup = DT.Task.Group;
+    if (TaskGroup && TaskGroup->Prio == Priority::High)
+      HighPriorityTasks.push_back(std::move(DT.Task));
+    else
+      Tasks.push_back(std::move(DT.Task));
+    Queued = true;
+  }
+  if (Queued)
+    erase_if(DeferredTasks, [](const DeferredTask &DT) { return DT.Deps.empty(); });
+  return Queued;
+}
+
 #if LLVM_ENABLE_THREADS
 
+/// The pool that owns the current thread, if any.
+static LLVM_THREAD_LOCAL ThreadPool *CurrentThreadPool = nullptr;
+
 // Default to hardware_concurrency
 ThreadPool::ThreadPool() : ThreadPool(hardware_concurrency()) {}
 
-ThreadPool::ThreadPool(unsigned ThreadCount)
-    : ActiveThreads(0), EnableFlag(true) {
+ThreadPool::ThreadPool(unsigned ThreadCount) : EnableFlag(true) {
   // Create ThreadCount threads that will loop forever, wait on QueueCondition
   // for tasks to be queued or the Pool to be destroyed.
   Threads.reserve(ThreadCount);
   for (unsigned ThreadID = 0; ThreadID < ThreadCount; ++ThreadID) {
     Threads.emplace_back([&] {
+      CurrentThreadPool = this;
       while (true) {
-        PackagedTaskTy Task;
+        QueuedTask Task;
         {
           std::unique_lock<std::mutex> LockGuard(QueueLock);
           // Wait for tasks to be pushed in the queue
           QueueCondition.wait(LockGuard,
-                              [&] { return !EnableFlag || !Tasks.empty(); });
+                              [&] { return !EnableFlag || hasQueuedTasks(); });
           // Exit condition
-          if (!EnableFlag && Tasks.empty())
+          if (!EnableFlag && !hasQueuedTasks())
             return;
           // Yeah, we have a task, grab it and release the lock on the queue
 
           // We first need to signal that we are active before popping the queue
           // in order for wait() to properly detect that even if the queue is
           // empty, there is still a task in flight.
-          {
-            std::unique_lock<std::mutex> LockGuard(CompletionLock);
-            ++ActiveThreads;
-          }
-          Task = std::move(Tasks.front());
-          Tasks.pop();
+          ++ActiveThreads;
+          Task = popTask(nullptr);
         }
         // Run the task we just grabbed
-        Task();
-
-        {
-          // Adjust `ActiveThreads`, in case someone waits on ThreadPool::wait()
-          std::unique_lock<std::mutex> LockGuard(CompletionLock);
-          --ActiveThreads;
-        }
-
-        // Notify task completion, in case someone waits on ThreadPool::wait()
-        CompletionCondition.notify_all();
+        runTask(Task);
       }
     });
   }
 }
 
-void ThreadPool::wait() {
-  // Wait for all threads to complete and the queue to be empty
-  std::unique_lock<std::mutex> LockGuard(CompletionLock);
-  // The order of the checks for ActiveThreads and Tasks.empty() matters because
-  // any active threads might be modifying the Tasks queue, and this would be a
-  // race.
-  CompletionCondition.wait(LockGuard,
-                           [&] { return !ActiveThreads && Tasks.empty(); });
-}
+void ThreadPool::runTask(QueuedTask &Task) {
+  Task.Task();
 
-std::shared_future<void> ThreadPool::asyncImpl(TaskTy Task) {
-  /// Wrap the Task in a packaged_task to return a future object.
-  PackagedTaskTy PackagedTask(std::move(Task));
-  auto Future = PackagedTask.get_future();
+  bool Queued;
   {
-    // Lock the queue and push the new task
+    // Adjust `ActiveThreads`, in case someone waits on ThreadPool::wait()
     std::unique_lock<std::mutex> LockGuard(QueueLock);
+    --ActiveThreads;
+    Queued = taskDone(Task.Group);
+  }
 
-    // Don't allow enqueueing after disabling the pool
-    assert(EnableFlag && "Queuing a thread during ThreadPool destruction");
+  // Notify task completion, in case someone waits on ThreadPool::wait()
+  CompletionCondition.notify_all();
+  if (Queued)
+    QueueCondition.notify_all();
+}
 
-    Tasks.push(std::move(PackagedTask));
+void ThreadPool::wait() {
+  assert(CurrentThreadPool != this &&
+         "ThreadPool::wait() called from a task of the same pool");
+  // Wait for all threads to complete and the queues to be empty
+  std::unique_lock<std::mutex> LockGuard(QueueLock);
+  CompletionCondition.wait(LockGuard, [&] {
+    return !ActiveThreads && !hasQueuedTasks() && DeferredTasks.empty();
+  });
+}
+
+void ThreadPool::wait(ThreadPoolTaskGroup &Group) {
+  // A thread outside the pool simply blocks.
+  if (CurrentThreadPool != this) {
+    std::unique_lock<std::mutex> LockGuard(QueueLock);
+    CompletionCondition.wait(LockGuard, [&] { return !Group.Pending; });
+    return;
+  }
+
+  // A worker thread would deadlock the pool if every worker ended up blocked
+  // in here, so it keeps running queued tasks, preferring those of Group,
+  // until the group is done.
+  while (true) {
+    QueuedTask Task;
+    {
+      std::unique_lock<std::mutex> LockGuard(QueueLock);
+      CompletionCondition.wait(
+          LockGuard, [&] { return !Group.Pending || hasQueuedTasks(); });
+      if (!Group.Pending)
+        return;
+      ++ActiveThreads;
+      Task = popTask(&Group);
+    }
+    runTask(Task);
   }
-  QueueCondition.notify_one();
-  return Future.share();
 }
 
 // The destructor joins all threads, waiting for completion.
 ThreadPool::~ThreadPool() {
+  wait();
   {
     std::unique_lock<std::mutex> LockGuard(QueueLock);
     EnableFlag = false;
@@ -111,31 +213,32 @@ ThreadPool::~ThreadPool() {
 ThreadPool::ThreadPool() : ThreadPool(0) {}
 
 // No threads are launched, issue a warning if ThreadCount is not 0
-ThreadPool::ThreadPool(unsigned ThreadCount)
-    : ActiveThreads(0) {
+ThreadPool::ThreadPool(unsigned ThreadCount) {
   if (ThreadCount) {
     errs() << "Warning: request a ThreadPool with " << ThreadCount
            << " threads, but LLVM_ENABLE_THREADS has been turned off\n";
   }
 }
 
+void ThreadPool::runTask(QueuedTask &Task) {
+  Task.Task();
+  taskDone(Task.Group);
+}
+
 void ThreadPool::wait() {
   // Sequential implementation running the tasks
-  while (!Tasks.empty()) {
-    auto Task = std::move(Tasks.front());
-    Tasks.pop();
-    Task();
+  while (hasQueuedTasks()) {
+    QueuedTask Task = popTask(nullptr);
+    runTask(Task);
   }
 }
 
-std::shared_future<void> ThreadPool::asyncImpl(TaskTy Task) {
-  // Get a Future with launch::deferred execution using std::async
-  auto Future = std::async(std::launch::deferred, std::move(Task)).share();
-  // Wrap the future so that both ThreadPool::wait() can operate and the
-  // returned future can be sync'ed on.
-  PackagedTaskTy PackagedTask([Future]() { Future.get(); });
-  Tasks.push(std::move(PackagedTask));
-  return Future;
+void ThreadPool::wait(ThreadPoolTaskGroup &Group) {
+  while (Group.Pending) {
+    assert(hasQueuedTasks() && "Group has pending tasks that cannot run");
+    QueuedTask Task = popTask(&Group);
+    runTask(Task);
+  }
 }
 
 ThreadPool::~ThreadPool() {
@@ -11,10 +11,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/TimeProfiler.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/JSON.h"
+#include "llvm/Support/Threading.h"
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <string>
@@ -49,9 +53,25 @@ struct Entry {
         Detail(std::move(Dt)){};
 };
 
-struct TimeTraceProfiler {
-  TimeTraceProfiler() {
-    StartTime = steady_clock::now();
+struct InstantEntry {
+  time_point<steady_clock> Time;
+  std::string Name;
+  std::string Detail;
+};
+
+struct CounterEntry {
+  time_point<steady_clock> Time;
+  std::string Name;
+  int64_t Value;
+};
+
+/// The sections and events traced by one thread. Only that thread touches
+/// them until the trace is written.
+struct ThreadTimeTraceProfiler {
+  ThreadTimeTraceProfiler() : Tid(get_threadid()) {
+    SmallString<32> Name;
+    get_thread_name(Name);
+    ThreadName = Name.str();
   }
 
   void begin(std::string Name, llvm::function_ref<std::string()> Detail) {
@@ -84,33 +104,127 @@ struct TimeTraceProfiler {
     Stack.pop_back();
   }
 
+  SmallVector<Entry, 16> Stack;
+  SmallVector<Entry, 128> Entries;
+  std::vector<InstantEntry> Instants;
+  std::vector<CounterEntry> Counters;
+  StringMap<CountAndDurationType> CountAndTotalPerName;
+  const uint64_t Tid;
+  std::string ThreadName;
+  ThreadTimeTraceProfiler *Next = nullptr;
+};
+
+/// The profiler of the calling thread, valid while the thread's cached
+/// profiler ID is that of the current TimeTraceProfiler. IDs are never
+/// reused, so a profiler left over from an earlier session is never used.
+static LLVM_THREAD_LOCAL ThreadTimeTraceProfiler *CurrentThreadProfiler =
+    nullptr;
+static LLVM_THREAD_LOCAL uint64_t CurrentThreadProfilerID = 0;
+static std::atomic<uint64_t> NextProfilerID{1};
+
+struct TimeTraceProfiler {
+  TimeTraceProfiler() {
+    StartTime = steady_clock::now();
+  }
+
+  ~TimeTraceProfiler() {
+    ThreadTimeTraceProfiler *TP = Threads.load(std::memory_order_acquire);
+    while (TP) {
+      ThreadTimeTraceProfiler *Next = TP->Next;
+      delete TP;
+      TP = Next;
+    }
+  }
+
+  /// Returns the profiler of the calling thread, creating it if needed. New
+  /// profilers are pushed onto a list with a compare and swap, so threads
+  /// never wait for each other.
+  ThreadTimeTraceProfiler &getThreadProfiler() {
+    if (CurrentThreadProfilerID == ID)
+      return *CurrentThreadProfiler;
+    ThreadTimeTraceProfiler *TP = new ThreadTimeTraceProfiler();
+    TP->Next = Threads.load(std::memory_order_acquire);
+    while (!Threads.compare_exchange_weak(TP->Next, TP,
+                                          std::memory_order_release,
+                                          std::memory_order_acquire))
+      ;
+    CurrentThreadProfiler = TP;
+    CurrentThreadProfilerID = ID;
+    return *TP;
+  }
+
   void Write(raw_pwrite_stream &OS) {
-    assert(Stack.empty() &&
-           "All profiler sections should be ended when calling Write");
+    // Threads in the order they started tracing.
+    SmallVector<const ThreadTimeTraceProfiler *, 8> ThreadProfilers;
+    for (ThreadTimeTraceProfiler *TP = Threads.load(std::memory_order_acquire);
+         TP; TP = TP->Next) {
+      assert(TP->Stack.empty() &&
+             "All profiler sections should be ended when calling Write");
+      ThreadProfilers.push_back(TP);
+    }
+    std::reverse(ThreadProfilers.begin(), ThreadProfilers.end());
+
     json::OStream J(OS);
     J.objectBegin();
     J.attributeBegin("traceEvents");
     J.arrayBegin();
 
-    // Emit all events for the main flame graph.
-    for (const auto &E : Entries) {
-      auto StartUs = duration_cast<microseconds>(E.Start - StartTime).count();
-      auto DurUs = duration_cast<microseconds>(E.Duration).count();
+    auto TimeUs = [&](time_point<steady_clock> T) {
+      return int64_t(duration_cast<microseconds>(T - StartTime).count());
+    };
 
-      J.object([&]{
-        J.attribute("pid", 1);
-        J.attribute("tid", 0);
-        J.attribute("ph", "X");
-        J.attribute("ts", StartUs);
-        J.attribute("dur", DurUs);
-        J.attribute("name", E.Name);
-        J.attributeObject("args", [&] { J.attribute("detail", E.Detail); });
-      });
+    // Emit all events for the main flame graph, with the events of every
+    // thread on a track of its own.
+    StringMap<CountAndDurationType> CountAndTotalPerName;
+    uint64_t MaxTid = 0;
+    for (const ThreadTimeTraceProfiler *TP : ThreadProfilers) {
+      MaxTid = std::max(MaxTid, TP->Tid);
+
+      for (const auto &E : TP->Entries) {
+        auto DurUs = duration_cast<microseconds>(E.Duration).count();
+
+        J.object([&]{
+          J.attribute("pid", 1);
+          J.attribute("tid", int64_t(TP->Tid));
+          J.attribute("ph", "X");
+          J.attribute("ts", TimeUs(E.Start));
+          J.attribute("dur", DurUs);
+          J.attribute("name", E.Name);
+          J.attributeObject("args", [&] { J.attribute("detail", E.Detail); });
+        });
+      }
+
+      for (const InstantEntry &E : TP->Instants)
+        J.object([&] {
+          J.attribute("pid", 1);
+          J.attribute("tid", int64_t(TP->Tid));
+          J.attribute("ph", "i");
+          J.attribute("s", "t");
+          J.attribute("ts", TimeUs(E.Time));
+          J.attribute("name", E.Name);
+          J.attributeObject("args", [&] { J.attribute("detail", E.Detail); });
+        });
+
+      for (const CounterEntry &E : TP->Counters)
+        J.object([&] {
+          J.attribute("pid", 1);
+          J.attribute("tid", int64_t(TP->Tid));
+          J.attribute("ph", "C");
+          J.attribute("ts", TimeUs(E.Time));
+          J.attribute("name", E.Name);
+          J.attributeObject("args", [&] { J.attribute(E.Name, E.Value); });
+        });
+
+      for (const auto &E : TP->CountAndTotalPerName) {
+        auto &CountAndTotal = CountAndTotalPerName[E.getKey()];
+        CountAndTotal.first += E.getValue().first;
+        CountAndTotal.second += E.getValue().second;
+      }
     }
 
     // Emit totals by section name as additional "thread" events, sorted from
-    // longest one.
-    int Tid = 1;
+    // longest one. Their ids follow the ids of the threads.
+    uint64_t Tid = MaxTid + 1;
     std::vector<NameAndCountAndDurationType> SortedTotals;
     SortedTotals.reserve(CountAndTotalPerName.size());
     for (const auto &E : CountAndTotalPerName)
@@ -127,7 +241,7 @@ struct TimeTraceProfiler {
 
       J.object([&]{
         J.attribute("pid", 1);
-        J.attribute("tid", Tid);
+        J.attribute("tid", int64_t(Tid));
         J.attribute("ph", "X");
         J.attribute("ts", 0);
         J.attribute("dur", DurUs);
@@ -152,14 +266,29 @@ struct TimeTraceProfiler {
       J.attributeObject("args", [&] { J.attribute("name", "clang"); });
     });
 
+    // And the names of the threads, so that they can be told apart.
+    for (const ThreadTimeTraceProfiler *TP : ThreadProfilers)
+      J.object([&] {
+        J.attribute("cat", "");
+        J.attribute("pid", 1);
+        J.attribute("tid", int64_t(TP->Tid));
+        J.attribute("ts", 0);
+        J.attribute("ph", "M");
+        J.attribute("name", "thread_name");
+        J.attributeObject("args", [&] {
+          J.attribute("name", TP->ThreadName.empty()
+                                  ? "thread " + std::to_string(TP->Tid)
+                                  : TP->ThreadName);
+        });
+      });
+
     J.arrayEnd();
     J.attributeEnd();
     J.objectEnd();
   }
 
-  SmallVector<Entry, 16> Stack;
-  SmallVector<Entry, 128> Entries;
-  StringMap<CountAndDurationType> CountAndTotalPerName;
+  std::atomic<ThreadTimeTraceProfiler *> Threads{nullptr};
+  const uint64_t ID = NextProfilerID++;
   time_point<steady_clock> StartTime;
 };
 
@@ -182,18 +311,31 @@ void timeTraceProfilerWrite(raw_pwrite_stream &OS) {
 
 void timeTraceProfilerBegin(StringRef Name, StringRef Detail) {
   if (TimeTraceProfilerInstance != nullptr)
-    TimeTraceProfilerInstance->begin(Name, [&]() { return Detail; });
+    TimeTraceProfilerInstance->getThreadProfiler().begin(
+        Name, [&]() { return Detail; });
 }
 
 void timeTraceProfilerBegin(StringRef Name,
                             llvm::function_ref<std::string()> Detail) {
   if (TimeTraceProfilerInstance != nullptr)
-    TimeTraceProfilerInstance->begin(Name, Detail);
+    TimeTraceProfilerInstance->getThreadProfiler().begin(Name, Detail);
 }
 
 void timeTraceProfilerEnd() {
   if (TimeTraceProfilerInstance != nullptr)
-    TimeTraceProfilerInstance->end();
+    TimeTraceProfilerInstance->getThreadProfiler().end();
+}
+
+void timeTraceProfilerInstant(StringRef Name, StringRef Detail) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->getThreadProfiler().Instants.push_back(
+        {steady_clock::now(), Name, Detail});
+}
+
+void timeTraceProfilerCounter(StringRef Name, int64_t Value) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->getThreadProfiler().Counters.push_back(
+        {steady_clock::now(), Name, Value});
 }
 
 } // namespace llvm
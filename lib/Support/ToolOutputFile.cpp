@@ -41,5 +41,20 @@ ToolOutputFile::ToolOutputFile(StringRef Filename, std::error_code &EC,
     Installer.Keep = true;
 }
 
+ToolOutputFile::ToolOutputFile(StringRef Filename, std::error_code &EC,
+                               sys::fs::OpenFlags Flags, bool Mapped)
+    : Installer(Filename),
+      OS(Filename, EC, sys::fs::CD_CreateAlways,
+         Mapped ? sys::fs::FA_Read | sys::fs::FA_Write : sys::fs::FA_Write,
+         Flags) {
+  // If open fails, no cleanup is needed.
+  if (EC) {
+    Installer.Keep = true;
+    return;
+  }
+  if (Mapped)
+    (void)OS.enableMappedOutput();
+}
+
 ToolOutputFile::ToolOutputFile(StringRef Filename, int FD)
     : Installer(Filename), OS(FD, true) {}
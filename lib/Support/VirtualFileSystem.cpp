@@ -517,6 +517,236 @@ directory_iterator OverlayFileSystem::dir_begin(const Twine &Dir,
 
 void ProxyFileSystem::anchor() {}
 
+//===-----------------------------------------------------------------------===/
+// CachingFileSystem implementation
+//===-----------------------------------------------------------------------===/
+
+CachingFileSystem::CachingFileSystem(IntrusiveRefCntPtr<FileSystem> FS,
+                                     Optional<bool> UseDirectoryListings)
+    : ProxyFileSystem(std::move(FS)) {
+#if defined(_WIN32) || defined(__APPLE__)
+  this->UseDirectoryListings = UseDirectoryListings.getValueOr(false);
+#else
+  this->UseDirectoryListings = UseDirectoryListings.getValueOr(true);
+#endif
+  ErrorOr<std::string> WD = getUnderlyingFS().getCurrentWorkingDirectory();
+  if (WD)
+    WorkingDirectory = std::move(*WD);
+}
+
+CachingFileSystem::~CachingFileSystem() = default;
+
+/// Whether a failed lookup may be cached: the path does not exist, rather
+/// than being temporarily unavailable.
+static bool isMissing(std::error_code EC) {
+  return EC == errc::no_such_file_or_directory || EC == errc::not_a_directory;
+}
+
+bool CachingFileSystem::getKey(const Twine &Path,
+                               SmallVectorImpl<char> &Key) const {
+  Path.toVector(Key);
+  if (!sys::path::is_absolute(Key)) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (!WorkingDirectory)
+      return false;
+    sys::fs::make_absolute(*WorkingDirectory, Key);
+  }
+  // '..' is kept, as it does not cancel out a symbolic link before it.
+  sys::path::remove_dots(Key);
+  return true;
+}
+
+bool CachingFileSystem::isMissingFromListing(StringRef Key) const {
+  if (!UseDirectoryListings)
+    return false;
+  // Any listed ancestor can tell that the path does not exist. Listings do
+  // not have '.' and '..', so the ancestors before those can't.
+  for (StringRef Path = Key, Parent = sys::path::parent_path(Path);
+       !Parent.empty() && Parent != Path;
+       Path = Parent, Parent = sys::path::parent_path(Path)) {
+    StringRef Name = sys::path::filename(Path);
+    if (Name == "." || Name == "..")
+      return false;
+    auto I = Listings.find(Parent);
+    if (I != Listings.end())
+      return !I->second->Names.count(Name);
+  }
+  return false;
+}
+
+std::shared_ptr<CachingFileSystem::DirectoryListing>
+CachingFileSystem::listDirectory(StringRef Dir, std::error_code &EC) {
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto I = Listings.find(Dir);
+    if (I != Listings.end()) {
+      EC = I->second->EC;
+      return I->second;
+    }
+  }
+
+  auto Listing = std::make_shared<DirectoryListing>();
+  directory_iterator End;
+  for (directory_iterator I = getUnderlyingFS().dir_begin(Dir, EC);
+       !EC && I != End; I.increment(EC)) {
+    Listing->Entries.push_back(*I);
+    Listing->Names.insert(sys::path::filename(I->path()));
+  }
+  // A directory that does not exist has no entries, which is worth knowing
+  // for the lookups in it.
+  if (EC && !isMissing(EC))
+    return nullptr;
+  Listing->EC = EC;
+
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto I = Listings.insert(std::make_pair(Dir, std::move(Listing))).first;
+  EC = I->second->EC;
+  return I->second;
+}
+
+void CachingFileSystem::recordStatus(StringRef Key, const ErrorOr<Status> &S) {
+  if (!S && !isMissing(S.getError()))
+    return;
+  std::lock_guard<std::mutex> Lock(Mutex);
+  Statuses.insert(std::make_pair(Key, S));
+}
+
+ErrorOr<Status> CachingFileSystem::status(const Twine &Path) {
+  SmallString<256> Key;
+  if (!getKey(Path, Key))
+    return getUnderlyingFS().status(Path);
+
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto I = Statuses.find(Key);
+    if (I != Statuses.end()) {
+      if (!I->second)
+        return I->second.getError();
+      return Status::copyWithNewName(*I->second, Path);
+    }
+    if (isMissingFromListing(Key))
+      return make_error_code(errc::no_such_file_or_directory);
+  }
+
+  ErrorOr<Status> S = getUnderlyingFS().status(Path);
+  recordStatus(Key, S);
+  // Other lookups in the same directory are likely to miss too, as when
+  // probing search paths, so list it to answer them.
+  if (!S && isMissing(S.getError()) && UseDirectoryListings) {
+    std::error_code EC;
+    StringRef Parent = sys::path::parent_path(Key);
+    if (!Parent.empty())
+      listDirectory(Parent, EC);
+  }
+  return S;
+}
+
+ErrorOr<std::unique_ptr<File>>
+CachingFileSystem::openFileForRead(const Twine &Path) {
+  SmallString<256> Key;
+  if (!getKey(Path, Key))
+    return getUnderlyingFS().openFileForRead(Path);
+
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto I = Statuses.find(Key);
+    if (I != Statuses.end() && !I->second)
+      return I->second.getError();
+    if (I == Statuses.end() && isMissingFromListing(Key))
+      return make_error_code(errc::no_such_file_or_directory);
+  }
+
+  ErrorOr<std::unique_ptr<File>> F = getUnderlyingFS().openFileForRead(Path);
+  if (!F)
+    recordStatus(Key, F.getError());
+  return F;
+}
+
+namespace {
+
+/// Iterates over a cached directory listing, with the paths of the entries
+/// spelled relative to the directory as it was given.
+class CachedDirIterImpl : public llvm::vfs::detail::DirIterImpl {
+  std::shared_ptr<const std::vector<directory_entry>> Entries;
+  std::string Dir;
+  size_t Index = 0;
+
+  void setCurrentEntry() {
+    if (Index == Entries->size()) {
+      CurrentEntry = directory_entry();
+      return;
+    }
+    const directory_entry &E = (*Entries)[Index];
+    SmallString<256> Path(Dir);
+    sys::path::append(Path, sys::path::filename(E.path()));
+    CurrentEntry = directory_entry(Path.str(), E.type());
+  }
+
+public:
+  CachedDirIterImpl(std::shared_ptr<const std::vector<directory_entry>> Entries,
+                    const Twine &Dir)
+      : Entries(std::move(Entries)), Dir(Dir.str()) {
+    setCurrentEntry();
+  }
+
+  std::error_code increment() override {
+    ++Index;
+    setCurrentEntry();
+    return {};
+  }
+};
+
+} // namespace
+
+directory_iterator CachingFileSystem::dir_begin(const Twine &Dir,
+                                                std::error_code &EC) {
+  SmallString<256> Key;
+  if (!getKey(Dir, Key))
+    return getUnderlyingFS().dir_begin(Dir, EC);
+
+  std::shared_ptr<DirectoryListing> Listing = listDirectory(Key, EC);
+  if (!Listing)
+    return getUnderlyingFS().dir_begin(Dir, EC);
+  if (EC)
+    return directory_iterator();
+  // Share the ownership of the listing, which may be invalidated meanwhile.
+  std::shared_ptr<const std::vector<directory_entry>> Entries(
+      Listing, &Listing->Entries);
+  return directory_iterator(
+      std::make_shared<CachedDirIterImpl>(std::move(Entries), Dir));
+}
+
+std::error_code
+CachingFileSystem::setCurrentWorkingDirectory(const Twine &Path) {
+  if (std::error_code EC = getUnderlyingFS().setCurrentWorkingDirectory(Path))
+    return EC;
+  ErrorOr<std::string> WD = getUnderlyingFS().getCurrentWorkingDirectory();
+  std::lock_guard<std::mutex> Lock(Mutex);
+  if (WD)
+    WorkingDirectory = std::move(*WD);
+  else
+    WorkingDirectory = None;
+  return {};
+}
+
+void CachingFileSystem::invalidate(const Twine &Path) {
+  SmallString<256> Key;
+  if (!getKey(Path, Key)) {
+    invalidateAll();
+    return;
+  }
+  std::lock_guard<std::mutex> Lock(Mutex);
+  Statuses.erase(Key);
+  Listings.erase(Key);
+  Listings.erase(sys::path::parent_path(Key));
+}
+
+void CachingFileSystem::invalidateAll() {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  Statuses.clear();
+  Listings.clear();
+}
+
 namespace llvm {
 namespace vfs {
 
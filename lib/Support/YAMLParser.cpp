@@ -797,6 +797,8 @@ Token &Scanner::peekNext() {
             "fetchMoreTokens lied about getting tokens!");
 
     removeStaleSimpleKeyCandidates();
+    if (SimpleKeys.empty())
+      break;
     SimpleKey SK;
     SK.Tok = TokenQueue.begin();
     if (!is_contained(SimpleKeys, SK))
@@ -922,7 +924,7 @@ void Scanner::scan_ns_uri_char() {
           && is_ns_hex_digit(*(Current + 1))
           && is_ns_hex_digit(*(Current + 2)))
         || is_ns_word_char(*Current)
-        || StringRef(Current, 1).find_first_of("#;/?:@&=+$,_.!~*'()[]")
+        || StringRef("#;/?:@&=+$,_.!~*'()[]").find(*Current)
           != StringRef::npos) {
       ++Current;
       ++Column;
@@ -984,6 +986,8 @@ void Scanner::saveSimpleKeyCandidate( TokenQueueT::iterator Tok
 }
 
 void Scanner::removeStaleSimpleKeyCandidates() {
+  if (SimpleKeys.empty())
+    return;
   for (SmallVectorImpl<SimpleKey>::iterator i = SimpleKeys.begin();
                                             i != SimpleKeys.end();) {
     if (i->Line != Line || i->Column + 1024 < Column) {
@@ -1335,6 +1339,17 @@ bool Scanner::scanPlainScalar() {
       break;
 
     while (!isBlankOrBreak(Current)) {
+      // Skip runs of printable ASCII characters which can't end the scalar.
+      StringRef::iterator Run = Current;
+      while (Current != End && *Current > 0x20 && *Current <= 0x7E &&
+             *Current != ':' &&
+             !(FlowLevel && StringRef(",?[]{}").find(*Current) !=
+                                StringRef::npos))
+        ++Current;
+      Column += Current - Run;
+      if (Current != Run)
+        continue;
+
       if (  FlowLevel && *Current == ':'
           && !(isBlankOrBreak(Current + 1) || *(Current + 1) == ',')) {
         setError("Found unexpected ':' while scanning a plain scalar", Current);
@@ -1344,8 +1359,7 @@ bool Scanner::scanPlainScalar() {
       // Check for the end of the plain scalar.
       if (  (*Current == ':' && isBlankOrBreak(Current + 1))
           || (  FlowLevel
-          && (StringRef(Current, 1).find_first_of(",:?[]{}")
-              != StringRef::npos)))
+          && (StringRef(",:?[]{}").find(*Current) != StringRef::npos)))
         break;
 
       StringRef::iterator i = skip_nb_char(Current);
@@ -1743,9 +1757,8 @@ bool Scanner::fetchMoreTokens() {
     return scanFlowScalar(true);
 
   // Get a plain scalar.
-  StringRef FirstChar(Current, 1);
   if (!(isBlankOrBreak(Current)
-        || FirstChar.find_first_of("-?:,[]{}#&*!|>'\"%@`") != StringRef::npos)
+        || StringRef("-?:,[]{}#&*!|>'\"%@`").find(*Current) != StringRef::npos)
       || (*Current == '-' && !isBlankOrBreak(Current + 1))
       || (!FlowLevel && (*Current == '?' || *Current == ':')
           && isBlankOrBreak(Current + 1))
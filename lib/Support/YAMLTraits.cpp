@@ -133,7 +133,9 @@ void Input::beginMapping() {
   // CurrentNode can be null if the document is empty.
   MapHNode *MN = dyn_cast_or_null<MapHNode>(CurrentNode);
   if (MN) {
-    MN->ValidKeys.clear();
+    for (MapHNode::Entry &E : MN->Mapping)
+      E.Used = false;
+    MN->NextEntry = 0;
   }
 }
 
@@ -144,8 +146,8 @@ std::vector<StringRef> Input::keys() {
     setError(CurrentNode, "not a mapping");
     return Ret;
   }
-  for (auto &P : MN->Mapping)
-    Ret.push_back(P.first());
+  for (const MapHNode::Entry &E : MN->Mapping)
+    Ret.push_back(E.Key);
   return Ret;
 }
 
@@ -169,17 +171,17 @@ bool Input::preflightKey(const char *Key, bool Required, bool, bool &UseDefault,
       setError(CurrentNode, "not a mapping");
     return false;
   }
-  MN->ValidKeys.push_back(Key);
-  HNode *Value = MN->Mapping[Key].get();
-  if (!Value) {
+  MapHNode::Entry *E = MN->find(Key);
+  if (!E) {
     if (Required)
       setError(CurrentNode, Twine("missing required key '") + Key + "'");
     else
       UseDefault = true;
     return false;
   }
+  E->Used = true;
   SaveInfo = CurrentNode;
-  CurrentNode = Value;
+  CurrentNode = E->Value.get();
   return true;
 }
 
@@ -194,14 +196,34 @@ void Input::endMapping() {
   MapHNode *MN = dyn_cast_or_null<MapHNode>(CurrentNode);
   if (!MN)
     return;
-  for (const auto &NN : MN->Mapping) {
-    if (!is_contained(MN->ValidKeys, NN.first())) {
-      setError(NN.second.get(), Twine("unknown key '") + NN.first() + "'");
-      break;
-    }
+  for (const MapHNode::Entry &E : MN->Mapping) {
+    if (E.Used)
+      continue;
+    // A key which is repeated is only used once.
+    bool Duplicate = std::any_of(
+        MN->Mapping.begin(), MN->Mapping.end(),
+        [&](const MapHNode::Entry &O) { return O.Used && O.Key == E.Key; });
+    setError(E.Value.get(), Twine(Duplicate ? "duplicated mapping key '"
+                                            : "unknown key '") +
+                                E.Key + "'");
+    break;
   }
 }
 
+Input::MapHNode::Entry *Input::MapHNode::find(StringRef Key) {
+  for (unsigned I = NextEntry, E = Mapping.size(); I != E; ++I)
+    if (Mapping[I].Key == Key) {
+      NextEntry = I + 1;
+      return &Mapping[I];
+    }
+  for (unsigned I = 0; I != NextEntry; ++I)
+    if (Mapping[I].Key == Key) {
+      NextEntry = I + 1;
+      return &Mapping[I];
+    }
+  return nullptr;
+}
+
 void Input::beginFlowMapping() { beginMapping(); }
 
 void Input::endFlowMapping() { endMapping(); }
@@ -412,7 +434,7 @@ std::unique_ptr<Input::HNode> Input::createHNodes(Node *N) {
       auto ValueHNode = createHNodes(Value);
       if (EC)
         break;
-      mapHNode->Mapping[KeyStr] = std::move(ValueHNode);
+      mapHNode->Mapping.emplace_back(KeyStr, std::move(ValueHNode));
     }
     return std::move(mapHNode);
   } else if (isa<NullNode>(N)) {
@@ -16,6 +16,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/Errc.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
@@ -592,6 +593,8 @@ raw_fd_ostream::raw_fd_ostream(int fd, bool shouldClose, bool unbuffered)
 raw_fd_ostream::~raw_fd_ostream() {
   if (FD >= 0) {
     flush();
+    if (Mapping)
+      exitMappedOutput();
     if (ShouldClose) {
       if (auto EC = sys::Process::SafelyCloseFileDescriptor(FD))
         error_detected(EC);
@@ -667,6 +670,10 @@ static bool write_console_impl(int FD, StringRef Data) {
 
 void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
   assert(FD >= 0 && "File already closed.");
+  if (Mapping) {
+    write_mapped(Ptr, Size);
+    return;
+  }
   pos += Size;
 
 #if defined(_WIN32)
@@ -725,6 +732,8 @@ void raw_fd_ostream::close() {
   assert(ShouldClose);
   ShouldClose = false;
   flush();
+  if (Mapping)
+    exitMappedOutput();
   if (auto EC = sys::Process::SafelyCloseFileDescriptor(FD))
     error_detected(EC);
   FD = -1;
@@ -733,6 +742,18 @@ void raw_fd_ostream::close() {
 uint64_t raw_fd_ostream::seek(uint64_t off) {
   assert(SupportsSeeking && "Stream does not support seeking!");
   flush();
+  if (Mapping) {
+    pos = off;
+    if (off < MappingOffset || off >= MappingOffset + Mapping->size()) {
+      if (std::error_code EC = mapWindowAt(off)) {
+        error_detected(EC);
+        exitMappedOutput();
+        return pos;
+      }
+    }
+    resetMappedBuffer();
+    return pos;
+  }
 #ifdef _WIN32
   pos = ::_lseeki64(FD, off, SEEK_SET);
 #elif defined(HAVE_LSEEK64)
@@ -745,6 +766,108 @@ uint64_t raw_fd_ostream::seek(uint64_t off) {
   return pos;
 }
 
+// Mapped windows start at 1MB and double up to 256MB, or 16MB on hosts with
+// a 32-bit address space, so small outputs don't reserve much disk space and
+// large ones remap rarely.
+static const size_t MinMappedChunkSize = 1 << 20;
+static const size_t MaxMappedChunkSize =
+    sizeof(void *) >= 8 ? size_t(1) << 28 : size_t(1) << 24;
+
+std::error_code raw_fd_ostream::enableMappedOutput() {
+  if (Mapping)
+    return std::error_code();
+  if (FD < 0 || !SupportsSeeking)
+    return make_error_code(errc::not_supported);
+  sys::fs::file_status Status;
+  if (std::error_code EC = sys::fs::status(FD, Status))
+    return EC;
+  if (Status.type() != sys::fs::file_type::regular_file)
+    return make_error_code(errc::not_supported);
+
+  flush();
+  // Data already in the file is kept, even if it is past the current
+  // position.
+  MappedFileSize = Status.getSize();
+  MappedDataEnd = std::max(MappedFileSize, pos);
+  MappedChunkSize = MinMappedChunkSize;
+  if (std::error_code EC = mapWindowAt(pos)) {
+    // Undo any extension of the file.
+    if (MappedFileSize != Status.getSize())
+      sys::fs::resize_file(FD, Status.getSize());
+    return EC;
+  }
+  resetMappedBuffer();
+  return std::error_code();
+}
+
+std::error_code raw_fd_ostream::mapWindowAt(uint64_t Offset) {
+  Mapping.reset();
+  uint64_t Start = alignDown(Offset, sys::fs::mapped_file_region::alignment());
+  uint64_t End = alignTo(Start + MappedChunkSize,
+                         sys::fs::mapped_file_region::alignment());
+  assert(Offset < End && "window does not contain Offset");
+  if (End > MappedFileSize) {
+    if (std::error_code EC = sys::fs::resize_file(FD, End))
+      return EC;
+    MappedFileSize = End;
+  }
+
+  std::error_code EC;
+  auto Region = llvm::make_unique<sys::fs::mapped_file_region>(
+      FD, sys::fs::mapped_file_region::readwrite, End - Start, Start, EC);
+  if (EC)
+    return EC;
+  Mapping = std::move(Region);
+  MappingOffset = Start;
+  MappedChunkSize = std::min(MappedChunkSize * 2, MaxMappedChunkSize);
+  return std::error_code();
+}
+
+void raw_fd_ostream::resetMappedBuffer() {
+  uint64_t Used = pos - MappingOffset;
+  SetBuffer(Mapping->data() + Used, Mapping->size() - Used);
+}
+
+void raw_fd_ostream::write_mapped(const char *Ptr, size_t Size) {
+  while (true) {
+    uint64_t Used = pos - MappingOffset;
+    size_t Bytes = std::min<uint64_t>(Size, Mapping->size() - Used);
+    // When flushing, the data is already in place: the buffer is the mapping.
+    char *Dst = Mapping->data() + Used;
+    if (Dst != Ptr)
+      memcpy(Dst, Ptr, Bytes);
+    Ptr += Bytes;
+    Size -= Bytes;
+    pos += Bytes;
+    MappedDataEnd = std::max(MappedDataEnd, pos);
+
+    if (pos == MappingOffset + Mapping->size()) {
+      if (std::error_code EC = mapWindowAt(pos)) {
+        // Report the error and fall back to ordinary writes, which will most
+        // likely fail in the same way.
+        error_detected(EC);
+        exitMappedOutput();
+        if (Size)
+          write_impl(Ptr, Size);
+        return;
+      }
+    }
+    if (!Size)
+      break;
+  }
+  resetMappedBuffer();
+}
+
+void raw_fd_ostream::exitMappedOutput() {
+  assert(GetNumBytesInBuffer() == 0 && "unflushed mapped output");
+  Mapping.reset();
+  SetBuffered();
+  if (std::error_code EC = sys::fs::resize_file(FD, MappedDataEnd))
+    error_detected(EC);
+  // Leave the file descriptor positioned where the stream is.
+  seek(pos);
+}
+
 void raw_fd_ostream::pwrite_impl(const char *Ptr, size_t Size,
                                  uint64_t Offset) {
   uint64_t Pos = tell();
@@ -3397,7 +3397,7 @@ void NewGVN::iterateTouchedInstructions() {
       updateProcessedCount(V);
     }
   }
-  NumGVNMaxIterations = std::max(NumGVNMaxIterations.getValue(), Iterations);
+  NumGVNMaxIterations.updateMax(Iterations);
 }
 
 // This is the main transformation entry point.
@@ -0,0 +1,46 @@
+; Printing the functions on other threads must give the same text as printing
+; them on one thread.
+; RUN: llvm-as < %S/../Bitcode/compatibility.ll | llvm-dis > %t.serial.ll
+; RUN: llvm-as < %S/../Bitcode/compatibility.ll | llvm-dis -asm-print-threads=4 > %t.threads.ll
+; RUN: cmp %t.serial.ll %t.threads.ll
+; RUN: llvm-as < %s | llvm-dis -asm-print-threads=2 | FileCheck %s
+
+; CHECK: define i32 @f(i32) #0 {
+; CHECK-NEXT: %2 = add i32 %0, 1, !bar !0
+; CHECK-NEXT: %3 = call i32 @g(i32 %2) #1
+define i32 @f(i32) #0 {
+  %2 = add i32 %0, 1, !bar !0
+  %3 = call i32 @g(i32 %2) #1
+  ret i32 %3
+}
+
+; CHECK: define i32 @g(i32 %x) #0 {
+; CHECK-NEXT: %1 = add i32 %x, 2, !foo !1
+define i32 @g(i32 %x) #0 {
+  %1 = add i32 %x, 2, !foo !1
+  ret i32 %1
+}
+
+; Elements of data constants are printed without creating constants for them.
+; CHECK: define void @h(<4 x i32>* %p, [3 x double]* %q, <2 x half>* %r) {
+; CHECK-NEXT: %1 = add <4 x i32> <i32 1, i32 -2, i32 3, i32 4>, <i32 5, i32 6, i32 7, i32 8>
+; CHECK-NEXT: store <4 x i32> %1, <4 x i32>* %p
+; CHECK-NEXT: store [3 x double] [double 1.500000e+00, double 0x7FF8000000000000, double -0.000000e+00], [3 x double]* %q
+; CHECK-NEXT: store <2 x half> <half 0xH3C00, half 0xH7C00>, <2 x half>* %r
+define void @h(<4 x i32>* %p, [3 x double]* %q, <2 x half>* %r) {
+  %1 = add <4 x i32> <i32 1, i32 -2, i32 3, i32 4>, <i32 5, i32 6, i32 7, i32 8>
+  store <4 x i32> %1, <4 x i32>* %p
+  store [3 x double] [double 1.5, double 0x7FF8000000000000, double -0.0], [3 x double]* %q
+  store <2 x half> <half 0xH3C00, half 0xH7C00>, <2 x half>* %r
+  ret void
+}
+
+; CHECK: attributes #0 = { nounwind }
+; CHECK: attributes #1 = { cold }
+attributes #0 = { nounwind }
+attributes #1 = { cold }
+
+; CHECK: !0 = !{!"f"}
+; CHECK: !1 = !{!"g"}
+!0 = !{!"f"}
+!1 = !{!"g"}
@@ -0,0 +1,22 @@
+; Decoding the function blocks ahead of time on other threads must give the
+; same module as reading them on demand.
+; RUN: llvm-as < %S/compatibility.ll > %t.bc
+; RUN: llvm-dis %t.bc -o %t.serial.ll
+; RUN: llvm-dis -bitcode-materialize-threads=4 %t.bc -o %t.threads.ll
+; RUN: diff %t.serial.ll %t.threads.ll
+; RUN: llvm-as < %s | llvm-dis -bitcode-materialize-threads=1 | FileCheck %s
+
+; CHECK: define i32 @f(i32 %x)
+; CHECK-NEXT: %y = add i32 %x, 1
+; CHECK-NEXT: %z = call i32 @g(i32 %y)
+define i32 @f(i32 %x) {
+  %y = add i32 %x, 1
+  %z = call i32 @g(i32 %y)
+  ret i32 %z
+}
+
+; CHECK: define i32 @g(i32 %x)
+; CHECK: ret i32 %x
+define i32 @g(i32 %x) {
+  ret i32 %x
+}
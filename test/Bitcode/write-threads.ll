@@ -0,0 +1,24 @@
+; Writing the function blocks on other threads must give the same bitcode as
+; writing them on one thread.
+; RUN: llvm-as < %S/compatibility.ll > %t.serial.bc
+; RUN: llvm-as -bitcode-write-threads=4 < %S/compatibility.ll > %t.threads.bc
+; RUN: cmp %t.serial.bc %t.threads.bc
+; RUN: llvm-as < %s > %t.serial.bc
+; RUN: llvm-as -bitcode-write-threads=2 < %s > %t.threads.bc
+; RUN: cmp %t.serial.bc %t.threads.bc
+; RUN: llvm-dis < %t.threads.bc | FileCheck %s
+
+; CHECK: define i32 @f(i32 %x)
+; CHECK-NEXT: %y = add i32 %x, 1
+; CHECK-NEXT: %z = call i32 @g(i32 %y)
+define i32 @f(i32 %x) {
+  %y = add i32 %x, 1
+  %z = call i32 @g(i32 %y)
+  ret i32 %z
+}
+
+; CHECK: define i32 @g(i32 %x)
+; CHECK: ret i32 %x
+define i32 @g(i32 %x) {
+  ret i32 %x
+}
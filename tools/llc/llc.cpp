@@ -106,6 +106,10 @@ static cl::opt<std::string> SplitDwarfFile(
 static cl::opt<bool> NoVerify("disable-verify", cl::Hidden,
                               cl::desc("Do not verify input module"));
 
+static cl::opt<bool>
+    MappedOutput("mmap-output", cl::Hidden,
+                 cl::desc("Write the output file through a memory mapping"));
+
 static cl::opt<bool> DisableSimplifyLibCalls("disable-simplify-libcalls",
                                              cl::desc("Disable simplify-libcalls"));
 
@@ -242,7 +246,8 @@ static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
   sys::fs::OpenFlags OpenFlags = sys::fs::F_None;
   if (!Binary)
     OpenFlags |= sys::fs::F_Text;
-  auto FDOut = llvm::make_unique<ToolOutputFile>(OutputFilename, EC, OpenFlags);
+  auto FDOut = llvm::make_unique<ToolOutputFile>(OutputFilename, EC, OpenFlags,
+                                                 MappedOutput);
   if (EC) {
     WithColor::error() << EC.message() << '\n';
     return nullptr;
@@ -48,6 +48,10 @@ Force("f", cl::desc("Enable binary output on terminals"));
 static cl::opt<bool>
 DontPrint("disable-output", cl::desc("Don't output the .ll file"), cl::Hidden);
 
+static cl::opt<bool>
+    MappedOutput("mmap-output", cl::Hidden,
+                 cl::desc("Write the output file through a memory mapping"));
+
 static cl::opt<bool>
     SetImporting("set-importing",
                  cl::desc("Set lazy loading to pretend to import a module"),
@@ -186,7 +190,7 @@ int main(int argc, char **argv) {
 
   std::error_code EC;
   std::unique_ptr<ToolOutputFile> Out(
-      new ToolOutputFile(OutputFilename, EC, sys::fs::F_None));
+      new ToolOutputFile(OutputFilename, EC, sys::fs::F_None, MappedOutput));
   if (EC) {
     errs() << EC.message() << '\n';
     return 1;
@@ -7,20 +7,27 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <thread>
 using namespace llvm;
 
-using OptionalStatistic = Optional<std::pair<StringRef, unsigned>>;
+using OptionalStatistic = Optional<std::pair<StringRef, uint64_t>>;
 
 namespace {
 #define DEBUG_TYPE "unittest"
 STATISTIC(Counter, "Counts things");
 STATISTIC(Counter2, "Counts other things");
+STATISTIC(Maximum, "Largest thing");
+STATISTIC_HISTOGRAM(Sizes, "Sizes of things");
 
 #if LLVM_ENABLE_STATS
 static void
-extractCounters(const std::vector<std::pair<StringRef, unsigned>> &Range,
+extractCounters(const std::vector<std::pair<StringRef, uint64_t>> &Range,
                 OptionalStatistic &S1, OptionalStatistic &S2) {
   for (const auto &S : Range) {
     if (S.first == "Counter")
@@ -156,4 +163,133 @@ TEST(StatisticTest, API) {
 #endif
 }
 
+TEST(StatisticTest, Max) {
+  EnableStatistics();
+
+  Maximum = 0;
+  Maximum.updateMax(3);
+  Maximum.updateMax(1);
+#if LLVM_ENABLE_STATS
+  EXPECT_EQ(Maximum, 3u);
+#else
+  EXPECT_EQ(Maximum, 0u);
+#endif
+}
+
+TEST(StatisticTest, Histogram) {
+  EnableStatistics();
+
+  Sizes.record(0);
+  Sizes.record(1);
+  Sizes.record(5);
+  Sizes.record(7);
+  Sizes.record(uint64_t(1) << 40);
+#if LLVM_ENABLE_STATS
+  EXPECT_EQ(Sizes.getCount(), 5u);
+  EXPECT_EQ(Sizes.getSum(), 13u + (uint64_t(1) << 40));
+  EXPECT_EQ(Sizes.getBucketCount(0), 1u);
+  EXPECT_EQ(Sizes.getBucketCount(1), 1u);
+  EXPECT_EQ(Sizes.getBucketCount(3), 2u);
+  EXPECT_EQ(Sizes.getBucketCount(41), 1u);
+#else
+  EXPECT_EQ(Sizes.getCount(), 0u);
+#endif
+}
+
+#if LLVM_ENABLE_STATS && LLVM_ENABLE_THREADS
+TEST(StatisticTest, Threads) {
+  EnableStatistics();
+
+  Counter = 5;
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I != 4; ++I)
+    Threads.emplace_back([] {
+      for (unsigned J = 0; J != 1000; ++J)
+        ++Counter;
+      Counter += 10;
+    });
+  for (std::thread &T : Threads)
+    T.join();
+  EXPECT_EQ(Counter, 5u + 4 * 1010);
+
+  // Assignments account for the counts of all threads.
+  Counter = 1;
+  EXPECT_EQ(Counter, 1u);
+  --Counter;
+  EXPECT_EQ(Counter, 0u);
+}
+#endif
+
+static std::string writeStatsFile(const Twine &Contents) {
+  int FD;
+  SmallString<128> Path;
+  EXPECT_FALSE(sys::fs::createTemporaryFile("stats", "json", FD, Path));
+  raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  OS << Contents;
+  return Path.str();
+}
+
+TEST(StatisticTest, MergeFiles) {
+  // The buckets of histograms with values of 0 only.
+  std::string Zeros;
+  for (unsigned I = 1; I != HistogramStatistic::NumBuckets; ++I)
+    Zeros += ",0";
+  std::string Buckets1 = "[1" + Zeros + "]", Buckets2 = "[2" + Zeros + "]";
+  std::vector<std::string> Inputs = {
+      writeStatsFile(R"({"version":1,"invocations":1,"counters":{"a.x":3},)"
+                     R"("maxima":{"a.m":7},"histograms":{"a.h":{"count":1,)"
+                     R"("sum":0,"buckets":)" + Buckets1 + "}}}"),
+      writeStatsFile(R"({"version":1,"invocations":2,"counters":{"a.x":4,)"
+                     R"("b.y":1},"maxima":{"a.m":5},"histograms":{"a.h":)"
+                     R"({"count":2,"sum":0,"buckets":)" + Buckets2 + "}}}")};
+
+  std::string Output;
+  raw_string_ostream OS(Output);
+  ASSERT_FALSE(errorToBool(MergeStatisticsFiles(Inputs, OS)));
+  Expected<json::Value> Merged = json::parse(OS.str());
+  ASSERT_TRUE(bool(Merged));
+  const json::Object *Obj = Merged->getAsObject();
+  ASSERT_TRUE(Obj);
+  EXPECT_EQ(*Obj->getInteger("invocations"), 3);
+  EXPECT_EQ(*Obj->getObject("counters")->getInteger("a.x"), 7);
+  EXPECT_EQ(*Obj->getObject("counters")->getInteger("b.y"), 1);
+  EXPECT_EQ(*Obj->getObject("maxima")->getInteger("a.m"), 7);
+  const json::Object *H = Obj->getObject("histograms")->getObject("a.h");
+  ASSERT_TRUE(H);
+  EXPECT_EQ(*H->getInteger("count"), 3);
+  EXPECT_EQ(*(*H->getArray("buckets"))[0].getAsInteger(), 3);
+
+  // Files of another version are rejected.
+  Inputs.push_back(writeStatsFile(R"({"version":2})"));
+  EXPECT_TRUE(errorToBool(MergeStatisticsFiles(Inputs, OS)));
+
+  for (const std::string &Input : Inputs)
+    sys::fs::remove(Input);
+}
+
+TEST(StatisticTest, MergeIntoFile) {
+  EnableStatistics();
+
+  Counter = 2;
+  SmallString<128> Path;
+  ASSERT_FALSE(
+      sys::fs::getPotentiallyUniqueTempFileName("stats", "json", Path));
+  ASSERT_FALSE(errorToBool(MergeStatisticsIntoFile(Path)));
+  ASSERT_FALSE(errorToBool(MergeStatisticsIntoFile(Path)));
+
+  std::string Output;
+  raw_string_ostream OS(Output);
+  ASSERT_FALSE(errorToBool(MergeStatisticsFiles({Path.str()}, OS)));
+  Expected<json::Value> Merged = json::parse(OS.str());
+  ASSERT_TRUE(bool(Merged));
+  const json::Object *Obj = Merged->getAsObject();
+  EXPECT_EQ(*Obj->getInteger("invocations"), 2);
+#if LLVM_ENABLE_STATS
+  EXPECT_EQ(*Obj->getObject("counters")->getInteger("unittest.Counter"), 4);
+#else
+  EXPECT_FALSE(Obj->getObject("counters")->getInteger("unittest.Counter"));
+#endif
+  sys::fs::remove(Path);
+}
+
 } // end anonymous namespace
@@ -516,4 +516,27 @@ TEST(StringMapCustomTest, StringMapEntrySize) {
   EXPECT_EQ(LargeValue, Key.size());
 }
 
+TEST(StringMapCustomTest, PrecomputedHash) {
+  StringMap<int> Map1, Map2;
+  StringRef Key = "a key that is looked up in several maps";
+  uint32_t Hash = StringMapImpl::hash(Key);
+
+  EXPECT_TRUE(Map1.try_emplace_with_hash(Key, Hash, 1).second);
+  EXPECT_FALSE(Map1.try_emplace_with_hash(Key, Hash, 2).second);
+  EXPECT_TRUE(Map2.try_emplace_with_hash(Key, Hash, 3).second);
+
+  EXPECT_EQ(1, Map1.find(Key, Hash)->second);
+  EXPECT_EQ(3, Map2.find(Key, Hash)->second);
+  // Entries inserted with a precomputed hash can be found without one, and
+  // the other way around.
+  EXPECT_EQ(1, Map1.lookup(Key));
+  Map1.insert(std::make_pair("other", 4));
+  EXPECT_EQ(4, Map1.find("other", StringMapImpl::hash("other"))->second);
+
+  const StringMap<int> &ConstMap = Map2;
+  EXPECT_EQ(3, ConstMap.find(Key, Hash)->second);
+  EXPECT_TRUE(ConstMap.find("missing", StringMapImpl::hash("missing")) ==
+              ConstMap.end());
+}
+
 } // end anonymous namespace
@@ -0,0 +1,176 @@
+//===- llvm/unittest/ADT/SwissTableMapTest.cpp - SwissTableMap tests ------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SwissTableMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "gtest/gtest.h"
+#include <map>
+#include <memory>
+#include <random>
+
+using namespace llvm;
+
+namespace {
+
+TEST(SwissTableMapTest, EmptyMap) {
+  SwissTableMap<unsigned, unsigned> M;
+  EXPECT_TRUE(M.empty());
+  EXPECT_EQ(0u, M.size());
+  EXPECT_EQ(0u, M.getNumBuckets());
+  EXPECT_TRUE(M.begin() == M.end());
+  EXPECT_EQ(0u, M.count(1));
+  EXPECT_TRUE(M.find(1) == M.end());
+  EXPECT_EQ(0u, M.lookup(1));
+}
+
+TEST(SwissTableMapTest, InsertFindErase) {
+  SwissTableMap<unsigned, unsigned> M;
+  EXPECT_TRUE(M.insert(std::make_pair(1u, 2u)).second);
+  EXPECT_FALSE(M.insert(std::make_pair(1u, 3u)).second);
+  EXPECT_EQ(1u, M.size());
+  EXPECT_EQ(2u, M.lookup(1));
+  EXPECT_EQ(1u, M.find(1)->first);
+  EXPECT_EQ(2u, M.find(1)->second);
+
+  M[5] = 6;
+  EXPECT_EQ(6u, M.lookup(5));
+  EXPECT_EQ(2u, M.size());
+
+  EXPECT_TRUE(M.erase(1));
+  EXPECT_FALSE(M.erase(1));
+  EXPECT_EQ(0u, M.count(1));
+  EXPECT_EQ(1u, M.size());
+
+  M.erase(M.find(5));
+  EXPECT_TRUE(M.empty());
+}
+
+// Keys that are DenseMapInfo's empty and tombstone keys are fine, since the
+// bucket state lives in the control bytes.
+TEST(SwissTableMapTest, SentinelKeys) {
+  SwissTableMap<unsigned, unsigned> M;
+  M[DenseMapInfo<unsigned>::getEmptyKey()] = 1;
+  M[DenseMapInfo<unsigned>::getTombstoneKey()] = 2;
+  EXPECT_EQ(2u, M.size());
+  EXPECT_EQ(1u, M.lookup(DenseMapInfo<unsigned>::getEmptyKey()));
+  EXPECT_EQ(2u, M.lookup(DenseMapInfo<unsigned>::getTombstoneKey()));
+}
+
+TEST(SwissTableMapTest, MatchesStdMap) {
+  // Random insertions and deletions, checked against std::map. The key range
+  // is small enough to create many collisions and deleted buckets.
+  SwissTableMap<unsigned, unsigned> M;
+  std::map<unsigned, unsigned> Ref;
+  std::mt19937 Rng(0);
+  for (unsigned I = 0; I < 100000; ++I) {
+    unsigned Key = Rng() % 5000;
+    if (Rng() % 3 == 0) {
+      EXPECT_EQ(Ref.erase(Key) != 0, M.erase(Key));
+    } else {
+      M[Key] = I;
+      Ref[Key] = I;
+    }
+    ASSERT_EQ(Ref.size(), M.size());
+  }
+  for (const auto &KV : Ref)
+    EXPECT_EQ(KV.second, M.lookup(KV.first));
+
+  unsigned Count = 0;
+  for (const auto &KV : M) {
+    EXPECT_EQ(Ref[KV.first], KV.second);
+    ++Count;
+  }
+  EXPECT_EQ(Ref.size(), Count);
+}
+
+TEST(SwissTableMapTest, PointerKeys) {
+  std::vector<std::unique_ptr<int>> Objects;
+  SwissTableMap<int *, unsigned> M;
+  for (unsigned I = 0; I < 1000; ++I) {
+    Objects.push_back(llvm::make_unique<int>(I));
+    M[Objects.back().get()] = I;
+  }
+  for (unsigned I = 0; I < 1000; ++I)
+    EXPECT_EQ(I, M.lookup(Objects[I].get()));
+  int NotInMap;
+  EXPECT_EQ(0u, M.count(&NotInMap));
+}
+
+TEST(SwissTableMapTest, StringRefKeys) {
+  SwissTableMap<StringRef, int> M;
+  M["a"] = 1;
+  M["b"] = 2;
+  M[""] = 3;
+  EXPECT_EQ(1, M.lookup("a"));
+  EXPECT_EQ(2, M.lookup("b"));
+  EXPECT_EQ(3, M.lookup(""));
+  EXPECT_EQ(0, M.lookup("c"));
+}
+
+TEST(SwissTableMapTest, NonTrivialValues) {
+  SwissTableMap<unsigned, std::string> M;
+  for (unsigned I = 0; I < 100; ++I)
+    M[I] = std::string(I, 'x');
+  SwissTableMap<unsigned, std::string> Copy(M);
+  SwissTableMap<unsigned, std::string> Moved(std::move(M));
+  EXPECT_TRUE(M.empty());
+  for (unsigned I = 0; I < 100; ++I) {
+    EXPECT_EQ(I, Copy[I].size());
+    EXPECT_EQ(I, Moved[I].size());
+  }
+  Copy.clear();
+  EXPECT_TRUE(Copy.empty());
+  EXPECT_TRUE(Copy.begin() == Copy.end());
+  Copy = Moved;
+  EXPECT_EQ(100u, Copy.size());
+}
+
+TEST(SwissTableMapTest, TryEmplace) {
+  SwissTableMap<unsigned, std::unique_ptr<unsigned>> M;
+  auto Try1 = M.try_emplace(0, new unsigned(5));
+  EXPECT_TRUE(Try1.second);
+  auto Try2 = M.try_emplace(0, new unsigned(6));
+  EXPECT_FALSE(Try2.second);
+  EXPECT_EQ(Try1.first, Try2.first);
+  EXPECT_EQ(5u, *Try1.first->second);
+}
+
+TEST(SwissTableMapTest, Reserve) {
+  SwissTableMap<unsigned, unsigned> M;
+  M.reserve(1000);
+  unsigned NumBuckets = M.getNumBuckets();
+  EXPECT_LE(1000u, NumBuckets - NumBuckets / 8);
+  for (unsigned I = 0; I < 1000; ++I)
+    M[I] = I;
+  EXPECT_EQ(NumBuckets, M.getNumBuckets());
+}
+
+TEST(SwissTableMapTest, EraseKeepsSize) {
+  // Repeatedly inserting and erasing must not grow the table forever; deleted
+  // buckets are reclaimed by rehashing in place once the table is less than
+  // half full.
+  SwissTableMap<unsigned, unsigned> M;
+  for (unsigned I = 0; I < 64; ++I)
+    M[I] = I;
+  unsigned NumBuckets = M.getNumBuckets();
+  for (unsigned I = 64; I < 100000; ++I) {
+    M[I] = I;
+    M.erase(I - 64);
+  }
+  EXPECT_EQ(64u, M.size());
+  EXPECT_GE(2 * NumBuckets, M.getNumBuckets());
+}
+
+TEST(SwissTableMapTest, InitializerList) {
+  SwissTableMap<int, int> M = {{0, 1}, {1, 2}};
+  EXPECT_EQ(2u, M.size());
+  EXPECT_EQ(1, M.lookup(0));
+  EXPECT_EQ(2, M.lookup(1));
+}
+
+} // namespace
@@ -414,4 +414,53 @@ TEST(AsmParserTest, TypeAtBeginningWithSlotMappingParsing) {
   ASSERT_TRUE(Read == 4);
 }
 
+TEST(AsmParserTest, NamesAndStrings) {
+  // Names and strings longer than 16 bytes, with and without escapes, and
+  // with names and comments at chunk boundaries and at the end of input.
+  LLVMContext Ctx;
+  StringRef Source =
+      "@a_rather_long_global_variable_name.with$dots-and-dashes = "
+      "global [19 x i8] c\"a string of twenty\\21\"\n"
+      "@\"an escaped \\22name\\22 that is long\" = global i32 0\n"
+      ";                                        a long comment\n"
+      "define i32 @f(i32 %an_argument_with_a_long_name) {\n"
+      "an_entry_block_with_a_long_name:\n"
+      "                                        br label %\"the next \\5Cblock\"\n"
+      "\"the next \\5Cblock\":\n"
+      "  %a_value_whose_name_is_long = add i32 %an_argument_with_a_long_name, 1\n"
+      "  ret i32 %a_value_whose_name_is_long\n"
+      "}\n"
+      "; a comment at the end, without a newline";
+  SMDiagnostic Error;
+  auto Mod = parseAssemblyString(Source, Error, Ctx);
+  ASSERT_TRUE(Mod != nullptr) << Error.getMessage();
+
+  GlobalVariable *GV = Mod->getGlobalVariable(
+      "a_rather_long_global_variable_name.with$dots-and-dashes");
+  ASSERT_TRUE(GV);
+  EXPECT_EQ("a string of twenty!",
+            cast<ConstantDataArray>(GV->getInitializer())->getAsString());
+  EXPECT_TRUE(Mod->getGlobalVariable("an escaped \"name\" that is long"));
+
+  Function *F = Mod->getFunction("f");
+  ASSERT_TRUE(F);
+  EXPECT_EQ("an_argument_with_a_long_name", F->arg_begin()->getName());
+  EXPECT_EQ("an_entry_block_with_a_long_name", F->front().getName());
+  EXPECT_EQ("the next \\block", F->back().getName());
+  EXPECT_EQ("a_value_whose_name_is_long", F->back().front().getName());
+}
+
+TEST(AsmParserTest, UndefinedLocalValue) {
+  // Of several undefined values, the first in sorted order is reported.
+  LLVMContext Ctx;
+  StringRef Source = "define i32 @f() {\n"
+                     "  %x = add i32 %b, %a\n"
+                     "  ret i32 %x\n"
+                     "}\n";
+  SMDiagnostic Error;
+  auto Mod = parseAssemblyString(Source, Error, Ctx);
+  EXPECT_FALSE(Mod);
+  EXPECT_EQ("use of undefined value '%a'", Error.getMessage());
+}
+
 } // end anonymous namespace
@@ -11,9 +11,11 @@
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -190,4 +192,161 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+// Tests that decoding the function blocks ahead of time on other threads
+// materializes the same module.
+TEST(BitReaderTest, MaterializeModuleWithThreads) {
+  const char *Assembly = "@g = global i8* blockaddress(@after, %bb)\n"
+                         "define i8* @before(i32 %x) {\n"
+                         "entry:\n"
+                         "  %y = add i32 %x, 42, !annotation !0\n"
+                         "  %c = icmp eq i32 %y, 0\n"
+                         "  br i1 %c, label %then, label %else\n"
+                         "then:\n"
+                         "  ret i8* blockaddress(@after, %bb)\n"
+                         "else:\n"
+                         "  ret i8* getelementptr (i8, i8* null, i64 1)\n"
+                         "}\n"
+                         "define void @other() {\n"
+                         "  call void asm sideeffect \"\", \"\"(), !srcloc !1\n"
+                         "  ret void\n"
+                         "}\n"
+                         "define void @after() {\n"
+                         "  unreachable\n"
+                         "bb:\n"
+                         "  unreachable\n"
+                         "}\n"
+                         "!0 = !{!\"annotation\"}\n"
+                         "!1 = !{i32 42}\n";
+
+  auto Print = [&](unsigned Threads) {
+    auto &Opts = cl::getRegisteredOptions();
+    auto *Opt = static_cast<cl::opt<unsigned> *>(
+        Opts["bitcode-materialize-threads"]);
+    Opt->setValue(Threads);
+
+    SmallString<1024> Mem;
+    LLVMContext Context;
+    std::unique_ptr<Module> M =
+        getLazyModuleFromAssembly(Context, Mem, Assembly);
+    EXPECT_FALSE(M->materializeAll());
+    EXPECT_FALSE(verifyModule(*M, &dbgs()));
+    Opt->setValue(0);
+
+    std::string Str;
+    raw_string_ostream OS(Str);
+    M->print(OS, nullptr);
+    return OS.str();
+  };
+
+  std::string Serial = Print(0);
+  EXPECT_EQ(Serial, Print(1));
+  EXPECT_EQ(Serial, Print(4));
+}
+
+// Tests that writing the function blocks on other threads writes the same
+// bitcode.
+TEST(BitReaderTest, WriteModuleWithThreads) {
+  std::string Assembly = "@g = global i8* blockaddress(@f1, %bb)\n";
+  for (unsigned I = 0; I != 16; ++I) {
+    std::string N = std::to_string(I);
+    Assembly += "define i32 @f" + N + "(i32 %x) {\n"
+                "entry:\n"
+                "  %y = add i32 %x, " + N + ", !annotation !0\n"
+                "  br label %bb\n"
+                "bb:\n"
+                "  %z = call i32 @f0(i32 %y)\n"
+                "  ret i32 %z\n"
+                "}\n";
+  }
+  Assembly += "!0 = !{!\"annotation\"}\n";
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = parseAssembly(Context, Assembly.c_str());
+  auto Write = [&](unsigned Threads) {
+    auto &Opts = cl::getRegisteredOptions();
+    auto *Opt = static_cast<cl::opt<unsigned> *>(Opts["bitcode-write-threads"]);
+    Opt->setValue(Threads);
+    SmallString<1024> Mem;
+    raw_svector_ostream OS(Mem);
+    WriteBitcodeToFile(*M, OS);
+    Opt->setValue(0);
+    return Mem.str().str();
+  };
+
+  std::string Serial = Write(0);
+  EXPECT_EQ(Serial, Write(1));
+  EXPECT_EQ(Serial, Write(3));
+}
+
+// Tests that the module-level metadata of a lazily loaded module is only loaded
+// once a materialized function refers to it.
+TEST(BitReaderTest, MaterializeMetadataOnDemand) {
+  const char *Assembly =
+      "define void @a1() !dbg !4 {\n"
+      "  ret void\n"
+      "}\n"
+      "define void @a2() !dbg !5 {\n"
+      "  ret void\n"
+      "}\n"
+      "define void @b1() !dbg !7 {\n"
+      "  ret void\n"
+      "}\n"
+      "define void @b2() !dbg !8 {\n"
+      "  ret void\n"
+      "}\n"
+      "!llvm.dbg.cu = !{!0}\n"
+      "!llvm.module.flags = !{!2}\n"
+      "!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, "
+      "emissionKind: FullDebug)\n"
+      "!1 = !DIFile(filename: \"t.cpp\", directory: \"/\")\n"
+      "!2 = !{i32 2, !\"Debug Info Version\", i32 3}\n"
+      "!3 = distinct !DICompositeType(tag: DW_TAG_class_type, name: \"A\", "
+      "file: !1, identifier: \"_ZTS1A\")\n"
+      "!4 = distinct !DISubprogram(name: \"a1\", scope: !3, file: !1, "
+      "spFlags: DISPFlagDefinition, unit: !0)\n"
+      "!5 = distinct !DISubprogram(name: \"a2\", scope: !3, file: !1, "
+      "spFlags: DISPFlagDefinition, unit: !0)\n"
+      "!6 = distinct !DICompositeType(tag: DW_TAG_class_type, name: \"B\", "
+      "file: !1, identifier: \"_ZTS1B\")\n"
+      "!7 = distinct !DISubprogram(name: \"b1\", scope: !6, file: !1, "
+      "spFlags: DISPFlagDefinition, unit: !0)\n"
+      "!8 = distinct !DISubprogram(name: \"b2\", scope: !6, file: !1, "
+      "spFlags: DISPFlagDefinition, unit: !0)\n";
+
+  // Each class is shared by two functions, so it is written with the
+  // module-level metadata, which is indexed however small it is.
+  auto *Threshold = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions()["bitcode-mdindex-threshold"]);
+  Threshold->setValue(0);
+  SmallString<1024> Mem;
+  {
+    LLVMContext Context;
+    writeModuleToBuffer(parseAssembly(Context, Assembly), Mem);
+  }
+  Threshold->setValue(25);
+
+  LLVMContext Context;
+  Context.enableDebugTypeODRUniquing();
+  Expected<std::unique_ptr<Module>> ModuleOrErr =
+      getLazyBitcodeModule(MemoryBufferRef(Mem.str(), "test"), Context);
+  ASSERT_TRUE(!!ModuleOrErr);
+  std::unique_ptr<Module> M = std::move(ModuleOrErr.get());
+  MDString *A = MDString::get(Context, "_ZTS1A");
+  MDString *B = MDString::get(Context, "_ZTS1B");
+  EXPECT_FALSE(DICompositeType::getODRTypeIfExists(Context, *A));
+  EXPECT_FALSE(DICompositeType::getODRTypeIfExists(Context, *B));
+
+  ASSERT_FALSE(M->getFunction("a1")->materialize());
+  EXPECT_TRUE(DICompositeType::getODRTypeIfExists(Context, *A));
+  EXPECT_FALSE(DICompositeType::getODRTypeIfExists(Context, *B));
+  EXPECT_EQ(M->getFunction("a1")->getSubprogram()->getScope(),
+            DICompositeType::getODRTypeIfExists(Context, *A));
+
+  ASSERT_FALSE(M->materializeAll());
+  EXPECT_TRUE(DICompositeType::getODRTypeIfExists(Context, *B));
+  EXPECT_EQ(M->getFunction("b2")->getSubprogram()->getScope(),
+            DICompositeType::getODRTypeIfExists(Context, *B));
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+}
+
 } // end namespace
@@ -147,6 +147,101 @@ TEST(BitstreamReaderTest, shortRead) {
   }
 }
 
+TEST(BitstreamReaderTest, recordAndReplayBlock) {
+  const unsigned Magic = 0x12345678;
+  const unsigned BlockID = bitc::FIRST_APPLICATION_BLOCKID;
+  const unsigned RecordID = 1;
+  const uint8_t BlobBytes[] = {0x01, 0x7f, 0x80, 0xff};
+  StringRef BlobIn((const char *)BlobBytes, sizeof(BlobBytes));
+
+  // Write a block with an abbreviated record, a sub-block to enter, one to
+  // skip and a record with a blob, followed by a word outside of it.
+  SmallVector<char, 1> Buffer;
+  unsigned ArrayAbbrevID, BlobAbbrevID;
+  {
+    BitstreamWriter Stream(Buffer);
+    Stream.Emit(Magic, 32);
+    Stream.EnterSubblock(BlockID, 3);
+
+    auto Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(RecordID));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+    ArrayAbbrevID = Stream.EmitAbbrev(std::move(Abbrev));
+    Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(RecordID + 1));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    BlobAbbrevID = Stream.EmitAbbrev(std::move(Abbrev));
+
+    unsigned Array[] = {1, 1000, 1000000};
+    Stream.EmitRecord(RecordID, makeArrayRef(Array), ArrayAbbrevID);
+    Stream.EnterSubblock(BlockID + 1, 3);
+    Stream.EmitRecord(RecordID + 2, makeArrayRef(Array));
+    Stream.ExitBlock();
+    Stream.EnterSubblock(BlockID + 2, 3);
+    Stream.EmitRecord(RecordID + 3, makeArrayRef(Array));
+    Stream.ExitBlock();
+    unsigned Record[] = {RecordID + 1};
+    Stream.EmitRecordWithBlob(BlobAbbrevID, makeArrayRef(Record), BlobIn);
+
+    Stream.ExitBlock();
+    Stream.Emit(~Magic, 32);
+  }
+
+  BitstreamCursor Stream(
+      ArrayRef<uint8_t>((const uint8_t *)Buffer.begin(), Buffer.size()));
+  ASSERT_EQ(Magic, Stream.Read(32));
+  BitstreamEntry Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  ASSERT_EQ(BlockID, Entry.ID);
+
+  // Record the block on another cursor, which continues after it.
+  BitstreamBlockRecording Recording;
+  BitstreamCursor Recorder(Stream);
+  ASSERT_FALSE(Recorder.recordBlock(BlockID, Recording));
+  EXPECT_EQ(~Magic, Recorder.Read(32));
+
+  // Replay it.
+  Stream.replayBlock(Recording);
+  ASSERT_TRUE(Stream.isReplaying());
+  ASSERT_FALSE(Stream.EnterSubBlock(BlockID));
+
+  SmallVector<uint64_t, 4> Vals;
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+  EXPECT_EQ(ArrayAbbrevID, Entry.ID);
+  EXPECT_EQ(RecordID, Stream.readRecord(Entry.ID, Vals));
+  EXPECT_EQ((std::vector<uint64_t>{1, 1000, 1000000}),
+            std::vector<uint64_t>(Vals.begin(), Vals.end()));
+
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  EXPECT_EQ(BlockID + 1, Entry.ID);
+  ASSERT_FALSE(Stream.EnterSubBlock(Entry.ID));
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+  EXPECT_EQ(unsigned(bitc::UNABBREV_RECORD), Entry.ID);
+  EXPECT_EQ(RecordID + 2, Stream.skipRecord(Entry.ID));
+  EXPECT_EQ(BitstreamEntry::EndBlock, Stream.advance().Kind);
+
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  EXPECT_EQ(BlockID + 2, Entry.ID);
+  ASSERT_FALSE(Stream.SkipBlock());
+
+  // Without a blob to return, the blob is unpacked into the operands.
+  unsigned Code = Stream.ReadCode();
+  EXPECT_EQ(BlobAbbrevID, Code);
+  Vals.clear();
+  EXPECT_EQ(RecordID + 1, Stream.readRecord(Code, Vals));
+  EXPECT_EQ((std::vector<uint64_t>{0x01, 0x7f, 0x80, 0xff}),
+            std::vector<uint64_t>(Vals.begin(), Vals.end()));
+
+  EXPECT_EQ(BitstreamEntry::EndBlock, Stream.advance().Kind);
+  EXPECT_FALSE(Stream.isReplaying());
+  EXPECT_EQ(~Magic, Stream.Read(32));
+}
+
 static_assert(is_trivially_copyable<BitCodeAbbrevOp>::value,
               "trivially copyable");
 
@@ -55,4 +55,41 @@ TEST(BitstreamWriterTest, emitBlob4ByteAligned) {
   EXPECT_EQ(StringRef("str0"), Buffer);
 }
 
+TEST(BitstreamWriterTest, EmitBits) {
+  // Bits written elsewhere, from a word boundary.
+  SmallString<64> Source;
+  {
+    BitstreamWriter W(Source);
+    W.Emit(0xffffffff, 32);
+    for (unsigned I = 0; I != 20; ++I)
+      W.EmitVBR(I * 997, 6);
+    W.FlushToWord();
+  }
+  ArrayRef<uint8_t> Bytes((const uint8_t *)Source.data(), Source.size());
+  uint64_t BeginBit = 32, EndBit = 32;
+  for (unsigned I = 0; I != 20; ++I)
+    EndBit += I * 997 < 32 ? 6 : I * 997 < 1024 ? 12 : 18;
+
+  // Splice them in at every offset within a word.
+  for (unsigned Offset = 0; Offset != 32; ++Offset) {
+    SmallString<64> Buffer, Expected;
+    {
+      BitstreamWriter W(Buffer);
+      if (Offset)
+        W.Emit(1, Offset);
+      W.EmitBits(Bytes, BeginBit, EndBit);
+      W.FlushToWord();
+    }
+    {
+      BitstreamWriter W(Expected);
+      if (Offset)
+        W.Emit(1, Offset);
+      for (unsigned I = 0; I != 20; ++I)
+        W.EmitVBR(I * 997, 6);
+      W.FlushToWord();
+    }
+    EXPECT_EQ(StringRef(Expected), StringRef(Buffer));
+  }
+}
+
 } // end namespace
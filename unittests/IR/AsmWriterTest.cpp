@@ -5,6 +5,7 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 //
 //===----------------------------------------------------------------------===//
+#include "llvm/AsmParser/Parser.h"
 #include "llvm/BinaryFormat/Dwarf.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Function.h"
@@ -12,6 +13,8 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -50,4 +53,80 @@ TEST(AsmWriterTest, DumpDIExpression) {
             OS.str());
 }
 
+static const char *ModuleWithSlots = R"(
+@0 = global i32 0, !g !0
+@named = global i32* @0
+
+define i32 @f(i32) #0 {
+  %2 = add i32 %0, 1, !a !1
+  br label %3
+
+; <label>:3:
+  call void @h() #1
+  ret i32 %2
+}
+
+define void @g() !s !2 {
+  %1 = load i32, i32* @0, !b !3
+  call void @h() #1
+  ret void
+}
+
+declare void @h() #0
+
+attributes #0 = { nounwind }
+attributes #1 = { cold }
+
+!n = !{!4}
+
+!0 = !{!"global"}
+!1 = !{!"f"}
+!2 = !{!"g"}
+!3 = !{!"load"}
+!4 = !{!"named"}
+)";
+
+TEST(AsmWriterTest, PrintModuleWithThreads) {
+  LLVMContext Ctx;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(ModuleWithSlots, Err, Ctx);
+  ASSERT_TRUE(M);
+
+  std::string Serial;
+  raw_string_ostream SerialOS(Serial);
+  M->print(SerialOS, nullptr);
+
+  auto *Threads = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions()["asm-print-threads"]);
+  ASSERT_TRUE(Threads);
+  for (unsigned N : {1, 2, 4}) {
+    Threads->setValue(N);
+    std::string Parallel;
+    raw_string_ostream ParallelOS(Parallel);
+    M->print(ParallelOS, nullptr);
+    EXPECT_EQ(SerialOS.str(), ParallelOS.str()) << N << " threads";
+  }
+  Threads->setValue(0);
+}
+
+TEST(AsmWriterTest, PrintFunctionSlots) {
+  // Printing a function numbers the module's metadata before the function's,
+  // and its local values without regard to other functions.
+  LLVMContext Ctx;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(ModuleWithSlots, Err, Ctx);
+  ASSERT_TRUE(M);
+
+  std::string S;
+  raw_string_ostream OS(S);
+  M->getFunction("g")->print(OS);
+  EXPECT_EQ("\n"
+            "define void @g() !s !2 {\n"
+            "  %1 = load i32, i32* @0, !b !3\n"
+            "  call void @h() #1\n"
+            "  ret void\n"
+            "}\n",
+            OS.str());
+}
+
 }
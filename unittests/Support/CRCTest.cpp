@@ -11,7 +11,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/CRC.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/JamCRC.h"
 #include "gtest/gtest.h"
+#include <vector>
 
 using namespace llvm;
 
@@ -26,4 +29,37 @@ TEST(CRCTest, CRC32) {
   EXPECT_EQ(0xCBF43926U, llvm::crc32(0, StringRef("123456789")));
 }
 
+// Computes the CRC-32 one bit at a time.
+static uint32_t referenceCRC32(uint32_t CRC, StringRef S) {
+  CRC = ~CRC;
+  for (unsigned char C : S) {
+    CRC ^= C;
+    for (int I = 0; I != 8; ++I)
+      CRC = (CRC >> 1) ^ (0xEDB88320U & -(CRC & 1));
+  }
+  return ~CRC;
+}
+
+TEST(CRCTest, CRC32Sizes) {
+  // Cover the sizes and alignments handled by each of the implementations.
+  std::vector<char> Data(4096 + 16);
+  for (size_t I = 0; I != Data.size(); ++I)
+    Data[I] = I * 31 + (I >> 5);
+  for (size_t Size = 0; Size <= 4096; Size += Size < 300 ? 1 : 509) {
+    for (size_t Offset : {0, 1, 7, 8, 15}) {
+      StringRef S(Data.data() + Offset, Size);
+      EXPECT_EQ(referenceCRC32(0x12345678U, S), llvm::crc32(0x12345678U, S))
+          << "size " << Size << ", offset " << Offset;
+    }
+  }
+}
+
+TEST(CRCTest, JamCRC) {
+  StringRef S("The quick brown fox jumps over the lazy dog");
+  JamCRC CRC;
+  CRC.update(makeArrayRef(S.data(), 10));
+  CRC.update(makeArrayRef(S.data() + 10, S.size() - 10));
+  EXPECT_EQ(~0x414FA339U, CRC.getCRC());
+}
+
 } // end anonymous namespace
@@ -7,7 +7,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/CachePruning.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -91,6 +98,186 @@ TEST(CachePruningPolicyParser, Errors) {
   EXPECT_EQ(
       "'foo' not an integer",
       toString(parseCachePruningPolicy("cache_size_bytes=foom").takeError()));
+  EXPECT_EQ("'yes' must be 0 or 1",
+            toString(parseCachePruningPolicy("incremental=yes").takeError()));
   EXPECT_EQ("Unknown key: 'foo'",
             toString(parseCachePruningPolicy("foo=bar").takeError()));
 }
+
+TEST(CachePruningPolicyParser, Incremental) {
+  auto P = parseCachePruningPolicy("");
+  ASSERT_TRUE(bool(P));
+  EXPECT_FALSE(P->Incremental);
+  P = parseCachePruningPolicy("incremental=1:cache_size_files=10");
+  ASSERT_TRUE(bool(P));
+  EXPECT_TRUE(P->Incremental);
+  EXPECT_EQ(10u, P->MaxSizeFiles);
+}
+
+namespace {
+class CachePruningTest : public ::testing::TestWithParam<bool> {
+protected:
+  SmallString<128> Dir;
+  sys::TimePoint<> Now = std::chrono::system_clock::now();
+
+  void SetUp() override {
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("cache-pruning-test", Dir));
+  }
+  void TearDown() override { sys::fs::remove_directories(Dir); }
+
+  /// Writes the file \p Name of \p Size bytes, last used \p Age seconds ago.
+  void writeFile(StringRef Name, size_t Size, unsigned Age) {
+    SmallString<128> Path(Dir);
+    sys::path::append(Path, Name);
+    int FD;
+    ASSERT_FALSE(sys::fs::openFileForWrite(Path, FD));
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << std::string(Size, 'x');
+    OS.flush();
+    touch(FD, Age);
+  }
+
+  void touch(int FD, unsigned Age) {
+    sys::TimePoint<> Time = Now - std::chrono::seconds(Age);
+    ASSERT_FALSE(sys::fs::setLastAccessAndModificationTime(FD, Time, Time));
+  }
+
+  /// Marks the file \p Name as used \p Age seconds ago.
+  void touch(StringRef Name, unsigned Age) {
+    SmallString<128> Path(Dir);
+    sys::path::append(Path, Name);
+    int FD;
+    ASSERT_FALSE(sys::fs::openFileForWrite(Path, FD, sys::fs::CD_OpenExisting,
+                                           sys::fs::OF_Append));
+    touch(FD, Age);
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  }
+
+  std::vector<std::string> getFiles() {
+    std::vector<std::string> Files;
+    std::error_code EC;
+    for (sys::fs::directory_iterator I(Dir, EC), E; !EC && I != E;
+         I.increment(EC))
+      Files.push_back(sys::path::filename(I->path()));
+    llvm::sort(Files);
+    return Files;
+  }
+
+  CachePruningPolicy getPolicy() {
+    CachePruningPolicy Policy;
+    Policy.Interval = std::chrono::seconds(0);
+    Policy.Expiration = std::chrono::seconds(0);
+    Policy.MaxSizePercentageOfAvailableSpace = 0;
+    Policy.MaxSizeFiles = 0;
+    Policy.Incremental = GetParam();
+    return Policy;
+  }
+};
+} // namespace
+
+TEST_P(CachePruningTest, LeastRecentlyUsed) {
+  for (unsigned I = 0; I != 6; ++I)
+    writeFile("llvmcache-" + std::to_string(I), 100, 600 - I * 10);
+  writeFile("unrelated", 1000, 1000);
+
+  CachePruningPolicy Policy = getPolicy();
+  Policy.MaxSizeFiles = 4;
+  EXPECT_TRUE(pruneCache(Dir, Policy));
+  std::vector<std::string> Files = getFiles();
+  EXPECT_EQ(GetParam(), is_contained(Files, "llvmcache.index"));
+  Files.erase(std::remove(Files.begin(), Files.end(), "llvmcache.index"),
+              Files.end());
+  EXPECT_EQ((std::vector<std::string>{"llvmcache-2", "llvmcache-3",
+                                      "llvmcache-4", "llvmcache-5",
+                                      "llvmcache.timestamp", "unrelated"}),
+            Files);
+
+  // Files used and added since the last pruning are taken into account, even
+  // if the index does not know about them yet.
+  touch("llvmcache-2", 10);
+  writeFile("llvmcache-6", 100, 20);
+  writeFile("llvmcache-7", 100, 700);
+  Policy.MaxSizeFiles = 0;
+  Policy.MaxSizeBytes = 200;
+  EXPECT_TRUE(pruneCache(Dir, Policy));
+  Files = getFiles();
+  EXPECT_FALSE(is_contained(Files, "llvmcache-3"));
+  EXPECT_FALSE(is_contained(Files, "llvmcache-4"));
+  EXPECT_FALSE(is_contained(Files, "llvmcache-5"));
+  EXPECT_FALSE(is_contained(Files, "llvmcache-7"));
+  EXPECT_TRUE(is_contained(Files, "llvmcache-2"));
+  EXPECT_TRUE(is_contained(Files, "llvmcache-6"));
+
+  // Expiration also checks the index against the files.
+  touch("llvmcache-6", 1000);
+  Policy.MaxSizeBytes = 0;
+  Policy.Expiration = std::chrono::seconds(100);
+  EXPECT_TRUE(pruneCacheAsync(Dir, Policy).get());
+  Files = getFiles();
+  EXPECT_TRUE(is_contained(Files, "llvmcache-2"));
+  EXPECT_FALSE(is_contained(Files, "llvmcache-6"));
+  EXPECT_TRUE(is_contained(Files, "unrelated"));
+}
+
+TEST_P(CachePruningTest, RemovedFiles) {
+  for (unsigned I = 0; I != 4; ++I)
+    writeFile("llvmcache-" + std::to_string(I), 100, 600 - I * 10);
+  CachePruningPolicy Policy = getPolicy();
+  Policy.MaxSizeFiles = 3;
+  EXPECT_TRUE(pruneCache(Dir, Policy));
+
+  // Files removed by others are forgotten.
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, "llvmcache-1");
+  ASSERT_FALSE(sys::fs::remove(Path));
+  Policy.MaxSizeFiles = 1;
+  EXPECT_TRUE(pruneCache(Dir, Policy));
+  std::vector<std::string> Files = getFiles();
+  EXPECT_FALSE(is_contained(Files, "llvmcache-2"));
+  EXPECT_TRUE(is_contained(Files, "llvmcache-3"));
+}
+
+TEST_P(CachePruningTest, CorruptedIndex) {
+  if (!GetParam())
+    return;
+  writeFile("llvmcache-0", 100, 10);
+  writeFile("unrelated", 100, 1000);
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, "llvmcache-x");
+  ASSERT_FALSE(sys::fs::create_directory(Path));
+  SmallString<128> IndexPath(Dir);
+  sys::path::append(IndexPath, "llvmcache.index");
+  ASSERT_FALSE(sys::fs::create_directory(IndexPath));
+  sys::path::append(IndexPath, "index");
+
+  // An index that claims the directory is unchanged and lists files that are
+  // not part of the cache, as expired, is ignored.
+  for (StringRef Name : {"", "unrelated", "llvmcache-x/../unrelated"}) {
+    sys::fs::file_status DirStatus;
+    ASSERT_FALSE(sys::fs::status(Dir, DirStatus));
+    std::error_code EC;
+    raw_fd_ostream OS(IndexPath, EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    support::endian::Writer W(OS, support::little);
+    OS << "LLVMCIX1";
+    W.write<uint64_t>(
+        DirStatus.getLastModificationTime().time_since_epoch().count());
+    W.write<uint64_t>((Now + std::chrono::hours(1)).time_since_epoch().count());
+    W.write<uint64_t>(1);
+    W.write<uint64_t>((Now - std::chrono::hours(1)).time_since_epoch().count());
+    W.write<uint64_t>(100);
+    W.write<uint32_t>(Name.size());
+    OS << Name;
+    OS.close();
+
+    CachePruningPolicy Policy = getPolicy();
+    Policy.Expiration = std::chrono::seconds(100);
+    EXPECT_TRUE(pruneCache(Dir, Policy));
+    std::vector<std::string> Files = getFiles();
+    EXPECT_TRUE(is_contained(Files, "unrelated")) << Name;
+    EXPECT_TRUE(is_contained(Files, "llvmcache-0")) << Name;
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(CachePruningTest, CachePruningTest,
+                        ::testing::Values(false, true));
@@ -545,6 +545,54 @@ TEST(CommandLineTest, ReparseCommandLineOptions) {
   EXPECT_TRUE(TopLevelOpt);
 }
 
+TEST(CommandLineTest, RegisterOnFirstUse) {
+  cl::ResetCommandLineParser();
+
+  // None of these are in the option maps until the command line is parsed.
+  StackOption<std::string> First(cl::Positional);
+  StackOption<std::string> Second(cl::Positional);
+  StackOption<bool> Renamed("old-name");
+  Renamed.setArgStr("new-name");
+  {
+    StackOption<bool> Removed("removed");
+  }
+
+  const char *args[] = {"prog", "-new-name", "a", "b"};
+  EXPECT_TRUE(
+      cl::ParseCommandLineOptions(4, args, StringRef(), &llvm::nulls()));
+  EXPECT_TRUE(Renamed);
+  EXPECT_EQ("a", First);
+  EXPECT_EQ("b", Second);
+
+  StringMap<cl::Option *> &Map =
+      cl::getRegisteredOptions(*cl::TopLevelSubCommand);
+  EXPECT_EQ(0u, Map.count("old-name"));
+  EXPECT_EQ(0u, Map.count("removed"));
+}
+
+// Like PluginLoader, constructs an option while the command line is parsed.
+struct OptionLoader {
+  static std::unique_ptr<StackOption<bool>> Loaded;
+  void operator=(const std::string &) {
+    Loaded = llvm::make_unique<StackOption<bool>>("plugin-flag");
+  }
+};
+std::unique_ptr<StackOption<bool>> OptionLoader::Loaded;
+
+TEST(CommandLineTest, RegisterWhileParsing) {
+  cl::ResetCommandLineParser();
+
+  StackOption<OptionLoader,
+              cl::opt<OptionLoader, false, cl::parser<std::string>>>
+      Load("load-option");
+  const char *args[] = {"prog", "-load-option=plugin.so", "-plugin-flag"};
+  EXPECT_TRUE(
+      cl::ParseCommandLineOptions(3, args, StringRef(), &llvm::nulls()));
+  ASSERT_TRUE(OptionLoader::Loaded);
+  EXPECT_TRUE(*OptionLoader::Loaded);
+  OptionLoader::Loaded.reset();
+}
+
 TEST(CommandLineTest, RemoveFromRegularSubCommand) {
   cl::ResetCommandLineParser();
 
@@ -65,6 +65,49 @@ TEST(CompressionTest, Zlib) {
   TestZlibCompression(BinaryDataStr, zlib::DefaultCompression);
 }
 
+TEST(CompressionTest, ZlibParallel) {
+  // Text that compresses, with repeats across the blocks.
+  std::string Input;
+  for (unsigned I = 0; Input.size() < 300000; ++I)
+    Input += "line " + std::to_string(I % 5000) + " of " +
+             std::to_string(I * 7919 % 100003) + "\n";
+
+  SmallString<32> Serial;
+  ASSERT_FALSE(errorToBool(zlib::compress(Input, Serial)));
+  for (size_t BlockSize : {1 << 15, 100000, 1 << 20}) {
+    for (int Level : {zlib::NoCompression, zlib::BestSpeedCompression,
+                      zlib::DefaultCompression, zlib::BestSizeCompression}) {
+      SmallString<32> Compressed, Uncompressed;
+      ASSERT_FALSE(errorToBool(
+          zlib::compressParallel(Input, Compressed, Level, BlockSize)));
+      ASSERT_FALSE(errorToBool(
+          zlib::uncompress(Compressed, Uncompressed, Input.size())));
+      EXPECT_EQ(Input, Uncompressed);
+      if (Level == zlib::DefaultCompression) {
+        // Inputs that fit in a block are compressed as by compress(), and
+        // the dictionaries keep the others close to it.
+        if (BlockSize >= Input.size())
+          EXPECT_EQ(Serial, Compressed);
+        else
+          EXPECT_LT(Compressed.size(), Serial.size() * 11 / 10);
+      }
+    }
+  }
+
+}
+
+TEST(CompressionTest, ZlibCodec) {
+  std::unique_ptr<CompressionCodec> Codec = createZlibCodec();
+  EXPECT_EQ("zlib", Codec->getName());
+  EXPECT_TRUE(Codec->isAvailable());
+  std::string Input(3 << 20, 'x');
+  SmallString<32> Compressed, Uncompressed;
+  ASSERT_FALSE(errorToBool(Codec->compress(Input, Compressed)));
+  ASSERT_FALSE(
+      errorToBool(Codec->uncompress(Compressed, Uncompressed, Input.size())));
+  EXPECT_EQ(Input, Uncompressed);
+}
+
 TEST(CompressionTest, ZlibCRC32) {
   EXPECT_EQ(
       0x414FA339U,
@@ -0,0 +1,135 @@
+//===- ConcurrentAllocatorTest.cpp - ConcurrentAllocator.h tests ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ConcurrentAllocator.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/StringSaver.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+TEST(ConcurrentAllocatorTest, Basics) {
+  ConcurrentBumpPtrAllocator Alloc;
+  int *A = Alloc.Allocate<int>(1);
+  int *B = Alloc.Allocate<int>(10);
+  *A = 1;
+  B[9] = 2;
+  EXPECT_EQ(1, *A);
+  EXPECT_EQ(2, B[9]);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(B) % alignof(int));
+  EXPECT_EQ(11 * sizeof(int), Alloc.getBytesAllocated());
+  EXPECT_EQ(1u, Alloc.GetNumSlabs());
+  EXPECT_EQ(&Alloc.getThreadAllocator(), &Alloc.getThreadAllocator());
+
+  Alloc.Reset();
+  EXPECT_EQ(0u, Alloc.getBytesAllocated());
+}
+
+// Allocators in use at the same time on one thread must not share slabs.
+TEST(ConcurrentAllocatorTest, Interleaved) {
+  ConcurrentBumpPtrAllocator Alloc1, Alloc2;
+  char *A = static_cast<char *>(Alloc1.Allocate(16, 1));
+  char *B = static_cast<char *>(Alloc2.Allocate(16, 1));
+  char *C = static_cast<char *>(Alloc1.Allocate(16, 1));
+  EXPECT_NE(&Alloc1.getThreadAllocator(), &Alloc2.getThreadAllocator());
+  EXPECT_EQ(A + 16, C);
+  EXPECT_NE(A + 16, B);
+  EXPECT_EQ(32u, Alloc1.getBytesAllocated());
+  EXPECT_EQ(16u, Alloc2.getBytesAllocated());
+}
+
+// A new allocator must not pick up the thread's cached slabs of a destroyed
+// one, even if it is constructed at the same address.
+TEST(ConcurrentAllocatorTest, Reconstructed) {
+  for (unsigned I = 0; I < 3; ++I) {
+    ConcurrentBumpPtrAllocator Alloc;
+    EXPECT_EQ(0u, Alloc.getBytesAllocated());
+    Alloc.Allocate(8, 8);
+    EXPECT_EQ(8u, Alloc.getBytesAllocated());
+  }
+}
+
+TEST(ConcurrentAllocatorTest, StringSaver) {
+  ConcurrentBumpPtrAllocator Alloc;
+  ConcurrentStringSaver Saver(Alloc);
+  StringRef S = Saver.save(Twine("hello") + " world");
+  EXPECT_EQ("hello world", S);
+  EXPECT_EQ('\0', *S.end());
+}
+
+struct Counted {
+  static std::atomic<unsigned> Destroyed;
+  ~Counted() { ++Destroyed; }
+};
+std::atomic<unsigned> Counted::Destroyed{0};
+
+TEST(ConcurrentAllocatorTest, Specific) {
+  Counted::Destroyed = 0;
+  {
+    ConcurrentSpecificBumpPtrAllocator<Counted> Alloc;
+    for (unsigned I = 0; I < 10; ++I)
+      new (Alloc.Allocate()) Counted();
+    Alloc.DestroyAll();
+    EXPECT_EQ(10u, Counted::Destroyed);
+    new (Alloc.Allocate()) Counted();
+  }
+  EXPECT_EQ(11u, Counted::Destroyed);
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(ConcurrentAllocatorTest, Threads) {
+  const unsigned NumThreads = 8, NumAllocs = 10000;
+  ConcurrentBumpPtrAllocator Alloc;
+  ConcurrentStringSaver Saver(Alloc);
+  std::vector<std::vector<StringRef>> Saved(NumThreads);
+  std::vector<std::thread> Threads;
+  for (unsigned T = 0; T < NumThreads; ++T)
+    Threads.emplace_back([&, T] {
+      for (unsigned I = 0; I < NumAllocs; ++I)
+        Saved[T].push_back(Saver.save(Twine(T) + ":" + Twine(I)));
+    });
+  for (std::thread &T : Threads)
+    T.join();
+
+  // Every string must be intact, so no two threads handed out the same
+  // memory.
+  std::vector<const char *> Ptrs;
+  for (unsigned T = 0; T < NumThreads; ++T)
+    for (unsigned I = 0; I < NumAllocs; ++I) {
+      EXPECT_EQ((Twine(T) + ":" + Twine(I)).str(), Saved[T][I]);
+      Ptrs.push_back(Saved[T][I].data());
+    }
+  std::sort(Ptrs.begin(), Ptrs.end());
+  EXPECT_EQ(Ptrs.end(), std::adjacent_find(Ptrs.begin(), Ptrs.end()));
+}
+
+TEST(ConcurrentAllocatorTest, SpecificThreads) {
+  const unsigned NumThreads = 4, NumAllocs = 1000;
+  Counted::Destroyed = 0;
+  {
+    ConcurrentSpecificBumpPtrAllocator<Counted> Alloc;
+    std::vector<std::thread> Threads;
+    for (unsigned T = 0; T < NumThreads; ++T)
+      Threads.emplace_back([&] {
+        for (unsigned I = 0; I < NumAllocs; ++I)
+          new (Alloc.Allocate()) Counted();
+      });
+    for (std::thread &T : Threads)
+      T.join();
+  }
+  EXPECT_EQ(NumThreads * NumAllocs, Counted::Destroyed);
+}
+#endif
+
+} // anonymous namespace
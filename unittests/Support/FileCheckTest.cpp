@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/FileCheck.h"
+#include "llvm/Support/Regex.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -215,6 +216,18 @@ public:
     size_t MatchLen;
     return errorToBool(P.match(BufferRef, MatchLen, SM).takeError());
   }
+
+  /// \returns the text matched in \p Buffer, or None if there is no match.
+  Optional<StringRef> matchedText(StringRef Buffer) {
+    StringRef BufferRef = bufferize(SM, Buffer);
+    size_t MatchLen;
+    Expected<size_t> MatchPos = P.match(BufferRef, MatchLen, SM);
+    if (!MatchPos) {
+      consumeError(MatchPos.takeError());
+      return None;
+    }
+    return BufferRef.substr(*MatchPos, MatchLen);
+  }
 };
 
 TEST_F(FileCheckTest, ParseNumericVariableDefinition) {
@@ -335,11 +348,99 @@ TEST_F(FileCheckTest, Match) {
   EXPECT_FALSE(Tester.matchExpect("18 20"));
 }
 
+// Patterns made of literals and {{.*}} are matched without the regex engine,
+// and must give the same result as the regex would.
+TEST_F(FileCheckTest, MatchWildcardPattern) {
+  PatternTester Tester;
+
+  Tester.parsePatternExpect("mov{{.*}}%eax");
+  EXPECT_EQ(None, Tester.matchedText("mov %ebx\n%eax"));
+  EXPECT_EQ(StringRef("mov %eax, %eax"),
+            Tester.matchedText("add\nx mov %eax, %eax, %ebx\n%eax"));
+  EXPECT_EQ(StringRef("mov %eax"),
+            Tester.matchedText("mov %ebx\nmovl %ebx\nmov %eax\n"));
+
+  // Leading and trailing wildcards extend the match to the line bounds.
+  Tester.initNextPattern();
+  Tester.parsePatternExpect("{{.*}}b{{.*}}");
+  EXPECT_EQ(StringRef("abc"), Tester.matchedText("x\nabc\nb"));
+
+  // Literals are placed as early as possible, except the last one.
+  Tester.initNextPattern();
+  Tester.parsePatternExpect("a{{.*}}b{{.*}}c");
+  EXPECT_EQ(StringRef("abcabc"), Tester.matchedText("xabcabcb"));
+  EXPECT_EQ(StringRef("a b c"), Tester.matchedText("ac\na b c\n"));
+  EXPECT_EQ(None, Tester.matchedText("a c b\n c"));
+
+  // Repeated literals give the leftmost longest match, as the regex engine
+  // does.
+  const char *Inputs[] = {"foo foo", "xfoo yfoo\nfoo", "a\nfoofoo bar foo b",
+                          "foo bar foo bar"};
+  const std::pair<const char *, const char *> Patterns[] = {
+      {"{{.*}}foo", ".*foo"},
+      {"foo{{.*}}foo", "foo.*foo"},
+      {"{{.*}}foo{{.*}}bar", ".*foo.*bar"},
+      {"foo{{.*}}bar{{.*}}", "foo.*bar.*"}};
+  for (const auto &P : Patterns) {
+    Tester.initNextPattern();
+    ASSERT_FALSE(Tester.parsePatternExpect(P.first));
+    Regex R(P.second, Regex::Newline);
+    for (const char *Input : Inputs) {
+      SmallVector<StringRef, 1> Matches;
+      Optional<StringRef> Expected;
+      if (R.match(Input, &Matches))
+        Expected = Matches[0];
+      EXPECT_EQ(Expected, Tester.matchedText(Input))
+          << P.first << " on " << Input;
+    }
+  }
+
+  // Anchors.
+  Tester.initNextPattern();
+  Tester.parsePatternExpect("{{^}}foo");
+  EXPECT_EQ(StringRef("foo"), Tester.matchedText("foo"));
+  EXPECT_EQ(None, Tester.matchedText(" foo\n foo"));
+  StringRef Matched = *Tester.matchedText(" foo\nfoo");
+  EXPECT_EQ(StringRef("foo"), Matched);
+  EXPECT_EQ('\n', Matched.data()[-1]);
+  Tester.initNextPattern();
+  Tester.parsePatternExpect("foo{{$}}");
+  EXPECT_EQ(None, Tester.matchedText("foox\nfoo foox"));
+  Matched = *Tester.matchedText("foo foo\nfoo");
+  EXPECT_EQ('\n', Matched.data()[Matched.size()]);
+  Tester.initNextPattern();
+  Tester.parsePatternExpect("a{{.*}}b{{$}}");
+  EXPECT_EQ(StringRef("ab b"), Tester.matchedText("abc\nxab bc\nab b"));
+
+  // Substituted values are matched literally.
+  Tester.initNextPattern();
+  Tester.parsePatternExpect("[[BAR]]{{.*}}[[#FOO+1]]");
+  EXPECT_EQ(StringRef("BAZ 43"), Tester.matchedText("BAZ 42\nBAZ 43 42"));
+}
+
+// Patterns that need the regex engine only run it on the lines that contain
+// their literal pieces, which must not change the result.
+TEST_F(FileCheckTest, MatchWithLiteralPrefilter) {
+  PatternTester Tester;
+
+  Tester.parsePatternExpect("add {{[0-9]+}}, [[BAR]]");
+  EXPECT_EQ(None, Tester.matchedText("add x, BAZ\nadd 1, BAR"));
+  EXPECT_EQ(StringRef("add 12, BAZ"),
+            Tester.matchedText("add 1, \nBAZ\nadd x, BAZ add 12, BAZ"));
+
+  // Bracket expressions can match a newline, in which case the whole input is
+  // matched at once.
+  Tester.initNextPattern();
+  Tester.parsePatternExpect("a{{[[:space:]]+}}b");
+  EXPECT_EQ(StringRef("a\n b"), Tester.matchedText("xa\n b"));
+}
+
 TEST_F(FileCheckTest, Substitution) {
   SourceMgr SM;
   FileCheckPatternContext Context;
   std::vector<std::string> GlobalDefines;
   GlobalDefines.emplace_back(std::string("FOO=BAR"));
+  GlobalDefines.emplace_back(std::string("DOT=a.b"));
   EXPECT_FALSE(errorToBool(Context.defineCmdlineVariables(GlobalDefines, SM)));
 
   // Substitution of an undefined string variable fails and error holds that
@@ -383,6 +484,16 @@ TEST_F(FileCheckTest, Substitution) {
   Value = StringSubstitution.getResult();
   EXPECT_TRUE(static_cast<bool>(Value));
   EXPECT_EQ("BAR", *Value);
+
+  // The value of a string variable is escaped for the regex, but not as a
+  // literal.
+  StringSubstitution = FileCheckStringSubstitution(&Context, "DOT", 42);
+  Value = StringSubstitution.getResult();
+  EXPECT_TRUE(static_cast<bool>(Value));
+  EXPECT_EQ("a\\.b", *Value);
+  Value = StringSubstitution.getLiteralResult();
+  EXPECT_TRUE(static_cast<bool>(Value));
+  EXPECT_EQ("a.b", *Value);
 }
 
 TEST_F(FileCheckTest, FileCheckContext) {
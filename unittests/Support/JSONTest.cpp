@@ -194,6 +194,92 @@ TEST(JSONTest, ParseErrors) {
   ExpectErr("Invalid UTF-8 sequence", "\"\xC0\x80\""); // WTF-8 null
 }
 
+// Records the events of the streaming parser in a compact form.
+class EventRecorder : public Handler {
+public:
+  std::string Events;
+  // Stop parsing at the event with this index.
+  unsigned StopAt = ~0u;
+
+  bool null() override { return record("null"); }
+  bool boolean(bool B) override { return record(B ? "true" : "false"); }
+  bool integer(int64_t I) override { return record("i" + std::to_string(I)); }
+  bool number(double D) override {
+    return record(llvm::formatv("d{0}", D).str());
+  }
+  bool string(llvm::StringRef S) override { return record(("'" + S).str()); }
+  bool arrayBegin() override { return record("["); }
+  bool arrayEnd() override { return record("]"); }
+  bool objectBegin() override { return record("{"); }
+  bool objectKey(llvm::StringRef K) override {
+    return record(("'" + K + "':").str());
+  }
+  bool objectEnd() override { return record("}"); }
+
+private:
+  unsigned NumEvents = 0;
+
+  bool record(const std::string &Event) {
+    if (!Events.empty())
+      Events += ' ';
+    Events += Event;
+    return NumEvents++ != StopAt;
+  }
+};
+
+TEST(JSONTest, ParseEvents) {
+  auto Events = [](llvm::StringRef S) {
+    EventRecorder R;
+    if (Error E = parse(S, R))
+      return "error: " + toString(std::move(E));
+    return R.Events;
+  };
+
+  EXPECT_EQ("true", Events("true"));
+  EXPECT_EQ("null", Events(" null "));
+  EXPECT_EQ("i42", Events("42"));
+  EXPECT_EQ("i-9223372036854775808", Events("-9223372036854775808"));
+  EXPECT_EQ("d2.50", Events("2.5"));
+  EXPECT_EQ("'foo", Events(R"("foo")"));
+  EXPECT_EQ("'a\"b\n", Events(R"("a\"b\n")"));
+  EXPECT_EQ(std::string("'\0", 2), Events(R"("\u0000")"));
+  EXPECT_EQ("'\xE2\x82\xAC\xF0\x9D\x84\x9E",
+            Events("\"\xE2\x82\xAC\xF0\x9D\x84\x9E\""));
+  EXPECT_EQ("[ ]", Events("[]"));
+  EXPECT_EQ("{ }", Events("{ }"));
+  // Unlike parse() into a Value, duplicate keys and key order are kept.
+  EXPECT_EQ("{ 'b': i1 'a': [ i2 [ ] { } ] 'b': null }",
+            Events(R"({"b": 1, "a": [2, [], {}], "b": null})"));
+  EXPECT_EQ("[ [ [ [ 'x ] ] ] true ]", Events("\r[\n\t[[[\"x\"]]],true] "));
+
+  // Deep nesting does not use the call stack.
+  std::string Deep = std::string(100000, '[') + std::string(100000, ']');
+  EXPECT_EQ(399999u, Events(Deep).size());
+}
+
+TEST(JSONTest, ParseEventsErrors) {
+  // The streaming parser reports the same errors as parse().
+  for (llvm::StringRef S : {"", "[", "[][]", "fuzzy", "[2?]", "{a:2}",
+                            R"({"a",2})", R"({"a":2 "b":3})", R"([&%!])",
+                            "1e1.0", R"("abc\"def)", "\"abc\ndef\"",
+                            R"("\030")", R"("\usuck")", "{\n  \"valid\": 1,\n  "
+                            "invalid: 2\n}", "\"\xC0\x80\"", "[\"a\xC0\x80\"]",
+                            "\"\\n\xC0\x80\""}) {
+    Expected<Value> V = parse(S);
+    ASSERT_FALSE(bool(V)) << S;
+    EventRecorder R;
+    Error E = parse(S, R);
+    ASSERT_TRUE(bool(E)) << S;
+    EXPECT_EQ(toString(V.takeError()), toString(std::move(E))) << S;
+  }
+
+  EventRecorder R;
+  R.StopAt = 3;
+  Error E = parse(R"([1, [2], 3])", R);
+  EXPECT_EQ("[ i1 [ i2", R.Events);
+  EXPECT_EQ("[1:6, byte=6]: Stopped by handler", toString(std::move(E)));
+}
+
 // Direct tests of isUTF8 and fixUTF8. Internal uses are also tested elsewhere.
 TEST(JSONTest, UTF8) {
   for (const char *Valid : {
@@ -402,11 +488,14 @@ TEST(JSONTest, Stream) {
       J.objectEnd();
       J.attributeEnd();
       J.attribute("baz", "xyz");
+      J.attributeBegin("qux");
+      J.rawValue([](raw_ostream &OS) { OS << "[1, 2]"; });
+      J.attributeEnd();
     });
     return OS.str();
   };
 
-  const char *Plain = R"({"foo":[null,42.5,[43]],"bar":{},"baz":"xyz"})";
+  const char *Plain = R"({"foo":[null,42.5,[43]],"bar":{},"baz":"xyz","qux":[1, 2]})";
   EXPECT_EQ(Plain, StreamStuff(0));
   const char *Pretty = R"({
   "foo": [
@@ -417,7 +506,8 @@ TEST(JSONTest, Stream) {
     ]
   ],
   "bar": {},
-  "baz": "xyz"
+  "baz": "xyz",
+  "qux": [1, 2]
 })";
   EXPECT_EQ(Pretty, StreamStuff(2));
 }
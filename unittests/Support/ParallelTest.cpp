@@ -14,6 +14,7 @@
 #include "llvm/Support/Parallel.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
 #include <random>
 
 uint32_t array[1024 * 1024];
@@ -49,4 +50,30 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+TEST(Parallel, NestedForEach) {
+  // Inner loops run on worker threads and wait for their own task groups.
+  // This must neither deadlock nor lose iterations.
+  std::atomic<unsigned> Count{0};
+  for_each_n(parallel::par, 0, 64, [&](size_t) {
+    for_each_n(parallel::par, 0, 2048, [&](size_t) { ++Count; });
+  });
+  ASSERT_EQ(Count, 64u * 2048u);
+}
+
+TEST(Parallel, NestedTaskGroups) {
+  std::atomic<unsigned> Count{0};
+  {
+    parallel::detail::TaskGroup Outer;
+    for (int I = 0; I < 16; ++I)
+      Outer.spawn([&] {
+        parallel::detail::TaskGroup Inner;
+        for (int J = 0; J < 16; ++J)
+          Inner.spawn([&] { ++Count; });
+        Inner.sync();
+        ++Count;
+      });
+  }
+  ASSERT_EQ(Count, 16u * 16u + 16u);
+}
+
 #endif
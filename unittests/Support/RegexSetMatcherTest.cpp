@@ -0,0 +1,142 @@
+//===- RegexSetMatcherTest.cpp - Unit tests for RegexSetMatcher -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/RegexSetMatcher.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Regex.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+class RegexSetMatcherTest : public ::testing::Test {
+protected:
+  std::unique_ptr<RegexSetMatcher>
+  makeMatcher(std::vector<std::string> Regexes) {
+    std::unique_ptr<RegexSetMatcher> WM = make_unique<RegexSetMatcher>();
+    for (auto &Regex : Regexes) {
+      std::string Error;
+      EXPECT_TRUE(WM->insert(Regex, Error)) << Regex << ": " << Error;
+    }
+    WM->finalize();
+    return WM;
+  }
+};
+
+TEST_F(RegexSetMatcherTest, Empty) {
+  std::unique_ptr<RegexSetMatcher> WM = makeMatcher({});
+  EXPECT_FALSE(WM->match("foo"));
+  EXPECT_FALSE(WM->match(""));
+}
+
+TEST_F(RegexSetMatcherTest, Invalid) {
+  RegexSetMatcher WM;
+  for (StringRef Regex : {"a(", "[b-a]", "[ab", "a\\", "a**"}) {
+    std::string Error;
+    EXPECT_FALSE(WM.insert(Regex, Error)) << Regex;
+    EXPECT_FALSE(Error.empty()) << Regex;
+  }
+  EXPECT_EQ(0u, WM.size());
+}
+
+TEST_F(RegexSetMatcherTest, Regexes) {
+  std::unique_ptr<RegexSetMatcher> WM =
+      makeMatcher({"_ZN(base|net)Lock.*", "a|b", "ab*c", "x[[:digit:]]+y",
+                   "(q)\\2", "\\.*z"});
+  EXPECT_EQ(0u, WM->match("_ZNnetLock1"));
+  EXPECT_FALSE(WM->match("_ZNfooLock1"));
+  EXPECT_EQ(1u, WM->match("b"));
+  EXPECT_FALSE(WM->match("ab"));
+  EXPECT_EQ(2u, WM->match("ac"));
+  EXPECT_EQ(2u, WM->match("abbc"));
+  EXPECT_EQ(3u, WM->match("x12y"));
+  EXPECT_FALSE(WM->match("xy"));
+  EXPECT_EQ(4u, WM->match("qq"));
+  EXPECT_EQ(5u, WM->match("..z"));
+  EXPECT_EQ(5u, WM->match("z"));
+}
+
+TEST_F(RegexSetMatcherTest, Segments) {
+  std::unique_ptr<RegexSetMatcher> WM =
+      makeMatcher({"foo.*", ".*bar", "a.*b.*c", "x.z", ".*mid.*"});
+  EXPECT_EQ(0u, WM->match("foo"));
+  EXPECT_EQ(0u, WM->match("foobar"));
+  EXPECT_EQ(1u, WM->match("bar"));
+  EXPECT_EQ(2u, WM->match("abc"));
+  EXPECT_EQ(2u, WM->match("a_b_b_c"));
+  EXPECT_FALSE(WM->match("acb"));
+  EXPECT_FALSE(WM->match("ab"));
+  EXPECT_EQ(3u, WM->match("xyz"));
+  EXPECT_FALSE(WM->match("xz"));
+  EXPECT_FALSE(WM->match("xyyz"));
+  EXPECT_EQ(4u, WM->match("amidst"));
+  EXPECT_FALSE(WM->match("mi"));
+}
+
+TEST_F(RegexSetMatcherTest, FirstInserted) {
+  std::unique_ptr<RegexSetMatcher> WM =
+      makeMatcher({".*ab.*", ".*abc.*", ".*", "abc"});
+  EXPECT_EQ(0u, WM->match("xabcx"));
+  EXPECT_EQ(2u, WM->match("xbcx"));
+}
+
+TEST_F(RegexSetMatcherTest, Brackets) {
+  std::unique_ptr<RegexSetMatcher> WM =
+      makeMatcher({"[Tt]est.*", "v[0-9][^0-9]", "[]-]x", "y[a-]"});
+  EXPECT_EQ(0u, WM->match("Test1"));
+  EXPECT_EQ(0u, WM->match("test"));
+  EXPECT_FALSE(WM->match("best"));
+  EXPECT_EQ(1u, WM->match("v1a"));
+  EXPECT_FALSE(WM->match("v12"));
+  EXPECT_EQ(2u, WM->match("]x"));
+  EXPECT_EQ(2u, WM->match("-x"));
+  EXPECT_EQ(3u, WM->match("y-"));
+  EXPECT_FALSE(WM->match("yb"));
+}
+
+TEST_F(RegexSetMatcherTest, Escapes) {
+  std::unique_ptr<RegexSetMatcher> WM = makeMatcher({"a\\.b.*", "\\*x"});
+  EXPECT_EQ(0u, WM->match("a.b"));
+  EXPECT_FALSE(WM->match("axb"));
+  EXPECT_EQ(1u, WM->match("*x"));
+}
+
+// Overlapping literals exercise the failure links of the automaton.
+TEST_F(RegexSetMatcherTest, OverlappingLiterals) {
+  std::unique_ptr<RegexSetMatcher> WM =
+      makeMatcher({".*she.*", ".*he.*x", ".*hers", ".*is.*y"});
+  EXPECT_EQ(0u, WM->match("ushers"));
+  EXPECT_EQ(1u, WM->match("the_x"));
+  EXPECT_EQ(2u, WM->match("hers"));
+  EXPECT_EQ(3u, WM->match("hisy"));
+  EXPECT_FALSE(WM->match("his"));
+}
+
+// The matcher must agree with Regex on what it accepts.
+TEST_F(RegexSetMatcherTest, AgreesWithRegex) {
+  std::vector<std::string> Wildcards = {
+      "a.*b",    ".*[ab]c.*", "a..b.*", ".*a.*a.*", "[^a]b", "a.*ab",
+      ".*aba",   "a+b",       "(a|b)a", "ab?a",     "a{2}b", "(ab)+",
+      "a(b)*a.*"};
+  std::vector<std::string> Queries = {"", "a", "ab", "aab", "abab", "acb",
+                                      "bc", "xacx", "a12b", "aaa", "bb",
+                                      "ab", "aaba", "abba"};
+  for (const std::string &Wildcard : Wildcards) {
+    std::unique_ptr<RegexSetMatcher> WM = makeMatcher({Wildcard});
+    Regex R("^(" + Wildcard + ")$");
+    for (const std::string &Query : Queries)
+      EXPECT_EQ(R.match(Query), WM->match(Query).hasValue())
+          << Wildcard << " " << Query;
+  }
+}
+
+}  // namespace
@@ -170,6 +170,97 @@ TEST_F(RegexTest, MatchInvalid) {
   EXPECT_FALSE(r1.match("X"));
 }
 
+TEST_F(RegexTest, LeftmostLongest) {
+  SmallVector<StringRef, 4> Matches;
+  Regex r1("a|ab|abc");
+  EXPECT_TRUE(r1.match("xxabcd", &Matches));
+  ASSERT_EQ(1u, Matches.size());
+  EXPECT_EQ("abc", Matches[0]);
+
+  Regex r2("[0-9]+(x[0-9]+)?");
+  EXPECT_TRUE(r2.match("a 12 34x5x", &Matches));
+  ASSERT_EQ(2u, Matches.size());
+  EXPECT_EQ("12", Matches[0]);
+  EXPECT_EQ("", Matches[1]);
+  EXPECT_TRUE(r2.match("a 34x56x", &Matches));
+  EXPECT_EQ("34x56", Matches[0]);
+  EXPECT_EQ("x56", Matches[1]);
+
+  Regex r3("(a*)(b|abc)");
+  EXPECT_TRUE(r3.match("aabcd", &Matches));
+  ASSERT_EQ(3u, Matches.size());
+  EXPECT_EQ("aabc", Matches[0]);
+  EXPECT_EQ("a", Matches[1]);
+  EXPECT_EQ("abc", Matches[2]);
+
+  Regex r4("x*");
+  EXPECT_TRUE(r4.match("abc", &Matches));
+  EXPECT_EQ(0u, Matches[0].size());
+  EXPECT_EQ("abc", StringRef(Matches[0].data(), 3));
+
+  Regex r5("b{2,3}");
+  StringRef Bs = "abbbbc";
+  EXPECT_TRUE(r5.match(Bs, &Matches));
+  EXPECT_EQ(Bs.substr(1, 3), Matches[0]);
+  EXPECT_EQ(Bs.data() + 1, Matches[0].data());
+  EXPECT_FALSE(r5.match("abc"));
+}
+
+TEST_F(RegexTest, Anchors) {
+  SmallVector<StringRef, 4> Matches;
+  Regex r1("^b+$");
+  EXPECT_FALSE(r1.match("a\nbb\nc"));
+  EXPECT_TRUE(r1.match("bbb"));
+
+  Regex r2("^b+$", Regex::Newline);
+  EXPECT_TRUE(r2.match("a\nbb\nc", &Matches));
+  EXPECT_EQ("bb", Matches[0]);
+  EXPECT_FALSE(r2.match("a\nbbc"));
+
+  Regex r3("(^|,)x($|,)", Regex::Newline);
+  EXPECT_TRUE(r3.match("ax,\nx,y", &Matches));
+  ASSERT_EQ(3u, Matches.size());
+  EXPECT_EQ("x,", Matches[0]);
+  EXPECT_EQ("", Matches[1]);
+  EXPECT_EQ(",", Matches[2]);
+
+  Regex r4("a.c", Regex::Newline);
+  EXPECT_FALSE(r4.match("a\nc"));
+  EXPECT_TRUE(Regex("a.c").match("a\nc"));
+  EXPECT_FALSE(Regex("a[^x]c", Regex::Newline).match("a\nc"));
+}
+
+TEST_F(RegexTest, BracketsAndCase) {
+  EXPECT_TRUE(Regex("[]a]+").match("]a]"));
+  EXPECT_TRUE(Regex("^[^]a]$").match("b"));
+  EXPECT_FALSE(Regex("^[^]a]$").match("]"));
+  EXPECT_TRUE(Regex("^[a-]+$").match("-a-"));
+  EXPECT_TRUE(Regex("^[[:alpha:]_][[:alnum:]_]*$").match("_foo12"));
+  EXPECT_FALSE(Regex("^[[:alpha:]_][[:alnum:]_]*$").match("1foo"));
+  EXPECT_TRUE(Regex("^[[:xdigit:]]+[[:space:]]$").match("DEADbeef\t"));
+  EXPECT_TRUE(Regex("a{").match("a{"));
+  EXPECT_TRUE(Regex("^x{2}y{1,}z{0,1}$").match("xxyyy"));
+
+  EXPECT_TRUE(Regex("^ab[c-e]$", Regex::IgnoreCase).match("AbD"));
+  EXPECT_TRUE(Regex("^[^a]$", Regex::IgnoreCase).match("b"));
+  EXPECT_FALSE(Regex("^[^a]$", Regex::IgnoreCase).match("A"));
+}
+
+TEST_F(RegexTest, LinearTime) {
+  // These take exponential time with naive backtracking, and create many DFA
+  // states.
+  std::string As(100000, 'a');
+  EXPECT_FALSE(Regex("(a|aa)*c").match(As));
+  EXPECT_TRUE(Regex("(a|aa)*$").match(As));
+  std::string Bits;
+  for (unsigned I = 0; I != 20000; ++I)
+    Bits += (I * 7919) % 13 < 6 ? 'a' : 'b';
+  Bits += "abbbbbbbbbbbbb";
+  SmallVector<StringRef, 1> Matches;
+  EXPECT_TRUE(Regex("a[ab]{12}b$").match(Bits, &Matches));
+  EXPECT_EQ(StringRef(Bits).take_back(14), Matches[0]);
+}
+
 // https://bugs.chromium.org/p/oss-fuzz/issues/detail?id=3727
 TEST_F(RegexTest, OssFuzz3727Regression) {
   // Wrap in a StringRef so the NUL byte doesn't terminate the string
@@ -496,3 +496,59 @@ TEST_F(SourceMgrTest, FixitForTab) {
             Output);
 }
 
+
+TEST_F(SourceMgrTest, LineAndColumn) {
+  setMainBuffer("aaa\nbb\r\n\ncc\rdd", "file.in");
+  EXPECT_EQ(std::make_pair(1u, 1u), SM.getLineAndColumn(getLoc(0)));
+  EXPECT_EQ(std::make_pair(1u, 4u), SM.getLineAndColumn(getLoc(3)));
+  EXPECT_EQ(std::make_pair(2u, 2u), SM.getLineAndColumn(getLoc(5)));
+  EXPECT_EQ(std::make_pair(3u, 1u), SM.getLineAndColumn(getLoc(8)));
+  EXPECT_EQ(std::make_pair(4u, 2u), SM.getLineAndColumn(getLoc(10)));
+  // A lone '\r' restarts the column count but not the line count.
+  EXPECT_EQ(std::make_pair(4u, 1u), SM.getLineAndColumn(getLoc(12)));
+  // The end of the buffer is part of the last line.
+  EXPECT_EQ(std::make_pair(4u, 3u), SM.getLineAndColumn(getLoc(14)));
+}
+
+// Buffers of different sizes use different offset types in the line index,
+// and are indexed incrementally as lookups move forward.
+TEST_F(SourceMgrTest, LineAndColumnLargeBuffers) {
+  for (unsigned NumLines : {10u, 1000u, 100000u}) {
+    SourceMgr LocalSM;
+    std::string Text;
+    std::vector<unsigned> LineStarts;
+    for (unsigned I = 0; I < NumLines; ++I) {
+      LineStarts.push_back(Text.size());
+      Text += std::string(I % 37, 'x') + "\n";
+    }
+    unsigned ID = LocalSM.AddNewSourceBuffer(
+        MemoryBuffer::getMemBuffer(Text, "file.in"), SMLoc());
+    const char *Start = LocalSM.getMemoryBuffer(ID)->getBufferStart();
+    auto Check = [&](unsigned Line) {
+      unsigned Col = Line % 37 ? Line % 37 : 1;
+      SMLoc Loc = SMLoc::getFromPointer(Start + LineStarts[Line] + Col - 1);
+      EXPECT_EQ(std::make_pair(Line + 1, Col),
+                LocalSM.getLineAndColumn(Loc, ID));
+      EXPECT_EQ(Loc, LocalSM.FindLocForLineAndColumn(ID, Line + 1, Col));
+    };
+    Check(0);
+    Check(NumLines / 2);
+    Check(NumLines / 3);
+    Check(NumLines - 1);
+    Check(1);
+  }
+}
+
+TEST_F(SourceMgrTest, FindLocForLineAndColumn) {
+  setMainBuffer("aaa\nbb\n\ncc", "file.in");
+  EXPECT_EQ(getLoc(0), SM.FindLocForLineAndColumn(MainBufferID, 1, 1));
+  EXPECT_EQ(getLoc(3), SM.FindLocForLineAndColumn(MainBufferID, 1, 4));
+  EXPECT_EQ(getLoc(5), SM.FindLocForLineAndColumn(MainBufferID, 2, 2));
+  EXPECT_EQ(getLoc(7), SM.FindLocForLineAndColumn(MainBufferID, 3, 1));
+  EXPECT_EQ(getLoc(10), SM.FindLocForLineAndColumn(MainBufferID, 4, 3));
+  EXPECT_EQ(SMLoc(), SM.FindLocForLineAndColumn(MainBufferID, 0, 1));
+  EXPECT_EQ(SMLoc(), SM.FindLocForLineAndColumn(MainBufferID, 1, 0));
+  EXPECT_EQ(SMLoc(), SM.FindLocForLineAndColumn(MainBufferID, 1, 6));
+  EXPECT_EQ(SMLoc(), SM.FindLocForLineAndColumn(MainBufferID, 4, 4));
+  EXPECT_EQ(SMLoc(), SM.FindLocForLineAndColumn(MainBufferID, 5, 1));
+}
@@ -163,3 +163,112 @@ TEST_F(ThreadPoolTest, PoolDestruction) {
   }
   ASSERT_EQ(5, checked_in);
 }
+
+TEST_F(ThreadPoolTest, TypedFuture) {
+  CHECK_UNSUPPORTED();
+  ThreadPool Pool{2};
+  std::shared_future<int> F1 = Pool.async([] { return 42; });
+  std::shared_future<int> F2 = Pool.async([](int X) { return X + 1; }, 1);
+  ASSERT_EQ(42, F1.get());
+  ASSERT_EQ(2, F2.get());
+}
+
+struct MemberTask {
+  int Value = 0;
+  void add(int X) { Value += X; }
+};
+
+TEST_F(ThreadPoolTest, MemberFunction) {
+  CHECK_UNSUPPORTED();
+  MemberTask M;
+  ThreadPool Pool{1};
+  Pool.async(&MemberTask::add, &M, 3);
+  Pool.async(&MemberTask::add, std::ref(M), 4);
+  Pool.wait();
+  ASSERT_EQ(7, M.Value);
+}
+
+TEST_F(ThreadPoolTest, GroupWait) {
+  CHECK_UNSUPPORTED();
+  // One more thread than the number of tasks blocked in Group2.
+  ThreadPool Pool{4};
+  ThreadPoolTaskGroup Group1(Pool);
+  ThreadPoolTaskGroup Group2(Pool);
+  std::atomic_int checked_in1{0};
+  std::atomic_int checked_in2{0};
+  for (size_t i = 0; i < 3; ++i)
+    Group2.async([this, &checked_in2] {
+      waitForMainThread();
+      ++checked_in2;
+    });
+  for (size_t i = 0; i < 3; ++i)
+    Group1.async([&checked_in1] { ++checked_in1; });
+  // Group1 can be waited for while Group2 is blocked.
+  Group1.wait();
+  ASSERT_EQ(3, checked_in1);
+  ASSERT_EQ(0, checked_in2);
+  setMainThreadReady();
+  Group2.wait();
+  ASSERT_EQ(3, checked_in2);
+}
+
+TEST_F(ThreadPoolTest, GroupWaitFromTask) {
+  CHECK_UNSUPPORTED();
+  // A task waiting on another group must not deadlock, even when it occupies
+  // the only thread of the pool.
+  ThreadPool Pool{1};
+  std::atomic_int checked_in{0};
+  ThreadPoolTaskGroup Outer(Pool);
+  Outer.async([&] {
+    ThreadPoolTaskGroup Inner(Pool);
+    for (size_t i = 0; i < 5; ++i)
+      Inner.async([&checked_in] { ++checked_in; });
+    Inner.wait();
+    ASSERT_EQ(5, checked_in);
+  });
+  Outer.wait();
+  ASSERT_EQ(5, checked_in);
+}
+
+TEST_F(ThreadPoolTest, Dependencies) {
+  CHECK_UNSUPPORTED();
+  ThreadPool Pool{4};
+  ThreadPoolTaskGroup Y(Pool), Z(Pool), X(Pool);
+  std::atomic_int checked_in{0};
+  Y.async([this, &checked_in] {
+    waitForMainThread();
+    ++checked_in;
+  });
+  Z.async([&checked_in] { ++checked_in; });
+  std::shared_future<int> Result =
+      X.asyncAfter({&Y, &Z}, [&checked_in] { return checked_in.load(); });
+  Z.wait();
+  ASSERT_EQ(1, checked_in);
+  setMainThreadReady();
+  ASSERT_EQ(2, Result.get());
+  Pool.wait();
+}
+
+TEST_F(ThreadPoolTest, Priorities) {
+  CHECK_UNSUPPORTED();
+  ThreadPool Pool{1};
+  ThreadPoolTaskGroup Normal(Pool);
+  ThreadPoolTaskGroup High(Pool, ThreadPool::Priority::High);
+  std::mutex Lock;
+  std::vector<int> Order;
+  // Block the only thread until everything has been queued.
+  Pool.async([this] { waitForMainThread(); });
+  Normal.async([&] {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Order.push_back(1);
+  });
+  High.async([&] {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Order.push_back(2);
+  });
+  setMainThreadReady();
+  Pool.wait();
+  ASSERT_EQ(2u, Order.size());
+  ASSERT_EQ(2, Order[0]);
+  ASSERT_EQ(1, Order[1]);
+}
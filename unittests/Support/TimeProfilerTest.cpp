@@ -0,0 +1,116 @@
+//===- unittests/TimeProfilerTest.cpp - Time trace profiler tests ---------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/JSON.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <set>
+#include <thread>
+
+using namespace llvm;
+
+namespace {
+
+// Longer than the default granularity of the profiler.
+void tracedWork(StringRef Detail) {
+  TimeTraceScope Scope("Work", Detail);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+}
+
+json::Array writeTrace() {
+  SmallString<1024> Trace;
+  raw_svector_ostream OS(Trace);
+  timeTraceProfilerWrite(OS);
+  Expected<json::Value> Parsed = json::parse(Trace);
+  EXPECT_TRUE(bool(Parsed));
+  if (!Parsed) {
+    consumeError(Parsed.takeError());
+    return {};
+  }
+  return *Parsed->getAsObject()->getArray("traceEvents");
+}
+
+// Returns the events of phase \p Ph named \p Name.
+std::vector<const json::Object *> getEvents(const json::Array &Events,
+                                            StringRef Ph, StringRef Name) {
+  std::vector<const json::Object *> Result;
+  for (const json::Value &V : Events) {
+    const json::Object *E = V.getAsObject();
+    if (E->getString("ph") == Ph && E->getString("name") == Name)
+      Result.push_back(E);
+  }
+  return Result;
+}
+
+TEST(TimeProfilerTest, SingleThread) {
+  timeTraceProfilerInitialize();
+  tracedWork("a");
+  timeTraceProfilerInstant("Checkpoint", "b");
+  timeTraceProfilerCounter("Jobs", 3);
+  json::Array Events = writeTrace();
+  timeTraceProfilerCleanup();
+
+  auto Work = getEvents(Events, "X", "Work");
+  ASSERT_EQ(1u, Work.size());
+  EXPECT_EQ(StringRef("a"),
+            Work[0]->getObject("args")->getString("detail").getValueOr(""));
+  auto Instants = getEvents(Events, "i", "Checkpoint");
+  ASSERT_EQ(1u, Instants.size());
+  EXPECT_EQ(Work[0]->getInteger("tid"), Instants[0]->getInteger("tid"));
+  auto Counters = getEvents(Events, "C", "Jobs");
+  ASSERT_EQ(1u, Counters.size());
+  EXPECT_EQ(3, *Counters[0]->getObject("args")->getInteger("Jobs"));
+  EXPECT_EQ(1u, getEvents(Events, "M", "thread_name").size());
+
+  // A new session starts from scratch.
+  timeTraceProfilerInitialize();
+  json::Array Empty = writeTrace();
+  timeTraceProfilerCleanup();
+  EXPECT_TRUE(getEvents(Empty, "X", "Work").empty());
+  EXPECT_TRUE(getEvents(Empty, "M", "thread_name").empty());
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(TimeProfilerTest, Threads) {
+  const unsigned NumThreads = 4;
+  timeTraceProfilerInitialize();
+  tracedWork("main");
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I != NumThreads; ++I)
+    Threads.emplace_back([I] {
+      tracedWork("worker");
+      timeTraceProfilerCounter("Worker", I);
+    });
+  for (std::thread &T : Threads)
+    T.join();
+  json::Array Events = writeTrace();
+  timeTraceProfilerCleanup();
+
+  // Every thread has a track of its own.
+  auto Work = getEvents(Events, "X", "Work");
+  ASSERT_EQ(NumThreads + 1, Work.size());
+  std::set<int64_t> Tids;
+  for (const json::Object *E : Work)
+    Tids.insert(*E->getInteger("tid"));
+  EXPECT_EQ(NumThreads + 1, Tids.size());
+  EXPECT_EQ(NumThreads + 1, getEvents(Events, "M", "thread_name").size());
+  EXPECT_EQ(NumThreads, getEvents(Events, "C", "Worker").size());
+
+  // Totals are merged over all threads, on tracks of their own.
+  auto Totals = getEvents(Events, "X", "Total Work");
+  ASSERT_EQ(1u, Totals.size());
+  EXPECT_EQ(int64_t(NumThreads + 1),
+            *Totals[0]->getObject("args")->getInteger("count"));
+  EXPECT_GT(*Totals[0]->getInteger("tid"), *Tids.rbegin());
+}
+#endif
+
+} // end anonymous namespace
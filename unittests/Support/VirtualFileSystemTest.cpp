@@ -16,8 +16,10 @@
 #include "llvm/Support/SourceMgr.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include <atomic>
 #include <map>
 #include <string>
+#include <thread>
 
 using namespace llvm;
 using llvm::sys::fs::UniqueID;
@@ -865,6 +867,172 @@ TEST(ProxyFileSystemTest, Basic) {
   EXPECT_FALSE(Local);
 }
 
+namespace {
+/// Counts the calls made to the file system below a CachingFileSystem.
+class CountingFileSystem : public vfs::ProxyFileSystem {
+public:
+  explicit CountingFileSystem(IntrusiveRefCntPtr<vfs::FileSystem> FS)
+      : ProxyFileSystem(std::move(FS)) {}
+
+  ErrorOr<vfs::Status> status(const Twine &Path) override {
+    ++StatusCalls;
+    return ProxyFileSystem::status(Path);
+  }
+  ErrorOr<std::unique_ptr<vfs::File>>
+  openFileForRead(const Twine &Path) override {
+    ++OpenCalls;
+    return ProxyFileSystem::openFileForRead(Path);
+  }
+  vfs::directory_iterator dir_begin(const Twine &Dir,
+                                    std::error_code &EC) override {
+    ++DirBeginCalls;
+    return ProxyFileSystem::dir_begin(Dir, EC);
+  }
+
+  std::atomic<unsigned> StatusCalls{0}, OpenCalls{0}, DirBeginCalls{0};
+};
+
+class CachingFileSystemTest : public ::testing::Test {
+protected:
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> Base;
+  IntrusiveRefCntPtr<CountingFileSystem> Counter;
+
+  CachingFileSystemTest()
+      : Base(new vfs::InMemoryFileSystem()),
+        Counter(new CountingFileSystem(Base)) {
+    Base->setCurrentWorkingDirectory("/");
+    Base->addFile("/include/a.h", 0, MemoryBuffer::getMemBuffer("a"));
+    Base->addFile("/include/sys/b.h", 0, MemoryBuffer::getMemBuffer("b"));
+    Base->addFile("/usr/c.h", 0, MemoryBuffer::getMemBuffer("c"));
+  }
+};
+} // namespace
+
+TEST_F(CachingFileSystemTest, Status) {
+  vfs::CachingFileSystem FS(Counter);
+  auto Stat = FS.status("/include/a.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_EQ("/include/a.h", Stat->getName());
+  EXPECT_EQ(1u, Counter->StatusCalls);
+
+  // Other spellings of the same path are answered from the cache, with the
+  // name as it was asked for.
+  ASSERT_FALSE(FS.setCurrentWorkingDirectory("/include"));
+  Stat = FS.status("./a.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_EQ("./a.h", Stat->getName());
+  EXPECT_TRUE(FS.exists("/include/./a.h"));
+  EXPECT_EQ(1u, Counter->StatusCalls);
+
+  auto File = FS.openFileForRead("a.h");
+  ASSERT_FALSE(File.getError());
+  EXPECT_EQ("a", (*(*File)->getBuffer("ignored"))->getBuffer());
+}
+
+TEST_F(CachingFileSystemTest, MissingPaths) {
+  vfs::CachingFileSystem FS(Counter, /*UseDirectoryListings=*/true);
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS.status("/usr/a.h").getError());
+  EXPECT_EQ(1u, Counter->StatusCalls);
+  EXPECT_EQ(1u, Counter->DirBeginCalls);
+
+  // The miss is cached, and the listing of /usr answers the other misses.
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS.openFileForRead("/usr/a.h").getError());
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS.status("/usr/b.h").getError());
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS.openFileForRead("/usr/sys/b.h").getError());
+  EXPECT_EQ(1u, Counter->StatusCalls);
+  EXPECT_EQ(0u, Counter->OpenCalls);
+  EXPECT_FALSE(FS.status("/usr/c.h").getError());
+  EXPECT_EQ(2u, Counter->StatusCalls);
+
+  // Lookups in directories that do not exist fail after one listing.
+  EXPECT_FALSE(FS.exists("/opt/include/a.h"));
+  EXPECT_FALSE(FS.exists("/opt/include/b.h"));
+  EXPECT_EQ(3u, Counter->StatusCalls);
+  std::error_code EC;
+  FS.dir_begin("/opt/include", EC);
+  EXPECT_EQ(errc::no_such_file_or_directory, EC);
+}
+
+TEST_F(CachingFileSystemTest, MissingPathsWithDotDot) {
+  vfs::CachingFileSystem FS(Counter, /*UseDirectoryListings=*/true);
+  EXPECT_FALSE(FS.exists("/include/c.h"));
+  EXPECT_EQ(1u, Counter->DirBeginCalls);
+
+  // The listing of /include has no '..', which doesn't make the paths through
+  // it missing.
+  EXPECT_TRUE(FS.exists("/include/../usr/c.h"));
+  EXPECT_TRUE(FS.exists("/include/sys/../a.h"));
+  EXPECT_FALSE(FS.exists("/include/../usr/d.h"));
+}
+
+TEST_F(CachingFileSystemTest, NoDirectoryListings) {
+  vfs::CachingFileSystem FS(Counter, /*UseDirectoryListings=*/false);
+  EXPECT_FALSE(FS.exists("/usr/a.h"));
+  EXPECT_FALSE(FS.exists("/usr/a.h"));
+  EXPECT_FALSE(FS.exists("/usr/b.h"));
+  EXPECT_EQ(2u, Counter->StatusCalls);
+  EXPECT_EQ(0u, Counter->DirBeginCalls);
+}
+
+TEST_F(CachingFileSystemTest, DirectoryIteration) {
+  vfs::CachingFileSystem FS(Counter);
+  for (int I = 0; I != 2; ++I) {
+    std::error_code EC;
+    std::vector<std::string> Paths;
+    for (vfs::directory_iterator It = FS.dir_begin(I ? "include" : "/include",
+                                                   EC),
+                                 End;
+         !EC && It != End; It.increment(EC))
+      Paths.push_back(It->path());
+    ASSERT_FALSE(EC);
+    if (I)
+      EXPECT_THAT(Paths, UnorderedElementsAre("include/a.h", "include/sys"));
+    else
+      EXPECT_THAT(Paths, UnorderedElementsAre("/include/a.h", "/include/sys"));
+  }
+  EXPECT_EQ(1u, Counter->DirBeginCalls);
+}
+
+TEST_F(CachingFileSystemTest, Invalidate) {
+  vfs::CachingFileSystem FS(Counter);
+  EXPECT_FALSE(FS.exists("/include/d.h"));
+  Base->addFile("/include/d.h", 0, MemoryBuffer::getMemBuffer("d"));
+  EXPECT_FALSE(FS.exists("/include/d.h"));
+  EXPECT_FALSE(FS.exists("/include/e.h"));
+
+  FS.invalidate("/include/d.h");
+  EXPECT_TRUE(FS.exists("/include/d.h"));
+  EXPECT_FALSE(FS.exists("/include/e.h"));
+
+  Base->addFile("/include/e.h", 0, MemoryBuffer::getMemBuffer("e"));
+  FS.invalidateAll();
+  EXPECT_TRUE(FS.exists("/include/e.h"));
+}
+
+#if LLVM_ENABLE_THREADS
+TEST_F(CachingFileSystemTest, Threads) {
+  vfs::CachingFileSystem FS(Counter);
+  std::vector<std::thread> Threads;
+  std::atomic<unsigned> Found{0};
+  for (int T = 0; T != 4; ++T)
+    Threads.emplace_back([&] {
+      for (int I = 0; I != 100; ++I) {
+        Found += FS.exists("/include/a.h");
+        Found += FS.exists("/include/sys/b.h");
+        Found += FS.exists("/include/sys/c.h");
+        FS.invalidate("/include/sys/b.h");
+      }
+    });
+  for (std::thread &T : Threads)
+    T.join();
+  EXPECT_EQ(800u, Found);
+}
+#endif
+
 class InMemoryFileSystemTest : public ::testing::Test {
 protected:
   llvm::vfs::InMemoryFileSystem FS;
@@ -104,6 +104,40 @@ TEST(YAMLIO, TestMalformedMapRead) {
   EXPECT_TRUE(!!yin.error());
 }
 
+TEST(YAMLIO, TestMapReadOutOfOrder) {
+  FooBar doc;
+  Input yin("---\nbar:  5\nfoo:  3\n...\n");
+  yin >> doc;
+
+  EXPECT_FALSE(yin.error());
+  EXPECT_EQ(doc.foo, 3);
+  EXPECT_EQ(doc.bar, 5);
+}
+
+static void collectErrorMessages(const llvm::SMDiagnostic &Diag, void *Ctxt) {
+  *static_cast<std::string *>(Ctxt) += Diag.getMessage();
+}
+
+TEST(YAMLIO, TestMapReadBadKeys) {
+  FooBar doc;
+  {
+    std::string Errors;
+    Input yin("{foo: 3, bar: 5, baz: 7}", nullptr, collectErrorMessages,
+              &Errors);
+    yin >> doc;
+    EXPECT_TRUE(!!yin.error());
+    EXPECT_EQ("unknown key 'baz'", Errors);
+  }
+  {
+    std::string Errors;
+    Input yin("{foo: 3, bar: 5, foo: 7}", nullptr, collectErrorMessages,
+              &Errors);
+    yin >> doc;
+    EXPECT_TRUE(!!yin.error());
+    EXPECT_EQ("duplicated mapping key 'foo'", Errors);
+  }
+}
+
 //
 // Test the reading of a yaml sequence of mappings
 //
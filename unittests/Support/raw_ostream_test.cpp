@@ -8,7 +8,10 @@
 
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
@@ -342,4 +345,79 @@ TEST(raw_fd_ostreamTest, multiple_raw_fd_ostream_to_stdout) {
   { raw_fd_ostream("-", EC, sys::fs::OpenFlags::F_None); }
   { raw_fd_ostream("-", EC, sys::fs::OpenFlags::F_None); }
 }
+
+static std::string readFile(StringRef Path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buf = MemoryBuffer::getFile(Path);
+  EXPECT_TRUE(bool(Buf));
+  return Buf ? (*Buf)->getBuffer().str() : std::string();
+}
+
+TEST(raw_fd_ostreamTest, MappedOutput) {
+  SmallString<64> Path;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("mapped", "out", Path));
+  FileRemover Cleanup(Path);
+
+  // Write enough to need several windows, with writes of all sizes.
+  std::string Expected;
+  {
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC, sys::fs::CD_CreateAlways,
+                      sys::fs::FA_Read | sys::fs::FA_Write, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    ASSERT_FALSE(OS.enableMappedOutput());
+    EXPECT_TRUE(OS.isMappedOutput());
+    std::string Big(3 << 20, 'b');
+    for (unsigned I = 0; I < 100000; ++I) {
+      OS << I << ' ';
+      Expected += std::to_string(I) + ' ';
+      if (I % 20000 == 0) {
+        OS << Big;
+        Expected += Big;
+      }
+    }
+    EXPECT_EQ(Expected.size(), OS.tell());
+    // Patch the start of the file, as object writers do.
+    OS.pwrite("XY", 2, 1);
+    Expected[1] = 'X';
+    Expected[2] = 'Y';
+  }
+  // The file is truncated to what was written.
+  EXPECT_EQ(Expected, readFile(Path));
+}
+
+TEST(raw_fd_ostreamTest, MappedOutputSmall) {
+  SmallString<64> Path;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("mapped", "out", Path));
+  FileRemover Cleanup(Path);
+
+  {
+    std::error_code EC;
+    ToolOutputFile Out(Path, EC, sys::fs::F_None, /*Mapped=*/true);
+    ASSERT_FALSE(EC);
+    EXPECT_TRUE(Out.os().isMappedOutput());
+    Out.os() << "hello";
+    Out.os().flush();
+    Out.os() << " world\n";
+    Out.keep();
+  }
+  EXPECT_EQ("hello world\n", readFile(Path));
+}
+
+TEST(raw_fd_ostreamTest, MappedOutputWriteOnly) {
+  SmallString<64> Path;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("mapped", "out", Path));
+  FileRemover Cleanup(Path);
+
+  {
+    // A write-only file cannot be mapped for writing; the stream keeps
+    // using write().
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    EXPECT_TRUE(bool(OS.enableMappedOutput()));
+    EXPECT_FALSE(OS.isMappedOutput());
+    OS << "data";
+  }
+  EXPECT_EQ("data", readFile(Path));
+}
 }
@@ -11,6 +11,7 @@
 #include "gtest/gtest.h"
 
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -75,3 +76,54 @@ TEST(raw_sha1_ostreamTest, Reset) {
 
   ASSERT_EQ("7447F2A5A42185C8CF91E632789C431830B59067", Hash);
 }
+
+TEST(sha1_hash_test, Large) {
+  // The FIPS 180 test vector of a million 'a's.
+  std::vector<uint8_t> Input(1000000, 'a');
+  std::array<uint8_t, 20> Vec = SHA1::hash(Input);
+  ASSERT_EQ("34AA973CD4C4DAA4F61EEB2BDBAD27316534016F",
+            toHex({(const char *)Vec.data(), 20}));
+}
+
+// Check that the hash does not depend on how the input is split into updates.
+TEST(sha1_hash_test, Split) {
+  std::vector<uint8_t> Input(1000);
+  for (size_t I = 0; I != Input.size(); ++I)
+    Input[I] = I * 7 + (I >> 8);
+  for (size_t Size : {0, 1, 55, 56, 63, 64, 65, 128, 1000}) {
+    ArrayRef<uint8_t> Data = makeArrayRef(Input).take_front(Size);
+    std::array<uint8_t, 20> Expected = SHA1::hash(Data);
+    for (size_t Split = 0; Split <= Size; Split += 13) {
+      SHA1 Hash;
+      Hash.update(Data.take_front(Split));
+      for (uint8_t Byte : Data.slice(Split, std::min<size_t>(70, Size - Split)))
+        Hash.update(makeArrayRef(Byte));
+      Hash.update(Data.drop_front(std::min<size_t>(Split + 70, Size)));
+      EXPECT_EQ(toHex({(const char *)Expected.data(), 20}), toHex(Hash.final()))
+          << "size " << Size << ", split " << Split;
+    }
+  }
+}
+
+TEST(sha1_hash_test, Tree) {
+  std::vector<uint8_t> Input(10000);
+  for (size_t I = 0; I != Input.size(); ++I)
+    Input[I] = I * 13;
+
+  // The root is the hash of the sizes and of the hash of each chunk.
+  std::vector<uint8_t> Root = {0x10, 0x27, 0, 0, 0, 0, 0, 0,
+                               0,    0x10, 0, 0, 0, 0, 0, 0};
+  for (size_t Begin = 0; Begin < Input.size(); Begin += 4096) {
+    std::array<uint8_t, 20> Leaf = SHA1::hash(
+        makeArrayRef(Input).slice(Begin, std::min<size_t>(4096, 10000 - Begin)));
+    Root.insert(Root.end(), Leaf.begin(), Leaf.end());
+  }
+  EXPECT_EQ(SHA1::hash(Root), SHA1::hashTree(Input, 4096));
+
+  // Different shapes of the tree give different hashes.
+  EXPECT_NE(SHA1::hashTree(Input, 4096), SHA1::hashTree(Input, 8192));
+  EXPECT_NE(SHA1::hashTree(Input, 4096),
+            SHA1::hashTree(makeArrayRef(Input).drop_back(), 4096));
+  EXPECT_EQ(SHA1::hashTree({}, 64), SHA1::hashTree({}, 64));
+  EXPECT_NE(SHA1::hash({}), SHA1::hashTree({}, 64));
+}
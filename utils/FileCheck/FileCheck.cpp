@@ -90,6 +90,11 @@ static cl::opt<bool> VerboseVerbose(
     cl::desc("Print information helpful in diagnosing internal FileCheck\n"
              "issues, or add it to the input dump if enabled.  Implies\n"
              "-v.\n"));
+
+static cl::opt<bool> TimeChecks(
+    "time-checks", cl::init(false),
+    cl::desc("Report the time spent matching the directives of each check\n"
+             "prefix.\n"));
 static const char * DumpInputEnv = "FILECHECK_DUMP_INPUT_ON_FAILURE";
 
 static cl::opt<bool> DumpInputOnFailure(
@@ -554,6 +559,7 @@ int main(int argc, char **argv) {
   Req.VerboseVerbose = VerboseVerbose;
   Req.NoCanonicalizeWhiteSpace = NoCanonicalizeWhiteSpace;
   Req.MatchFullLines = MatchFullLines;
+  Req.TimeChecks = TimeChecks;
 
   if (VerboseVerbose)
     Req.Verbose = true;